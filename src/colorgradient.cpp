@@ -163,19 +163,13 @@ void QCPColorGradient::setPeriodic(bool enabled)
   mPeriodic = enabled;
 }
 
-/*!
-  This method is used to quickly convert a \a data array to colors. The colors will be output in
-  the array \a scanLine. Both \a data and \a scanLine must have the length \a n when passed to this
-  function. The data range that shall be used for mapping the data value to the gradient is passed
-  in \a range. \a logarithmic indicates whether the data values shall be mapped to colors
-  logarithmically.
+/*! \internal
   
-  if \a data actually contains 2D-data linearized via <tt>[row*columnCount + column]</tt>, you can
-  set \a dataIndexFactor to <tt>columnCount</tt> to convert a column instead of a row of the data
-  array, in \a scanLine. \a scanLine will remain a regular (1D) array. This works because \a data
-  is addressed <tt>data[i*dataIndexFactor]</tt>.
+  Implements \ref colorize for the different types of \a data. The values are converted to double
+  one by one, so no copy of \a data is needed.
 */
-void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic)
+template <typename T>
+void QCPColorGradient::colorizeCells(const T *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic)
 {
   // If you change something here, make sure to also adapt ::color()
   if (!data)
@@ -241,6 +235,42 @@ void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb
   }
 }
 
+/*!
+  This method is used to quickly convert a \a data array to colors. The colors will be output in
+  the array \a scanLine. Both \a data and \a scanLine must have the length \a n when passed to this
+  function. The data range that shall be used for mapping the data value to the gradient is passed
+  in \a range. \a logarithmic indicates whether the data values shall be mapped to colors
+  logarithmically.
+  
+  if \a data actually contains 2D-data linearized via <tt>[row*columnCount + column]</tt>, you can
+  set \a dataIndexFactor to <tt>columnCount</tt> to convert a column instead of a row of the data
+  array, in \a scanLine. \a scanLine will remain a regular (1D) array. This works because \a data
+  is addressed <tt>data[i*dataIndexFactor]</tt>.
+*/
+void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic)
+{
+  colorizeCells(data, range, scanLine, n, dataIndexFactor, logarithmic);
+}
+
+/*! \overload
+  
+  Converts a \a data array of single precision floating point values to colors.
+*/
+void QCPColorGradient::colorize(const float *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic)
+{
+  colorizeCells(data, range, scanLine, n, dataIndexFactor, logarithmic);
+}
+
+/*! \overload
+  
+  Converts a \a data array of 16 bit unsigned integers to colors, as they are common for camera
+  images and analog-to-digital converters.
+*/
+void QCPColorGradient::colorize(const quint16 *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic)
+{
+  colorizeCells(data, range, scanLine, n, dataIndexFactor, logarithmic);
+}
+
 /*! \internal
   
   This method is used to colorize a single data value given in \a position, to colors. The data
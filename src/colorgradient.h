@@ -81,6 +81,8 @@ public:
   
   // non-property methods:
   void colorize(const double *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor=1, bool logarithmic=false);
+  void colorize(const float *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor=1, bool logarithmic=false);
+  void colorize(const quint16 *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor=1, bool logarithmic=false);
   QRgb color(double position, const QCPRange &range, bool logarithmic=false);
   void loadPreset(GradientPreset preset);
   void clearColorStops();
@@ -88,6 +90,7 @@ public:
   
 protected:
   void updateColorBuffer();
+  template <typename T> void colorizeCells(const T *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic);
   
   // property members:
   int mLevelCount;
@@ -73,6 +73,23 @@
   one cell with the main QCPAxisRect inside.
 */
 
+/*! \fn int QCustomPlot::queuedReplotCount() const
+  
+  Returns the number of replots that were requested with the refresh priority \ref rpQueuedReplot
+  since the QCustomPlot was created or \ref resetReplotCounts was called.
+  
+  \see mergedReplotCount, setMaxReplotRate
+*/
+
+/*! \fn int QCustomPlot::mergedReplotCount() const
+  
+  Returns the number of replots requested with the refresh priority \ref rpQueuedReplot that didn't
+  cause a replot of their own, because they were merged into an already pending queued replot. The
+  count refers to the time since the QCustomPlot was created or \ref resetReplotCounts was called.
+  
+  \see queuedReplotCount, setMaxReplotRate
+*/
+
 /* end of documentation of inline functions */
 /* start of documentation of signals */
 
@@ -263,6 +280,15 @@
   \see replot, beforeReplot
 */
 
+/*! \fn void QCustomPlot::asyncReplotFinished()
+  
+  This signal is emitted when a frame that was rendered in the background thread (see \ref
+  setAsyncReplot) has been transferred to the widget surface. Frames that were outdated by a newer
+  replot before they were finished are dropped and don't emit this signal.
+  
+  \see replot, afterReplot
+*/
+
 /* end of documentation of signals */
 /* start of documentation of public members */
 
@@ -362,13 +388,22 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   mCurrentLayer(0),
   mPlottingHints(QCP::phCacheLabels|QCP::phForceRepaint),
   mMultiSelectModifier(Qt::ControlModifier),
-  mPaintBuffer(size()),
+  mMaxReplotRate(0),
+  mAsyncReplot(false),
   mMouseEventElement(0),
-  mReplotting(false)
+  mReplotting(false),
+  mQueuedReplotCount(0),
+  mMergedReplotCount(0),
+  mReplotThread(0),
+  mReplotWorker(0),
+  mAsyncFrameNumber(0),
+  mDisplayedFrameNumber(0)
 {
   setAttribute(Qt::WA_NoMousePropagation);
   setAttribute(Qt::WA_OpaquePaintEvent);
   setMouseTracking(true);
+  mReplotTimer.setSingleShot(true);
+  connect(&mReplotTimer, SIGNAL(timeout()), this, SLOT(processQueuedReplot()));
   QLocale currentLocale = locale();
   currentLocale.setNumberOptions(QLocale::OmitGroupSeparator);
   setLocale(currentLocale);
@@ -416,6 +451,7 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
 
 QCustomPlot::~QCustomPlot()
 {
+  stopReplotThread();
   clearPlottables();
   clearItems();
 
@@ -680,6 +716,75 @@ void QCustomPlot::setMultiSelectModifier(Qt::KeyboardModifier modifier)
   mMultiSelectModifier = modifier;
 }
 
+/*!
+  Sets the maximum number of replots per second that are performed for replot requests with the
+  refresh priority \ref rpQueuedReplot.
+  
+  A queued replot request doesn't render the plot immediately. Instead, the replot is performed in a
+  later event loop iteration, and all further queued replot requests until then are merged into
+  that single replot. If \a replotsPerSecond is greater than zero, the queued replot is
+  additionally delayed such that it happens no earlier than 1/\a replotsPerSecond seconds after the
+  previous replot. This way, many sources of replot requests (e.g. data acquisition threads, range
+  synchronization signals and user interactions) can request replots as often as they like, and
+  the plot is rendered at most with the specified frame rate.
+  
+  A value of zero (the default) means queued replots are performed in the next event loop
+  iteration, without a frame rate limit.
+  
+  Replots with other refresh priorities are never delayed. Such a replot also satisfies a pending
+  queued replot request, so it is cancelled.
+  
+  \see replot, queuedReplotCount, mergedReplotCount
+*/
+void QCustomPlot::setMaxReplotRate(double replotsPerSecond)
+{
+  mMaxReplotRate = qMax(0.0, replotsPerSecond);
+}
+
+/*!
+  Sets whether replots are rendered asynchronously in a background thread.
+  
+  If \a enabled is false (the default), \ref replot renders the plot into the paint buffers on the
+  GUI thread and only returns once the new frame is complete. For plots that take long to render
+  (e.g. large color maps or graphs with many antialiased lines), this blocks user input for the
+  duration of the replot.
+  
+  If \a enabled is true, \ref replot only lays out the plot and records the painting commands of
+  each layer into a QPicture on the GUI thread. This snapshot of the plot is independent of the
+  plot objects, so they may be modified freely right after the replot call. The recorded pictures
+  are then rasterized into QImages by a worker thread, which is the expensive part of a replot
+  (path rasterization, antialiasing, image scaling). When the frame is finished, it is transferred
+  to the widget surface in the GUI thread and \ref asyncReplotFinished is emitted. If further
+  replots are requested while a frame is being rendered, the outdated frame is dropped and only
+  the most recent one is rendered and shown.
+  
+  Replots with the refresh priority \ref rpImmediate, exports (e.g. \ref savePng, \ref toPixmap)
+  and individual layer replots (\ref QCPLayer::replot) are always performed synchronously. A
+  synchronous replot discards pending asynchronous frames.
+  
+  Since QPixmaps may only be used in the GUI thread, the recording bypasses the label cache (see
+  \ref QCP::phCacheLabels) and converts pixmaps like backgrounds (\ref setBackground), the pixmaps
+  of QCPItemPixmap and legend icons to QImages (see \ref QCPPainter::pmNoPixmaps). So asynchronous
+  replots can take slightly more time on the GUI thread for plots that are cheap to rasterize. This
+  mode is meant for plots where rasterization dominates the replot time.
+  
+  \see replot
+*/
+void QCustomPlot::setAsyncReplot(bool enabled)
+{
+  if (mAsyncReplot == enabled)
+    return;
+  mAsyncReplot = enabled;
+  if (mAsyncReplot)
+  {
+    mReplotThread = new QThread;
+    mReplotWorker = new QCPReplotWorker(this);
+    mReplotWorker->moveToThread(mReplotThread);
+    mReplotThread->start();
+  } else
+    stopReplotThread();
+}
+
 /*!
   Sets the viewport of this QCustomPlot. The Viewport is the area that the top level layout
   (QCustomPlot::plotLayout()) uses as its rect. Normally, the viewport is the entire widget rect.
@@ -1426,6 +1531,7 @@ bool QCustomPlot::addLayer(const QString &name, QCPLayer *otherLayer, QCustomPlo
   QCPLayer *newLayer = new QCPLayer(this, name);
   mLayers.insert(otherLayer->index() + (insertMode==limAbove ? 1:0), newLayer);
   updateLayerIndices();
+  invalidatePaintBuffers();
   return true;
 }
 
@@ -1477,6 +1583,7 @@ bool QCustomPlot::removeLayer(QCPLayer *layer)
   delete layer;
   mLayers.removeOne(layer);
   updateLayerIndices();
+  invalidatePaintBuffers();
   return true;
 }
 
@@ -1504,6 +1611,7 @@ bool QCustomPlot::moveLayer(QCPLayer *layer, QCPLayer *otherLayer, QCustomPlot::
   
   mLayers.move(layer->index(), otherLayer->index() + (insertMode==limAbove ? 1:0));
   updateLayerIndices();
+  invalidatePaintBuffers();
   return true;
 }
 
@@ -1686,35 +1794,124 @@ void QCustomPlot::deselectAll()
   afterReplot is emitted. It is safe to mutually connect the replot slot with any of those two
   signals on two QCustomPlots to make them replot synchronously, it won't cause an infinite
   recursion.
+  
+  If only the objects on one layer have changed, and that layer has its own paint buffer (see \ref
+  QCPLayer::setMode), use \ref QCPLayer::replot instead, which doesn't redraw the other layers.
+  
+  If \a refreshPriority is \ref rpQueuedReplot, the replot isn't performed immediately but in a
+  later event loop iteration. Multiple such requests are merged into one replot, and the rate of
+  queued replots may be limited with \ref setMaxReplotRate. This is the preferred way to request
+  replots from code that may run many times per event loop iteration.
+  
+  If asynchronous replots are enabled with \ref setAsyncReplot, the plot is rasterized in a
+  background thread and this method returns before the new frame is visible (unless \a
+  refreshPriority is \ref rpImmediate).
 */
 void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
 {
+  if (refreshPriority == rpQueuedReplot)
+  {
+    ++mQueuedReplotCount;
+    if (mReplotTimer.isActive())
+    {
+      ++mMergedReplotCount;
+    } else
+    {
+      int delay = 0;
+      if (mMaxReplotRate > 0 && mLastReplotTime.isValid())
+        delay = qMax(0, qRound(qMin(1000.0/mMaxReplotRate, 3600e3))-mLastReplotTime.elapsed()); // limit minimum interval to one hour to prevent integer overflow
+      mReplotTimer.start(delay);
+    }
+    return;
+  }
+  
   if (mReplotting) // incase signals loop back to replot slot
     return;
   mReplotting = true;
+  mReplotTimer.stop(); // a pending queued replot is satisfied by this replot
+  mLastReplotTime.start();
   emit beforeReplot();
   
-  mPaintBuffer.fill(mBackgroundBrush.style() == Qt::SolidPattern ? mBackgroundBrush.color() : Qt::transparent);
-  QCPPainter painter;
-  painter.begin(&mPaintBuffer);
-  if (painter.isActive())
+  setupPaintBuffers();
+  updateLayout();
+  QList<QCPAbstractPlottable*> preparedPlottables;
+  if (mPlottingHints.testFlag(QCP::phParallelPreparation))
   {
-    painter.setRenderHint(QPainter::HighQualityAntialiasing); // to make Antialiasing look good if using the OpenGL graphicssystem
-    if (mBackgroundBrush.style() != Qt::SolidPattern && mBackgroundBrush.style() != Qt::NoBrush)
-      painter.fillRect(mViewport, mBackgroundBrush);
-    draw(&painter);
-    painter.end();
-    if ((refreshPriority == rpHint && mPlottingHints.testFlag(QCP::phForceRepaint)) || refreshPriority==rpImmediate)
-      repaint();
-    else
-      update();
-  } else // might happen if QCustomPlot has width or height zero
-    qDebug() << Q_FUNC_INFO << "Couldn't activate painter on buffer. This usually happens because QCustomPlot has width or height zero.";
+    foreach (QCPAbstractPlottable *plottable, mPlottables)
+    {
+      if (plottable->realVisibility())
+        preparedPlottables.append(plottable);
+    }
+    QCPDrawPreparer::prepare(preparedPlottables);
+  }
+  if (mAsyncReplot && refreshPriority != rpImmediate)
+  {
+    if (!size().isEmpty())
+    {
+      QList<QPicture> pictures;
+      for (int bufferIndex=0; bufferIndex<mPaintBuffers.size(); ++bufferIndex)
+      {
+        QPicture picture;
+        QCPPainter painter;
+        if (painter.begin(&picture))
+        {
+          // pixmaps (cached labels, backgrounds, QCPItemPixmap, legend icons) may not be used in the worker thread:
+          painter.setModes(QCPPainter::pmNoCaching | QCPPainter::pmNoPixmaps);
+          drawPaintBuffer(&painter, bufferIndex);
+          painter.end();
+        }
+        pictures.append(picture);
+      }
+      ++mAsyncFrameNumber;
+      mReplotWorker->requestFrame(mAsyncFrameNumber, pictures, size(), mBackgroundBrush.style() == Qt::SolidPattern ? mBackgroundBrush.color() : QColor(Qt::transparent));
+    } else
+      qDebug() << Q_FUNC_INFO << "Couldn't record replot, because QCustomPlot has width or height zero.";
+  } else
+  {
+    mDisplayedFrameNumber = mAsyncFrameNumber; // pending asynchronous frames are outdated by this replot
+    bool painted = true;
+    for (int bufferIndex=0; bufferIndex<mPaintBuffers.size() && painted; ++bufferIndex)
+    {
+      QImage &buffer = mPaintBuffers[bufferIndex];
+      buffer.fill(0); // transparent
+      QCPPainter painter;
+      painter.begin(&buffer);
+      if (painter.isActive())
+      {
+        // the bottom buffer contains the background, the buffers above are composited on top of it:
+        if (bufferIndex == 0 && mBackgroundBrush.style() == Qt::SolidPattern)
+          painter.fillRect(buffer.rect(), mBackgroundBrush.color());
+        drawPaintBuffer(&painter, bufferIndex);
+        painter.end();
+      } else // might happen if QCustomPlot has width or height zero
+        painted = false;
+    }
+    if (painted)
+    {
+      mPaintBufferComposite = QPixmap();
+      if ((refreshPriority == rpHint && mPlottingHints.testFlag(QCP::phForceRepaint)) || refreshPriority==rpImmediate)
+        repaint();
+      else
+        update();
+    } else
+      qDebug() << Q_FUNC_INFO << "Couldn't activate painter on buffer. This usually happens because QCustomPlot has width or height zero.";
+  }
+  foreach (QCPAbstractPlottable *plottable, preparedPlottables)
+    plottable->clearPreparedDraw();
   
   emit afterReplot();
   mReplotting = false;
 }
 
+/*!
+  Resets the counters returned by \ref queuedReplotCount and \ref mergedReplotCount to zero.
+*/
+void QCustomPlot::resetReplotCounts()
+{
+  mQueuedReplotCount = 0;
+  mMergedReplotCount = 0;
+}
+
 /*!
   Rescales the axes such that all plottables (like graphs) in the plot are fully visible.
   
@@ -1977,12 +2174,33 @@ QSize QCustomPlot::sizeHint() const
   
   Event handler for when the QCustomPlot widget needs repainting. This does not cause a \ref replot, but
   draws the internal buffer on the widget surface.
+  
+  The paint buffers are composited into a single pixmap only when their content has changed, so
+  repaints without a preceding replot (e.g. when the widget is uncovered) draw just this pixmap.
+  While an asynchronous replot after a resize is pending (see \ref setAsyncReplot), the pixmap of
+  the previous frame is stretched to the new widget size.
 */
 void QCustomPlot::paintEvent(QPaintEvent *event)
 {
   Q_UNUSED(event);
+  if (mPaintBufferComposite.isNull() && !mPaintBuffers.isEmpty())
+  {
+    if (mPaintBuffers.size() == 1)
+      mPaintBufferComposite = QPixmap::fromImage(mPaintBuffers.first());
+    else
+    {
+      mPaintBufferComposite = QPixmap(mPaintBuffers.first().size());
+      mPaintBufferComposite.fill(Qt::transparent);
+      QPainter compositePainter(&mPaintBufferComposite);
+      foreach (const QImage &buffer, mPaintBuffers)
+        compositePainter.drawImage(0, 0, buffer);
+    }
+  }
   QPainter painter(this);
-  painter.drawPixmap(0, 0, mPaintBuffer);
+  if (mPaintBufferComposite.size() == size())
+    painter.drawPixmap(0, 0, mPaintBufferComposite);
+  else
+    painter.drawPixmap(rect(), mPaintBufferComposite);
 }
 
 /*! \internal
@@ -1993,8 +2211,8 @@ void QCustomPlot::paintEvent(QPaintEvent *event)
 */
 void QCustomPlot::resizeEvent(QResizeEvent *event)
 {
-  // resize and repaint the buffer:
-  mPaintBuffer = QPixmap(event->size());
+  Q_UNUSED(event)
+  // resize and repaint the buffers (setupPaintBuffers called by replot adapts them to the new size):
   setViewport(rect());
   replot(rpQueued); // queued update is important here, to prevent painting issues in some contexts
 }
@@ -2197,29 +2415,14 @@ void QCustomPlot::wheelEvent(QWheelEvent *event)
 */
 void QCustomPlot::draw(QCPPainter *painter)
 {
-  // run through layout phases:
-  mPlotLayout->update(QCPLayoutElement::upPreparation);
-  mPlotLayout->update(QCPLayoutElement::upMargins);
-  mPlotLayout->update(QCPLayoutElement::upLayout);
+  updateLayout();
   
   // draw viewport background pixmap:
   drawBackground(painter);
 
   // draw all layered objects (grid, axes, plottables, items, legend,...):
   foreach (QCPLayer *layer, mLayers)
-  {
-    foreach (QCPLayerable *child, layer->children())
-    {
-      if (child->realVisibility())
-      {
-        painter->save();
-        painter->setClipRect(child->clipRect().translated(0, -1));
-        child->applyDefaultAntialiasingHint(painter);
-        child->draw(painter);
-        painter->restore();
-      }
-    }
-  }
+    layer->draw(painter);
   
   /* Debug code to draw all layout element rects
   foreach (QCPLayoutElement* el, findChildren<QCPLayoutElement*>())
@@ -2233,6 +2436,178 @@ void QCustomPlot::draw(QCPPainter *painter)
   */
 }
 
+/*! \internal
+  
+  Runs through the layout phases of the plot layout, so all layout elements (axis rects, legends,
+  etc.) have their final positions and sizes for drawing.
+*/
+void QCustomPlot::updateLayout()
+{
+  mPlotLayout->update(QCPLayoutElement::upPreparation);
+  mPlotLayout->update(QCPLayoutElement::upMargins);
+  mPlotLayout->update(QCPLayoutElement::upLayout);
+}
+
+/*! \internal
+  
+  Assigns the layers to paint buffers and makes sure the paint buffers exist with the size of the
+  widget.
+  
+  The first paint buffer holds the background and all logical layers (\ref QCPLayer::lmLogical)
+  below the first buffered layer. Each buffered layer (\ref QCPLayer::lmBuffered) gets a paint
+  buffer of its own, and each run of adjacent logical layers above a buffered layer shares one
+  paint buffer. If no layer is buffered, there is only a single paint buffer.
+  
+  \see replot, paintEvent
+*/
+void QCustomPlot::setupPaintBuffers()
+{
+  int bufferIndex = 0;
+  bool bufferShared = true; // whether the current buffer is shared by logical layers
+  foreach (QCPLayer *layer, mLayers)
+  {
+    if (layer->mMode == QCPLayer::lmBuffered)
+    {
+      ++bufferIndex;
+      bufferShared = false;
+    } else if (!bufferShared)
+    {
+      ++bufferIndex;
+      bufferShared = true;
+    }
+    layer->mPaintBufferIndex = bufferIndex;
+  }
+  
+  while (mPaintBuffers.size() > bufferIndex+1)
+    mPaintBuffers.removeLast();
+  for (int i=0; i<=bufferIndex; ++i)
+  {
+    if (i < mPaintBuffers.size() && mPaintBuffers.at(i).size() == size())
+      continue;
+    // new buffers show the plain background until they are painted, e.g. by an asynchronous frame:
+    QImage buffer(size(), QImage::Format_ARGB32_Premultiplied);
+    buffer.fill(0); // transparent
+    if (i == 0 && mBackgroundBrush.style() == Qt::SolidPattern && !buffer.isNull())
+    {
+      QPainter painter(&buffer);
+      painter.fillRect(buffer.rect(), mBackgroundBrush.color());
+    }
+    if (i == mPaintBuffers.size())
+      mPaintBuffers.append(buffer);
+    else
+      mPaintBuffers[i] = buffer;
+  }
+  mPaintBufferReplotFrames.resize(mPaintBuffers.size());
+}
+
+/*! \internal
+  
+  Marks the assignment of layers to paint buffers as outdated. This is necessary when layers are
+  added, removed or moved, or when the mode of a layer changes (\ref QCPLayer::setMode), because
+  the paint buffer indices of the layers may change. Until the next full replot reassigns them
+  (see \ref setupPaintBuffers), \ref QCPLayer::replot performs a full replot.
+*/
+void QCustomPlot::invalidatePaintBuffers()
+{
+  foreach (QCPLayer *layer, mLayers)
+    layer->mPaintBufferIndex = -1;
+}
+
+/*! \internal
+  
+  Draws the contents of the paint buffer with index \a bufferIndex with the provided \a painter,
+  i.e. the background (only for the first buffer) and all layers that are assigned to that buffer
+  by \ref setupPaintBuffers. The painter is expected to paint on a surface that was already
+  cleared.
+  
+  \see replot
+*/
+void QCustomPlot::drawPaintBuffer(QCPPainter *painter, int bufferIndex)
+{
+  painter->setRenderHint(QPainter::HighQualityAntialiasing); // to make Antialiasing look good if using the OpenGL graphicssystem
+  if (bufferIndex == 0)
+  {
+    if (mBackgroundBrush.style() != Qt::SolidPattern && mBackgroundBrush.style() != Qt::NoBrush)
+      painter->fillRect(mViewport, mBackgroundBrush);
+    drawBackground(painter);
+  }
+  foreach (QCPLayer *layer, mLayers)
+  {
+    if (layer->mPaintBufferIndex == bufferIndex)
+      layer->draw(painter);
+  }
+}
+
+/*! \internal
+  
+  Stops the background thread used for asynchronous replots, if it is running, and deletes the
+  worker. Frames that are still being rendered are discarded.
+  
+  \see setAsyncReplot
+*/
+void QCustomPlot::stopReplotThread()
+{
+  if (mReplotThread)
+  {
+    mReplotThread->quit();
+    mReplotThread->wait();
+    delete mReplotWorker;
+    delete mReplotThread;
+    mReplotWorker = 0;
+    mReplotThread = 0;
+  }
+}
+
+/*! \internal
+  
+  Performs the replot that was requested with the refresh priority \ref rpQueuedReplot, once the
+  replot timer has expired.
+  
+  \see setMaxReplotRate
+*/
+void QCustomPlot::processQueuedReplot()
+{
+  replot(rpHint);
+}
+
+/*! \internal
+  
+  Called (via a queued invocation) by the replot worker when it has finished rendering a frame that
+  was requested by an asynchronous \ref replot. Transfers the frame into the paint buffers and
+  updates the widget surface.
+  
+  The frame is dropped, if a newer frame was already shown or a synchronous replot happened in the
+  meantime, or if the paint buffer configuration has changed since the frame was requested. Paint
+  buffers that were replotted individually by \ref QCPLayer::replot after the frame was requested
+  keep their more recent content.
+  
+  \see setAsyncReplot
+*/
+void QCustomPlot::processAsyncFrame()
+{
+  int frameNumber = 0;
+  QList<QImage> images;
+  if (!mReplotWorker || !mReplotWorker->takeFrame(&frameNumber, &images))
+    return;
+  if (frameNumber <= mDisplayedFrameNumber || images.size() != mPaintBuffers.size())
+    return;
+  for (int i=0; i<images.size(); ++i)
+  {
+    if (images.at(i).size() != mPaintBuffers.at(i).size())
+      return;
+  }
+  
+  for (int i=0; i<images.size(); ++i)
+  {
+    if (mPaintBufferReplotFrames.at(i) < frameNumber)
+      mPaintBuffers[i] = images.at(i);
+  }
+  mPaintBufferComposite = QPixmap();
+  mDisplayedFrameNumber = frameNumber;
+  update();
+  emit asyncReplotFinished();
+}
+
 /*! \internal
   
   Draws the viewport background pixmap of the plot.
@@ -2264,10 +2639,10 @@ void QCustomPlot::drawBackground(QCPPainter *painter)
       scaledSize.scale(mViewport.size(), mBackgroundScaledMode);
       if (mScaledBackgroundPixmap.size() != scaledSize)
         mScaledBackgroundPixmap = mBackgroundPixmap.scaled(mViewport.size(), mBackgroundScaledMode, Qt::SmoothTransformation);
-      painter->drawPixmap(mViewport.topLeft(), mScaledBackgroundPixmap, QRect(0, 0, mViewport.width(), mViewport.height()) & mScaledBackgroundPixmap.rect());
+      painter->drawPixmapOrImage(mViewport.topLeft(), mScaledBackgroundPixmap, QRect(0, 0, mViewport.width(), mViewport.height()) & mScaledBackgroundPixmap.rect());
     } else
     {
-      painter->drawPixmap(mViewport.topLeft(), mBackgroundPixmap, QRect(0, 0, mViewport.width(), mViewport.height()));
+      painter->drawPixmapOrImage(mViewport.topLeft(), mBackgroundPixmap, QRect(0, 0, mViewport.width(), mViewport.height()));
     }
   }
 }
@@ -2463,3 +2838,120 @@ void QCustomPlot::toPainter(QCPPainter *painter, int width, int height)
   } else
     qDebug() << Q_FUNC_INFO << "Passed painter is not active";
 }
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPReplotWorker
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPReplotWorker
+  
+  \internal
+  \brief (Private)
+  
+  This is a private class and not part of the public QCustomPlot interface.
+  
+  It lives in the background thread of a QCustomPlot with asynchronous replots enabled (see \ref
+  QCustomPlot::setAsyncReplot), and rasterizes the recorded paint buffers of a replot into QImages.
+  Only the most recent request is kept, so requests that arrive faster than they can be rendered
+  are dropped. All data exchanged with the GUI thread is protected by a mutex.
+*/
+
+/*!
+  Creates a replot worker that delivers its frames to \a parentPlot. The worker must be moved to
+  the rendering thread by the caller.
+*/
+QCPReplotWorker::QCPReplotWorker(QCustomPlot *parentPlot) :
+  QObject(0),
+  mParentPlot(parentPlot),
+  mRequestPending(false),
+  mRequestFrameNumber(0),
+  mFramePending(false),
+  mFrameNumber(0)
+{
+}
+
+/*!
+  Requests the rendering of the frame with number \a frameNumber. \a pictures holds the recorded
+  paint buffers from bottom to top, which are rasterized into images of the given \a size. The
+  bottom image is filled with \a backgroundColor before the picture is drawn onto it.
+  
+  This method is called from the GUI thread and returns immediately. If a previous request wasn't
+  started yet, it is replaced by this one. A frame that is currently being rendered is aborted.
+*/
+void QCPReplotWorker::requestFrame(int frameNumber, const QList<QPicture> &pictures, const QSize &size, const QColor &backgroundColor)
+{
+  QMutexLocker locker(&mMutex);
+  mRequestPending = true;
+  mRequestFrameNumber = frameNumber;
+  mRequestPictures = pictures;
+  mRequestSize = size;
+  mRequestBackgroundColor = backgroundColor;
+  locker.unlock();
+  QMetaObject::invokeMethod(this, "render", Qt::QueuedConnection);
+}
+
+/*!
+  Takes the most recently finished frame. Returns false if no frame is available. Otherwise, the
+  frame number is written to \a frameNumber and the rasterized paint buffers to \a images, and
+  true is returned.
+  
+  This method is called from the GUI thread.
+*/
+bool QCPReplotWorker::takeFrame(int *frameNumber, QList<QImage> *images)
+{
+  QMutexLocker locker(&mMutex);
+  if (!mFramePending)
+    return false;
+  mFramePending = false;
+  *frameNumber = mFrameNumber;
+  *images = mFrameImages;
+  mFrameImages.clear();
+  return true;
+}
+
+/*! \internal
+  
+  Rasterizes the pending request in the worker thread and notifies the parent plot when the frame
+  is finished. If a newer request arrives while rendering, the current frame is dropped and the
+  newer request is rendered by the subsequent invocation of this method.
+*/
+void QCPReplotWorker::render()
+{
+  QMutexLocker locker(&mMutex);
+  if (!mRequestPending)
+    return;
+  mRequestPending = false;
+  const int frameNumber = mRequestFrameNumber;
+  const QList<QPicture> pictures = mRequestPictures;
+  const QSize size = mRequestSize;
+  const QColor backgroundColor = mRequestBackgroundColor;
+  mRequestPictures.clear();
+  locker.unlock();
+  
+  QList<QImage> images;
+  for (int i=0; i<pictures.size(); ++i)
+  {
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(0);
+    QPainter painter(&image);
+    if (i == 0 && backgroundColor.alpha() > 0)
+      painter.fillRect(image.rect(), backgroundColor);
+    painter.drawPicture(0, 0, pictures.at(i));
+    painter.end();
+    images.append(image);
+    
+    locker.relock();
+    const bool outdated = mRequestPending;
+    locker.unlock();
+    if (outdated)
+      return;
+  }
+  
+  locker.relock();
+  mFramePending = true;
+  mFrameNumber = frameNumber;
+  mFrameImages = images;
+  locker.unlock();
+  QMetaObject::invokeMethod(mParentPlot, "processAsyncFrame", Qt::QueuedConnection);
+}
@@ -38,6 +38,36 @@ class QCPGraph;
 class QCPPlotTitle;
 class QCPLegend;
 class QCPAbstractLegendItem;
+class QCustomPlot;
+
+class QCP_LIB_DECL QCPReplotWorker : public QObject
+{
+  Q_OBJECT
+public:
+  explicit QCPReplotWorker(QCustomPlot *parentPlot);
+  
+  // non-property methods:
+  void requestFrame(int frameNumber, const QList<QPicture> &pictures, const QSize &size, const QColor &backgroundColor);
+  bool takeFrame(int *frameNumber, QList<QImage> *images);
+  
+protected:
+  QCustomPlot *mParentPlot;
+  QMutex mMutex;
+  // pending request:
+  bool mRequestPending;
+  int mRequestFrameNumber;
+  QList<QPicture> mRequestPictures;
+  QSize mRequestSize;
+  QColor mRequestBackgroundColor;
+  // finished frame:
+  bool mFramePending;
+  int mFrameNumber;
+  QList<QImage> mFrameImages;
+  
+  // non-virtual methods:
+  Q_SLOT void render();
+};
+
 
 class QCP_LIB_DECL QCustomPlot : public QWidget
 {
@@ -52,6 +82,8 @@ class QCP_LIB_DECL QCustomPlot : public QWidget
   Q_PROPERTY(int selectionTolerance READ selectionTolerance WRITE setSelectionTolerance)
   Q_PROPERTY(bool noAntialiasingOnDrag READ noAntialiasingOnDrag WRITE setNoAntialiasingOnDrag)
   Q_PROPERTY(Qt::KeyboardModifier multiSelectModifier READ multiSelectModifier WRITE setMultiSelectModifier)
+  Q_PROPERTY(double maxReplotRate READ maxReplotRate WRITE setMaxReplotRate)
+  Q_PROPERTY(bool asyncReplot READ asyncReplot WRITE setAsyncReplot)
   /// \endcond
 public:
   /*!
@@ -72,6 +104,7 @@ public:
   enum RefreshPriority { rpImmediate ///< The QCustomPlot surface is immediately refreshed, by calling QWidget::repaint() after the replot
                          ,rpQueued   ///< Queues the refresh such that it is performed at a slightly delayed point in time after the replot, by calling QWidget::update() after the replot
                          ,rpHint     ///< Whether to use immediate repaint or queued update depends on whether the plotting hint \ref QCP::phForceRepaint is set, see \ref setPlottingHints.
+                         ,rpQueuedReplot ///< Queues the entire replot for a later event loop iteration. All replot requests until then are merged into one replot, see \ref setMaxReplotRate.
                        };
   
   explicit QCustomPlot(QWidget *parent = 0);
@@ -91,6 +124,8 @@ public:
   bool noAntialiasingOnDrag() const { return mNoAntialiasingOnDrag; }
   QCP::PlottingHints plottingHints() const { return mPlottingHints; }
   Qt::KeyboardModifier multiSelectModifier() const { return mMultiSelectModifier; }
+  double maxReplotRate() const { return mMaxReplotRate; }
+  bool asyncReplot() const { return mAsyncReplot; }
 
   // setters:
   void setViewport(const QRect &rect);
@@ -111,6 +146,8 @@ public:
   void setPlottingHints(const QCP::PlottingHints &hints);
   void setPlottingHint(QCP::PlottingHint hint, bool enabled=true);
   void setMultiSelectModifier(Qt::KeyboardModifier modifier);
+  void setMaxReplotRate(double replotsPerSecond);
+  void setAsyncReplot(bool enabled);
   
   // non-property methods:
   // plottable interface:
@@ -177,6 +214,9 @@ public:
   QPixmap toPixmap(int width=0, int height=0, double scale=1.0);
   void toPainter(QCPPainter *painter, int width=0, int height=0);
   Q_SLOT void replot(QCustomPlot::RefreshPriority refreshPriority=QCustomPlot::rpHint);
+  int queuedReplotCount() const { return mQueuedReplotCount; }
+  int mergedReplotCount() const { return mMergedReplotCount; }
+  void resetReplotCounts();
   
   QCPAxis *xAxis, *yAxis, *xAxis2, *yAxis2;
   QCPLegend *legend;
@@ -202,6 +242,7 @@ signals:
   void selectionChangedByUser();
   void beforeReplot();
   void afterReplot();
+  void asyncReplotFinished();
   
 protected:
   // property members:
@@ -224,12 +265,22 @@ protected:
   QCPLayer *mCurrentLayer;
   QCP::PlottingHints mPlottingHints;
   Qt::KeyboardModifier mMultiSelectModifier;
+  double mMaxReplotRate;
+  bool mAsyncReplot;
   
   // non-property members:
-  QPixmap mPaintBuffer;
+  QList<QImage> mPaintBuffers;
+  QPixmap mPaintBufferComposite;
   QPoint mMousePressPos;
   QPointer<QCPLayoutElement> mMouseEventElement;
   bool mReplotting;
+  QTimer mReplotTimer;
+  QTime mLastReplotTime;
+  int mQueuedReplotCount, mMergedReplotCount;
+  QThread *mReplotThread;
+  QCPReplotWorker *mReplotWorker;
+  int mAsyncFrameNumber, mDisplayedFrameNumber;
+  QVector<int> mPaintBufferReplotFrames;
   
   // reimplemented virtual methods:
   virtual QSize minimumSizeHint() const;
@@ -248,9 +299,16 @@ protected:
   virtual void legendRemoved(QCPLegend *legend);
   
   // non-virtual methods:
+  void updateLayout();
+  void setupPaintBuffers();
+  void invalidatePaintBuffers();
+  void drawPaintBuffer(QCPPainter *painter, int bufferIndex);
+  void stopReplotThread();
   void updateLayerIndices() const;
   QCPLayerable *layerableAt(const QPointF &pos, bool onlySelectable, QVariant *selectionDetails=0) const;
   void drawBackground(QCPPainter *painter);
+  Q_SLOT void processQueuedReplot();
+  Q_SLOT void processAsyncFrame();
   
   friend class QCPLegend;
   friend class QCPAxis;
@@ -29,6 +29,7 @@
 // amalgamation: include begin
 #include <QObject>
 #include <QPointer>
+#include <QSharedPointer>
 #include <QWidget>
 #include <QPainter>
 #include <QPaintEvent>
@@ -40,12 +41,21 @@
 #include <QMultiMap>
 #include <QFlags>
 #include <QDebug>
+#include <QFile>
 #include <QVector2D>
 #include <QStack>
 #include <QCache>
 #include <QMargins>
+#include <QTimer>
+#include <QThread>
+#include <QMutex>
+#include <QPicture>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QSemaphore>
 #include <qmath.h>
 #include <limits>
+#include <algorithm>
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
 #  include <qnumeric.h>
 #  include <QPrinter>
@@ -120,6 +130,11 @@ enum PlottingHint { phNone            = 0x000 ///< <tt>0x000</tt> No hints are s
                     ,phForceRepaint   = 0x002 ///< <tt>0x002</tt> causes an immediate repaint() instead of a soft update() when QCustomPlot::replot() is called with parameter \ref QCustomPlot::rpHint.
                                               ///<                This is set by default to prevent the plot from freezing on fast consecutive replots (e.g. user drags ranges with mouse).
                     ,phCacheLabels    = 0x004 ///< <tt>0x004</tt> axis (tick) labels will be cached as pixmaps, increasing replot performance.
+                    ,phParallelPreparation = 0x008 ///< <tt>0x008</tt> the pixel geometry of the plottables is calculated in parallel on the global thread pool before the plottables are painted,
+                                              ///<                see \ref QCPAbstractPlottable::prepareDraw. This speeds up replots of plots with many large plottables on multi-core machines.
+                    ,phCacheScatters  = 0x010 ///< <tt>0x010</tt> scatter symbols of graphs and curves are rendered once into small images (sprites) which are then copied to each scatter position,
+                                              ///<                see \ref QCPScatterStyle::drawShapes. This greatly increases replot performance of plots with many scatter points,
+                                              ///<                but rounds the scatter positions to a quarter pixel, so scatters may appear up to one pixel off (especially without antialiasing).
                   };
 Q_DECLARE_FLAGS(PlottingHints, PlottingHint)
 
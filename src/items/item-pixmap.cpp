@@ -137,7 +137,7 @@ void QCPItemPixmap::draw(QCPPainter *painter)
   if (boundingRect.intersects(clipRect()))
   {
     updateScaledPixmap(rect, flipHorz, flipVert);
-    painter->drawPixmap(rect.topLeft(), mScaled ? mScaledPixmap : mPixmap);
+    painter->drawPixmapOrImage(rect.topLeft(), mScaled ? mScaledPixmap : mPixmap);
     QPen pen = mainPen();
     if (pen.style() != Qt::NoPen)
     {
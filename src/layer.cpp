@@ -72,6 +72,12 @@
   
   When a layer is deleted, the objects on it are not deleted with it, but fall on the layer below
   the deleted layer, see QCustomPlot::removeLayer.
+  
+  By default, all layers are drawn into one common paint buffer, so a replot redraws all objects
+  of all layers. If the objects on a layer change frequently while the rest of the plot stays the
+  same, for example an item following the mouse cursor, that layer can be given its own paint
+  buffer with \ref setMode. It can then be redrawn with \ref replot without redrawing the other
+  layers, which keep their previously rendered pixels.
 */
 
 /* start documentation of inline functions */
@@ -90,6 +96,13 @@
   Layers with higher indices will be drawn above layers with lower indices.
 */
 
+/*! \fn QCPLayer::LayerMode QCPLayer::mode() const
+  
+  Returns whether this layer is drawn into its own paint buffer.
+  
+  \see setMode
+*/
+
 /* end documentation of inline functions */
 
 /*!
@@ -105,7 +118,9 @@ QCPLayer::QCPLayer(QCustomPlot *parentPlot, const QString &layerName) :
   mParentPlot(parentPlot),
   mName(layerName),
   mIndex(-1), // will be set to a proper value by the QCustomPlot layer creation function
-  mVisible(true)
+  mVisible(true),
+  mMode(lmLogical),
+  mPaintBufferIndex(-1)
 {
   // Note: no need to make sure layerName is unique, because layer
   // management is done with QCustomPlot functions.
@@ -138,6 +153,84 @@ void QCPLayer::setVisible(bool visible)
   mVisible = visible;
 }
 
+/*!
+  Sets whether this layer is drawn into a paint buffer of its own (\ref lmBuffered), or shares the
+  paint buffer with the adjacent layers (\ref lmLogical, the default).
+  
+  A buffered layer can be redrawn individually with \ref replot, while all other layers keep their
+  rendered pixels. The paint buffers are composited on the widget surface after they changed. Each
+  buffered layer costs one additional image of the size of the QCustomPlot widget, so only layers
+  that need to be replotted individually should be buffered.
+  
+  The new mode takes effect with the next \ref QCustomPlot::replot.
+  
+  \see replot
+*/
+void QCPLayer::setMode(QCPLayer::LayerMode mode)
+{
+  if (mMode != mode)
+  {
+    mMode = mode;
+    mParentPlot->invalidatePaintBuffers(); // paint buffers of all layers are reassigned at next full replot
+  }
+}
+
+/*!
+  Redraws only the objects on this layer and updates the widget surface, if this layer is a
+  buffered layer (\ref setMode). The other layers are not redrawn, they reuse the pixels rendered
+  by the last \ref QCustomPlot::replot. This makes changes of the objects on this layer visible
+  considerably faster than a full replot, if the other layers contain many or complex objects.
+  
+  The layout of the plot is not updated, so changes that affect the layout (e.g. axis ranges,
+  tick labels or the legend) still require a full \ref QCustomPlot::replot.
+  
+  If this layer is not buffered, or the paint buffers haven't been set up yet because the mode of
+  a layer was changed or layers were added, removed or moved after the last full replot, this
+  calls \ref QCustomPlot::replot.
+*/
+void QCPLayer::replot()
+{
+  if (mMode == lmBuffered && mPaintBufferIndex > 0 && mPaintBufferIndex < mParentPlot->mPaintBuffers.size())
+  {
+    QImage &buffer = mParentPlot->mPaintBuffers[mPaintBufferIndex];
+    buffer.fill(0); // transparent
+    QCPPainter painter;
+    painter.begin(&buffer);
+    if (painter.isActive())
+    {
+      painter.setRenderHint(QPainter::HighQualityAntialiasing); // to make Antialiasing look good if using the OpenGL graphicssystem
+      draw(&painter);
+      painter.end();
+      mParentPlot->mPaintBufferReplotFrames[mPaintBufferIndex] = mParentPlot->mAsyncFrameNumber; // pending asynchronous frames mustn't overwrite this buffer
+      mParentPlot->mPaintBufferComposite = QPixmap();
+      mParentPlot->update();
+    } else
+      qDebug() << Q_FUNC_INFO << "Couldn't activate painter on paint buffer of layer" << mName;
+  } else
+    mParentPlot->replot();
+}
+
+/*! \internal
+  
+  Draws all visible layerables of this layer with the provided \a painter, from bottom to top.
+  
+  \see QCustomPlot::draw
+*/
+void QCPLayer::draw(QCPPainter *painter)
+{
+  foreach (QCPLayerable *child, mChildren)
+  {
+    if (child->realVisibility())
+    {
+      painter->save();
+      painter->setClipRect(child->clipRect().translated(0, -1));
+      child->applyDefaultAntialiasingHint(painter);
+      child->draw(painter);
+      painter->restore();
+    }
+  }
+}
+
 /*! \internal
   
   Adds the \a layerable to the list of this layer. If \a prepend is set to true, the layerable will
@@ -43,8 +43,19 @@ class QCP_LIB_DECL QCPLayer : public QObject
   Q_PROPERTY(int index READ index)
   Q_PROPERTY(QList<QCPLayerable*> children READ children)
   Q_PROPERTY(bool visible READ visible WRITE setVisible)
+  Q_PROPERTY(LayerMode mode READ mode WRITE setMode)
   /// \endcond
 public:
+  /*!
+    Defines how a layer is rendered into the paint buffers of the parent QCustomPlot.
+    
+    \see setMode
+  */
+  enum LayerMode { lmLogical   ///< Layer is only used for the rendering order and shares its paint buffer with adjacent logical layers
+                   ,lmBuffered ///< Layer has its own paint buffer and can be replotted individually (see \ref replot)
+                 };
+  Q_ENUMS(LayerMode)
+  
   QCPLayer(QCustomPlot* parentPlot, const QString &layerName);
   ~QCPLayer();
   
@@ -54,9 +65,14 @@ public:
   int index() const { return mIndex; }
   QList<QCPLayerable*> children() const { return mChildren; }
   bool visible() const { return mVisible; }
+  LayerMode mode() const { return mMode; }
   
   // setters:
   void setVisible(bool visible);
+  void setMode(LayerMode mode);
+  
+  // non-property methods:
+  void replot();
   
 protected:
   // property members:
@@ -65,8 +81,13 @@ protected:
   int mIndex;
   QList<QCPLayerable*> mChildren;
   bool mVisible;
+  LayerMode mMode;
+  
+  // non-property members:
+  int mPaintBufferIndex;
   
   // non-virtual methods:
+  void draw(QCPPainter *painter);
   void addChild(QCPLayerable *layerable, bool prepend);
   void removeChild(QCPLayerable *layerable);
   
@@ -141,6 +162,7 @@ private:
   Q_DISABLE_COPY(QCPLayerable)
   
   friend class QCustomPlot;
+  friend class QCPLayer;
   friend class QCPAxisRect;
 };
 
@@ -242,6 +242,152 @@ void QCPPainter::makeNonCosmetic()
   }
 }
 
+/*!
+  Draws the polyline given by the \a pointCount points at \a points with the current pen. Points
+  with a NaN coordinate aren't drawn and split the polyline into separate polylines, which leaves
+  a gap.
+  
+  If the painter paints aliased lines of one pixel width with a solid, opaque pen into a QImage
+  (see \ref canRasterizePolylineDirectly), the lines are rasterized directly into the pixels of
+  the image by a \ref QCPPolylineRasterizer, which bypasses the QPainter stroking machinery and
+  produces the same pixels as QPainter::drawPolyline. Otherwise, each polyline is passed to
+  QPainter::drawPolyline.
+*/
+void QCPPainter::drawPolylineWithGaps(const QPointF *points, int pointCount)
+{
+  QRect clipRect;
+  QPointF offset;
+  QCPPolylineRasterizer *rasterizer = 0;
+  if (QImage *image = directRasterImage(pointCount, &clipRect, &offset))
+    rasterizer = new QCPPolylineRasterizer(image, clipRect, pen().color().rgba(), pen().capStyle() != Qt::FlatCap);
+  
+  int segmentStart = 0;
+  for (int i=0; i<=pointCount; ++i)
+  {
+    if (i == pointCount || qIsNaN(points[i].x()) || qIsNaN(points[i].y())) // NaNs create a gap in the line
+    {
+      if (rasterizer)
+        rasterizer->drawPolyline(points+segmentStart, i-segmentStart, offset);
+      else
+        QPainter::drawPolyline(points+segmentStart, i-segmentStart);
+      segmentStart = i+1;
+    }
+  }
+  delete rasterizer;
+}
+
+/*!
+  Draws \a pixmap with its top left corner at \a point. If the \ref pmNoPixmaps mode is set, the
+  pixmap is converted to a QImage and drawn with QPainter::drawImage instead.
+  
+  QCustomPlot uses this function instead of QPainter::drawPixmap for all pixmaps that may be
+  drawn during an asynchronous replot (see \ref QCustomPlot::setAsyncReplot). Custom layerables
+  that draw pixmaps should do the same.
+  */
+void QCPPainter::drawPixmapOrImage(const QPointF &point, const QPixmap &pixmap)
+{
+  if (mModes.testFlag(pmNoPixmaps))
+    drawImage(point, pixmap.toImage());
+  else
+    QPainter::drawPixmap(point, pixmap);
+}
+
+/*! \overload
+  
+  Draws the part \a source of \a pixmap with its top left corner at \a point. If the \ref
+  pmNoPixmaps mode is set, the pixmap is converted to a QImage and drawn with QPainter::drawImage
+  instead.
+  */
+void QCPPainter::drawPixmapOrImage(const QPointF &point, const QPixmap &pixmap, const QRectF &source)
+{
+  if (mModes.testFlag(pmNoPixmaps))
+    drawImage(point, pixmap.toImage(), source);
+  else
+    QPainter::drawPixmap(point, pixmap, source);
+}
+
+/*! \overload
+  
+  Draws \a pixmap scaled into the rectangle \a target. If the \ref pmNoPixmaps mode is set, the
+  pixmap is converted to a QImage and drawn with QPainter::drawImage instead.
+  */
+void QCPPainter::drawPixmapOrImage(const QRectF &target, const QPixmap &pixmap)
+{
+  if (mModes.testFlag(pmNoPixmaps))
+    drawImage(target, pixmap.toImage());
+  else
+    QPainter::drawPixmap(target, pixmap, QRectF());
+}
+
+/*!
+  Returns whether \ref drawPolylineWithGaps can rasterize a polyline with \a pointCount points
+  directly into the paint device, with the current painter state.
+  
+  This is the case if the painter is active on a QImage of a 32 bit RGB format, the pen is a solid,
+  opaque pen with a width of zero or one pixel, antialiasing is disabled, the painter transform is
+  at most a translation, the clipping (if any) is a single rectangle and the composition mode is
+  QPainter::CompositionMode_SourceOver with full painter opacity. Since the exact rasterization
+  rules of the raster engine changed with Qt5, direct rasterization is only used with Qt5.
+*/
+bool QCPPainter::canRasterizePolylineDirectly(int pointCount) const
+{
+  QRect clipRect;
+  QPointF offset;
+  return directRasterImage(pointCount, &clipRect, &offset) != 0;
+}
+
+/*! \internal
+  
+  If polylines with \a pointCount points can be rasterized directly (see \ref
+  canRasterizePolylineDirectly), returns the image the painter is active on, and sets \a clipRect
+  to the rect pixels may be drawn in and \a offset to the translation of the painter, both in
+  device coordinates. Otherwise returns 0.
+*/
+QImage *QCPPainter::directRasterImage(int pointCount, QRect *clipRect, QPointF *offset) const
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+  Q_UNUSED(pointCount)
+  Q_UNUSED(clipRect)
+  Q_UNUSED(offset)
+  return 0;
+#else
+  if (!isActive() || !device() || device()->devType() != QInternal::Image)
+    return 0;
+  if (pointCount > 0xffff) // the raster engine strokes longer polylines via a generic path
+    return 0;
+  if (testRenderHint(QPainter::Antialiasing) || testRenderHint(QPainter::Qt4CompatiblePainting))
+    return 0;
+  if (compositionMode() != QPainter::CompositionMode_SourceOver || opacity() != 1.0)
+    return 0;
+  const QPen &currentPen = pen();
+  if (currentPen.style() != Qt::SolidLine || currentPen.brush().style() != Qt::SolidPattern || currentPen.color().alpha() != 255)
+    return 0;
+  if (currentPen.widthF() != 0 && currentPen.widthF() != 1)
+    return 0;
+  const QTransform transform = deviceTransform();
+  if (transform.type() > QTransform::TxTranslate)
+    return 0;
+  
+  QImage *image = static_cast<QImage*>(device());
+  if (image->format() != QImage::Format_ARGB32_Premultiplied && image->format() != QImage::Format_ARGB32 && image->format() != QImage::Format_RGB32)
+    return 0;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 1, 0)
+  if (image->devicePixelRatio() != 1)
+    return 0;
+#endif
+  *clipRect = image->rect();
+  if (hasClipping())
+  {
+    const QRegion region = clipRegion();
+    if (region.rectCount() > 1)
+      return 0;
+    *clipRect &= region.boundingRect().translated(qRound(transform.dx()), qRound(transform.dy()));
+  }
+  *offset = QPointF(transform.dx(), transform.dy());
+  return image;
+#endif
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPScatterStyle
@@ -442,6 +588,7 @@ QCPScatterStyle::QCPScatterStyle(const QPainterPath &customPath, const QPen &pen
 void QCPScatterStyle::setSize(double size)
 {
   mSize = size;
+  mSpriteCache.clear();
 }
 
 /*!
@@ -455,6 +602,7 @@ void QCPScatterStyle::setSize(double size)
 void QCPScatterStyle::setShape(QCPScatterStyle::ScatterShape shape)
 {
   mShape = shape;
+  mSpriteCache.clear();
 }
 
 /*!
@@ -504,6 +652,7 @@ void QCPScatterStyle::setCustomPath(const QPainterPath &customPath)
 {
   setShape(ssCustom);
   mCustomPath = customPath;
+  mSpriteCache.clear();
 }
 
 /*!
@@ -646,7 +795,7 @@ void QCPScatterStyle::drawShape(QCPPainter *painter, double x, double y) const
     }
     case ssPixmap:
     {
-      painter->drawPixmap(x-mPixmap.width()*0.5, y-mPixmap.height()*0.5, mPixmap);
+      painter->drawPixmapOrImage(x-mPixmap.width()*0.5, y-mPixmap.height()*0.5, mPixmap);
       break;
     }
     case ssCustom:
@@ -661,4 +810,529 @@ void QCPScatterStyle::drawShape(QCPPainter *painter, double x, double y) const
   }
 }
 
+/*!
+  Draws the scatter shape with \a painter at all \a positions. Positions with NaN coordinates are
+  skipped.
+  
+  Like \ref drawShape, this function does not modify the pen or the brush on the painter, so \ref
+  applyTo should be called before.
+  
+  If \a useSprites is true and the painter draws to a pixel-based device with at most a translation,
+  the scatter shape is only rendered once with the current pen, brush and antialiasing of \a painter
+  into a small image (sprite), which is then drawn at every position. Sprites are rendered for four
+  sub-pixel offsets in each direction, so the scatter positions are effectively rounded to a quarter
+  pixel. For many scatter points, this is much faster than painting each shape separately. Positions
+  on the quarter pixel grid look exactly like directly painted shapes. Other positions may appear
+  shifted by up to an eighth of a pixel with antialiasing, and by up to one pixel without
+  antialiasing, because the aliased rasterization may round the quantized position differently than
+  the exact one. The sprites are reused for subsequent calls, as long as pen, brush and antialiasing
+  of \a painter don't change. Vectorized painters (\ref QCPPainter::pmVectorized) and painters that
+  shall not use caches (\ref QCPPainter::pmNoCaching) always draw the actual shapes.
+  
+  Plottables pass true as \a useSprites if the \ref QCP::phCacheScatters plotting hint is set,
+  which is off by default.
+  
+  \see drawShape
+*/
+void QCPScatterStyle::drawShapes(QCPPainter *painter, const QVector<QPointF> &positions, bool useSprites) const
+{
+  if (useSprites && prepareSprites(painter))
+  {
+    const int subPixelSteps = 4;
+    // positions are quantized in device coordinates, without the antialiasing shift which the sprites contain themselves:
+    const QTransform transform = painter->deviceTransform();
+    const double dx = transform.dx();
+    const double dy = transform.dy();
+    const double shift = mSpriteCache->antialiasing ? 0.5 : 0;
+    const int radius = mSpriteCache->radius;
+    for (int i=0; i<positions.size(); ++i)
+    {
+      const QPointF &pos = positions.at(i);
+      if (qIsNaN(pos.x()) || qIsNaN(pos.y()))
+        continue;
+      const double deviceX = pos.x()+dx-shift;
+      const double deviceY = pos.y()+dy-shift;
+      int pixelX = qFloor(deviceX);
+      int pixelY = qFloor(deviceY);
+      int subPixelX = qRound((deviceX-pixelX)*subPixelSteps);
+      int subPixelY = qRound((deviceY-pixelY)*subPixelSteps);
+      if (subPixelX == subPixelSteps)
+      {
+        ++pixelX;
+        subPixelX = 0;
+      }
+      if (subPixelY == subPixelSteps)
+      {
+        ++pixelY;
+        subPixelY = 0;
+      }
+      QImage &sprite = mSpriteCache->sprites[subPixelY*subPixelSteps+subPixelX];
+      if (sprite.isNull())
+        sprite = createSprite(subPixelX/(double)subPixelSteps, subPixelY/(double)subPixelSteps);
+      painter->drawImage(QPointF(pixelX-radius-dx, pixelY-radius-dy), sprite);
+    }
+  } else
+  {
+    for (int i=0; i<positions.size(); ++i)
+    {
+      const QPointF &pos = positions.at(i);
+      if (!qIsNaN(pos.x()) && !qIsNaN(pos.y()))
+        drawShape(painter, pos.x(), pos.y());
+    }
+  }
+}
+
+/*! \internal
+  
+  Checks whether the scatter shape may be drawn as sprites with the current state of \a painter
+  (see \ref drawShapes), and makes sure \ref mSpriteCache holds sprites for the pen, brush and
+  antialiasing of \a painter. Sprites that were created for a different painter state are
+  discarded.
+  
+  Returns false if the shape must be painted directly.
+*/
+bool QCPScatterStyle::prepareSprites(QCPPainter *painter) const
+{
+  if (mShape == ssNone || mShape == ssPixmap) // pixmaps are drawn as images anyway
+    return false;
+  if (painter->modes().testFlag(QCPPainter::pmVectorized) || painter->modes().testFlag(QCPPainter::pmNoCaching))
+    return false;
+  if (painter->compositionMode() != QPainter::CompositionMode_SourceOver || painter->opacity() != 1.0) // overlapping strokes of a shape would blend differently
+    return false;
+  if (painter->deviceTransform().type() > QTransform::TxTranslate)
+    return false;
+  const QPen pen = painter->pen();
+  const QBrush brush = painter->brush();
+  // brushes with patterns or gradients depend on the absolute position:
+  if (pen.style() != Qt::NoPen && pen.brush().style() != Qt::SolidPattern)
+    return false;
+  if (brush.style() != Qt::NoBrush && brush.style() != Qt::SolidPattern)
+    return false;
+  
+  const bool antialiasing = painter->antialiasing();
+  if (!mSpriteCache || mSpriteCache->pen != pen || mSpriteCache->brush != brush || mSpriteCache->antialiasing != antialiasing)
+  {
+    // determine the distance from the scatter position that the shape may cover, including the pen width and antialiasing fringe:
+    double extent = mSize/2.0;
+    if (mShape == ssDot)
+      extent = 0;
+    else if (mShape == ssCustom)
+    {
+      const QRectF pathBounds = mCustomPath.boundingRect();
+      extent = qMax(qMax(qAbs(pathBounds.left()), qAbs(pathBounds.right())), qMax(qAbs(pathBounds.top()), qAbs(pathBounds.bottom())))*qAbs(mSize)/6.0;
+    }
+    const double penWidth = pen.style() == Qt::NoPen ? 0 : qMax(1.0, pen.widthF());
+    const double radius = extent+penWidth+1;
+    if (radius > 64) // large shapes aren't worth the memory of the sprites
+      return false;
+    // sprites may be shared with copies of this scatter style, so create new sprites instead of modifying them:
+    mSpriteCache = QSharedPointer<SpriteCache>(new SpriteCache);
+    mSpriteCache->pen = pen;
+    mSpriteCache->brush = brush;
+    mSpriteCache->antialiasing = antialiasing;
+    mSpriteCache->radius = qCeil(radius);
+    mSpriteCache->sprites.resize(4*4);
+  }
+  return true;
+}
+
+/*! \internal
+  
+  Renders the scatter shape into a new sprite image, using the pen, brush and antialiasing stored
+  in \ref mSpriteCache. The shape center is placed \a subPixelX and \a subPixelY pixels right and
+  below the sprite pixel at a distance of the sprite radius from the top left corner.
+  
+  \see drawShapes
+*/
+QImage QCPScatterStyle::createSprite(double subPixelX, double subPixelY) const
+{
+  const int radius = mSpriteCache->radius;
+  QImage sprite(2*radius+2, 2*radius+2, QImage::Format_ARGB32_Premultiplied);
+  sprite.fill(0);
+  QCPPainter spritePainter(&sprite);
+  spritePainter.setAntialiasing(mSpriteCache->antialiasing);
+  spritePainter.setPen(mSpriteCache->pen);
+  spritePainter.setBrush(mSpriteCache->brush);
+  drawShape(&spritePainter, radius+subPixelX, radius+subPixelY);
+  return sprite;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPPolylineRasterizer
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPPolylineRasterizer
+  
+  \internal
+  \brief (Private)
+  
+  This is a private class and not part of the public QCustomPlot interface.
+  
+  It draws aliased polylines of one pixel width directly into the pixels of a 32 bit QImage, and
+  is used by \ref QCPPainter::drawPolylineWithGaps. For long polylines like the lines of graphs
+  with many data points, this is considerably faster than QPainter::drawPolyline, which has a
+  large overhead per call and per line segment.
+  
+  The rasterization follows the rules of the cosmetic stroker of Qt's raster paint engine, so the
+  result is identical to QPainter::drawPolyline with the same pen: Line segments are clipped to the
+  clip rect (or the image bounds, if there is no clipping) extended by about one pixel, because the
+  clipping determines the fixed point start positions of the walks. They are then walked along their
+  major axis in 26.6 fixed point coordinates, setting one pixel per row or column. Pen caps other
+  than Qt::FlatCap extend the polyline by half a pixel at both ends. At the joins, duplicated pixels
+  are skipped and missing pixels are inserted, depending on the directions of the adjacent segments.
+*/
+
+/*!
+  Creates a rasterizer that draws into \a image with the \a color, which must be opaque. Pixels
+  outside \a clipRect (in device coordinates) aren't drawn. Like the cosmetic stroker of Qt, the
+  line segments are clipped to \a clipRect extended by one pixel at the top left and two pixels at
+  the bottom right before they are walked. If \a drawCaps is true, the polylines are extended by
+  half a pixel at their ends, like with the pen cap styles Qt::SquareCap and Qt::RoundCap.
+*/
+QCPPolylineRasterizer::QCPPolylineRasterizer(QImage *image, const QRect &clipRect, QRgb color, bool drawCaps) :
+  mPixels(reinterpret_cast<uint*>(image->bits())),
+  mPixelsPerLine(image->bytesPerLine()/4),
+  mColor(color),
+  mDrawCaps(drawCaps),
+  mLastPixelX(std::numeric_limits<int>::min()),
+  mLastPixelY(std::numeric_limits<int>::min()),
+  mLastDirection(dNone),
+  mLastAxisAligned(false)
+{
+  const QRect clip = clipRect & image->rect();
+  mClipLeft = clip.left();
+  mClipTop = clip.top();
+  mClipRight = clip.right();
+  mClipBottom = clip.bottom();
+  mBoundsLeft = clip.left()-1;
+  mBoundsTop = clip.top()-1;
+  mBoundsRight = clip.right()+2;
+  mBoundsBottom = clip.bottom()+2;
+}
+
+/*!
+  Draws the polyline given by the \a pointCount points at \a points, translated by \a offset. The
+  points must not contain NaN coordinates.
+*/
+void QCPPolylineRasterizer::drawPolyline(const QPointF *points, int pointCount, const QPointF &offset)
+{
+  if (pointCount < 2)
+    return;
+  mLastPixelX = std::numeric_limits<int>::min();
+  mLastPixelY = std::numeric_limits<int>::min();
+  mLastDirection = dNone;
+  mLastAxisAligned = false;
+  
+  double startX = points[0].x()+offset.x();
+  double startY = points[0].y()+offset.y();
+  int caps = mDrawCaps ? cBegin : cNone;
+  for (int i=1; i<pointCount; ++i)
+  {
+    const double endX = points[i].x()+offset.x();
+    const double endY = points[i].y()+offset.y();
+    if (mDrawCaps && i == pointCount-1)
+      caps |= cEnd;
+    // segments that didn't set a pixel are merged with the next segment, so sequences of very short segments don't leave gaps:
+    if (drawLine(startX, startY, endX, endY, caps))
+    {
+      startX = endX;
+      startY = endY;
+    }
+    caps = cNone;
+  }
+}
+
+/*! \internal
+  
+  Clips the line from (\a x1, \a y1) to (\a x2, \a y2) to the image bounds extended by about one
+  pixel. Returns true if the line lies completely outside. The clipping only serves to keep the
+  coordinates in the range of the fixed point arithmetic, the exact pixel clipping is done in \ref
+  drawPixel.
+*/
+bool QCPPolylineRasterizer::clipLine(double &x1, double &y1, double &x2, double &y2)
+{
+  if (x1 < mBoundsLeft)
+  {
+    if (x2 <= mBoundsLeft)
+    {
+      mLastPixelX = std::numeric_limits<int>::min();
+      return true;
+    }
+    y1 += (y2-y1)/(x2-x1)*(mBoundsLeft-x1);
+    x1 = mBoundsLeft;
+  } else if (x1 > mBoundsRight)
+  {
+    if (x2 >= mBoundsRight)
+    {
+      mLastPixelX = std::numeric_limits<int>::min();
+      return true;
+    }
+    y1 += (y2-y1)/(x2-x1)*(mBoundsRight-x1);
+    x1 = mBoundsRight;
+  }
+  if (x2 < mBoundsLeft)
+  {
+    mLastPixelX = std::numeric_limits<int>::min();
+    y2 += (y2-y1)/(x2-x1)*(mBoundsLeft-x2);
+    x2 = mBoundsLeft;
+  } else if (x2 > mBoundsRight)
+  {
+    mLastPixelX = std::numeric_limits<int>::min();
+    y2 += (y2-y1)/(x2-x1)*(mBoundsRight-x2);
+    x2 = mBoundsRight;
+  }
+  
+  if (y1 < mBoundsTop)
+  {
+    if (y2 <= mBoundsTop)
+    {
+      mLastPixelX = std::numeric_limits<int>::min();
+      return true;
+    }
+    x1 += (x2-x1)/(y2-y1)*(mBoundsTop-y1);
+    y1 = mBoundsTop;
+  } else if (y1 > mBoundsBottom)
+  {
+    if (y2 >= mBoundsBottom)
+    {
+      mLastPixelX = std::numeric_limits<int>::min();
+      return true;
+    }
+    x1 += (x2-x1)/(y2-y1)*(mBoundsBottom-y1);
+    y1 = mBoundsBottom;
+  }
+  if (y2 < mBoundsTop)
+  {
+    mLastPixelX = std::numeric_limits<int>::min();
+    x2 += (x2-x1)/(y2-y1)*(mBoundsTop-y2);
+    y2 = mBoundsTop;
+  } else if (y2 > mBoundsBottom)
+  {
+    mLastPixelX = std::numeric_limits<int>::min();
+    x2 += (x2-x1)/(y2-y1)*(mBoundsBottom-y2);
+    y2 = mBoundsBottom;
+  }
+  return false;
+}
+
+/*! \internal
+  
+  Draws one segment of a polyline from (\a rx1, \a ry1) to (\a rx2, \a ry2). \a caps is an or
+  combination of \ref Cap values and defines which ends of the segment are extended by half a
+  pixel. The last pixel and direction of the previous segment are used to avoid duplicated and
+  missing pixels at the join.
+  
+  Returns true if the segment set pixels or was clipped away completely, and false if the segment
+  was too short to set any pixel. In the latter case, the caller merges it with the next segment.
+*/
+bool QCPPolylineRasterizer::drawLine(double rx1, double ry1, double rx2, double ry2, int caps)
+{
+  if (clipLine(rx1, ry1, rx2, ry2))
+    return true;
+  
+  // convert to 26.6 fixed point, truncating like the raster engine:
+  int x1 = int(rx1*64.0);
+  int y1 = int(ry1*64.0);
+  int x2 = int(rx2*64.0);
+  int y2 = int(ry2*64.0);
+  const int dx = qAbs(x2-x1);
+  const int dy = qAbs(y2-y1);
+  
+  int lastX = mLastPixelX;
+  int lastY = mLastPixelY;
+  bool didDraw = false;
+  if (dx < dy) // steep segment, set one pixel per row
+  {
+    int direction = dTopToBottom;
+    bool swapped = false;
+    if (y1 > y2)
+    {
+      swapped = true;
+      qSwap(y1, y2);
+      qSwap(x1, x2);
+      caps = swapCaps(caps);
+      direction = dBottomToTop;
+    }
+    const int xinc = fixedDiv(x2-x1, y2-y1); // 16.16 fixed point
+    int x = x1*(1<<10); // 26.6 to 16.16 fixed point
+    if ((mLastDirection ^ dVerticalMask) == direction) // the polyline reverses its direction, so the join needs a cap
+      caps |= swapped ? cEnd : cBegin;
+    if (caps & cBegin)
+    {
+      y1 -= 32;
+      x -= xinc >> 1;
+    }
+    if (caps & cEnd)
+      y2 += 32;
+    
+    int y = (y1+32) >> 6;
+    int ys = (y2+32) >> 6;
+    const int round = xinc > 0 ? 32 : 0;
+    if (y != ys)
+    {
+      x += ((y*(1<<6))+round-y1)*xinc >> 6;
+      
+      // first and last pixel of the segment in drawing order, for the handling of the joins:
+      int firstX = x >> 16;
+      int firstY = y;
+      lastX = (x+(ys-y-1)*xinc) >> 16;
+      lastY = ys-1;
+      if (swapped)
+      {
+        qSwap(firstX, lastX);
+        qSwap(firstY, lastY);
+      }
+      const bool axisAligned = qAbs(xinc) < (1<<14);
+      if (mLastPixelX > std::numeric_limits<int>::min())
+      {
+        if (firstX == mLastPixelX && firstY == mLastPixelY) // skip duplicated pixel
+        {
+          if (swapped)
+            --ys;
+          else
+          {
+            ++y;
+            x += xinc;
+          }
+        } else if (mLastDirection != direction &&
+                   ((axisAligned && mLastAxisAligned && mLastPixelX != firstX && mLastPixelY != firstY) ||
+                    qAbs(mLastPixelX-firstX) > 1 || qAbs(mLastPixelY-firstY) > 1)) // insert missing pixel
+        {
+          if (swapped)
+            ++ys;
+          else
+          {
+            --y;
+            x -= xinc;
+          }
+        } else if (mLastDirection == direction && qAbs(mLastPixelX-firstX) <= 1 && qAbs(mLastPixelY-firstY) > 1)
+        {
+          x += xinc >> 1;
+          if (swapped)
+            lastX = x >> 16;
+          else
+            lastX = (x+(ys-y-1)*xinc) >> 16;
+        }
+      }
+      mLastDirection = direction;
+      mLastAxisAligned = axisAligned;
+      
+      do
+      {
+        drawPixel(x >> 16, y);
+        x += xinc;
+      } while (++y < ys);
+      didDraw = true;
+    }
+  } else // flat segment, set one pixel per column
+  {
+    if (dx == 0)
+      return true;
+    
+    int direction = dLeftToRight;
+    bool swapped = false;
+    if (x1 > x2)
+    {
+      swapped = true;
+      qSwap(x1, x2);
+      qSwap(y1, y2);
+      caps = swapCaps(caps);
+      direction = dRightToLeft;
+    }
+    const int yinc = fixedDiv(y2-y1, x2-x1); // 16.16 fixed point
+    int y = y1*(1<<10); // 26.6 to 16.16 fixed point
+    if ((mLastDirection ^ dHorizontalMask) == direction) // the polyline reverses its direction, so the join needs a cap
+      caps |= swapped ? cEnd : cBegin;
+    if (caps & cBegin)
+    {
+      x1 -= 32;
+      y -= yinc >> 1;
+    }
+    if (caps & cEnd)
+      x2 += 32;
+    
+    int x = (x1+32) >> 6;
+    int xs = (x2+32) >> 6;
+    const int round = yinc > 0 ? 32 : 0;
+    if (x != xs)
+    {
+      y += ((x*(1<<6))+round-x1)*yinc >> 6;
+      
+      // first and last pixel of the segment in drawing order, for the handling of the joins:
+      int firstX = x;
+      int firstY = y >> 16;
+      lastX = xs-1;
+      lastY = (y+(xs-x-1)*yinc) >> 16;
+      if (swapped)
+      {
+        qSwap(firstX, lastX);
+        qSwap(firstY, lastY);
+      }
+      const bool axisAligned = qAbs(yinc) < (1<<14);
+      if (mLastPixelX > std::numeric_limits<int>::min())
+      {
+        if (firstX == mLastPixelX && firstY == mLastPixelY) // skip duplicated pixel
+        {
+          if (swapped)
+            --xs;
+          else
+          {
+            ++x;
+            y += yinc;
+          }
+        } else if (mLastDirection != direction &&
+                   ((axisAligned && mLastAxisAligned && mLastPixelX != firstX && mLastPixelY != firstY) ||
+                    qAbs(mLastPixelX-firstX) > 1 || qAbs(mLastPixelY-firstY) > 1)) // insert missing pixel
+        {
+          if (swapped)
+            ++xs;
+          else
+          {
+            --x;
+            y -= yinc;
+          }
+        } else if (mLastDirection == direction && qAbs(mLastPixelX-firstX) > 1 && qAbs(mLastPixelY-firstY) <= 1)
+        {
+          y += yinc >> 1;
+          if (swapped)
+            lastY = y >> 16;
+          else
+            lastY = (y+(xs-x-1)*yinc) >> 16;
+        }
+      }
+      mLastDirection = direction;
+      mLastAxisAligned = axisAligned;
+      
+      do
+      {
+        drawPixel(x, y >> 16);
+        y += yinc;
+      } while (++x < xs);
+      didDraw = true;
+    }
+  }
+  mLastPixelX = lastX;
+  mLastPixelY = lastY;
+  return didDraw;
+}
+
+/*! \internal
+  
+  Divides the 26.6 fixed point numbers \a x and \a y and returns the result in 16.16 fixed point.
+*/
+int QCPPolylineRasterizer::fixedDiv(int x, int y)
+{
+  if (qAbs(x) > 0x7fff)
+    return int(qint64(x)*(1<<16)/y);
+  return x*(1<<16)/y;
+}
 
+/*! \internal
+  
+  Returns the \ref Cap combination \a caps for the reversed direction of a line segment.
+*/
+int QCPPolylineRasterizer::swapCaps(int caps)
+{
+  return ((caps & cBegin) << 1) | ((caps & cEnd) >> 1);
+}
@@ -92,8 +92,18 @@ public:
   void applyTo(QCPPainter *painter, const QPen &defaultPen) const;
   void drawShape(QCPPainter *painter, QPointF pos) const;
   void drawShape(QCPPainter *painter, double x, double y) const;
+  void drawShapes(QCPPainter *painter, const QVector<QPointF> &positions, bool useSprites) const;
 
 protected:
+  struct SpriteCache
+  {
+    QPen pen;
+    QBrush brush;
+    bool antialiasing;
+    int radius;
+    QVector<QImage> sprites;
+  };
+  
   // property members:
   double mSize;
   ScatterShape mShape;
@@ -104,6 +114,11 @@ protected:
   
   // non-property members:
   bool mPenDefined;
+  mutable QSharedPointer<SpriteCache> mSpriteCache;
+  
+  // non-virtual methods:
+  bool prepareSprites(QCPPainter *painter) const;
+  QImage createSprite(double subPixelX, double subPixelY) const;
 };
 Q_DECLARE_TYPEINFO(QCPScatterStyle, Q_MOVABLE_TYPE);
 
@@ -120,6 +135,7 @@ public:
                      ,pmVectorized   = 0x01   ///< <tt>0x01</tt> Mode for vectorized painting (e.g. PDF export). For example, this prevents some antialiasing fixes.
                      ,pmNoCaching    = 0x02   ///< <tt>0x02</tt> Mode for all sorts of exports (e.g. PNG, PDF,...). For example, this prevents using cached pixmap labels
                      ,pmNonCosmetic  = 0x04   ///< <tt>0x04</tt> Turns pen widths 0 to 1, i.e. disables cosmetic pens. (A cosmetic pen is always drawn with width 1 pixel in the vector image/pdf viewer, independent of zoom.)
+                     ,pmNoPixmaps    = 0x08   ///< <tt>0x08</tt> Makes \ref drawPixmapOrImage draw pixmaps as QImages, so the painting may be recorded into a QPicture that is replayed outside the GUI thread (see \ref QCustomPlot::setAsyncReplot)
                    };
   Q_FLAGS(PainterMode PainterModes)
   Q_DECLARE_FLAGS(PainterModes, PainterMode)
@@ -149,6 +165,12 @@ public:
   
   // non-virtual methods:
   void makeNonCosmetic();
+  void drawPolylineWithGaps(const QPointF *points, int pointCount);
+  void drawPixmapOrImage(const QPointF &point, const QPixmap &pixmap);
+  void drawPixmapOrImage(const QPointF &point, const QPixmap &pixmap, const QRectF &source);
+  void drawPixmapOrImage(const QRectF &target, const QPixmap &pixmap);
+  void drawPixmapOrImage(int x, int y, const QPixmap &pixmap) {drawPixmapOrImage(QPointF(x, y), pixmap);}
+  bool canRasterizePolylineDirectly(int pointCount) const;
   
 protected:
   // property members:
@@ -157,7 +179,59 @@ protected:
   
   // non-property members:
   QStack<bool> mAntialiasingStack;
+  
+  // non-virtual methods:
+  QImage *directRasterImage(int pointCount, QRect *clipRect, QPointF *offset) const;
 };
 Q_DECLARE_OPERATORS_FOR_FLAGS(QCPPainter::PainterModes)
 
+
+class QCP_LIB_DECL QCPPolylineRasterizer
+{
+public:
+  QCPPolylineRasterizer(QImage *image, const QRect &clipRect, QRgb color, bool drawCaps);
+  
+  // non-virtual methods:
+  void drawPolyline(const QPointF *points, int pointCount, const QPointF &offset=QPointF());
+  
+protected:
+  /*!
+    Defines the direction in which a line segment was traversed, used to handle the joins between
+    the segments of a polyline.
+  */
+  enum Direction { dNone           = 0x0
+                   ,dTopToBottom   = 0x1
+                   ,dBottomToTop   = 0x2
+                   ,dLeftToRight   = 0x4
+                   ,dRightToLeft   = 0x8
+                   ,dVerticalMask  = 0x3
+                   ,dHorizontalMask = 0xc
+                 };
+  /*!
+    Defines at which ends a line segment is extended by half a pixel.
+  */
+  enum Cap { cNone    = 0x0
+             ,cBegin  = 0x1
+             ,cEnd    = 0x2
+           };
+  
+  // non-property members:
+  uint *mPixels;
+  int mPixelsPerLine;
+  int mClipLeft, mClipTop, mClipRight, mClipBottom;
+  double mBoundsLeft, mBoundsTop, mBoundsRight, mBoundsBottom;
+  uint mColor;
+  bool mDrawCaps;
+  int mLastPixelX, mLastPixelY;
+  int mLastDirection;
+  bool mLastAxisAligned;
+  
+  // non-virtual methods:
+  bool clipLine(double &x1, double &y1, double &x2, double &y2);
+  bool drawLine(double x1, double y1, double x2, double y2, int caps);
+  void drawPixel(int x, int y) { if (x >= mClipLeft && x <= mClipRight && y >= mClipTop && y <= mClipBottom) mPixels[y*mPixelsPerLine+x] = mColor; }
+  static int fixedDiv(int x, int y);
+  static int swapCaps(int caps);
+};
+
 #endif // QCP_PAINTER_H
@@ -31,6 +31,49 @@
 #include "layoutelements/layoutelement-axisrect.h"
 #include "layoutelements/layoutelement-legend.h"
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataPoint
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDataPoint
+  \brief Describes a data point of a plottable, as found by \ref QCPAbstractPlottable::nearestDataPoint
+  
+  \a index is the position of the data point in the data container of the plottable, \a key and \a
+  value are its coordinates, and \a distance is its distance in pixels to the queried position.
+  What the value and the distance refer to depends on the plottable type, see the reimplementations
+  of \ref QCPAbstractPlottable::findNearestDataPoint.
+  
+  If no data point was found, \a index is -1 and \ref isValid returns false.
+*/
+
+/*! \fn bool QCPDataPoint::isValid() const
+  
+  Returns whether this describes a found data point.
+*/
+
+/*!
+  Constructs an invalid data point, i.e. with index -1.
+*/
+QCPDataPoint::QCPDataPoint() :
+  index(-1),
+  key(0),
+  value(0),
+  distance(-1)
+{
+}
+
+/*!
+  Constructs a data point with the specified \a index, \a key, \a value and \a distance.
+*/
+QCPDataPoint::QCPDataPoint(int index, double key, double value, double distance) :
+  index(index),
+  key(key),
+  value(value),
+  distance(distance)
+{
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPAbstractPlottable
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -195,7 +238,9 @@ QCPAbstractPlottable::QCPAbstractPlottable(QCPAxis *keyAxis, QCPAxis *valueAxis)
   mKeyAxis(keyAxis),
   mValueAxis(valueAxis),
   mSelectable(true),
-  mSelected(false)
+  mSelected(false),
+  mRangeCacheRevision(0),
+  mDrawPrepared(false)
 {
   if (keyAxis->parentPlot() != valueAxis->parentPlot())
     qDebug() << Q_FUNC_INFO << "Parent plot of keyAxis is not the same as that of valueAxis.";
@@ -437,31 +482,65 @@ void QCPAbstractPlottable::rescaleValueAxis(bool onlyEnlarge) const
   QCPAxis *valueAxis = mValueAxis.data();
   if (!valueAxis) { qDebug() << Q_FUNC_INFO << "invalid value axis"; return; }
   
-  SignDomain signDomain = sdBoth;
-  if (valueAxis->scaleType() == QCPAxis::stLogarithmic)
-    signDomain = (valueAxis->range().upper < 0 ? sdNegative : sdPositive);
+  bool foundRange;
+  QCPRange newRange = getValueRange(foundRange, valueSignDomain());
+  if (foundRange)
+    applyValueAxisRange(newRange, onlyEnlarge);
+}
+
+/*!
+  Rescales the value axis of the plottable so the part of the plottable inside the current range of
+  the key axis is visible. This is useful to automatically fit the value axis to the data while the
+  user drags or zooms the key axis.
+  
+  How the value range inside the key range is determined depends on the plottable type, see \ref
+  getValueRangeInKeyRange. For example, QCPGraph with an enabled min/max pyramid (\ref
+  QCPGraph::setMinMaxPyramid) determines it in logarithmic time, so this function may be called on
+  every frame of a drag operation, even for large data sets.
+  
+  See \ref rescaleAxes for detailed behaviour.
+*/
+void QCPAbstractPlottable::rescaleValueAxisInKeyRange(bool onlyEnlarge) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
   
   bool foundRange;
-  QCPRange newRange = getValueRange(foundRange, signDomain);
+  QCPRange newRange = getValueRangeInKeyRange(foundRange, valueSignDomain(), keyAxis->range());
   if (foundRange)
-  {
-    if (onlyEnlarge)
-      newRange.expand(valueAxis->range());
-    if (!QCPRange::validRange(newRange)) // likely due to range being zero (plottable has only constant data in this axis dimension), shift current range to at least center the plottable
-    {
-      double center = (newRange.lower+newRange.upper)*0.5; // upper and lower should be equal anyway, but just to make sure, incase validRange returned false for other reason
-      if (valueAxis->scaleType() == QCPAxis::stLinear)
-      {
-        newRange.lower = center-valueAxis->range().size()/2.0;
-        newRange.upper = center+valueAxis->range().size()/2.0;
-      } else // scaleType() == stLogarithmic
-      {
-        newRange.lower = center/qSqrt(valueAxis->range().upper/valueAxis->range().lower);
-        newRange.upper = center*qSqrt(valueAxis->range().upper/valueAxis->range().lower);
-      }
-    }
-    valueAxis->setRange(newRange);
-  }
+    applyValueAxisRange(newRange, onlyEnlarge);
+}
+
+/*!
+  Returns the data point of this plottable which is nearest to the pixel position \a pixelPos, e.g.
+  to show a tooltip for the data point below the mouse cursor. If the plottable has no data
+  points, the returned QCPDataPoint is invalid (see \ref QCPDataPoint::isValid).
+  
+  Unlike \ref selectTest, this also considers data points outside the visible axis ranges, and
+  returns the found data point instead of just its distance. The plottables shipped with
+  QCustomPlot usually answer this query without examining every data point: QCPGraph, QCPBars and
+  QCPFinancial use binary searches on their sorted keys, QCPCurve uses a spatial index of its
+  points. Other plottables return an invalid data point. For QCPGraph with many data points per
+  pixel column, the search is only fast with an enabled min/max pyramid (see \ref
+  QCPGraph::setMinMaxPyramid).
+  
+  \see findNearestDataPoint
+*/
+QCPDataPoint QCPAbstractPlottable::nearestDataPoint(const QPointF &pixelPos) const
+{
+  return findNearestDataPoint(pixelPos, QCPRange(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()));
+}
+
+/*! \overload
+  
+  Only considers data points whose keys lie within \a keyWindow (inclusive). This is useful to
+  restrict hover tooltips to data points near the mouse cursor in the key dimension, e.g. by
+  passing a window of a few pixels around the key at the cursor position.
+*/
+QCPDataPoint QCPAbstractPlottable::nearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const
+{
+  return findNearestDataPoint(pixelPos, keyWindow);
 }
 
 /*!
@@ -723,6 +802,326 @@ double QCPAbstractPlottable::distSqrToLine(const QPointF &start, const QPointF &
     return (a-p).lengthSquared();
 }
 
+/*! \internal
+  
+  Finds the shortest squared distance of \a point to the (filled) rectangle \a rect, which is zero
+  if \a point lies inside. \a rect may have negative width or height.
+*/
+double QCPAbstractPlottable::distSqrToRect(const QRectF &rect, const QPointF &point) const
+{
+  const QRectF normalized = rect.normalized();
+  const double dx = qMax(0.0, qMax(normalized.left()-point.x(), point.x()-normalized.right()));
+  const double dy = qMax(0.0, qMax(normalized.top()-point.y(), point.y()-normalized.bottom()));
+  return dx*dx+dy*dy;
+}
+
+/*! \internal
+  
+  Returns the sign domain the value range of this plottable must be restricted to, so it can be
+  displayed on the value axis. This is \ref sdBoth for linear value axes, and the sign of the
+  current value axis range for logarithmic ones.
+  
+  \see rescaleValueAxis, rescaleValueAxisInKeyRange
+*/
+QCPAbstractPlottable::SignDomain QCPAbstractPlottable::valueSignDomain() const
+{
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (valueAxis && valueAxis->scaleType() == QCPAxis::stLogarithmic)
+    return (valueAxis->range().upper < 0 ? sdNegative : sdPositive);
+  return sdBoth;
+}
+
+/*! \internal
+  
+  Sets the range of the value axis to \a newRange, which is a value range found by \ref
+  rescaleValueAxis or \ref rescaleValueAxisInKeyRange. If \a onlyEnlarge is true, the current
+  value axis range is included. If \a newRange has zero size (e.g. because the data is constant),
+  the current range size is kept and the range is centered on the data.
+*/
+void QCPAbstractPlottable::applyValueAxisRange(QCPRange newRange, bool onlyEnlarge) const
+{
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!valueAxis) { qDebug() << Q_FUNC_INFO << "invalid value axis"; return; }
+  
+  if (onlyEnlarge)
+    newRange.expand(valueAxis->range());
+  if (!QCPRange::validRange(newRange)) // likely due to range being zero (plottable has only constant data in this axis dimension), shift current range to at least center the plottable
+  {
+    double center = (newRange.lower+newRange.upper)*0.5; // upper and lower should be equal anyway, but just to make sure, incase validRange returned false for other reason
+    if (valueAxis->scaleType() == QCPAxis::stLinear)
+    {
+      newRange.lower = center-valueAxis->range().size()/2.0;
+      newRange.upper = center+valueAxis->range().size()/2.0;
+    } else // scaleType() == stLogarithmic
+    {
+      newRange.lower = center/qSqrt(valueAxis->range().upper/valueAxis->range().lower);
+      newRange.upper = center*qSqrt(valueAxis->range().upper/valueAxis->range().lower);
+    }
+  }
+  valueAxis->setRange(newRange);
+}
+
+/*! \internal
+  
+  Returns the current state of the axes of this plottable, together with \a dataRevision, the
+  revision of its data container. Subclasses that cache pixel geometry (e.g. for \ref selectTest
+  or \ref findNearestDataPoint) store this state along with the geometry. The geometry is still
+  valid as long as a newly returned state compares equal to the stored one.
+*/
+QCPAbstractPlottable::HitTestState QCPAbstractPlottable::hitTestState(quint32 dataRevision) const
+{
+  HitTestState state;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (keyAxis && valueAxis)
+  {
+    state.axisRect = keyAxis->axisRect()->rect();
+    state.keyRange = keyAxis->range();
+    state.valueRange = valueAxis->range();
+    state.keyReversed = keyAxis->rangeReversed();
+    state.valueReversed = valueAxis->rangeReversed();
+    state.keyScaleType = keyAxis->scaleType();
+    state.valueScaleType = valueAxis->scaleType();
+  }
+  state.dataRevision = dataRevision;
+  return state;
+}
+
+/*! \internal
+  
+  Returns whether this state equals \a other, i.e. whether pixel geometry calculated for one state
+  is valid for the other.
+*/
+bool QCPAbstractPlottable::HitTestState::operator==(const HitTestState &other) const
+{
+  return axisRect == other.axisRect &&
+      keyRange == other.keyRange && valueRange == other.valueRange &&
+      keyReversed == other.keyReversed && valueReversed == other.valueReversed &&
+      keyScaleType == other.keyScaleType && valueScaleType == other.valueScaleType &&
+      dataRevision == other.dataRevision;
+}
+
+/*! \internal
+  
+  Returns the value range of the data points whose keys lie within \a inKeyRange, see \ref
+  getValueRange for the meaning of \a foundRange and \a inSignDomain. This is used by \ref
+  rescaleValueAxisInKeyRange.
+  
+  Plottables with data points at individual keys reimplement this method to only take the data
+  points inside \a inKeyRange into account. The default implementation only checks whether the key
+  range of the plottable (see \ref getKeyRange) intersects \a inKeyRange at all. If so, it returns
+  the value range of all data, otherwise \a foundRange is set to false. This is exact for
+  plottables whose value range doesn't depend on the key, like QCPColorMap, and for plottables
+  consisting of a single data point, like QCPStatisticalBox.
+*/
+QCPRange QCPAbstractPlottable::getValueRangeInKeyRange(bool &foundRange, SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+  bool foundKeyRange;
+  const QCPRange keyRange = getKeyRange(foundKeyRange);
+  if (!foundKeyRange || keyRange.upper < inKeyRange.lower || keyRange.lower > inKeyRange.upper)
+  {
+    foundRange = false;
+    return QCPRange();
+  }
+  return getValueRange(foundRange, inSignDomain);
+}
+
+/*! \internal
+  
+  Performs the CPU intensive part of the next \ref draw call ahead of time, e.g. the transformation
+  of the visible data to pixel coordinates, and stores the result until \ref draw consumes it.
+  
+  If the plotting hint \ref QCP::phParallelPreparation is set, \ref QCustomPlot::replot calls this
+  method for all visible plottables in parallel on the global thread pool (see \ref
+  QCPDrawPreparer), after the layout was updated and before the sequential painting starts. So
+  reimplementations may run concurrently to the preparation of other plottables, and must only
+  read the shared state of the plot (e.g. the axes), and only modify state owned by this
+  plottable. Painting and the creation of pixmaps is not allowed here.
+  
+  Reimplementations set \a mDrawPrepared to true when the result is stored. The default
+  implementation does nothing, so the whole work is done in \ref draw.
+  
+  \see clearPreparedDraw
+*/
+void QCPAbstractPlottable::prepareDraw()
+{
+}
+
+/*! \internal
+  
+  Discards the result of a \ref prepareDraw call that wasn't consumed by \ref draw, e.g. because
+  the layer of this plottable wasn't drawn. This is called by \ref QCustomPlot::replot for all
+  prepared plottables after painting, so a stale result is never used by a later draw call.
+  
+  Reimplementations release the stored data and call the base class implementation.
+*/
+void QCPAbstractPlottable::clearPreparedDraw()
+{
+  mDrawPrepared = false;
+}
+
+/*! \internal
+  
+  Returns the data point nearest to \a pixelPos among the data points with keys inside \a
+  keyWindow, see \ref nearestDataPoint. \a keyWindow may have infinite bounds.
+  
+  Reimplementations should avoid examining every data point, since this is typically called on
+  every mouse move. The default implementation returns an invalid data point.
+*/
+QCPDataPoint QCPAbstractPlottable::findNearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const
+{
+  Q_UNUSED(pixelPos)
+  Q_UNUSED(keyWindow)
+  return QCPDataPoint();
+}
+
+/*! \internal
+  
+  Returns the cached data bounds of this plottable in the key dimension (\a valueDimension false)
+  or value dimension (\a valueDimension true), for the sign domain \a inSignDomain, and with or
+  without error bars (\a includeErrors).
+  
+  Subclasses use this cache in their \ref getKeyRange and \ref getValueRange implementations, so
+  that e.g. \ref rescaleAxes doesn't need to scan all data points each time it is called: If the
+  returned entry isn't valid, they determine the bounds with \ref extendRange and mark the entry as
+  valid. When data is added, they call \ref extendRangeCache with the new data points, which
+  updates all valid entries in constant time. When single data points are removed, they may call
+  \ref shrinkRangeCache, which only invalidates the entries whose bounds the data points defined.
+  Any other modification of the data (e.g. removing ranges of data points) must call \ref
+  invalidateRangeCache, so the bounds are determined anew when they're needed the next time. If the
+  data container provides a revision number that changes with every modification (like \ref
+  QCPDataContainer::revision), subclasses may instead call \ref syncRangeCache before accessing the
+  cache, which detects all modifications, including the ones made directly on the container.
+  QMap based plottables like QCPBars don't detect modifications made via their data pointer, so
+  they provide a public method (e.g. \ref QCPBars::dataChanged) that invalidates the range cache.
+  
+  Only the bounds of the data itself should be cached. Parts of the range that depend on other
+  properties (e.g. the bar width of QCPBars) are added after reading the cache.
+*/
+QCPAbstractPlottable::RangeCache &QCPAbstractPlottable::rangeCache(bool valueDimension, SignDomain inSignDomain, bool includeErrors) const
+{
+  return mRangeCache[valueDimension ? 1 : 0][inSignDomain][includeErrors ? 1 : 0];
+}
+
+/*! \internal
+  
+  Marks all entries of the range cache as invalid.
+  
+  \see rangeCache
+*/
+void QCPAbstractPlottable::invalidateRangeCache() const
+{
+  for (int dimension=0; dimension<2; ++dimension)
+    for (int signDomain=0; signDomain<3; ++signDomain)
+      for (int errors=0; errors<2; ++errors)
+        mRangeCache[dimension][signDomain][errors].valid = false;
+}
+
+/*! \internal
+  
+  Invalidates the range cache if \a dataRevision differs from the data revision the cache was last
+  synchronized with, i.e. if the data was modified in the meantime. Afterwards, the cache is
+  considered to correspond to \a dataRevision.
+  
+  \see rangeCache
+*/
+void QCPAbstractPlottable::syncRangeCache(quint32 dataRevision) const
+{
+  if (mRangeCacheRevision != dataRevision)
+  {
+    invalidateRangeCache();
+    mRangeCacheRevision = dataRevision;
+  }
+}
+
+/*! \internal
+  
+  Extends all valid entries of the range cache in the key dimension (\a valueDimension false) or
+  value dimension (\a valueDimension true) by a newly added data point with the coordinate \a
+  current. \a errorMinus and \a errorPlus are only applied to the entries that include error bars.
+  
+  \see rangeCache
+*/
+void QCPAbstractPlottable::extendRangeCache(bool valueDimension, double current, double errorMinus, double errorPlus) const
+{
+  for (int signDomain=0; signDomain<3; ++signDomain)
+  {
+    RangeCache &withoutErrors = mRangeCache[valueDimension ? 1 : 0][signDomain][0];
+    if (withoutErrors.valid)
+      extendRange(withoutErrors, SignDomain(signDomain), current);
+    RangeCache &withErrors = mRangeCache[valueDimension ? 1 : 0][signDomain][1];
+    if (withErrors.valid)
+      extendRange(withErrors, SignDomain(signDomain), current, errorMinus, errorPlus);
+  }
+}
+
+/*! \internal
+  
+  Invalidates the valid entries of the range cache in the key dimension (\a valueDimension false)
+  or value dimension (\a valueDimension true) whose bounds may be determined by a removed data
+  point with the coordinate \a current and the error bars \a errorMinus and \a errorPlus. Entries
+  whose bounds lie beyond the removed data point stay valid. So removing data points that don't
+  define the bounds, e.g. when a circular buffer evicts old data points, doesn't require the bounds
+  to be determined anew from all data.
+  
+  \see rangeCache, extendRangeCache
+*/
+void QCPAbstractPlottable::shrinkRangeCache(bool valueDimension, double current, double errorMinus, double errorPlus) const
+{
+  for (int signDomain=0; signDomain<3; ++signDomain)
+  {
+    for (int errors=0; errors<2; ++errors)
+    {
+      RangeCache &cache = mRangeCache[valueDimension ? 1 : 0][signDomain][errors];
+      if (!cache.valid)
+        continue;
+      // with error bars, the data point coordinate itself may still define a bound (see extendRange):
+      const double lower = errors ? qMin(current-errorMinus, current) : current;
+      const double upper = errors ? qMax(current+errorPlus, current) : current;
+      if ((cache.haveLower && lower <= cache.range.lower) || (cache.haveUpper && upper >= cache.range.upper))
+        cache.valid = false;
+    }
+  }
+}
+
+/*! \internal
+  
+  Extends the bounds held by \a cache by the data point coordinate \a current with the error bars
+  \a errorMinus and \a errorPlus, taking into account only coordinates within \a inSignDomain. If
+  the error bars stretch beyond the sign domain, the data point coordinate itself is still taken
+  into account.
+  
+  \see rangeCache
+*/
+void QCPAbstractPlottable::extendRange(RangeCache &cache, SignDomain inSignDomain, double current, double errorMinus, double errorPlus)
+{
+  const double lower = current-errorMinus;
+  const double upper = current+errorPlus;
+  if ((lower < cache.range.lower || !cache.haveLower) && (inSignDomain == sdBoth || (inSignDomain == sdNegative && lower < 0) || (inSignDomain == sdPositive && lower > 0)))
+  {
+    cache.range.lower = lower;
+    cache.haveLower = true;
+  }
+  if ((upper > cache.range.upper || !cache.haveUpper) && (inSignDomain == sdBoth || (inSignDomain == sdNegative && upper < 0) || (inSignDomain == sdPositive && upper > 0)))
+  {
+    cache.range.upper = upper;
+    cache.haveUpper = true;
+  }
+  if (inSignDomain != sdBoth) // in case point is in valid sign domain but error bars stretch beyond it, we still want to get that point
+  {
+    if ((current < cache.range.lower || !cache.haveLower) && ((inSignDomain == sdNegative && current < 0) || (inSignDomain == sdPositive && current > 0)))
+    {
+      cache.range.lower = current;
+      cache.haveLower = true;
+    }
+    if ((current > cache.range.upper || !cache.haveUpper) && ((inSignDomain == sdNegative && current < 0) || (inSignDomain == sdPositive && current > 0)))
+    {
+      cache.range.upper = current;
+      cache.haveUpper = true;
+    }
+  }
+}
+
 /* inherits documentation from base class */
 void QCPAbstractPlottable::selectEvent(QMouseEvent *event, bool additive, const QVariant &details, bool *selectionStateChanged)
 {
@@ -748,3 +1147,395 @@ void QCPAbstractPlottable::deselectEvent(bool *selectionStateChanged)
       *selectionStateChanged = mSelected != selBefore;
   }
 }
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDrawPreparer
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDrawPreparer
+  
+  \internal
+  \brief (Private)
+  
+  This is a private class and not part of the public QCustomPlot interface.
+  
+  It runs the preparation phase of a replot (see \ref QCPAbstractPlottable::prepareDraw) for
+  multiple plottables in parallel on the global QThreadPool. All tasks of a preparation phase share
+  an atomic index into the list of plottables, and each task repeatedly takes the next unprepared
+  plottable, so the work is balanced even if the plottables differ strongly in size.
+*/
+
+/*!
+  Creates a task that prepares the not yet taken plottables of \a plottables, sharing the index
+  \a nextIndex with the other tasks, and releases \a finished once when done.
+*/
+QCPDrawPreparer::QCPDrawPreparer(const QList<QCPAbstractPlottable*> *plottables, QAtomicInt *nextIndex, QSemaphore *finished) :
+  mPlottables(plottables),
+  mNextIndex(nextIndex),
+  mFinished(finished)
+{
+}
+
+/* inherits documentation from base class */
+void QCPDrawPreparer::run()
+{
+  prepareRemaining(*mPlottables, mNextIndex);
+  mFinished->release();
+}
+
+/*!
+  Calls \ref QCPAbstractPlottable::prepareDraw for all \a plottables and returns when all of them
+  are prepared.
+  
+  The calling thread takes part in the work, and as many idle threads of the global thread pool
+  as are useful are started in addition. So if the thread pool is busy, the preparation is simply
+  done by the calling thread. With only one plottable, nothing is prepared ahead of time, because
+  it wouldn't be faster than preparing in the draw call.
+*/
+void QCPDrawPreparer::prepare(const QList<QCPAbstractPlottable*> &plottables)
+{
+  if (plottables.size() < 2)
+    return;
+  
+  QAtomicInt nextIndex(0);
+  QSemaphore finished;
+  QThreadPool *pool = QThreadPool::globalInstance();
+  const int taskCount = qMin(plottables.size(), pool->maxThreadCount())-1; // the calling thread does the work of one task
+  int startedCount = 0;
+  for (int i=0; i<taskCount; ++i)
+  {
+    QCPDrawPreparer *task = new QCPDrawPreparer(&plottables, &nextIndex, &finished);
+    if (!pool->tryStart(task)) // no idle thread available, the remaining work is done by the running tasks
+    {
+      delete task;
+      break;
+    }
+    ++startedCount;
+  }
+  prepareRemaining(plottables, &nextIndex);
+  finished.acquire(startedCount);
+}
+
+/*! \internal
+  
+  Prepares plottables from \a plottables by taking the next index from \a nextIndex, until all
+  plottables have been taken.
+*/
+void QCPDrawPreparer::prepareRemaining(const QList<QCPAbstractPlottable*> &plottables, QAtomicInt *nextIndex)
+{
+  int index = nextIndex->fetchAndAddOrdered(1);
+  while (index < plottables.size())
+  {
+    plottables.at(index)->prepareDraw();
+    index = nextIndex->fetchAndAddOrdered(1);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPHitTestIndex
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPHitTestIndex
+  
+  \internal
+  \brief (Private)
+  
+  This is a private class and not part of the public QCustomPlot interface.
+  
+  It holds the pixel geometry of a plottable, i.e. points or line segments, as it was drawn in the
+  last replot, and answers the distance of a pixel position to the nearest item. This is used by
+  plottables to answer \ref QCPAbstractPlottable::selectTest without recalculating their pixel
+  geometry for every call.
+  
+  The items are sorted into a uniform grid of square cells over the bounds passed to \ref
+  setGeometry. Each item is registered in all cells its bounding box touches. A distance query
+  examines the cells in rings of growing size around the cell of the queried position, and stops
+  once no unexamined cell can contain a closer item. For the dense geometry of typical plottables,
+  a query thus only touches a few cells, independent of the number of items. The grid is built
+  lazily on the first query after the geometry was set.
+*/
+
+/*!
+  The edge length of the grid cells in pixels.
+*/
+const int QCPHitTestIndex::cellSize = 8;
+
+/*!
+  Creates an empty hit test index.
+*/
+QCPHitTestIndex::QCPHitTestIndex() :
+  mType(gtPoints),
+  mGridValid(false),
+  mColumnCount(0),
+  mRowCount(0)
+{
+}
+
+/*!
+  Sets the geometry of this index to \a points, which form items according to \a type. The grid
+  covers \a bounds, typically the axis rect of the plottable. Items outside \a bounds are assigned
+  to the outer cells.
+  
+  Points with NaN coordinates don't form items, so gaps in lines are respected. The points are
+  implicitly shared, so passing the vector that was used for drawing is cheap.
+*/
+void QCPHitTestIndex::setGeometry(const QVector<QPointF> &points, GeometryType type, const QRect &bounds)
+{
+  mPoints = points;
+  mType = type;
+  // a polyline with a single point is represented by the point itself:
+  if (mType == gtPolyline && mPoints.size() == 1)
+    mType = gtPoints;
+  mBounds = bounds;
+  mGridValid = false;
+  mCellBegin.clear();
+  mCellItems.clear();
+}
+
+/*!
+  Removes the geometry from this index, so \ref isEmpty returns true.
+*/
+void QCPHitTestIndex::clear()
+{
+  setGeometry(QVector<QPointF>(), gtPoints, QRect());
+}
+
+/*!
+  Returns the distance in pixels of \a pos to the nearest item, or -1 if the index contains no
+  items.
+*/
+double QCPHitTestIndex::distance(const QPointF &pos) const
+{
+  double result = -1;
+  findNearest(pos, 0, 0, &result);
+  return result;
+}
+
+/*!
+  Returns the index of the item nearest to \a pos, or -1 if the index contains no items. If \a
+  distance is non-zero, the distance of the item to \a pos is written to it.
+  
+  For the geometry type \ref gtPoints, the item index is the index of the point in the vector
+  passed to \ref setGeometry.
+*/
+int QCPHitTestIndex::nearestItem(const QPointF &pos, double *distance) const
+{
+  return findNearest(pos, 0, 0, distance);
+}
+
+/*! \overload
+  
+  Only considers items whose points all lie within \a xRange and \a yRange (in pixels, inclusive).
+  The ranges may be unbounded, i.e. have infinite bounds.
+*/
+int QCPHitTestIndex::nearestItem(const QPointF &pos, const QCPRange &xRange, const QCPRange &yRange, double *distance) const
+{
+  return findNearest(pos, &xRange, &yRange, distance);
+}
+
+/*! \internal
+  
+  Returns the number of items formed by the points of this index, see \ref GeometryType.
+*/
+int QCPHitTestIndex::itemCount() const
+{
+  switch (mType)
+  {
+    case gtPoints: return mPoints.size();
+    case gtPolyline: return qMax(0, mPoints.size()-1);
+    case gtLinePairs: return mPoints.size()/2;
+  }
+  return 0;
+}
+
+/*! \internal
+  
+  Sets \a cells to the range of grid cells which the bounding box of \a item touches, limited to
+  the grid. Returns false if the item doesn't exist because of NaN coordinates.
+*/
+bool QCPHitTestIndex::itemCells(int item, QRect *cells) const
+{
+  QPointF a, b;
+  switch (mType)
+  {
+    case gtPoints: a = b = mPoints.at(item); break;
+    case gtPolyline: a = mPoints.at(item); b = mPoints.at(item+1); break;
+    case gtLinePairs: a = mPoints.at(2*item); b = mPoints.at(2*item+1); break;
+  }
+  if (qIsNaN(a.x()) || qIsNaN(a.y()) || qIsNaN(b.x()) || qIsNaN(b.y()))
+    return false;
+  // bound the coordinates before converting to int, because points may lie far outside:
+  const double left = qBound(-1.0, (qMin(a.x(), b.x())-mBounds.left())/cellSize, double(mColumnCount));
+  const double right = qBound(-1.0, (qMax(a.x(), b.x())-mBounds.left())/cellSize, double(mColumnCount));
+  const double top = qBound(-1.0, (qMin(a.y(), b.y())-mBounds.top())/cellSize, double(mRowCount));
+  const double bottom = qBound(-1.0, (qMax(a.y(), b.y())-mBounds.top())/cellSize, double(mRowCount));
+  cells->setCoords(qBound(0, qFloor(left), mColumnCount-1), qBound(0, qFloor(top), mRowCount-1),
+                   qBound(0, qFloor(right), mColumnCount-1), qBound(0, qFloor(bottom), mRowCount-1));
+  return true;
+}
+
+/*! \internal
+  
+  Returns the squared distance of \a pos to \a item. For items with NaN coordinates, the result is
+  NaN, which is never smaller than another distance.
+*/
+double QCPHitTestIndex::itemDistanceSqr(int item, const QPointF &pos) const
+{
+  QPointF a, b;
+  switch (mType)
+  {
+    case gtPoints: a = b = mPoints.at(item); break;
+    case gtPolyline: a = mPoints.at(item); b = mPoints.at(item+1); break;
+    case gtLinePairs: a = mPoints.at(2*item); b = mPoints.at(2*item+1); break;
+  }
+  // shortest distance to the line segment from a to b, like QCPAbstractPlottable::distSqrToLine:
+  const double vx = b.x()-a.x();
+  const double vy = b.y()-a.y();
+  const double vLengthSqr = vx*vx+vy*vy;
+  double mu = 0;
+  if (!qFuzzyIsNull(vLengthSqr))
+    mu = qBound(0.0, ((pos.x()-a.x())*vx+(pos.y()-a.y())*vy)/vLengthSqr, 1.0);
+  const double dx = a.x()+mu*vx-pos.x();
+  const double dy = a.y()+mu*vy-pos.y();
+  return dx*dx+dy*dy;
+}
+
+/*! \internal
+  
+  Returns whether all points of \a item lie within \a xRange and \a yRange.
+*/
+bool QCPHitTestIndex::itemInRanges(int item, const QCPRange &xRange, const QCPRange &yRange) const
+{
+  int first = item;
+  int last = item;
+  if (mType == gtPolyline)
+    last = item+1;
+  else if (mType == gtLinePairs)
+  {
+    first = 2*item;
+    last = first+1;
+  }
+  for (int i=first; i<=last; ++i)
+  {
+    const QPointF &point = mPoints.at(i);
+    if (!(point.x() >= xRange.lower && point.x() <= xRange.upper && point.y() >= yRange.lower && point.y() <= yRange.upper))
+      return false;
+  }
+  return true;
+}
+
+/*! \internal
+  
+  Sorts the items into the grid cells, see the class documentation. The cell lists are stored
+  consecutively in \ref mCellItems, with the list of each cell starting at its entry in \ref
+  mCellBegin.
+*/
+void QCPHitTestIndex::buildGrid() const
+{
+  mColumnCount = qMax(0, (mBounds.width()+cellSize-1)/cellSize);
+  mRowCount = qMax(0, (mBounds.height()+cellSize-1)/cellSize);
+  mCellBegin.fill(0, mColumnCount*mRowCount+1);
+  mCellItems.clear();
+  mGridValid = true;
+  if (mColumnCount == 0 || mRowCount == 0)
+    return;
+  
+  // count items per cell, then turn the counts into begin indices and fill the items in:
+  const int count = itemCount();
+  QRect cells;
+  for (int item=0; item<count; ++item)
+  {
+    if (!itemCells(item, &cells))
+      continue;
+    for (int y=cells.top(); y<=cells.bottom(); ++y)
+      for (int x=cells.left(); x<=cells.right(); ++x)
+        ++mCellBegin[y*mColumnCount+x+1];
+  }
+  for (int cell=0; cell<mColumnCount*mRowCount; ++cell)
+    mCellBegin[cell+1] += mCellBegin.at(cell);
+  mCellItems.resize(mCellBegin.last());
+  QVector<int> fillIndex = mCellBegin;
+  for (int item=0; item<count; ++item)
+  {
+    if (!itemCells(item, &cells))
+      continue;
+    for (int y=cells.top(); y<=cells.bottom(); ++y)
+      for (int x=cells.left(); x<=cells.right(); ++x)
+        mCellItems[fillIndex[y*mColumnCount+x]++] = item;
+  }
+}
+
+/*! \internal
+  
+  Returns the index of the item nearest to \a pos and writes its distance to \a distance, if
+  non-zero. If \a xRange and \a yRange are non-zero, only items within these ranges are considered
+  (see \ref itemInRanges). If no item is found, returns -1 and sets \a distance to -1.
+  
+  If \a pos lies within the bounds of the grid, the cells are examined in rings around the cell of
+  \a pos. Otherwise, all items are examined.
+*/
+int QCPHitTestIndex::findNearest(const QPointF &pos, const QCPRange *xRange, const QCPRange *yRange, double *distance) const
+{
+  const int count = itemCount();
+  if (!mGridValid && count > 0)
+    buildGrid();
+  
+  int nearest = -1;
+  double minDistSqr = std::numeric_limits<double>::max();
+  if (count == 0)
+  {
+    // nothing to examine
+  } else if (!mBounds.contains(pos.toPoint()) || mColumnCount == 0 || mRowCount == 0) // the ring search requires the position to be inside the grid
+  {
+    for (int item=0; item<count; ++item)
+    {
+      const double distSqr = itemDistanceSqr(item, pos);
+      if (distSqr < minDistSqr && (!xRange || itemInRanges(item, *xRange, *yRange)))
+      {
+        minDistSqr = distSqr;
+        nearest = item;
+      }
+    }
+  } else
+  {
+    const int column = qBound(0, (int(pos.x())-mBounds.left())/cellSize, mColumnCount-1);
+    const int row = qBound(0, (int(pos.y())-mBounds.top())/cellSize, mRowCount-1);
+    const int maxRing = qMax(mColumnCount, mRowCount);
+    for (int ring=0; ring<=maxRing; ++ring)
+    {
+      const int top = row-ring;
+      const int bottom = row+ring;
+      for (int y=qMax(0, top); y<=qMin(mRowCount-1, bottom); ++y)
+      {
+        // on the top and bottom edge of the ring all cells are examined, in between only the left and right cell:
+        const int xStep = (y == top || y == bottom) ? 1 : qMax(1, 2*ring);
+        for (int x=column-ring; x<=column+ring; x+=xStep)
+        {
+          if (x < 0 || x >= mColumnCount)
+            continue;
+          const int cell = y*mColumnCount+x;
+          for (int i=mCellBegin.at(cell); i<mCellBegin.at(cell+1); ++i)
+          {
+            const int item = mCellItems.at(i);
+            const double distSqr = itemDistanceSqr(item, pos);
+            // items spanning several cells are found multiple times, prefer the lowest index for equal distances:
+            if ((distSqr < minDistSqr || (distSqr == minDistSqr && item < nearest)) && (!xRange || itemInRanges(item, *xRange, *yRange)))
+            {
+              minDistSqr = distSqr;
+              nearest = item;
+            }
+          }
+        }
+      }
+      // cells outside of the rings examined so far are at least ring*cellSize pixels away:
+      const double ringDistance = ring*cellSize;
+      if (minDistSqr <= ringDistance*ringDistance)
+        break;
+    }
+  }
+  if (distance)
+    *distance = nearest >= 0 ? qSqrt(minDistSqr) : -1;
+  return nearest;
+}
@@ -33,6 +33,18 @@
 
 class QCPPainter;
 
+class QCP_LIB_DECL QCPDataPoint
+{
+public:
+  QCPDataPoint();
+  QCPDataPoint(int index, double key, double value, double distance);
+  bool isValid() const { return index >= 0; }
+  int index;
+  double key, value;
+  double distance;
+};
+Q_DECLARE_TYPEINFO(QCPDataPoint, Q_MOVABLE_TYPE);
+
 class QCP_LIB_DECL QCPAbstractPlottable : public QCPLayerable
 {
   Q_OBJECT
@@ -91,6 +103,9 @@ public:
   void rescaleAxes(bool onlyEnlarge=false) const;
   void rescaleKeyAxis(bool onlyEnlarge=false) const;
   void rescaleValueAxis(bool onlyEnlarge=false) const;
+  void rescaleValueAxisInKeyRange(bool onlyEnlarge=false) const;
+  QCPDataPoint nearestDataPoint(const QPointF &pixelPos) const;
+  QCPDataPoint nearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const;
   
 signals:
   void selectionChanged(bool selected);
@@ -105,6 +120,31 @@ protected:
                     ,sdPositive ///< The positive sign domain, i.e. numbers greater than zero
                   };
   
+  /*!
+    Cached bounds of the data in one dimension and sign domain, see \ref rangeCache.
+  */
+  struct RangeCache
+  {
+    RangeCache() : valid(false), haveLower(false), haveUpper(false) {}
+    bool valid, haveLower, haveUpper;
+    QCPRange range;
+  };
+  
+  /*!
+    The state of the axes and the data for which cached pixel geometry was calculated, see \ref
+    hitTestState.
+  */
+  struct HitTestState
+  {
+    HitTestState() : keyReversed(false), valueReversed(false), keyScaleType(QCPAxis::stLinear), valueScaleType(QCPAxis::stLinear), dataRevision(0) {}
+    bool operator==(const HitTestState &other) const;
+    QRect axisRect;
+    QCPRange keyRange, valueRange;
+    bool keyReversed, valueReversed;
+    QCPAxis::ScaleType keyScaleType, valueScaleType;
+    quint32 dataRevision;
+  };
+  
   // property members:
   QString mName;
   bool mAntialiasedFill, mAntialiasedScatters, mAntialiasedErrorBars;
@@ -112,6 +152,10 @@ protected:
   QBrush mBrush, mSelectedBrush;
   QPointer<QCPAxis> mKeyAxis, mValueAxis;
   bool mSelectable, mSelected;
+  // non-property members:
+  mutable RangeCache mRangeCache[2][3][2]; // [key/value dimension][sign domain][without/with errors]
+  mutable quint32 mRangeCacheRevision;
+  bool mDrawPrepared;
   
   // reimplemented virtual methods:
   virtual QRect clipRect() const;
@@ -126,6 +170,10 @@ protected:
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const = 0;
   virtual QCPRange getKeyRange(bool &foundRange, SignDomain inSignDomain=sdBoth) const = 0;
   virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain=sdBoth) const = 0;
+  virtual QCPRange getValueRangeInKeyRange(bool &foundRange, SignDomain inSignDomain, const QCPRange &inKeyRange) const;
+  virtual void prepareDraw();
+  virtual void clearPreparedDraw();
+  virtual QCPDataPoint findNearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const;
   
   // non-virtual methods:
   void coordsToPixels(double key, double value, double &x, double &y) const;
@@ -138,6 +186,16 @@ protected:
   void applyScattersAntialiasingHint(QCPPainter *painter) const;
   void applyErrorBarsAntialiasingHint(QCPPainter *painter) const;
   double distSqrToLine(const QPointF &start, const QPointF &end, const QPointF &point) const;
+  double distSqrToRect(const QRectF &rect, const QPointF &point) const;
+  SignDomain valueSignDomain() const;
+  void applyValueAxisRange(QCPRange newRange, bool onlyEnlarge) const;
+  HitTestState hitTestState(quint32 dataRevision) const;
+  RangeCache &rangeCache(bool valueDimension, SignDomain inSignDomain, bool includeErrors=false) const;
+  void invalidateRangeCache() const;
+  void syncRangeCache(quint32 dataRevision) const;
+  void extendRangeCache(bool valueDimension, double current, double errorMinus=0, double errorPlus=0) const;
+  void shrinkRangeCache(bool valueDimension, double current, double errorMinus=0, double errorPlus=0) const;
+  static void extendRange(RangeCache &cache, SignDomain inSignDomain, double current, double errorMinus=0, double errorPlus=0);
 
 private:
   Q_DISABLE_COPY(QCPAbstractPlottable)
@@ -145,6 +203,71 @@ private:
   friend class QCustomPlot;
   friend class QCPAxis;
   friend class QCPPlottableLegendItem;
+  friend class QCPDrawPreparer;
+};
+
+
+class QCP_LIB_DECL QCPDrawPreparer : public QRunnable
+{
+public:
+  QCPDrawPreparer(const QList<QCPAbstractPlottable*> *plottables, QAtomicInt *nextIndex, QSemaphore *finished);
+  
+  // reimplemented virtual methods:
+  virtual void run();
+  
+  // static methods:
+  static void prepare(const QList<QCPAbstractPlottable*> &plottables);
+  
+protected:
+  const QList<QCPAbstractPlottable*> *mPlottables;
+  QAtomicInt *mNextIndex;
+  QSemaphore *mFinished;
+  
+  // static methods:
+  static void prepareRemaining(const QList<QCPAbstractPlottable*> &plottables, QAtomicInt *nextIndex);
+};
+
+
+class QCP_LIB_DECL QCPHitTestIndex
+{
+public:
+  /*!
+    Defines how the points passed to \ref setGeometry form the items that are hit-tested.
+  */
+  enum GeometryType { gtPoints     ///< each point is an item
+                      ,gtPolyline  ///< each pair of consecutive points forms a line segment
+                      ,gtLinePairs ///< the points 0 and 1, 2 and 3, etc. form line segments
+                    };
+  
+  QCPHitTestIndex();
+  
+  // getters:
+  bool isEmpty() const { return mPoints.isEmpty(); }
+  
+  // non-property methods:
+  void setGeometry(const QVector<QPointF> &points, GeometryType type, const QRect &bounds);
+  void clear();
+  double distance(const QPointF &pos) const;
+  int nearestItem(const QPointF &pos, double *distance=0) const;
+  int nearestItem(const QPointF &pos, const QCPRange &xRange, const QCPRange &yRange, double *distance=0) const;
+  
+protected:
+  QVector<QPointF> mPoints;
+  GeometryType mType;
+  QRect mBounds;
+  mutable bool mGridValid;
+  mutable int mColumnCount, mRowCount;
+  mutable QVector<int> mCellBegin; // index into mCellItems of the first item of each cell, plus end index
+  mutable QVector<int> mCellItems;
+  static const int cellSize;
+  
+  // non-virtual methods:
+  int itemCount() const;
+  bool itemCells(int item, QRect *cells) const;
+  double itemDistanceSqr(int item, const QPointF &pos) const;
+  bool itemInRanges(int item, const QCPRange &xRange, const QCPRange &yRange) const;
+  void buildGrid() const;
+  int findNearest(const QPointF &pos, const QCPRange *xRange, const QCPRange *yRange, double *distance) const;
 };
 
 #endif // QCP_PLOTTABLE_H
@@ -461,6 +461,16 @@ QCPBarData::QCPBarData(double key, double value) :
   \see barBelow, moveBelow, moveAbove
 */
 
+/*! \fn QCPBarDataMap *QCPBars::data() const
+  
+  Returns a pointer to the internal data storage of type \ref QCPBarDataMap. You may use it to
+  directly manipulate the data, which may be more convenient and faster than using the regular \ref
+  setData or \ref addData methods.
+  
+  If you modify the data this way, call \ref dataChanged afterwards, so the cached data bounds
+  which are used by \ref rescaleAxes are determined anew.
+*/
+
 /* end of documentation of inline functions */
 
 /*!
@@ -555,6 +565,7 @@ void QCPBars::setBarsGroup(QCPBarsGroup *barsGroup)
 void QCPBars::setBaseValue(double baseValue)
 {
   mBaseValue = baseValue;
+  invalidateRangeCache();
 }
 
 /*!
@@ -579,6 +590,7 @@ void QCPBars::setData(QCPBarDataMap *data, bool copy)
     delete mData;
     mData = data;
   }
+  invalidateRangeCache();
 }
 
 /*! \overload
@@ -599,6 +611,7 @@ void QCPBars::setData(const QVector<double> &key, const QVector<double> &value)
     newData.value = value[i];
     mData->insertMulti(newData.key, newData);
   }
+  invalidateRangeCache();
 }
 
 /*!
@@ -674,6 +687,12 @@ void QCPBars::moveAbove(QCPBars *bars)
 void QCPBars::addData(const QCPBarDataMap &dataMap)
 {
   mData->unite(dataMap);
+  QCPBarDataMap::const_iterator it = dataMap.constBegin();
+  while (it != dataMap.constEnd())
+  {
+    addToRangeCache(it.value());
+    ++it;
+  }
 }
 
 /*! \overload
@@ -683,6 +702,7 @@ void QCPBars::addData(const QCPBarDataMap &dataMap)
 void QCPBars::addData(const QCPBarData &data)
 {
   mData->insertMulti(data.key, data);
+  addToRangeCache(data);
 }
 
 /*! \overload
@@ -695,6 +715,7 @@ void QCPBars::addData(double key, double value)
   newData.key = key;
   newData.value = value;
   mData->insertMulti(newData.key, newData);
+  addToRangeCache(newData);
 }
 
 /*! \overload
@@ -711,6 +732,7 @@ void QCPBars::addData(const QVector<double> &keys, const QVector<double> &values
     newData.key = keys[i];
     newData.value = values[i];
     mData->insertMulti(newData.key, newData);
+    addToRangeCache(newData);
   }
 }
 
@@ -723,6 +745,7 @@ void QCPBars::removeDataBefore(double key)
   QCPBarDataMap::iterator it = mData->begin();
   while (it != mData->end() && it.key() < key)
     it = mData->erase(it);
+  invalidateRangeCache();
 }
 
 /*!
@@ -735,6 +758,7 @@ void QCPBars::removeDataAfter(double key)
   QCPBarDataMap::iterator it = mData->upperBound(key);
   while (it != mData->end())
     it = mData->erase(it);
+  invalidateRangeCache();
 }
 
 /*!
@@ -751,6 +775,7 @@ void QCPBars::removeData(double fromKey, double toKey)
   QCPBarDataMap::iterator itEnd = mData->upperBound(toKey);
   while (it != itEnd)
     it = mData->erase(it);
+  invalidateRangeCache();
 }
 
 /*! \overload
@@ -764,6 +789,7 @@ void QCPBars::removeData(double fromKey, double toKey)
 void QCPBars::removeData(double key)
 {
   mData->remove(key);
+  invalidateRangeCache();
 }
 
 /*!
@@ -773,6 +799,18 @@ void QCPBars::removeData(double key)
 void QCPBars::clearData()
 {
   mData->clear();
+  invalidateRangeCache();
+}
+
+/*!
+  Notifies the plottable that its data was modified directly via the pointer returned by \ref
+  data. The cached data bounds are discarded, so the next call of e.g. \ref rescaleAxes determines
+  them anew. Modifications via the methods of this plottable (e.g. \ref addData) don't require
+  calling this method.
+*/
+void QCPBars::dataChanged()
+{
+  invalidateRangeCache();
 }
 
 /* inherits documentation from base class */
@@ -867,8 +905,9 @@ void QCPBars::getVisibleDataBounds(QCPBarDataMap::const_iterator &lower, QCPBarD
   }
   
   // get visible data range as QMap iterators
-  lower = mData->lowerBound(mKeyAxis.data()->range().lower);
-  upperEnd = mData->upperBound(mKeyAxis.data()->range().upper);
+  const QCPBarDataMap &constData = *mData;
+  lower = constData.lowerBound(mKeyAxis.data()->range().lower);
+  upperEnd = constData.upperBound(mKeyAxis.data()->range().upper);
   double lowerPixelBound = mKeyAxis.data()->coordToPixel(mKeyAxis.data()->range().lower);
   double upperPixelBound = mKeyAxis.data()->coordToPixel(mKeyAxis.data()->range().upper);
   bool isVisible = false;
@@ -1011,8 +1050,9 @@ double QCPBars::getStackedBaseValue(double key, bool positive) const
     double epsilon = qAbs(key)*1e-6; // should be safe even when changed to use float at some point
     if (key == 0)
       epsilon = 1e-6;
-    QCPBarDataMap::const_iterator it = mBarBelow.data()->mData->lowerBound(key-epsilon);
-    QCPBarDataMap::const_iterator itEnd = mBarBelow.data()->mData->upperBound(key+epsilon);
+    const QCPBarDataMap &dataBelow = *mBarBelow.data()->mData;
+    QCPBarDataMap::const_iterator it = dataBelow.lowerBound(key-epsilon);
+    QCPBarDataMap::const_iterator itEnd = dataBelow.upperBound(key+epsilon);
     while (it != itEnd)
     {
       if ((positive && it.value().value > max) ||
@@ -1037,6 +1077,9 @@ double QCPBars::getStackedBaseValue(double key, bool positive) const
 void QCPBars::connectBars(QCPBars *lower, QCPBars *upper)
 {
   if (!lower && !upper) return;
+  // the value range of stacked bars depends on the bars below, so it's not kept in the range cache:
+  if (upper)
+    upper->invalidateRangeCache();
   
   if (!lower) // disconnect upper at bottom
   {
@@ -1066,32 +1109,21 @@ void QCPBars::connectBars(QCPBars *lower, QCPBars *upper)
 /* inherits documentation from base class */
 QCPRange QCPBars::getKeyRange(bool &foundRange, SignDomain inSignDomain) const
 {
-  QCPRange range;
-  bool haveLower = false;
-  bool haveUpper = false;
-  
-  double current;
-  QCPBarDataMap::const_iterator it = mData->constBegin();
-  while (it != mData->constEnd())
+  RangeCache &cache = rangeCache(false, inSignDomain);
+  if (!cache.valid)
   {
-    current = it.value().key;
-    if (inSignDomain == sdBoth || (inSignDomain == sdNegative && current < 0) || (inSignDomain == sdPositive && current > 0))
+    cache = RangeCache();
+    QCPBarDataMap::const_iterator it = mData->constBegin();
+    while (it != mData->constEnd())
     {
-      if (current < range.lower || !haveLower)
-      {
-        range.lower = current;
-        haveLower = true;
-      }
-      if (current > range.upper || !haveUpper)
-      {
-        range.upper = current;
-        haveUpper = true;
-      }
+      extendRange(cache, inSignDomain, it.value().key);
+      ++it;
     }
-    ++it;
+    cache.valid = true;
   }
+  QCPRange range = cache.range;
   // determine exact range of bars by including bar width and barsgroup offset:
-  if (haveLower && mKeyAxis)
+  if (cache.haveLower && mKeyAxis)
   {
     double lowerPixelWidth, upperPixelWidth, keyPixel;
     getPixelWidth(range.lower, lowerPixelWidth, upperPixelWidth);
@@ -1100,7 +1132,7 @@ QCPRange QCPBars::getKeyRange(bool &foundRange, SignDomain inSignDomain) const
       keyPixel += mBarsGroup->keyPixelOffset(this, range.lower);
     range.lower = mKeyAxis.data()->pixelToCoord(keyPixel);
   }
-  if (haveUpper && mKeyAxis)
+  if (cache.haveUpper && mKeyAxis)
   {
     double lowerPixelWidth, upperPixelWidth, keyPixel;
     getPixelWidth(range.upper, lowerPixelWidth, upperPixelWidth);
@@ -1109,7 +1141,7 @@ QCPRange QCPBars::getKeyRange(bool &foundRange, SignDomain inSignDomain) const
       keyPixel += mBarsGroup->keyPixelOffset(this, range.upper);
     range.upper = mKeyAxis.data()->pixelToCoord(keyPixel);
   }
-  foundRange = haveLower && haveUpper;
+  foundRange = cache.haveLower && cache.haveUpper;
   return range;
 }
 
@@ -1119,26 +1151,72 @@ QCPRange QCPBars::getValueRange(bool &foundRange, SignDomain inSignDomain) const
   QCPRange range;
   range.lower = mBaseValue;
   range.upper = mBaseValue;
-  bool haveLower = true; // set to true, because baseValue should always be visible in bar charts
-  bool haveUpper = true; // set to true, because baseValue should always be visible in bar charts
-  double current;
-  
-  QCPBarDataMap::const_iterator it = mData->constBegin();
-  while (it != mData->constEnd())
+  if (mBarBelow) // stacked bars depend on the bars below, so their value range isn't cached
   {
-    current = it.value().value + getStackedBaseValue(it.value().key, it.value().value >= 0);
-    if (inSignDomain == sdBoth || (inSignDomain == sdNegative && current < 0) || (inSignDomain == sdPositive && current > 0))
+    double current;
+    QCPBarDataMap::const_iterator it = mData->constBegin();
+    while (it != mData->constEnd())
     {
-      if (current < range.lower || !haveLower)
+      current = it.value().value + getStackedBaseValue(it.value().key, it.value().value >= 0);
+      if (inSignDomain == sdBoth || (inSignDomain == sdNegative && current < 0) || (inSignDomain == sdPositive && current > 0))
       {
-        range.lower = current;
-        haveLower = true;
+        if (current < range.lower)
+          range.lower = current;
+        if (current > range.upper)
+          range.upper = current;
       }
-      if (current > range.upper || !haveUpper)
+      ++it;
+    }
+  } else
+  {
+    RangeCache &cache = rangeCache(true, inSignDomain);
+    if (!cache.valid)
+    {
+      cache = RangeCache();
+      QCPBarDataMap::const_iterator it = mData->constBegin();
+      while (it != mData->constEnd())
       {
-        range.upper = current;
-        haveUpper = true;
+        const double current = it.value().value + mBaseValue;
+        if (!qIsNaN(current))
+          extendRange(cache, inSignDomain, current);
+        ++it;
       }
+      cache.valid = true;
+    }
+    // baseValue should always be visible in bar charts:
+    if (cache.haveLower && cache.range.lower < range.lower)
+      range.lower = cache.range.lower;
+    if (cache.haveUpper && cache.range.upper > range.upper)
+      range.upper = cache.range.upper;
+  }
+  
+  foundRange = true; // return true because bar charts always have the 0-line visible
+  return range;
+}
+
+/*! \internal
+  
+  Returns the value range of the bars with keys inside \a inKeyRange, including the base value
+  (\ref setBaseValue) and the bars they are stacked on. The bars inside the key range are found
+  with binary searches, and only these are examined.
+*/
+QCPRange QCPBars::getValueRangeInKeyRange(bool &foundRange, SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+  QCPRange range;
+  range.lower = mBaseValue;
+  range.upper = mBaseValue;
+  const QCPBarDataMap &constData = *mData;
+  QCPBarDataMap::const_iterator it = constData.lowerBound(inKeyRange.lower);
+  const QCPBarDataMap::const_iterator end = constData.upperBound(inKeyRange.upper);
+  while (it != end)
+  {
+    const double current = it.value().value + (mBarBelow ? getStackedBaseValue(it.value().key, it.value().value >= 0) : mBaseValue);
+    if (inSignDomain == sdBoth || (inSignDomain == sdNegative && current < 0) || (inSignDomain == sdPositive && current > 0))
+    {
+      if (current < range.lower)
+        range.lower = current;
+      if (current > range.upper)
+        range.upper = current;
     }
     ++it;
   }
@@ -1147,3 +1225,90 @@ QCPRange QCPBars::getValueRange(bool &foundRange, SignDomain inSignDomain) const
   return range;
 }
 
+/*! \internal
+  
+  Returns the bar nearest to \a pixelPos among the bars with keys inside \a keyWindow, see \ref
+  QCPAbstractPlottable::nearestDataPoint. The distance is measured to the rectangle of the bar, so
+  it is zero if \a pixelPos lies inside the bar. The value of the returned data point is the value
+  of the bar, i.e. without the base value or the bars it is stacked on.
+  
+  The search starts at the bar with the key at \a pixelPos, which is found with a binary search,
+  and proceeds to both sides until the remaining bars are farther away in the key dimension than
+  the nearest bar found. Since the data is held in a QMap, the index of the found bar is
+  determined by counting the bars before it.
+*/
+QCPDataPoint QCPBars::findNearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return QCPDataPoint(); }
+  if (mData->isEmpty() || !(keyWindow.lower <= keyWindow.upper))
+    return QCPDataPoint();
+  
+  const bool keyIsVertical = keyAxis->orientation() == Qt::Vertical;
+  const double posKeyPixel = keyIsVertical ? pixelPos.y() : pixelPos.x();
+  const QCPBarDataMap &constData = *mData;
+  const QCPBarDataMap::const_iterator begin = constData.lowerBound(keyWindow.lower);
+  const QCPBarDataMap::const_iterator end = constData.upperBound(keyWindow.upper);
+  QCPBarDataMap::const_iterator lower = constData.lowerBound(qBound(keyWindow.lower, keyAxis->pixelToCoord(posKeyPixel), keyWindow.upper));
+  QCPBarDataMap::const_iterator upper = lower;
+  QCPBarDataMap::const_iterator nearest = mData->constEnd();
+  double minDistSqr = std::numeric_limits<double>::max();
+  while (lower != begin || upper != end)
+  {
+    // distances in the key dimension of the next bars on both sides:
+    QRectF lowerRect, upperRect;
+    double lowerDist = std::numeric_limits<double>::max();
+    double upperDist = std::numeric_limits<double>::max();
+    if (lower != begin)
+    {
+      lowerRect = getBarPolygon((lower-1).key(), (lower-1).value().value).boundingRect();
+      lowerDist = keyIsVertical ? qMax(0.0, qMax(lowerRect.top()-posKeyPixel, posKeyPixel-lowerRect.bottom())) : qMax(0.0, qMax(lowerRect.left()-posKeyPixel, posKeyPixel-lowerRect.right()));
+    }
+    if (upper != end)
+    {
+      upperRect = getBarPolygon(upper.key(), upper.value().value).boundingRect();
+      upperDist = keyIsVertical ? qMax(0.0, qMax(upperRect.top()-posKeyPixel, posKeyPixel-upperRect.bottom())) : qMax(0.0, qMax(upperRect.left()-posKeyPixel, posKeyPixel-upperRect.right()));
+    }
+    const double keyDist = qMin(lowerDist, upperDist);
+    if (keyDist*keyDist > minDistSqr)
+      break;
+    QCPBarDataMap::const_iterator it;
+    double distSqr;
+    if (upperDist <= lowerDist)
+    {
+      it = upper++;
+      distSqr = distSqrToRect(upperRect, pixelPos);
+    } else
+    {
+      it = --lower;
+      distSqr = distSqrToRect(lowerRect, pixelPos);
+    }
+    if (distSqr < minDistSqr) // also false for bars with NaN values
+    {
+      minDistSqr = distSqr;
+      nearest = it;
+    }
+  }
+  
+  if (nearest == mData->constEnd())
+    return QCPDataPoint();
+  int index = 0;
+  for (QCPBarDataMap::const_iterator it = mData->constBegin(); it != nearest; ++it)
+    ++index;
+  return QCPDataPoint(index, nearest.key(), nearest.value().value, qSqrt(minDistSqr));
+}
+
+/*! \internal
+  
+  Extends the range cache (see \ref QCPAbstractPlottable::rangeCache) by the newly added data point
+  \a data. If this bars plottable is stacked on top of other bars, only the key dimension is cached
+  (see \ref getValueRange).
+*/
+void QCPBars::addToRangeCache(const QCPBarData &data) const
+{
+  extendRangeCache(false, data.key);
+  if (!mBarBelow && !qIsNaN(data.value))
+    extendRangeCache(true, data.value + mBaseValue);
+}
+
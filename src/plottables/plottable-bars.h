@@ -172,6 +172,7 @@ public:
   void removeDataAfter(double key);
   void removeData(double fromKey, double toKey);
   void removeData(double key);
+  void dataChanged();
   
   // reimplemented virtual methods:
   virtual void clearData();
@@ -191,12 +192,15 @@ protected:
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const;
   virtual QCPRange getKeyRange(bool &foundRange, SignDomain inSignDomain=sdBoth) const;
   virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain=sdBoth) const;
+  virtual QCPRange getValueRangeInKeyRange(bool &foundRange, SignDomain inSignDomain, const QCPRange &inKeyRange) const;
+  virtual QCPDataPoint findNearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const;
   
   // non-virtual methods:
   void getVisibleDataBounds(QCPBarDataMap::const_iterator &lower, QCPBarDataMap::const_iterator &upperEnd) const;
   QPolygonF getBarPolygon(double key, double value) const;
   void getPixelWidth(double key, double &lower, double &upper) const;
   double getStackedBaseValue(double key, bool positive) const;
+  void addToRangeCache(const QCPBarData &data) const;
   static void connectBars(QCPBars* lower, QCPBars* upper);
   
   friend class QCustomPlot;
@@ -47,7 +47,13 @@
   The data cells can be accessed in two ways: They can be directly addressed by an integer index
   with \ref setCell. This is the fastest method. Alternatively, they can be addressed by their plot
   coordinate with \ref setData. plot coordinate to cell index transformations and vice versa are
-  provided by the functions \ref coordToCell and \ref cellToCoord.
+  provided by the functions \ref coordToCell and \ref cellToCoord. To load many cells at once,
+  for example a whole image, use \ref setRow, \ref setColumn or \ref setBlock, which copy entire
+  buffers instead of setting the cells one by one.
+  
+  The cells are stored as double by default. For data of lower precision, like camera images or
+  samples of analog-to-digital converters, \ref setCellType can reduce the memory to a half or a
+  quarter.
   
   This class also buffers the minimum and maximum values that are in the data set, to provide
   QCPColorMap::rescaleDataRange with the necessary information quickly. Setting a cell to a value
@@ -59,6 +65,15 @@
   true current minimum and maximum. The method QCPColorMap::rescaleDataRange offers a convenience
   parameter \a recalculateDataBounds which may be set to true to automatically call \ref
   recalculateDataBounds internally.
+  
+  Modifications of single cells with \ref setCell or \ref setData are tracked as rectangles of
+  modified cells. The QCPColorMap then only colorizes these cells again when it is replotted,
+  instead of the entire map. Modifications that affect all cells, like \ref fill or \ref setSize,
+  cause the entire map to be colorized again.
+  
+  For scrolling waterfall displays, use \ref appendRow to add a new row of cells and discard the
+  oldest one. The rows are held in a ring buffer, so this doesn't move any data and only the new
+  row is colorized when replotting.
 */
 
 /* start of documentation of inline functions */
@@ -69,23 +84,34 @@
   one of the dimensions is 0 (see \ref setSize).
 */
 
+/*! \fn int QCPColorMapData::physicalRow(int valueIndex) const
+  \internal
+  
+  Returns the row of the data array which holds the cells of \a valueIndex. The rows form a ring
+  buffer that starts at the row of value index 0 (see \ref appendRow), so this only equals \a
+  valueIndex if no rows were appended since the last \ref setSize.
+*/
+
 /* end of documentation of inline functions */
 
 /*!
   Constructs a new QCPColorMapData instance. The instance has \a keySize cells in the key direction
   and \a valueSize cells in the value direction. These cells will be displayed by the \ref QCPColorMap
-  at the coordinates \a keyRange and \a valueRange.
+  at the coordinates \a keyRange and \a valueRange. The cells are stored as \a cellType.
   
-  \see setSize, setKeySize, setValueSize, setRange, setKeyRange, setValueRange
+  \see setSize, setKeySize, setValueSize, setRange, setKeyRange, setValueRange, setCellType
 */
-QCPColorMapData::QCPColorMapData(int keySize, int valueSize, const QCPRange &keyRange, const QCPRange &valueRange) :
+QCPColorMapData::QCPColorMapData(int keySize, int valueSize, const QCPRange &keyRange, const QCPRange &valueRange, CellType cellType) :
   mKeySize(0),
   mValueSize(0),
   mKeyRange(keyRange),
   mValueRange(valueRange),
   mIsEmpty(true),
+  mCellType(cellType),
   mData(0),
-  mDataModified(true)
+  mDataModified(true),
+  mDirtyCellCount(0),
+  mRowOffset(0)
 {
   setSize(keySize, valueSize);
   fill(0);
@@ -104,8 +130,11 @@ QCPColorMapData::QCPColorMapData(const QCPColorMapData &other) :
   mKeySize(0),
   mValueSize(0),
   mIsEmpty(true),
+  mCellType(ctDouble),
   mData(0),
-  mDataModified(true)
+  mDataModified(true),
+  mDirtyCellCount(0),
+  mRowOffset(0)
 {
   *this = other;
 }
@@ -119,12 +148,18 @@ QCPColorMapData &QCPColorMapData::operator=(const QCPColorMapData &other)
   {
     const int keySize = other.keySize();
     const int valueSize = other.valueSize();
+    if (mCellType != other.mCellType)
+    {
+      setSize(0, 0); // frees the cells, so they are allocated with the new cell type below
+      mCellType = other.mCellType;
+    }
     setSize(keySize, valueSize);
     setRange(other.keyRange(), other.valueRange());
-    if (!mIsEmpty)
-      memcpy(mData, other.mData, sizeof(mData[0])*keySize*valueSize);
+    if (!mIsEmpty && mData)
+      memcpy(mData, other.mData, qint64(cellSize(mCellType))*keySize*valueSize);
+    mRowOffset = other.mRowOffset;
     mDataBounds = other.mDataBounds;
-    mDataModified = true;
+    markModified();
   }
   return *this;
 }
@@ -135,7 +170,7 @@ double QCPColorMapData::data(double key, double value)
   int keyCell = (key-mKeyRange.lower)/(mKeyRange.upper-mKeyRange.lower)*(mKeySize-1)+0.5;
   int valueCell = (value-mValueRange.lower)/(mValueRange.upper-mValueRange.lower)*(mValueSize-1)+0.5;
   if (keyCell >= 0 && keyCell < mKeySize && valueCell >= 0 && valueCell < mValueSize)
-    return mData[valueCell*mKeySize + keyCell];
+    return cellValue(physicalRow(valueCell)*mKeySize + keyCell);
   else
     return 0;
 }
@@ -144,7 +179,7 @@ double QCPColorMapData::data(double key, double value)
 double QCPColorMapData::cell(int keyIndex, int valueIndex)
 {
   if (keyIndex >= 0 && keyIndex < mKeySize && valueIndex >= 0 && valueIndex < mValueSize)
-    return mData[valueIndex*mKeySize + keyIndex];
+    return cellValue(physicalRow(valueIndex)*mKeySize + keyIndex);
   else
     return 0;
 }
@@ -167,25 +202,20 @@ void QCPColorMapData::setSize(int keySize, int valueSize)
   {
     mKeySize = keySize;
     mValueSize = valueSize;
+    mRowOffset = 0;
     if (mData)
       delete[] mData;
     mIsEmpty = mKeySize == 0 || mValueSize == 0;
     if (!mIsEmpty)
     {
-#ifdef __EXCEPTIONS
-      try { // 2D arrays get memory intensive fast. So if the allocation fails, at least output debug message
-#endif
-      mData = new double[mKeySize*mValueSize];
-#ifdef __EXCEPTIONS
-      } catch (...) { mData = 0; }
-#endif
+      mData = allocateCells(mCellType, mKeySize*mValueSize);
       if (mData)
         fill(0);
       else
         qDebug() << Q_FUNC_INFO << "out of memory for data dimensions "<< mKeySize << "*" << mValueSize;
     } else
       mData = 0;
-    mDataModified = true;
+    markModified();
   }
 }
 
@@ -283,12 +313,13 @@ void QCPColorMapData::setData(double key, double value, double z)
   int valueCell = (value-mValueRange.lower)/(mValueRange.upper-mValueRange.lower)*(mValueSize-1)+0.5;
   if (keyCell >= 0 && keyCell < mKeySize && valueCell >= 0 && valueCell < mValueSize)
   {
-    mData[valueCell*mKeySize + keyCell] = z;
+    const int row = physicalRow(valueCell);
+    z = setCellValue(row*mKeySize + keyCell, z);
     if (z < mDataBounds.lower)
       mDataBounds.lower = z;
     if (z > mDataBounds.upper)
       mDataBounds.upper = z;
-     mDataModified = true;
+    markDirty(QRect(keyCell, row, 1, 1));
   }
 }
 
@@ -307,13 +338,189 @@ void QCPColorMapData::setCell(int keyIndex, int valueIndex, double z)
 {
   if (keyIndex >= 0 && keyIndex < mKeySize && valueIndex >= 0 && valueIndex < mValueSize)
   {
-    mData[valueIndex*mKeySize + keyIndex] = z;
+    const int row = physicalRow(valueIndex);
+    z = setCellValue(row*mKeySize + keyIndex, z);
     if (z < mDataBounds.lower)
       mDataBounds.lower = z;
     if (z > mDataBounds.upper)
       mDataBounds.upper = z;
-     mDataModified = true;
+    markDirty(QRect(keyIndex, row, 1, 1));
+  }
+}
+
+/*!
+  Sets the type in which the cells are stored. The present cells are converted to the new type.
+  
+  By default, cells are stored as \ref ctDouble. Data from cameras or analog-to-digital converters
+  usually has a lower precision, so storing it as \ref ctFloat or \ref ctUInt16 halves or quarters
+  the memory of the map without losing information. The cells are colorized in their type
+  directly, without converting them to double first. Values set with \ref setCell, \ref setData or
+  the bulk setters (\ref setRow, \ref setColumn, \ref setBlock) are converted to the cell type.
+  Since \ref ctUInt16 cells only hold integers from 0 to 65535, values are rounded and clamped to
+  this range.
+*/
+void QCPColorMapData::setCellType(CellType type)
+{
+  if (mCellType == type)
+    return;
+  if (!mData)
+  {
+    mCellType = type;
+    return;
+  }
+  const int cellCount = mKeySize*mValueSize;
+  char *cells = allocateCells(type, cellCount);
+  if (!cells)
+  {
+    qDebug() << Q_FUNC_INFO << "out of memory for data dimensions "<< mKeySize << "*" << mValueSize;
+    return;
+  }
+  switch (mCellType)
+  {
+    case ctDouble: convertCells(reinterpret_cast<const double*>(mData), cellCount, cells, type); break;
+    case ctFloat: convertCells(reinterpret_cast<const float*>(mData), cellCount, cells, type); break;
+    case ctUInt16: convertCells(reinterpret_cast<const quint16*>(mData), cellCount, cells, type); break;
   }
+  delete[] mData;
+  mData = cells;
+  mCellType = type;
+  recalculateDataBounds();
+  markModified();
+}
+
+/*!
+  Sets the cells of the row with \a valueIndex to the \ref keySize values that \a data points to,
+  in ascending key index.
+  
+  This is much faster than setting each cell with \ref setCell. If the type of \a data matches the
+  cell type (\ref setCellType), the values are copied with memcpy, otherwise they are converted.
+  The data bounds are expanded like with \ref setCell, and the QCPColorMap only colorizes the
+  modified row again.
+  
+  \see setColumn, setBlock, appendRow
+*/
+void QCPColorMapData::setRow(int valueIndex, const double *data)
+{
+  setCells(0, valueIndex, mKeySize, 1, data);
+}
+
+/*! \overload
+  
+  Sets the cells of the row with \a valueIndex to single precision floating point values.
+*/
+void QCPColorMapData::setRow(int valueIndex, const float *data)
+{
+  setCells(0, valueIndex, mKeySize, 1, data);
+}
+
+/*! \overload
+  
+  Sets the cells of the row with \a valueIndex to 16 bit unsigned integer values.
+*/
+void QCPColorMapData::setRow(int valueIndex, const quint16 *data)
+{
+  setCells(0, valueIndex, mKeySize, 1, data);
+}
+
+/*!
+  Sets the cells of the column with \a keyIndex to the \ref valueSize values that \a data points
+  to, in ascending value index.
+  
+  This is much faster than setting each cell with \ref setCell, see \ref setRow.
+  
+  \see setBlock
+*/
+void QCPColorMapData::setColumn(int keyIndex, const double *data)
+{
+  setCells(keyIndex, 0, 1, mValueSize, data);
+}
+
+/*! \overload
+  
+  Sets the cells of the column with \a keyIndex to single precision floating point values.
+*/
+void QCPColorMapData::setColumn(int keyIndex, const float *data)
+{
+  setCells(keyIndex, 0, 1, mValueSize, data);
+}
+
+/*! \overload
+  
+  Sets the cells of the column with \a keyIndex to 16 bit unsigned integer values.
+*/
+void QCPColorMapData::setColumn(int keyIndex, const quint16 *data)
+{
+  setCells(keyIndex, 0, 1, mValueSize, data);
+}
+
+/*!
+  Sets the block of \a keyCount times \a valueCount cells, starting at \a keyIndex and \a
+  valueIndex, to the values that \a data points to. \a data holds \a valueCount rows of \a keyCount
+  values each, i.e. the cell (keyIndex+k, valueIndex+v) is set to <tt>data[v*keyCount + k]</tt>. So
+  a whole map can be loaded from an image buffer with a single call.
+  
+  The block must lie within the map (\ref setSize), otherwise no cells are set. Like \ref setRow,
+  this is much faster than setting each cell with \ref setCell.
+*/
+void QCPColorMapData::setBlock(int keyIndex, int valueIndex, int keyCount, int valueCount, const double *data)
+{
+  setCells(keyIndex, valueIndex, keyCount, valueCount, data);
+}
+
+/*! \overload
+  
+  Sets the block of cells to single precision floating point values.
+*/
+void QCPColorMapData::setBlock(int keyIndex, int valueIndex, int keyCount, int valueCount, const float *data)
+{
+  setCells(keyIndex, valueIndex, keyCount, valueCount, data);
+}
+
+/*! \overload
+  
+  Sets the block of cells to 16 bit unsigned integer values.
+*/
+void QCPColorMapData::setBlock(int keyIndex, int valueIndex, int keyCount, int valueCount, const quint16 *data)
+{
+  setCells(keyIndex, valueIndex, keyCount, valueCount, data);
+}
+
+/*!
+  Appends a row of cells at the highest value index and discards the row at value index 0, so the
+  remaining rows move down by one value index. This is the typical update of scrolling waterfall
+  displays and spectrograms, where each new frame (e.g. an FFT spectrum over the key dimension) is
+  appended at one end of the map.
+  
+  \a data must point to \ref keySize values, which become the cells of the new row in ascending key
+  index. They are converted to the cell type (\ref setCellType).
+  
+  The cells are held in a ring buffer, so no data is moved, and the QCPColorMap only colorizes the
+  new row on the next replot. The key and value ranges (\ref setRange) stay the same. If the value
+  dimension represents time, you may shift the value range with \ref setValueRange accordingly.
+  
+  \see setCell, setRow
+*/
+void QCPColorMapData::appendRow(const double *data)
+{
+  appendCells(data);
+}
+
+/*! \overload
+  
+  Appends a row of single precision floating point values.
+*/
+void QCPColorMapData::appendRow(const float *data)
+{
+  appendCells(data);
+}
+
+/*! \overload
+  
+  Appends a row of 16 bit unsigned integer values.
+*/
+void QCPColorMapData::appendRow(const quint16 *data)
+{
+  appendCells(data);
 }
 
 /*!
@@ -333,15 +540,16 @@ void QCPColorMapData::recalculateDataBounds()
 {
   if (mKeySize > 0 && mValueSize > 0)
   {
-    double minHeight = mData[0];
-    double maxHeight = mData[0];
+    double minHeight = cellValue(0);
+    double maxHeight = cellValue(0);
     const int dataCount = mValueSize*mKeySize;
     for (int i=0; i<dataCount; ++i)
     {
-      if (mData[i] > maxHeight)
-        maxHeight = mData[i];
-      if (mData[i] < minHeight)
-        minHeight = mData[i];
+      const double z = cellValue(i);
+      if (z > maxHeight)
+        maxHeight = z;
+      if (z < minHeight)
+        minHeight = z;
     }
     mDataBounds.lower = minHeight;
     mDataBounds.upper = maxHeight;
@@ -364,10 +572,40 @@ void QCPColorMapData::clear()
 void QCPColorMapData::fill(double z)
 {
   const int dataCount = mValueSize*mKeySize;
-  for (int i=0; i<dataCount; ++i)
-    mData[i] = z;
+  if (mData)
+  {
+    // convert the value to the cell type only once, then fill all cells with it:
+    switch (mCellType)
+    {
+      case ctDouble:
+      {
+        double *cells = reinterpret_cast<double*>(mData);
+        for (int i=0; i<dataCount; ++i)
+          cells[i] = z;
+        break;
+      }
+      case ctFloat:
+      {
+        const float cell = z;
+        float *cells = reinterpret_cast<float*>(mData);
+        for (int i=0; i<dataCount; ++i)
+          cells[i] = cell;
+        z = cell;
+        break;
+      }
+      case ctUInt16:
+      {
+        const quint16 cell = toUInt16(z);
+        quint16 *cells = reinterpret_cast<quint16*>(mData);
+        for (int i=0; i<dataCount; ++i)
+          cells[i] = cell;
+        z = cell;
+        break;
+      }
+    }
+  }
   mDataBounds = QCPRange(z, z);
-  mDataModified = true;
+  markModified();
 }
 
 /*!
@@ -419,6 +657,241 @@ void QCPColorMapData::cellToCoord(int keyIndex, int valueIndex, double *key, dou
 }
 
 
+/*! \internal
+  
+  The number of separate rectangles of modified cells that are tracked (see \ref markDirty). Once
+  more rectangles would be needed, the entire map is colorized again instead.
+*/
+const int QCPColorMapData::maxDirtyRects = 1024;
+
+/*! \internal
+  
+  Records that the cells in \a cells (key indices horizontally, physical rows vertically, see \ref
+  physicalRow) were modified, so QCPColorMap only needs to colorize them again (see \ref
+  QCPColorMap::updateMapImageCells).
+  
+  If \a cells is adjacent to or overlaps the most recently recorded rectangle such that their union
+  isn't larger than both together, the rectangle is extended. So consecutive cells of a row or
+  column, as they are typically written, are recorded as a single rectangle. If too many cells or
+  rectangles were recorded, all cells are marked as modified instead (see \ref markModified),
+  since colorizing the entire map is faster then.
+*/
+void QCPColorMapData::markDirty(const QRect &cells)
+{
+  if (mDataModified) // all cells will be colorized anyway
+    return;
+  if (!mDirtyCells.isEmpty())
+  {
+    QRect &last = mDirtyCells.last();
+    if (last.contains(cells))
+      return;
+    const QRect united = last.united(cells);
+    if (qint64(united.width())*united.height() <= qint64(last.width())*last.height()+qint64(cells.width())*cells.height())
+    {
+      mDirtyCellCount += united.width()*united.height()-last.width()*last.height();
+      last = united;
+      return;
+    }
+  }
+  mDirtyCellCount += cells.width()*cells.height();
+  if (mDirtyCells.size() >= maxDirtyRects || mDirtyCellCount > qint64(mKeySize)*mValueSize/4)
+    markModified();
+  else
+    mDirtyCells.append(cells);
+}
+
+/*! \internal
+  
+  Records that all cells were modified, so QCPColorMap colorizes the entire map again. Rectangles
+  of modified cells recorded with \ref markDirty are discarded.
+*/
+void QCPColorMapData::markModified()
+{
+  mDataModified = true;
+  mDirtyCells.clear();
+  mDirtyCellCount = 0;
+}
+
+/*! \internal
+  
+  Returns the value of the cell at \a index of the data array (see \ref physicalRow), converted to
+  double.
+*/
+double QCPColorMapData::cellValue(int index) const
+{
+  switch (mCellType)
+  {
+    case ctFloat: return reinterpret_cast<const float*>(mData)[index];
+    case ctUInt16: return reinterpret_cast<const quint16*>(mData)[index];
+    default: return reinterpret_cast<const double*>(mData)[index];
+  }
+}
+
+/*! \internal
+  
+  Sets the cell at \a index of the data array (see \ref physicalRow) to \a z, converted to the cell
+  type. Returns the value as it is stored, e.g. rounded for \ref ctUInt16.
+*/
+double QCPColorMapData::setCellValue(int index, double z)
+{
+  switch (mCellType)
+  {
+    case ctFloat: return reinterpret_cast<float*>(mData)[index] = z;
+    case ctUInt16: return reinterpret_cast<quint16*>(mData)[index] = toUInt16(z);
+    default: return reinterpret_cast<double*>(mData)[index] = z;
+  }
+}
+
+/*! \internal
+  
+  Converts \a count consecutive cells, starting at \a index of the data array, to double and writes
+  them to \a target.
+*/
+void QCPColorMapData::readCells(int index, int count, double *target) const
+{
+  switch (mCellType)
+  {
+    case ctDouble: convertCells(reinterpret_cast<const double*>(mData)+index, count, reinterpret_cast<char*>(target), ctDouble); break;
+    case ctFloat: convertCells(reinterpret_cast<const float*>(mData)+index, count, reinterpret_cast<char*>(target), ctDouble); break;
+    case ctUInt16: convertCells(reinterpret_cast<const quint16*>(mData)+index, count, reinterpret_cast<char*>(target), ctDouble); break;
+  }
+}
+
+/*! \internal
+  
+  Colorizes \a count cells of the data array with \a gradient into \a scanLine, see \ref
+  QCPColorGradient::colorize. The cells start at \a index and are \a indexStep apart. They are
+  read in their cell type directly.
+*/
+void QCPColorMapData::colorizeCells(QCPColorGradient &gradient, const QCPRange &range, bool logarithmic, int index, int count, int indexStep, QRgb *scanLine) const
+{
+  switch (mCellType)
+  {
+    case ctDouble: gradient.colorize(reinterpret_cast<const double*>(mData)+index, range, scanLine, count, indexStep, logarithmic); break;
+    case ctFloat: gradient.colorize(reinterpret_cast<const float*>(mData)+index, range, scanLine, count, indexStep, logarithmic); break;
+    case ctUInt16: gradient.colorize(reinterpret_cast<const quint16*>(mData)+index, range, scanLine, count, indexStep, logarithmic); break;
+  }
+}
+
+/*! \internal
+  
+  Implements \ref setRow, \ref setColumn and \ref setBlock for the different types of \a data,
+  see \ref setBlock for the parameters.
+*/
+template <typename T>
+void QCPColorMapData::setCells(int keyIndex, int valueIndex, int keyCount, int valueCount, const T *data)
+{
+  if (!data || !mData || keyCount <= 0 || valueCount <= 0)
+    return;
+  if (keyIndex < 0 || valueIndex < 0 || keyIndex+keyCount > mKeySize || valueIndex+valueCount > mValueSize)
+  {
+    qDebug() << Q_FUNC_INFO << "block exceeds map dimensions:" << keyIndex << valueIndex << keyCount << valueCount;
+    return;
+  }
+  const int size = cellSize(mCellType);
+  for (int i=0; i<valueCount; ++i)
+  {
+    const int row = physicalRow(valueIndex+i);
+    const int index = row*mKeySize+keyIndex;
+    convertCells(data+qint64(i)*keyCount, keyCount, mData+qint64(index)*size, mCellType);
+    for (int k=0; k<keyCount; ++k)
+    {
+      const double z = cellValue(index+k);
+      if (z < mDataBounds.lower)
+        mDataBounds.lower = z;
+      if (z > mDataBounds.upper)
+        mDataBounds.upper = z;
+    }
+    markDirty(QRect(keyIndex, row, keyCount, 1));
+  }
+}
+
+/*! \internal
+  
+  Implements \ref appendRow for the different types of \a data.
+*/
+template <typename T>
+void QCPColorMapData::appendCells(const T *data)
+{
+  if (mIsEmpty || !data)
+    return;
+  // the row at value index 0 is the oldest one in the ring buffer, let it become the row at the highest value index and overwrite it:
+  mRowOffset = mRowOffset+1 < mValueSize ? mRowOffset+1 : 0;
+  setCells(0, mValueSize-1, mKeySize, 1, data);
+}
+
+/*! \internal
+  
+  Returns the number of bytes per cell of the given cell \a type.
+*/
+int QCPColorMapData::cellSize(CellType type)
+{
+  switch (type)
+  {
+    case ctFloat: return sizeof(float);
+    case ctUInt16: return sizeof(quint16);
+    default: return sizeof(double);
+  }
+}
+
+/*! \internal
+  
+  Allocates an array for \a count cells of the given cell \a type. Returns 0 if the allocation
+  failed.
+*/
+char *QCPColorMapData::allocateCells(CellType type, int count)
+{
+  char *cells = 0;
+#ifdef __EXCEPTIONS
+  try { // 2D arrays get memory intensive fast. So if the allocation fails, at least output debug message
+#endif
+  cells = new char[qint64(count)*cellSize(type)];
+#ifdef __EXCEPTIONS
+  } catch (...) { cells = 0; }
+#endif
+  return cells;
+}
+
+/*! \internal
+  
+  Writes \a count values of \a source to the array \a target of cells with type \a targetType. If
+  the types match, the values are copied with memcpy, otherwise they are converted one by one.
+*/
+template <typename T>
+void QCPColorMapData::convertCells(const T *source, int count, char *target, CellType targetType)
+{
+  if (cellTypeOf(source) == targetType)
+  {
+    memcpy(target, source, sizeof(T)*count);
+    return;
+  }
+  switch (targetType)
+  {
+    case ctDouble:
+    {
+      double *cells = reinterpret_cast<double*>(target);
+      for (int i=0; i<count; ++i)
+        cells[i] = source[i];
+      break;
+    }
+    case ctFloat:
+    {
+      float *cells = reinterpret_cast<float*>(target);
+      for (int i=0; i<count; ++i)
+        cells[i] = source[i];
+      break;
+    }
+    case ctUInt16:
+    {
+      quint16 *cells = reinterpret_cast<quint16*>(target);
+      for (int i=0; i<count; ++i)
+        cells[i] = toUInt16(source[i]);
+      break;
+    }
+  }
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPColorMap
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -518,6 +991,13 @@ void QCPColorMapData::cellToCoord(int keyIndex, int valueIndex, double *key, dou
 
 /* end documentation of signals */
 
+/*! \internal
+  
+  The number of cells of a tile in each dimension, when drawing with levels of detail (see \ref
+  setLodReduction).
+*/
+const int QCPColorMap::lodTileSize = 256;
+
 /*!
   Constructs a color map with the specified \a keyAxis and \a valueAxis.
   
@@ -530,7 +1010,11 @@ QCPColorMap::QCPColorMap(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   mMapData(new QCPColorMapData(10, 10, QCPRange(0, 5), QCPRange(0, 5))),
   mInterpolate(true),
   mTightBoundary(false),
-  mMapImageInvalidated(true)
+  mLodReduction(lrNone),
+  mMapImageInvalidated(true),
+  mLodLevelsValid(false),
+  mLodRowOffset(0),
+  mLodTiles(16*1024*1024)
 {
 }
 
@@ -562,6 +1046,7 @@ void QCPColorMap::setData(QCPColorMapData *data, bool copy)
     mMapData = data;
   }
   mMapImageInvalidated = true;
+  mLodLevelsValid = false;
 }
 
 /*!
@@ -692,6 +1177,46 @@ void QCPColorMap::setColorScale(QCPColorScale *colorScale)
   }
 }
 
+/*!
+  Sets whether and how the color map reduces its cells to levels of detail for drawing.
+  
+  With the default \ref lrNone, the entire map is colorized into one image at full resolution,
+  which is then scaled to the screen by the painter. For very large maps, this image becomes very
+  large (four bytes per cell) and colorizing it takes long, even if only a small part of the map is
+  visible.
+  
+  With \ref lrMean or \ref lrMaximum, the color map builds a pyramid of levels of detail, each
+  level halving the number of cells in both dimensions with the given \a reduction. On each replot,
+  the finest level that has no more than one cell per screen pixel is chosen, so no cell is
+  skipped when scaling. Only the tiles of that level which intersect the visible key and value
+  range are colorized. Colorized tiles are cached, so panning and zooming back and forth reuses
+  them. Memory and time for drawing thus scale with the screen size rather than the number of
+  cells. The levels of detail store their cells in double precision, independent of the cell type
+  of the map data (\ref QCPColorMapData::setCellType). Together, they have about a third of the
+  number of cells of the map, so they take about a third of the memory of the map data in addition
+  for \ref QCPColorMapData::ctDouble, two thirds for \ref QCPColorMapData::ctFloat and four thirds
+  for \ref QCPColorMapData::ctUInt16.
+  
+  Modified cells (\ref QCPColorMapData::setCell) only update the affected cells of the levels of
+  detail and the affected tiles. Since \ref QCPColorMapData::appendRow moves all cells by one value
+  index, it causes the levels of detail to be rebuilt entirely. Scrolling waterfall displays are
+  thus better drawn with \ref lrNone.
+*/
+void QCPColorMap::setLodReduction(LodReduction reduction)
+{
+  if (mLodReduction != reduction)
+  {
+    mLodReduction = reduction;
+    mLodLevels.clear();
+    mLodLevelsValid = false;
+    mLodTiles.clear();
+    // the map image isn't used with levels of detail, free it and let it be rebuilt when switching back:
+    mMapImage = QImage();
+    mUndersampledMapImage = QImage();
+    mMapImageInvalidated = true;
+  }
+}
+
 /*!
   Sets the data range (\ref setDataRange) to span the minimum and maximum values that occur in the
   current data set. This corresponds to the \ref rescaleKeyAxis or \ref rescaleValueAxis methods,
@@ -735,14 +1260,29 @@ void QCPColorMap::rescaleDataRange(bool recalculateDataBounds)
 */
 void QCPColorMap::updateLegendIcon(Qt::TransformationMode transformMode, const QSize &thumbSize)
 {
-  if (mMapImage.isNull() && !data()->isEmpty())
+  if (mLodReduction == lrNone && mMapImage.isNull() && !data()->isEmpty())
     updateMapImage(); // try to update map image if it's null (happens if no draw has happened yet)
   
-  if (!mMapImage.isNull()) // might still be null, e.g. if data is empty, so check here again
+  if (mLodReduction != lrNone)
   {
+    if (data()->isEmpty())
+      return;
+    // colorize the coarsest level of detail, it fits into a single tile:
+    updateLodLevels();
+    const int level = mLodLevels.size();
     bool mirrorX = (keyAxis()->orientation() == Qt::Horizontal ? keyAxis() : valueAxis())->rangeReversed();
     bool mirrorY = (valueAxis()->orientation() == Qt::Vertical ? valueAxis() : keyAxis())->rangeReversed();
-    mLegendIcon = QPixmap::fromImage(mMapImage.mirrored(mirrorX, mirrorY)).scaled(thumbSize, Qt::KeepAspectRatio, transformMode);
+    const QImage levelImage = colorizeLodCells(level, QRect(QPoint(0, 0), lodLevelSize(level)));
+    mLegendIcon = QPixmap::fromImage(levelImage.mirrored(mirrorX, mirrorY)).scaled(thumbSize, Qt::KeepAspectRatio, transformMode);
+  } else if (!mMapImage.isNull()) // might still be null, e.g. if data is empty, so check here again
+  {
+    bool mirrorX = (keyAxis()->orientation() == Qt::Horizontal ? keyAxis() : valueAxis())->rangeReversed();
+    bool mirrorY = (valueAxis()->orientation() == Qt::Vertical ? valueAxis() : keyAxis())->rangeReversed();
+    QImage mapImage(mMapImage.size(), mMapImage.format());
+    QPainter painter(&mapImage);
+    drawMapImage(&painter, mapImage.rect(), mirrorX, mirrorY);
+    painter.end();
+    mLegendIcon = QPixmap::fromImage(mapImage).scaled(thumbSize, Qt::KeepAspectRatio, transformMode);
   }
 }
 
@@ -782,6 +1322,9 @@ double QCPColorMap::selectTest(const QPointF &pos, bool onlySelectable, QVariant
   has been invalidated for a different reason (e.g. a change of the data range with \ref
   setDataRange).
   
+  The colorization of large maps is split across the global QThreadPool by \ref
+  QCPColorMapColorizer, with each thread writing its own range of scanlines.
+  
   If the map cell count is low, the image created will be oversampled in order to avoid a
   QPainter::drawImage bug which makes inner pixel boundaries jitter when stretch-drawing images
   without smooth transform enabled. Accordingly, oversampling isn't performed if \ref
@@ -816,25 +1359,14 @@ void QCPColorMap::updateMapImage()
   } else if (!mUndersampledMapImage.isNull())
     mUndersampledMapImage = QImage(); // don't need oversampling mechanism anymore (map size has changed) but mUndersampledMapImage still has nonzero size, free it
   
-  const double *rawData = mMapData->mData;
   if (keyAxis->orientation() == Qt::Horizontal)
   {
-    const int lineCount = valueSize;
-    const int rowCount = keySize;
-    for (int line=0; line<lineCount; ++line)
-    {
-      QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
-      mGradient.colorize(rawData+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
-    }
+    // each scanline holds the cells of one physical row (see QCPColorMapData::physicalRow), consecutive in the data:
+    QCPColorMapColorizer::colorize(mGradient, mDataRange, mDataScaleType==QCPAxis::stLogarithmic, mMapData, keySize, 1, localMapImage, valueSize, keySize);
   } else // keyAxis->orientation() == Qt::Vertical
   {
-    const int lineCount = keySize;
-    const int rowCount = valueSize;
-    for (int line=0; line<lineCount; ++line)
-    {
-      QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
-      mGradient.colorize(rawData+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
-    }
+    // each scanline holds the cells of one key index, keySize apart in the data:
+    QCPColorMapColorizer::colorize(mGradient, mDataRange, mDataScaleType==QCPAxis::stLogarithmic, mMapData, 1, keySize, localMapImage, keySize, valueSize);
   }
   
   if (keyOversamplingFactor > 1 || valueOversamplingFactor > 1)
@@ -845,9 +1377,83 @@ void QCPColorMap::updateMapImage()
       mMapImage = mUndersampledMapImage.scaled(valueSize*valueOversamplingFactor, keySize*keyOversamplingFactor, Qt::IgnoreAspectRatio, Qt::FastTransformation);
   }
   mMapData->mDataModified = false;
+  mMapData->mDirtyCells.clear();
+  mMapData->mDirtyCellCount = 0;
   mMapImageInvalidated = false;
 }
 
+/*! \internal
+  
+  Colorizes only the cells which were modified since the last update of the map image, as recorded
+  by \ref QCPColorMapData::markDirty, and writes them to the map image.
+  
+  This requires the map image to be up to date otherwise, i.e. the gradient, data range, data
+  scale type and map size haven't changed. If this isn't the case, or if the map image is
+  oversampled (see \ref updateMapImage), the entire map image is updated instead.
+*/
+void QCPColorMap::updateMapImageCells()
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis) return;
+  if (mMapData->isEmpty()) return;
+  
+  const int keySize = mMapData->keySize();
+  const int valueSize = mMapData->valueSize();
+  const bool keyIsHorizontal = keyAxis->orientation() == Qt::Horizontal;
+  const QSize imageSize = keyIsHorizontal ? QSize(keySize, valueSize) : QSize(valueSize, keySize);
+  if (mMapData->mDataModified || mMapImageInvalidated || !mUndersampledMapImage.isNull() || mMapImage.size() != imageSize)
+  {
+    updateMapImage();
+    return;
+  }
+  
+  const bool logarithmic = mDataScaleType == QCPAxis::stLogarithmic;
+  for (int i=0; i<mMapData->mDirtyCells.size(); ++i)
+  {
+    const QRect cells = mMapData->mDirtyCells.at(i) & QRect(0, 0, keySize, valueSize);
+    if (keyIsHorizontal)
+    {
+      // each scanline holds the cells of one physical row, colorize the modified span of each:
+      for (int row=cells.top(); row<=cells.bottom(); ++row)
+      {
+        QRgb *pixels = reinterpret_cast<QRgb*>(mMapImage.scanLine(valueSize-1-row))+cells.left();
+        mMapData->colorizeCells(mGradient, mDataRange, logarithmic, row*keySize+cells.left(), cells.width(), 1, pixels);
+      }
+    } else
+    {
+      // each scanline holds the cells of one key index, colorize the modified span of each:
+      for (int keyIndex=cells.left(); keyIndex<=cells.right(); ++keyIndex)
+      {
+        QRgb *pixels = reinterpret_cast<QRgb*>(mMapImage.scanLine(keySize-1-keyIndex))+cells.top();
+        mMapData->colorizeCells(mGradient, mDataRange, logarithmic, cells.top()*keySize+keyIndex, cells.height(), keySize, pixels);
+      }
+    }
+  }
+  mMapData->mDirtyCells.clear();
+  mMapData->mDirtyCellCount = 0;
+}
+
+
+/*! \internal
+  
+  Updates the map image ahead of the draw call if it is outdated, see \ref
+  QCPAbstractPlottable::prepareDraw. The map image only depends on the map data, the data range
+  and the gradient of this color map, so the colorization may run concurrently to the preparation
+  of other plottables.
+*/
+void QCPColorMap::prepareDraw()
+{
+  if (mMapData->isEmpty()) return;
+  if (!mKeyAxis || !mValueAxis) return;
+  
+  if (mLodReduction != lrNone)
+    updateLodLevels();
+  else if (mMapData->mDataModified || mMapImageInvalidated)
+    updateMapImage();
+  else if (!mMapData->mDirtyCells.isEmpty())
+    updateMapImageCells();
+}
+
 /* inherits documentation from base class */
 void QCPColorMap::draw(QCPPainter *painter)
 {
@@ -855,8 +1461,12 @@ void QCPColorMap::draw(QCPPainter *painter)
   if (!mKeyAxis || !mValueAxis) return;
   applyDefaultAntialiasingHint(painter);
   
-  if (mMapData->mDataModified || mMapImageInvalidated)
+  if (mLodReduction != lrNone)
+    updateLodLevels();
+  else if (mMapData->mDataModified || mMapImageInvalidated)
     updateMapImage();
+  else if (!mMapData->mDirtyCells.isEmpty())
+    updateMapImageCells();
   
   // use buffer if painting vectorized (PDF):
   bool useBuffer = painter->modes().testFlag(QCPPainter::pmVectorized);
@@ -905,7 +1515,10 @@ void QCPColorMap::draw(QCPPainter *painter)
                                   coordsToPixels(mMapData->keyRange().upper, mMapData->valueRange().upper)).normalized();
     localPainter->setClipRect(tightClipRect, Qt::IntersectClip);
   }
-  localPainter->drawImage(imageRect, mMapImage.mirrored(mirrorX, mirrorY));
+  if (mLodReduction != lrNone)
+    drawLodTiles(localPainter, mirrorX, mirrorY, useBuffer ? mapBufferPixelRatio : 1);
+  else
+    drawMapImage(localPainter, imageRect, mirrorX, mirrorY);
   if (mTightBoundary)
     localPainter->setClipRegion(clipBackup);
   localPainter->setRenderHint(QPainter::SmoothPixmapTransform, smoothBackup);
@@ -913,10 +1526,328 @@ void QCPColorMap::draw(QCPPainter *painter)
   if (useBuffer) // localPainter painted to mapBuffer, so now draw buffer with original painter
   {
     delete localPainter;
-    painter->drawPixmap(mapBufferTarget.toRect(), mapBuffer);
+    painter->drawPixmapOrImage(mapBufferTarget.toRect(), mapBuffer);
+  }
+}
+
+/*! \internal
+  
+  Draws the map image into \a rect with \a painter, mirrored horizontally and/or vertically as
+  given by \a mirrorX and \a mirrorY.
+  
+  If rows were appended to the map data with \ref QCPColorMapData::appendRow, the rows of the map
+  image are rotated like the ring buffer of the data (see \ref QCPColorMapData::physicalRow). The
+  two parts of the map image are then drawn separately at their respective places, so the map
+  image never needs to be reordered.
+*/
+void QCPColorMap::drawMapImage(QPainter *painter, const QRectF &rect, bool mirrorX, bool mirrorY) const
+{
+  const QImage mapImage = mMapImage.mirrored(mirrorX, mirrorY);
+  if (mMapData->mRowOffset == 0)
+  {
+    painter->drawImage(rect, mapImage);
+    return;
+  }
+  
+  // the value dimension runs vertically through the map image if the key axis is horizontal, and horizontally otherwise:
+  const bool valueIsVertical = keyAxis()->orientation() == Qt::Horizontal;
+  const int extent = valueIsVertical ? mapImage.height() : mapImage.width(); // in image pixels, including oversampling
+  const int offset = mMapData->mRowOffset*(extent/mMapData->valueSize());
+  // image pixel p along the value dimension belongs at (p+shift)%extent:
+  int shift = valueIsVertical ? offset : extent-offset; // image rows are ordered top to bottom, i.e. descending value index
+  if (valueIsVertical ? mirrorY : mirrorX)
+    shift = extent-shift;
+  const int split = extent-shift;
+  if (valueIsVertical)
+  {
+    const double scale = rect.height()/(double)extent;
+    painter->drawImage(QRectF(rect.left(), rect.top()+shift*scale, rect.width(), split*scale), mapImage, QRectF(0, 0, mapImage.width(), split));
+    painter->drawImage(QRectF(rect.left(), rect.top(), rect.width(), shift*scale), mapImage, QRectF(0, split, mapImage.width(), shift));
+  } else
+  {
+    const double scale = rect.width()/(double)extent;
+    painter->drawImage(QRectF(rect.left()+shift*scale, rect.top(), split*scale, rect.height()), mapImage, QRectF(0, 0, split, mapImage.height()));
+    painter->drawImage(QRectF(rect.left(), rect.top(), shift*scale, rect.height()), mapImage, QRectF(split, 0, shift, mapImage.height()));
+  }
+}
+
+/*! \internal
+  
+  Draws the visible part of the color map from the tiles of a level of detail (see \ref
+  setLodReduction), with the map image orientation given by \a mirrorX and \a mirrorY.
+  
+  The level is chosen such that it has no more than one cell per pixel in both dimensions. \a
+  pixelRatio is the number of device pixels per logical pixel of \a painter. Tiles which aren't
+  cached yet are colorized with \ref colorizeLodCells.
+*/
+void QCPColorMap::drawLodTiles(QCPPainter *painter, bool mirrorX, bool mirrorY, double pixelRatio)
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  const int keySize = mMapData->keySize();
+  const int valueSize = mMapData->valueSize();
+  if (keySize < 2 || valueSize < 2) // map has no extent in one dimension, see cell centering in setRange
+    return;
+  const QCPRange keyRange = mMapData->keyRange();
+  const QCPRange valueRange = mMapData->valueRange();
+  const double keyStep = (keyRange.upper-keyRange.lower)/(double)(keySize-1); // coordinate distance of neighbouring cells
+  const double valueStep = (valueRange.upper-valueRange.lower)/(double)(valueSize-1);
+  
+  // determine the cells in the visible axis ranges:
+  const double keyIndexLower = (keyAxis->range().lower-keyRange.lower)/keyStep;
+  const double keyIndexUpper = (keyAxis->range().upper-keyRange.lower)/keyStep;
+  const double valueIndexLower = (valueAxis->range().lower-valueRange.lower)/valueStep;
+  const double valueIndexUpper = (valueAxis->range().upper-valueRange.lower)/valueStep;
+  const int keyBegin = qMax(0, qFloor(qMin(keyIndexLower, keyIndexUpper)+0.5));
+  const int keyEnd = qMin(keySize-1, qFloor(qMax(keyIndexLower, keyIndexUpper)+0.5));
+  const int valueBegin = qMax(0, qFloor(qMin(valueIndexLower, valueIndexUpper)+0.5));
+  const int valueEnd = qMin(valueSize-1, qFloor(qMax(valueIndexLower, valueIndexUpper)+0.5));
+  if (keyBegin > keyEnd || valueBegin > valueEnd)
+    return;
+  
+  // choose the finest level of detail that has no more than one cell per pixel in both dimensions, so no cell is skipped when scaling:
+  const double keyPixels = qAbs(keyAxis->coordToPixel(keyRange.lower+(keyEnd+0.5)*keyStep)-keyAxis->coordToPixel(keyRange.lower+(keyBegin-0.5)*keyStep))*pixelRatio;
+  const double valuePixels = qAbs(valueAxis->coordToPixel(valueRange.lower+(valueEnd+0.5)*valueStep)-valueAxis->coordToPixel(valueRange.lower+(valueBegin-0.5)*valueStep))*pixelRatio;
+  const double cellsPerPixel = qMax((keyEnd-keyBegin+1)/keyPixels, (valueEnd-valueBegin+1)/valuePixels);
+  int level = 0;
+  while (level < mLodLevels.size() && (1<<level) < cellsPerPixel)
+    ++level;
+  
+  const QRect levelCells(QPoint(0, 0), lodLevelSize(level));
+  for (int valueTile=(valueBegin>>level)/lodTileSize; valueTile<=(valueEnd>>level)/lodTileSize; ++valueTile)
+  {
+    for (int keyTile=(keyBegin>>level)/lodTileSize; keyTile<=(keyEnd>>level)/lodTileSize; ++keyTile)
+    {
+      const QRect cells = QRect(keyTile*lodTileSize, valueTile*lodTileSize, lodTileSize, lodTileSize) & levelCells;
+      const quint64 tileKey = lodTileKey(level, keyTile, valueTile);
+      QImage *tile = mLodTiles.object(tileKey);
+      if (!tile)
+      {
+        tile = new QImage(colorizeLodCells(level, cells));
+        mLodTiles.insert(tileKey, tile, cells.width()*cells.height());
+      }
+      // the tile spans the cells of level 0 it was reduced from, the last cell of a level may be reduced from fewer cells at the map border:
+      const double keyLower = keyRange.lower+((cells.left()<<level)-0.5)*keyStep;
+      const double keyUpper = keyRange.lower+(qMin((cells.right()+1)<<level, keySize)-0.5)*keyStep;
+      const double valueLower = valueRange.lower+((cells.top()<<level)-0.5)*valueStep;
+      const double valueUpper = valueRange.lower+(qMin((cells.bottom()+1)<<level, valueSize)-0.5)*valueStep;
+      const QRectF tileRect = QRectF(coordsToPixels(keyLower, valueLower), coordsToPixels(keyUpper, valueUpper)).normalized();
+      painter->drawImage(tileRect, tile->mirrored(mirrorX, mirrorY));
+    }
+  }
+}
+
+/*! \internal
+  
+  Brings the levels of detail (see \ref setLodReduction) up to date with the map data, and discards
+  cached tiles which are outdated.
+  
+  If only some cells were modified since the last update (see \ref QCPColorMapData::markDirty),
+  only these cells are reduced again and only the tiles containing them are discarded. Otherwise,
+  all levels are rebuilt and all tiles are discarded.
+*/
+void QCPColorMap::updateLodLevels()
+{
+  const int valueSize = mMapData->valueSize();
+  if (mMapData->mDataModified || !mLodLevelsValid || mLodRowOffset != mMapData->mRowOffset)
+  {
+    // the coarsest level fits into a single tile:
+    int levelCount = 0;
+    if (!mMapData->isEmpty())
+    {
+      while (lodLevelSize(levelCount).width() > lodTileSize || lodLevelSize(levelCount).height() > lodTileSize)
+        ++levelCount;
+    }
+    mLodLevels.resize(levelCount);
+    for (int level=1; level<=levelCount; ++level)
+    {
+      const QSize size = lodLevelSize(level);
+      mLodLevels[level-1].resize(size.width()*size.height());
+    }
+    if (!mMapData->isEmpty())
+      reduceLodCells(QRect(0, 0, mMapData->keySize(), valueSize));
+    mLodTiles.clear();
+  } else
+  {
+    for (int i=0; i<mMapData->mDirtyCells.size(); ++i)
+    {
+      // dirty rects span physical rows, which may wrap around from the highest to the lowest value index:
+      const QRect rows = mMapData->mDirtyCells.at(i);
+      int valueIndex = rows.top()-mLodRowOffset;
+      if (valueIndex < 0)
+        valueIndex += valueSize;
+      int remaining = rows.height();
+      while (remaining > 0)
+      {
+        const int count = qMin(remaining, valueSize-valueIndex);
+        const QRect cells(rows.left(), valueIndex, rows.width(), count);
+        reduceLodCells(cells);
+        removeLodTiles(cells);
+        remaining -= count;
+        valueIndex = 0;
+      }
+    }
+    if (mMapImageInvalidated) // gradient, data range or data scale type changed
+      mLodTiles.clear();
+  }
+  mMapData->mDataModified = false;
+  mMapData->mDirtyCells.clear();
+  mMapData->mDirtyCellCount = 0;
+  mLodRowOffset = mMapData->mRowOffset;
+  mLodLevelsValid = true;
+  mMapImageInvalidated = false;
+}
+
+/*! \internal
+  
+  Reduces the cells of all levels of detail which cover the \a cells of the map data (key indices
+  horizontally, value indices vertically), level by level from the finer to the coarser one, as
+  given by \ref setLodReduction.
+*/
+void QCPColorMap::reduceLodCells(const QRect &cells)
+{
+  const bool useMaximum = mLodReduction == lrMaximum;
+  QVector<double> sourceBuffer, nextSourceBuffer; // for rows of the map data that aren't stored as double
+  for (int level=1; level<=mLodLevels.size(); ++level)
+  {
+    const QSize sourceSize = lodLevelSize(level-1);
+    const int levelKeySize = lodLevelSize(level).width();
+    double *levelData = mLodLevels[level-1].data();
+    for (int valueIndex=cells.top()>>level; valueIndex<=cells.bottom()>>level; ++valueIndex)
+    {
+      // each cell is reduced from up to 2x2 cells of the finer level, fewer at the map border:
+      const double *sourceRow = lodRow(level-1, 2*valueIndex, sourceBuffer);
+      const double *nextSourceRow = 2*valueIndex+1 < sourceSize.height() ? lodRow(level-1, 2*valueIndex+1, nextSourceBuffer) : 0;
+      double *row = levelData+valueIndex*levelKeySize;
+      for (int keyIndex=cells.left()>>level; keyIndex<=cells.right()>>level; ++keyIndex)
+      {
+        const int sourceKey = 2*keyIndex;
+        const bool hasNextKey = sourceKey+1 < sourceSize.width();
+        double result = sourceRow[sourceKey];
+        if (useMaximum)
+        {
+          if (hasNextKey) result = qMax(result, sourceRow[sourceKey+1]);
+          if (nextSourceRow) result = qMax(result, nextSourceRow[sourceKey]);
+          if (nextSourceRow && hasNextKey) result = qMax(result, nextSourceRow[sourceKey+1]);
+        } else
+        {
+          int count = 1;
+          if (hasNextKey) { result += sourceRow[sourceKey+1]; ++count; }
+          if (nextSourceRow) { result += nextSourceRow[sourceKey]; ++count; }
+          if (nextSourceRow && hasNextKey) { result += nextSourceRow[sourceKey+1]; ++count; }
+          result /= count;
+        }
+        row[keyIndex] = result;
+      }
+    }
+  }
+}
+
+/*! \internal
+  
+  Discards the cached tiles of all levels of detail which cover any of the \a cells of the map
+  data (key indices horizontally, value indices vertically).
+*/
+void QCPColorMap::removeLodTiles(const QRect &cells)
+{
+  for (int level=0; level<=mLodLevels.size(); ++level)
+  {
+    for (int valueTile=(cells.top()>>level)/lodTileSize; valueTile<=(cells.bottom()>>level)/lodTileSize; ++valueTile)
+    {
+      for (int keyTile=(cells.left()>>level)/lodTileSize; keyTile<=(cells.right()>>level)/lodTileSize; ++keyTile)
+        mLodTiles.remove(lodTileKey(level, keyTile, valueTile));
+    }
   }
 }
 
+/*! \internal
+  
+  Returns the number of cells in key (width) and value (height) dimension of the given level of
+  detail. Level 0 is the map data itself, each further level halves the number of cells (rounding
+  up).
+*/
+QSize QCPColorMap::lodLevelSize(int level) const
+{
+  return QSize(((mMapData->keySize()-1)>>level)+1, ((mMapData->valueSize()-1)>>level)+1);
+}
+
+/*! \internal
+  
+  Returns a pointer to the cells of \a valueIndex in the given level of detail, ordered by key
+  index. For level 0, this is the corresponding row of the map data. If the map data isn't stored
+  as double (see \ref QCPColorMapData::setCellType), the row is converted into \a buffer first.
+*/
+const double *QCPColorMap::lodRow(int level, int valueIndex, QVector<double> &buffer) const
+{
+  if (level == 0)
+  {
+    const int index = mMapData->physicalRow(valueIndex)*mMapData->keySize();
+    if (mMapData->cellType() == QCPColorMapData::ctDouble)
+      return reinterpret_cast<const double*>(mMapData->mData)+index;
+    buffer.resize(mMapData->keySize());
+    mMapData->readCells(index, mMapData->keySize(), buffer.data());
+    return buffer.constData();
+  } else
+    return mLodLevels.at(level-1).constData()+valueIndex*lodLevelSize(level).width();
+}
+
+/*! \internal
+  
+  Colorizes the \a cells of the given level of detail (key indices horizontally, value indices
+  vertically) and returns them as an image, oriented like the map image (see \ref updateMapImage).
+*/
+QImage QCPColorMap::colorizeLodCells(int level, const QRect &cells)
+{
+  const bool keyIsHorizontal = mKeyAxis.data()->orientation() == Qt::Horizontal;
+  const bool logarithmic = mDataScaleType == QCPAxis::stLogarithmic;
+  const int levelKeySize = lodLevelSize(level).width();
+  QImage image(keyIsHorizontal ? cells.size() : cells.size().transposed(), QImage::Format_RGB32);
+  if (keyIsHorizontal)
+  {
+    // each scanline holds the cells of one value index, highest value index on top:
+    for (int valueIndex=cells.top(); valueIndex<=cells.bottom(); ++valueIndex)
+    {
+      QRgb *pixels = reinterpret_cast<QRgb*>(image.scanLine(cells.bottom()-valueIndex));
+      if (level == 0)
+        mMapData->colorizeCells(mGradient, mDataRange, logarithmic, mMapData->physicalRow(valueIndex)*levelKeySize+cells.left(), cells.width(), 1, pixels);
+      else
+        mGradient.colorize(mLodLevels.at(level-1).constData()+valueIndex*levelKeySize+cells.left(), mDataRange, pixels, cells.width(), 1, logarithmic);
+    }
+  } else
+  {
+    // each scanline holds the cells of one key index, highest key index on top:
+    for (int keyIndex=cells.left(); keyIndex<=cells.right(); ++keyIndex)
+    {
+      QRgb *pixels = reinterpret_cast<QRgb*>(image.scanLine(cells.right()-keyIndex));
+      // the cells are levelKeySize apart, except where the rows of level 0 wrap around the end of the ring buffer:
+      int valueIndex = cells.top();
+      while (valueIndex <= cells.bottom())
+      {
+        int count = cells.bottom()-valueIndex+1;
+        if (level == 0)
+        {
+          const int row = mMapData->physicalRow(valueIndex);
+          count = qMin(count, mMapData->valueSize()-row);
+          mMapData->colorizeCells(mGradient, mDataRange, logarithmic, row*levelKeySize+keyIndex, count, levelKeySize, pixels+valueIndex-cells.top());
+        } else
+          mGradient.colorize(mLodLevels.at(level-1).constData()+valueIndex*levelKeySize+keyIndex, mDataRange, pixels+valueIndex-cells.top(), count, levelKeySize, logarithmic);
+        valueIndex += count;
+      }
+    }
+  }
+  return image;
+}
+
+/*! \internal
+  
+  Returns the key of the tile with indices \a keyTile and \a valueTile of the given level of detail
+  in the tile cache.
+*/
+quint64 QCPColorMap::lodTileKey(int level, int keyTile, int valueTile)
+{
+  return (quint64(level)<<48) | (quint64(valueTile)<<24) | quint64(keyTile);
+}
+
 /* inherits documentation from base class */
 void QCPColorMap::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 {
@@ -927,7 +1858,7 @@ void QCPColorMap::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
     QPixmap scaledIcon = mLegendIcon.scaled(rect.size().toSize(), Qt::KeepAspectRatio, Qt::FastTransformation);
     QRectF iconRect = QRectF(0, 0, scaledIcon.width(), scaledIcon.height());
     iconRect.moveCenter(rect.center());
-    painter->drawPixmap(iconRect.topLeft(), scaledIcon);
+    painter->drawPixmapOrImage(iconRect.topLeft(), scaledIcon);
   }
   /*
   // draw frame:
@@ -981,3 +1912,113 @@ QCPRange QCPColorMap::getValueRange(bool &foundRange, SignDomain inSignDomain) c
   return result;
 }
 
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPColorMapColorizer
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPColorMapColorizer
+  
+  \internal
+  \brief (Private)
+  
+  This is a private class and not part of the public QCustomPlot interface.
+  
+  It colorizes the cells of a color map into the scanlines of the map image, see \ref
+  QCPColorMap::updateMapImage. Each instance colorizes a range of scanlines with its own copy of
+  the color gradient, so multiple ranges can be colorized in parallel on the global QThreadPool
+  without synchronization. Every scanline is colorized exactly like in a serial loop, so the result
+  doesn't depend on the number of threads, see \ref colorize.
+*/
+
+/*!
+  Creates a task that colorizes the scanlines \a beginLine to \a endLine (exclusive) of an image
+  with \a lineCount scanlines, whose pixel data starts at \a bits with \a bytesPerLine bytes per
+  scanline. \a rowCount pixels are colorized per scanline. The scanlines are counted from the
+  bottom of the image.
+  
+  The cells of scanline \a line start at index \a line * \a dataLineStep of the cells of \a data,
+  with consecutive cells \a dataIndexFactor apart. They are read in the cell type of \a data (see
+  \ref QCPColorMapData::setCellType) and colorized with \a gradient for the data range \a range, on a
+  logarithmic scale if \a logarithmic is true. When done, the task releases \a finished once.
+*/
+QCPColorMapColorizer::QCPColorMapColorizer(const QCPColorGradient &gradient, const QCPRange &range, bool logarithmic, const QCPColorMapData *data, int dataLineStep, int dataIndexFactor, uchar *bits, int bytesPerLine, int lineCount, int rowCount, int beginLine, int endLine, QSemaphore *finished) :
+  mGradient(gradient),
+  mRange(range),
+  mLogarithmic(logarithmic),
+  mData(data),
+  mDataLineStep(dataLineStep),
+  mDataIndexFactor(dataIndexFactor),
+  mBits(bits),
+  mBytesPerLine(bytesPerLine),
+  mLineCount(lineCount),
+  mRowCount(rowCount),
+  mBeginLine(beginLine),
+  mEndLine(endLine),
+  mFinished(finished)
+{
+}
+
+/* inherits documentation from base class */
+void QCPColorMapColorizer::run()
+{
+  for (int line=mBeginLine; line<mEndLine; ++line)
+  {
+    // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system):
+    QRgb *pixels = reinterpret_cast<QRgb*>(mBits+qint64(mBytesPerLine)*(mLineCount-1-line));
+    mData->colorizeCells(mGradient, mRange, mLogarithmic, line*mDataLineStep, mRowCount, mDataIndexFactor, pixels);
+  }
+  if (mFinished)
+    mFinished->release();
+}
+
+/*!
+  Colorizes \a lineCount scanlines with \a rowCount pixels each of \a image, which must have the
+  format QImage::Format_RGB32 or QImage::Format_ARGB32. For the meaning of the other parameters,
+  see the constructor.
+  
+  Large images are split into ranges of scanlines that are colorized in parallel. The calling
+  thread takes part in the work, and as many idle threads of the global thread pool as are
+  available are used in addition. Since the ranges are disjoint, the threads don't share any
+  scanlines, and the result is identical to colorizing the scanlines one after another.
+*/
+void QCPColorMapColorizer::colorize(const QCPColorGradient &gradient, const QCPRange &range, bool logarithmic, const QCPColorMapData *data, int dataLineStep, int dataIndexFactor, QImage *image, int lineCount, int rowCount)
+{
+  if (lineCount <= 0 || rowCount <= 0)
+    return;
+  // detach the image here, since QImage::bits isn't safe to call concurrently on a shared image:
+  uchar *bits = image->bits();
+  
+  // ranges must be large, so colorizing them outweighs the cost of starting a task:
+  const int minCellsPerTask = 65536;
+  const int taskCount = qBound(1, int(qint64(lineCount)*rowCount/minCellsPerTask), qMin(lineCount, QThreadPool::globalInstance()->maxThreadCount()));
+  if (taskCount == 1)
+  {
+    QCPColorMapColorizer task(gradient, range, logarithmic, data, dataLineStep, dataIndexFactor, bits, image->bytesPerLine(), lineCount, rowCount, 0, lineCount, 0);
+    task.run();
+    return;
+  }
+  
+  QSemaphore finished;
+  QList<QCPColorMapColorizer*> tasks;
+  for (int i=0; i<taskCount; ++i)
+  {
+    const int beginLine = int(qint64(lineCount)*i/taskCount);
+    const int endLine = int(qint64(lineCount)*(i+1)/taskCount);
+    QCPColorMapColorizer *task = new QCPColorMapColorizer(gradient, range, logarithmic, data, dataLineStep, dataIndexFactor, bits, image->bytesPerLine(), lineCount, rowCount, beginLine, endLine, &finished);
+    task->setAutoDelete(false); // the tasks are deleted after all of them have finished
+    tasks.append(task);
+  }
+  // start all tasks but the first one in the thread pool, tasks for which no thread is idle are run by the calling thread:
+  QList<QCPColorMapColorizer*> remainingTasks;
+  remainingTasks.append(tasks.first());
+  for (int i=1; i<tasks.size(); ++i)
+  {
+    if (!QThreadPool::globalInstance()->tryStart(tasks.at(i)))
+      remainingTasks.append(tasks.at(i));
+  }
+  for (int i=0; i<remainingTasks.size(); ++i)
+    remainingTasks.at(i)->run();
+  finished.acquire(taskCount);
+  qDeleteAll(tasks);
+}
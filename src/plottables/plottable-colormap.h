@@ -39,7 +39,16 @@ class QCPColorMap;
 class QCP_LIB_DECL QCPColorMapData
 {
 public:
-  QCPColorMapData(int keySize, int valueSize, const QCPRange &keyRange, const QCPRange &valueRange);
+  /*!
+    Defines the type in which the cells are stored.
+    \see setCellType
+  */
+  enum CellType { ctDouble  ///< 8 bytes per cell, double precision floating point
+                  ,ctFloat  ///< 4 bytes per cell, single precision floating point
+                  ,ctUInt16 ///< 2 bytes per cell, unsigned integers from 0 to 65535. Other values are rounded and clamped to this range
+                };
+  
+  QCPColorMapData(int keySize, int valueSize, const QCPRange &keyRange, const QCPRange &valueRange, CellType cellType=ctDouble);
   ~QCPColorMapData();
   QCPColorMapData(const QCPColorMapData &other);
   QCPColorMapData &operator=(const QCPColorMapData &other);
@@ -50,6 +59,7 @@ public:
   QCPRange keyRange() const { return mKeyRange; }
   QCPRange valueRange() const { return mValueRange; }
   QCPRange dataBounds() const { return mDataBounds; }
+  CellType cellType() const { return mCellType; }
   double data(double key, double value);
   double cell(int keyIndex, int valueIndex);
   
@@ -62,6 +72,19 @@ public:
   void setValueRange(const QCPRange &valueRange);
   void setData(double key, double value, double z);
   void setCell(int keyIndex, int valueIndex, double z);
+  void setCellType(CellType type);
+  void setRow(int valueIndex, const double *data);
+  void setRow(int valueIndex, const float *data);
+  void setRow(int valueIndex, const quint16 *data);
+  void setColumn(int keyIndex, const double *data);
+  void setColumn(int keyIndex, const float *data);
+  void setColumn(int keyIndex, const quint16 *data);
+  void setBlock(int keyIndex, int valueIndex, int keyCount, int valueCount, const double *data);
+  void setBlock(int keyIndex, int valueIndex, int keyCount, int valueCount, const float *data);
+  void setBlock(int keyIndex, int valueIndex, int keyCount, int valueCount, const quint16 *data);
+  void appendRow(const double *data);
+  void appendRow(const float *data);
+  void appendRow(const quint16 *data);
   
   // non-property methods:
   void recalculateDataBounds();
@@ -76,12 +99,38 @@ protected:
   int mKeySize, mValueSize;
   QCPRange mKeyRange, mValueRange;
   bool mIsEmpty;
+  CellType mCellType;
   // non-property members:
-  double *mData;
+  char *mData; // cells of type mCellType
   QCPRange mDataBounds;
-  bool mDataModified;
+  bool mDataModified; // all cells need to be colorized again
+  QList<QRect> mDirtyCells; // cell rectangles modified since the last colorization, x is the key index, y the physical row
+  int mDirtyCellCount;
+  int mRowOffset; // physical row of value index 0, rows form a ring buffer (see appendRow)
+  static const int maxDirtyRects;
+  
+  // non-virtual methods:
+  void markDirty(const QRect &cells);
+  void markModified();
+  int physicalRow(int valueIndex) const { return valueIndex < mValueSize-mRowOffset ? valueIndex+mRowOffset : valueIndex+mRowOffset-mValueSize; }
+  double cellValue(int index) const;
+  double setCellValue(int index, double z);
+  void readCells(int index, int count, double *target) const;
+  void colorizeCells(QCPColorGradient &gradient, const QCPRange &range, bool logarithmic, int index, int count, int indexStep, QRgb *scanLine) const;
+  template <typename T> void setCells(int keyIndex, int valueIndex, int keyCount, int valueCount, const T *data);
+  template <typename T> void appendCells(const T *data);
+  
+  // static methods:
+  static int cellSize(CellType type);
+  static char *allocateCells(CellType type, int count);
+  template <typename T> static void convertCells(const T *source, int count, char *target, CellType targetType);
+  static CellType cellTypeOf(const double *) { return ctDouble; }
+  static CellType cellTypeOf(const float *) { return ctFloat; }
+  static CellType cellTypeOf(const quint16 *) { return ctUInt16; }
+  static quint16 toUInt16(double z) { return !(z > 0) ? 0 : (z < 65535 ? quint16(z+0.5) : 65535); }
   
   friend class QCPColorMap;
+  friend class QCPColorMapColorizer;
 };
 
 
@@ -95,8 +144,19 @@ class QCP_LIB_DECL QCPColorMap : public QCPAbstractPlottable
   Q_PROPERTY(bool interpolate READ interpolate WRITE setInterpolate)
   Q_PROPERTY(bool tightBoundary READ tightBoundary WRITE setTightBoundary)
   Q_PROPERTY(QCPColorScale* colorScale READ colorScale WRITE setColorScale)
+  Q_PROPERTY(LodReduction lodReduction READ lodReduction WRITE setLodReduction)
   /// \endcond
 public:
+  /*!
+    Defines whether and how the cells are reduced for drawing at lower levels of detail.
+    \see setLodReduction
+  */
+  enum LodReduction { lrNone    ///< the entire map is colorized at full resolution and scaled to the screen by the painter
+                      ,lrMean    ///< each cell of a level of detail holds the mean of the 2x2 cells it covers in the next finer level
+                      ,lrMaximum ///< each cell of a level of detail holds the maximum of the 2x2 cells it covers in the next finer level, so isolated peaks stay visible
+                    };
+  Q_ENUMS(LodReduction)
+  
   explicit QCPColorMap(QCPAxis *keyAxis, QCPAxis *valueAxis);
   virtual ~QCPColorMap();
   
@@ -108,6 +168,7 @@ public:
   bool tightBoundary() const { return mTightBoundary; }
   QCPColorGradient gradient() const { return mGradient; }
   QCPColorScale *colorScale() const { return mColorScale.data(); }
+  LodReduction lodReduction() const { return mLodReduction; }
   
   // setters:
   void setData(QCPColorMapData *data, bool copy=false);
@@ -117,6 +178,7 @@ public:
   void setInterpolate(bool enabled);
   void setTightBoundary(bool enabled);
   void setColorScale(QCPColorScale *colorScale);
+  void setLodReduction(LodReduction reduction);
   
   // non-property methods:
   void rescaleDataRange(bool recalculateDataBounds=false);
@@ -140,23 +202,68 @@ protected:
   bool mInterpolate;
   bool mTightBoundary;
   QPointer<QCPColorScale> mColorScale;
+  LodReduction mLodReduction;
   // non-property members:
   QImage mMapImage, mUndersampledMapImage;
   QPixmap mLegendIcon;
   bool mMapImageInvalidated;
+  QVector<QVector<double> > mLodLevels; // reduced cells of the levels of detail 1, 2, ..., in value index order
+  bool mLodLevelsValid;
+  int mLodRowOffset; // row offset of the map data when mLodLevels were built
+  QCache<quint64, QImage> mLodTiles; // colorized tiles of all levels of detail, see lodTileKey
+  static const int lodTileSize;
   
   // introduced virtual methods:
   virtual void updateMapImage();
+  virtual void updateMapImageCells();
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter);
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const;
   virtual QCPRange getKeyRange(bool &foundRange, SignDomain inSignDomain=sdBoth) const;
   virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain=sdBoth) const;
+  virtual void prepareDraw();
+  
+  // non-virtual methods:
+  void drawMapImage(QPainter *painter, const QRectF &rect, bool mirrorX, bool mirrorY) const;
+  void drawLodTiles(QCPPainter *painter, bool mirrorX, bool mirrorY, double pixelRatio);
+  void updateLodLevels();
+  void reduceLodCells(const QRect &cells);
+  void removeLodTiles(const QRect &cells);
+  QSize lodLevelSize(int level) const;
+  const double *lodRow(int level, int valueIndex, QVector<double> &buffer) const;
+  QImage colorizeLodCells(int level, const QRect &cells);
+  
+  // static methods:
+  static quint64 lodTileKey(int level, int keyTile, int valueTile);
   
   friend class QCustomPlot;
   friend class QCPLegend;
 };
 
+
+class QCP_LIB_DECL QCPColorMapColorizer : public QRunnable
+{
+public:
+  QCPColorMapColorizer(const QCPColorGradient &gradient, const QCPRange &range, bool logarithmic, const QCPColorMapData *data, int dataLineStep, int dataIndexFactor, uchar *bits, int bytesPerLine, int lineCount, int rowCount, int beginLine, int endLine, QSemaphore *finished);
+  
+  // reimplemented virtual methods:
+  virtual void run();
+  
+  // static methods:
+  static void colorize(const QCPColorGradient &gradient, const QCPRange &range, bool logarithmic, const QCPColorMapData *data, int dataLineStep, int dataIndexFactor, QImage *image, int lineCount, int rowCount);
+  
+protected:
+  QCPColorGradient mGradient;
+  QCPRange mRange;
+  bool mLogarithmic;
+  const QCPColorMapData *mData;
+  int mDataLineStep, mDataIndexFactor;
+  uchar *mBits;
+  int mBytesPerLine, mLineCount, mRowCount;
+  int mBeginLine, mEndLine;
+  QSemaphore *mFinished;
+};
+
 #endif // QCP_PLOTTABLE_COLORMAP_H
  
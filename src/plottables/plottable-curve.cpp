@@ -68,6 +68,597 @@ QCPCurveData::QCPCurveData(double t, double key, double value) :
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPCurveDataContainer
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPCurveDataContainer
+  \brief Holds the data points of a QCPCurve, sorted by their curve parameter t.
+  
+  The data points (\ref QCPCurveData) are stored column-wise in contiguous memory, ordered
+  ascending by t. Multiple data points with the same t may exist, they keep the order in which they
+  were added. Since the data points aren't stored as QCPCurveData instances, \ref at and the const
+  iterators return them by value. Use \ref tAt, \ref keyAt and \ref valueAt to access single
+  columns.
+  
+  QCPCurveDataContainer provides the subset of the QMap interface that was commonly used when
+  QCPCurve stored its data in a QMap. The \a key() of its iterators is the curve parameter t. For
+  backward compatibility, \ref QCPCurveDataMap is a typedef of this class.
+  
+  The non-const STL-style iterators (\ref iterator) return a \ref reference to the data point,
+  which writes modifications back to the container, so code like <tt>it.value().key = 5;</tt>
+  written for QMap keeps working. Loops that change many coordinates are faster with \ref setKeyAt
+  and \ref setValueAt. Other modifications are done with the methods of this class (e.g. \ref
+  replace) or of QCPCurve. Code written for the Java-style QMap iterators can use \ref
+  QCPCurveDataMapIterator and \ref QCPCurveDataMutableMapIterator. Like with QVector, iterators
+  and indices are invalidated when the container is modified by other means than the iterator
+  itself.
+  
+  \see QCPCurve::data, setSinglePrecisionValues
+*/
+
+/* start of documentation of inline functions */
+
+/*! \fn bool QCPCurveDataContainer::singlePrecisionValues() const
+  
+  Returns whether the values are stored with single precision.
+  
+  \see setSinglePrecisionValues
+*/
+
+/*! \fn QCPCurveData QCPCurveDataContainer::at(int index) const
+  
+  Returns the data point at \a index. The data points are ordered ascending by t, so index 0 is the
+  data point with the lowest t. \a index must be a valid index, i.e. 0 <= \a index < \ref size.
+  
+  \see tAt, keyAt, valueAt
+*/
+
+/*! \fn quint32 QCPCurveDataContainer::revision() const
+  
+  Returns a number that changes whenever the data points of this container are modified. QCPCurve
+  uses this to determine whether its cached data bounds are still up to date.
+  
+  \see QCPDataContainer::revision
+*/
+
+/*! \fn double QCPCurveDataContainer::valueAt(int index) const
+  
+  Returns the value of the data point at \a index. If \ref setSinglePrecisionValues is enabled, the
+  stored single precision value is converted to double.
+*/
+
+/* end of documentation of inline functions */
+
+/*!
+  Constructs an empty curve data container.
+*/
+QCPCurveDataContainer::QCPCurveDataContainer() :
+  mSinglePrecisionValues(false),
+  mRevision(0)
+{
+}
+
+/*!
+  Sets whether the values of the data points are stored with single precision (float) instead of
+  double precision. Together with the double precision t and key columns, this reduces memory
+  consumption by a sixth per data point. The t parameter and keys are always stored with double
+  precision.
+  
+  Values that are already stored are converted. When switching to single precision, this loses
+  precision accordingly.
+  
+  \see QCPCurve::setSinglePrecisionValues
+*/
+void QCPCurveDataContainer::setSinglePrecisionValues(bool enabled)
+{
+  if (mSinglePrecisionValues == enabled)
+    return;
+  mSinglePrecisionValues = enabled;
+  if (mSinglePrecisionValues)
+  {
+    mFloatValues.resize(mValues.size());
+    for (int i=0; i<mValues.size(); ++i)
+      mFloatValues[i] = mValues.at(i);
+    mValues.clear();
+  } else
+  {
+    mValues.resize(mFloatValues.size());
+    for (int i=0; i<mFloatValues.size(); ++i)
+      mValues[i] = mFloatValues.at(i);
+    mFloatValues.clear();
+  }
+  ++mRevision;
+}
+
+/*!
+  Returns the index of the first data point with a t greater than or equal to \a t. If all data
+  points have smaller t, returns \ref size.
+  
+  \see findEnd, lowerBound
+*/
+int QCPCurveDataContainer::findBegin(double t) const
+{
+  return std::lower_bound(mT.constBegin(), mT.constEnd(), t)-mT.constBegin();
+}
+
+/*!
+  Returns the index of the first data point with a t greater than \a t. If no data point has a
+  greater t, returns \ref size.
+  
+  \see findBegin, upperBound
+*/
+int QCPCurveDataContainer::findEnd(double t) const
+{
+  return std::upper_bound(mT.constBegin(), mT.constEnd(), t)-mT.constBegin();
+}
+
+/*!
+  Returns an iterator to the first data point with exactly the parameter \a t, or \ref constEnd if
+  there is no such data point.
+*/
+QCPCurveDataContainer::const_iterator QCPCurveDataContainer::constFind(double t) const
+{
+  int index = findBegin(t);
+  if (index < mT.size() && mT.at(index) == t)
+    return const_iterator(this, index);
+  else
+    return constEnd();
+}
+
+/*!
+  Replaces the current data with the data points in \a data.
+  
+  If \a alreadySorted is true, \a data must be sorted ascending by t. If it is false, the data
+  points are checked for order and sorted if necessary.
+*/
+void QCPCurveDataContainer::set(const QVector<QCPCurveData> &data, bool alreadySorted)
+{
+  QVector<QCPCurveData> sortedData(data);
+  if (!alreadySorted && !isSorted(sortedData))
+    std::stable_sort(sortedData.begin(), sortedData.end(), lessThanT);
+  
+  const int n = sortedData.size();
+  mT.resize(n);
+  mKeys.resize(n);
+  if (mSinglePrecisionValues)
+    mFloatValues.resize(n);
+  else
+    mValues.resize(n);
+  for (int i=0; i<n; ++i)
+  {
+    const QCPCurveData &point = sortedData.at(i);
+    mT[i] = point.t;
+    mKeys[i] = point.key;
+    if (mSinglePrecisionValues)
+      mFloatValues[i] = point.value;
+    else
+      mValues[i] = point.value;
+  }
+  ++mRevision;
+}
+
+/*! \overload
+  
+  Adds the data points in \a data to the container.
+  
+  If \a alreadySorted is true, \a data must be sorted ascending by t. If it is false, the data
+  points are checked for order and sorted if necessary. If the new data points all have a t
+  greater than or equal to the existing ones, they are simply appended, otherwise they are merged
+  into the existing ones.
+*/
+void QCPCurveDataContainer::add(const QVector<QCPCurveData> &data, bool alreadySorted)
+{
+  if (data.isEmpty())
+    return;
+  if (isEmpty())
+  {
+    set(data, alreadySorted);
+    return;
+  }
+  
+  const bool sorted = alreadySorted || isSorted(data);
+  if (sorted && !(data.first().t < mT.last())) // new data extends existing data, append it
+  {
+    reserve(size()+data.size());
+    for (int i=0; i<data.size(); ++i)
+      insertData(size(), data.at(i));
+  } else // merge new data into existing data
+  {
+    QVector<QCPCurveData> merged = toVector();
+    const int oldSize = merged.size();
+    merged.reserve(oldSize+data.size());
+    for (int i=0; i<data.size(); ++i)
+      merged.append(data.at(i));
+    if (!sorted)
+      std::stable_sort(merged.begin()+oldSize, merged.end(), lessThanT);
+    std::inplace_merge(merged.begin(), merged.begin()+oldSize, merged.end(), lessThanT);
+    set(merged, true);
+  }
+}
+
+/*! \overload
+  
+  Adds all data points of \a other to this container. Equivalent to QMap::unite.
+*/
+void QCPCurveDataContainer::add(const QCPCurveDataContainer &other)
+{
+  add(other.toVector(), true);
+}
+
+/*! \overload
+  
+  Adds the single data point \a data to the container, behind existing data points with the same
+  t.
+*/
+void QCPCurveDataContainer::add(const QCPCurveData &data)
+{
+  insertData(findEnd(data.t), data);
+}
+
+/*!
+  Inserts \a data with the parameter \a t into the container. If a data point with exactly the
+  parameter \a t already exists, it is replaced. The t member of \a data is set to \a t. This
+  function corresponds to QMap::insert.
+  
+  \see insertMulti, add
+*/
+void QCPCurveDataContainer::insert(double t, const QCPCurveData &data)
+{
+  QCPCurveData newData(data);
+  newData.t = t;
+  int index = findBegin(t);
+  if (index < mT.size() && mT.at(index) == t)
+    eraseData(index, index+1);
+  insertData(index, newData);
+}
+
+/*!
+  Inserts \a data with the parameter \a t into the container, even if data points with the same
+  t already exist. The t member of \a data is set to \a t. This function corresponds to
+  QMap::insertMulti.
+  
+  \see insert, add
+*/
+void QCPCurveDataContainer::insertMulti(double t, const QCPCurveData &data)
+{
+  QCPCurveData newData(data);
+  newData.t = t;
+  add(newData);
+}
+
+/*!
+  Replaces the data point at \a index with \a data. The parameter t of the data point stays the
+  same, the t member of \a data is ignored, so the order is preserved. This is the equivalent of
+  assigning to the value of a QMap iterator.
+  
+  \a index must be a valid index, i.e. 0 <= \a index < \ref size.
+  
+  \see insert, QCPCurveDataMutableMapIterator::setValue
+*/
+void QCPCurveDataContainer::replace(int index, const QCPCurveData &data)
+{
+  if (index < 0 || index >= mT.size())
+  {
+    qDebug() << Q_FUNC_INFO << "index out of bounds:" << index;
+    return;
+  }
+  mKeys[index] = data.key;
+  if (mSinglePrecisionValues)
+    mFloatValues[index] = data.value;
+  else
+    mValues[index] = data.value;
+  ++mRevision;
+}
+
+/*!
+  Sets the key of the data point at \a index to \a key. The parameter t stays the same.
+  
+  \a index must be a valid index, i.e. 0 <= \a index < \ref size.
+  
+  \see keyAt, setValueAt, replace
+*/
+void QCPCurveDataContainer::setKeyAt(int index, double key)
+{
+  if (index < 0 || index >= mT.size())
+  {
+    qDebug() << Q_FUNC_INFO << "index out of bounds:" << index;
+    return;
+  }
+  mKeys[index] = key;
+  ++mRevision;
+}
+
+/*!
+  Sets the value of the data point at \a index to \a value. The parameter t stays the same.
+  
+  \a index must be a valid index, i.e. 0 <= \a index < \ref size.
+  
+  \see valueAt, setKeyAt, replace
+*/
+void QCPCurveDataContainer::setValueAt(int index, double value)
+{
+  if (index < 0 || index >= mT.size())
+  {
+    qDebug() << Q_FUNC_INFO << "index out of bounds:" << index;
+    return;
+  }
+  if (mSinglePrecisionValues)
+    mFloatValues[index] = value;
+  else
+    mValues[index] = value;
+  ++mRevision;
+}
+
+/*!
+  Removes all data points with t smaller than \a t.
+*/
+void QCPCurveDataContainer::removeBefore(double t)
+{
+  eraseData(0, findBegin(t));
+}
+
+/*!
+  Removes all data points with t greater than \a t.
+*/
+void QCPCurveDataContainer::removeAfter(double t)
+{
+  eraseData(findEnd(t), size());
+}
+
+/*!
+  Removes all data points with t greater than \a fromT and smaller than or equal to \a toT. If \a
+  fromT is greater than or equal to \a toT, this function does nothing.
+*/
+void QCPCurveDataContainer::remove(double fromT, double toT)
+{
+  if (fromT >= toT)
+    return;
+  eraseData(findEnd(fromT), findEnd(toT));
+}
+
+/*! \overload
+  
+  Removes all data points with exactly the parameter \a t and returns the number of removed data
+  points. This function corresponds to QMap::remove.
+*/
+int QCPCurveDataContainer::remove(double t)
+{
+  int begin = findBegin(t);
+  int end = begin;
+  while (end < mT.size() && mT.at(end) == t)
+    ++end;
+  eraseData(begin, end);
+  return end-begin;
+}
+
+/*!
+  Removes the data point at \a it and returns an iterator to the data point following it.
+*/
+QCPCurveDataContainer::const_iterator QCPCurveDataContainer::erase(const_iterator it)
+{
+  eraseData(it.index(), it.index()+1);
+  return const_iterator(this, it.index());
+}
+
+/*! \overload
+  
+  Removes the data points from \a first up to (but not including) \a last and returns an iterator
+  to the data point following the removed range.
+*/
+QCPCurveDataContainer::const_iterator QCPCurveDataContainer::erase(const_iterator first, const_iterator last)
+{
+  eraseData(first.index(), last.index());
+  return const_iterator(this, first.index());
+}
+
+/*!
+  Removes all data points.
+*/
+void QCPCurveDataContainer::clear()
+{
+  mT.clear();
+  mKeys.clear();
+  mValues.clear();
+  mFloatValues.clear();
+  ++mRevision;
+}
+
+/*!
+  Preallocates memory for \a size data points.
+*/
+void QCPCurveDataContainer::reserve(int size)
+{
+  mT.reserve(size);
+  mKeys.reserve(size);
+  if (mSinglePrecisionValues)
+    mFloatValues.reserve(size);
+  else
+    mValues.reserve(size);
+}
+
+/*!
+  Releases memory that was allocated for data points which have since been removed, or which was
+  preallocated with \ref reserve.
+*/
+void QCPCurveDataContainer::squeeze()
+{
+  mT.squeeze();
+  mKeys.squeeze();
+  mValues.squeeze();
+  mFloatValues.squeeze();
+}
+
+/*!
+  Returns a copy of all data points, sorted ascending by t.
+*/
+QVector<QCPCurveData> QCPCurveDataContainer::toVector() const
+{
+  QVector<QCPCurveData> result(size());
+  for (int i=0; i<result.size(); ++i)
+    result[i] = at(i);
+  return result;
+}
+
+/*! \internal
+  
+  Inserts \a data at \a index, without checking the t order.
+*/
+void QCPCurveDataContainer::insertData(int index, const QCPCurveData &data)
+{
+  mT.insert(index, data.t);
+  mKeys.insert(index, data.key);
+  if (mSinglePrecisionValues)
+    mFloatValues.insert(index, data.value);
+  else
+    mValues.insert(index, data.value);
+  ++mRevision;
+}
+
+/*! \internal
+  
+  Removes the data points with indices from \a begin up to (but not including) \a end.
+*/
+void QCPCurveDataContainer::eraseData(int begin, int end)
+{
+  const int count = end-begin;
+  if (count <= 0)
+    return;
+  mT.remove(begin, count);
+  mKeys.remove(begin, count);
+  if (mSinglePrecisionValues)
+    mFloatValues.remove(begin, count);
+  else
+    mValues.remove(begin, count);
+  ++mRevision;
+}
+
+/*! \internal
+  
+  Comparison function used for sorting data points by t.
+*/
+bool QCPCurveDataContainer::lessThanT(const QCPCurveData &a, const QCPCurveData &b)
+{
+  return a.t < b.t;
+}
+
+/*! \internal
+  
+  Returns whether the data points in \a data, starting at index \a from, are sorted ascending by
+  t.
+*/
+bool QCPCurveDataContainer::isSorted(const QVector<QCPCurveData> &data, int from)
+{
+  for (int i=from+1; i<data.size(); ++i)
+  {
+    if (data.at(i).t < data.at(i-1).t)
+      return false;
+  }
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPCurveDataContainer::reference
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPCurveDataContainer::reference
+  \brief Writable copy of a data point in a QCPCurveDataContainer
+  
+  The non-const iterators of \ref QCPCurveDataContainer return instances of this class instead of
+  a QCPCurveData reference, because the container doesn't store QCPCurveData instances. When it is
+  destroyed, it writes its modifications back to the container via \ref
+  QCPCurveDataContainer::replace.
+  
+  See \ref QCPDataContainer::reference for an example. Changes of the \a t member are ignored.
+*/
+
+/*!
+  Writes the data point back to the container, if it was modified since this reference was
+  created.
+*/
+QCPCurveDataContainer::reference::~reference()
+{
+  const QCPCurveData &data = *this;
+  if (!sameValue(data.key, mOriginal.key) || !sameValue(data.value, mOriginal.value))
+    mContainer->replace(mIndex, data);
+}
+
+/*! \internal
+  
+  Returns whether \a a and \a b are equal, treating two NaN values as equal, so unmodified gaps
+  don't cause a write back.
+*/
+bool QCPCurveDataContainer::reference::sameValue(double a, double b)
+{
+  return a == b || (qIsNaN(a) && qIsNaN(b));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPCurveDataMapIterator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPCurveDataMapIterator
+  \brief Java-style read-only iterator over the data points of a QCPCurveDataContainer
+  
+  This class provides the interface of QMapIterator<double, QCPCurveData>, which was the type of
+  QCPCurveDataMapIterator in earlier versions of QCustomPlot, when QCPCurve still stored its data
+  in a QMap. The \a key() is the curve parameter t. Since the container doesn't store QCPCurveData
+  instances, \ref value returns a copy.
+  
+  See \ref QCPDataMapIterator for the iteration semantics and an example.
+  
+  \see QCPCurveDataMutableMapIterator, QCPCurveDataContainer
+*/
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPCurveDataMutableMapIterator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPCurveDataMutableMapIterator
+  \brief Java-style iterator that can modify the data points of a QCPCurveDataContainer
+  
+  This class provides the interface of QMutableMapIterator<double, QCPCurveData>, which was the
+  type of QCPCurveDataMutableMapIterator in earlier versions of QCustomPlot. In addition to the
+  methods of \ref QCPCurveDataMapIterator, it can replace (\ref setValue) and remove (\ref remove)
+  the data point that was jumped over last. Like with QMutableMapIterator, data points can also be
+  modified via \ref value, which returns a \ref QCPCurveDataContainer::reference.
+  
+  \see QCPCurveDataContainer::replace
+*/
+
+/* start of documentation of inline functions */
+
+/*! \fn void QCPCurveDataMutableMapIterator::setValue(const QCPCurveData &data)
+  
+  Replaces the data point that was jumped over by the last call to \ref next or \ref previous with
+  \a data. The parameter t stays the same, see \ref QCPCurveDataContainer::replace.
+*/
+
+/*! \fn QCPCurveDataContainer::reference QCPCurveDataMutableMapIterator::value()
+  
+  Returns the data point that was jumped over by the last call to \ref next or \ref previous. The
+  returned \ref QCPCurveDataContainer::reference writes its modifications back to the container.
+*/
+
+/* end of documentation of inline functions */
+
+/*!
+  Removes the data point that was jumped over by the last call to \ref next or \ref previous from
+  the container.
+*/
+void QCPCurveDataMutableMapIterator::remove()
+{
+  if (mLast < 0)
+    return;
+  mMutableContainer->erase(QCPCurveDataContainer::const_iterator(mMutableContainer, mLast));
+  if (mLast < mIndex)
+    --mIndex;
+  mLast = -1;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPCurve
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -112,7 +703,8 @@ QCPCurveData::QCPCurveData(double t, double key, double value) :
   then takes ownership of the graph.
 */
 QCPCurve::QCPCurve(QCPAxis *keyAxis, QCPAxis *valueAxis) :
-  QCPAbstractPlottable(keyAxis, valueAxis)
+  QCPAbstractPlottable(keyAxis, valueAxis),
+  mPointIndexValid(false)
 {
   mData = new QCPCurveDataMap;
   mPen.setColor(Qt::blue);
@@ -139,6 +731,9 @@ QCPCurve::~QCPCurve()
   If \a copy is set to true, data points in \a data will only be copied. if false, the plottable
   takes ownership of the passed data and replaces the internal data pointer with it. This is
   significantly faster than copying for large datasets.
+  
+  In both cases, the value precision of the curve (\ref setSinglePrecisionValues) is kept. If \a
+  data is adopted, its values are converted accordingly.
 */
 void QCPCurve::setData(QCPCurveDataMap *data, bool copy)
 {
@@ -149,12 +744,15 @@ void QCPCurve::setData(QCPCurveDataMap *data, bool copy)
   }
   if (copy)
   {
-    *mData = *data;
+    mData->set(data->toVector(), true); // keeps value precision of this curve
   } else
   {
+    data->setSinglePrecisionValues(mData->singlePrecisionValues()); // carry the value precision of this curve over to the adopted container
     delete mData;
     mData = data;
+    mPointIndexValid = false; // the revision of the new container isn't comparable
   }
+  invalidateRangeCache();
 }
 
 /*! \overload
@@ -165,18 +763,17 @@ void QCPCurve::setData(QCPCurveDataMap *data, bool copy)
 */
 void QCPCurve::setData(const QVector<double> &t, const QVector<double> &key, const QVector<double> &value)
 {
-  mData->clear();
   int n = t.size();
   n = qMin(n, key.size());
   n = qMin(n, value.size());
-  QCPCurveData newData;
+  QVector<QCPCurveData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.t = t[i];
-    newData.key = key[i];
-    newData.value = value[i];
-    mData->insertMulti(newData.t, newData);
+    newData[i].t = t[i];
+    newData[i].key = key[i];
+    newData[i].value = value[i];
   }
+  mData->set(newData);
 }
 
 /*! \overload
@@ -186,17 +783,16 @@ void QCPCurve::setData(const QVector<double> &t, const QVector<double> &key, con
 */
 void QCPCurve::setData(const QVector<double> &key, const QVector<double> &value)
 {
-  mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
-  QCPCurveData newData;
+  QVector<QCPCurveData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.t = i; // no t vector given, so we assign t the index of the key/value pair
-    newData.key = key[i];
-    newData.value = value[i];
-    mData->insertMulti(newData.t, newData);
+    newData[i].t = i; // no t vector given, so we assign t the index of the key/value pair
+    newData[i].key = key[i];
+    newData[i].value = value[i];
   }
+  mData->set(newData, true);
 }
 
 /*!
@@ -223,13 +819,32 @@ void QCPCurve::setLineStyle(QCPCurve::LineStyle style)
   mLineStyle = style;
 }
 
+/*!
+  Sets whether the values of the data points are stored with single precision (float) instead of
+  double precision. The curve parameter t and the keys are always stored with double precision.
+  
+  For data with limited precision in the value dimension (e.g. from sensors), this reduces the
+  memory consumption of the curve data. The drawing code reads the single precision values
+  directly, no converted copy of the data is created.
+  
+  \see QCPCurveDataContainer::setSinglePrecisionValues
+*/
+void QCPCurve::setSinglePrecisionValues(bool enabled)
+{
+  mData->setSinglePrecisionValues(enabled);
+}
+
 /*!
   Adds the provided data points in \a dataMap to the current data.
   \see removeData
 */
 void QCPCurve::addData(const QCPCurveDataMap &dataMap)
 {
-  mData->unite(dataMap);
+  syncRangeCache(mData->revision());
+  mData->add(dataMap);
+  for (int i=0; i<dataMap.size(); ++i)
+    addToRangeCache(dataMap.at(i));
+  mRangeCacheRevision = mData->revision();
 }
 
 /*! \overload
@@ -238,7 +853,10 @@ void QCPCurve::addData(const QCPCurveDataMap &dataMap)
 */
 void QCPCurve::addData(const QCPCurveData &data)
 {
-  mData->insertMulti(data.t, data);
+  syncRangeCache(mData->revision());
+  mData->add(data);
+  addToRangeCache(data);
+  mRangeCacheRevision = mData->revision();
 }
 
 /*! \overload
@@ -251,7 +869,7 @@ void QCPCurve::addData(double t, double key, double value)
   newData.t = t;
   newData.key = key;
   newData.value = value;
-  mData->insertMulti(newData.t, newData);
+  addData(newData);
 }
 
 /*! \overload
@@ -266,12 +884,12 @@ void QCPCurve::addData(double key, double value)
 {
   QCPCurveData newData;
   if (!mData->isEmpty())
-    newData.t = (mData->constEnd()-1).key()+1;
+    newData.t = mData->tAt(mData->size()-1)+1;
   else
     newData.t = 0;
   newData.key = key;
   newData.value = value;
-  mData->insertMulti(newData.t, newData);
+  addData(newData);
 }
 
 /*! \overload
@@ -283,14 +901,18 @@ void QCPCurve::addData(const QVector<double> &ts, const QVector<double> &keys, c
   int n = ts.size();
   n = qMin(n, keys.size());
   n = qMin(n, values.size());
-  QCPCurveData newData;
+  QVector<QCPCurveData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.t = ts[i];
-    newData.key = keys[i];
-    newData.value = values[i];
-    mData->insertMulti(newData.t, newData);
+    newData[i].t = ts[i];
+    newData[i].key = keys[i];
+    newData[i].value = values[i];
   }
+  syncRangeCache(mData->revision());
+  mData->add(newData);
+  for (int i=0; i<n; ++i)
+    addToRangeCache(newData.at(i));
+  mRangeCacheRevision = mData->revision();
 }
 
 /*!
@@ -299,9 +921,7 @@ void QCPCurve::addData(const QVector<double> &ts, const QVector<double> &keys, c
 */
 void QCPCurve::removeDataBefore(double t)
 {
-  QCPCurveDataMap::iterator it = mData->begin();
-  while (it != mData->end() && it.key() < t)
-    it = mData->erase(it);
+  mData->removeBefore(t);
 }
 
 /*!
@@ -310,10 +930,7 @@ void QCPCurve::removeDataBefore(double t)
 */
 void QCPCurve::removeDataAfter(double t)
 {
-  if (mData->isEmpty()) return;
-  QCPCurveDataMap::iterator it = mData->upperBound(t);
-  while (it != mData->end())
-    it = mData->erase(it);
+  mData->removeAfter(t);
 }
 
 /*!
@@ -325,11 +942,7 @@ void QCPCurve::removeDataAfter(double t)
 */
 void QCPCurve::removeData(double fromt, double tot)
 {
-  if (fromt >= tot || mData->isEmpty()) return;
-  QCPCurveDataMap::iterator it = mData->upperBound(fromt);
-  QCPCurveDataMap::iterator itEnd = mData->upperBound(tot);
-  while (it != itEnd)
-    it = mData->erase(it);
+  mData->remove(fromt, tot);
 }
 
 /*! \overload
@@ -377,17 +990,21 @@ void QCPCurve::draw(QCPPainter *painter)
   // allocate line vector:
   QVector<QPointF> *lineData = new QVector<QPointF>;
   
-  // fill with curve data:
-  getCurveData(lineData);
+  // fill with curve data, or take it from prepareDraw:
+  if (mDrawPrepared)
+  {
+    *lineData = mPreparedLineData;
+    clearPreparedDraw();
+  } else
+    getCurveData(lineData);
   
   // check data validity if flag set:
 #ifdef QCUSTOMPLOT_CHECK_DATA
-  QCPCurveDataMap::const_iterator it;
-  for (it = mData->constBegin(); it != mData->constEnd(); ++it)
+  for (int i=0; i<mData->size(); ++i)
   {
-    if (QCP::isInvalidData(it.value().t) ||
-        QCP::isInvalidData(it.value().key, it.value().value))
-      qDebug() << Q_FUNC_INFO << "Data point at" << it.key() << "invalid." << "Plottable name:" << name();
+    if (QCP::isInvalidData(mData->tAt(i)) ||
+        QCP::isInvalidData(mData->keyAt(i), mData->valueAt(i)))
+      qDebug() << Q_FUNC_INFO << "Data point at" << mData->tAt(i) << "invalid." << "Plottable name:" << name();
   }
 #endif
   
@@ -457,6 +1074,77 @@ void QCPCurve::draw(QCPPainter *painter)
   delete lineData;
 }
 
+/* inherits documentation from base class */
+void QCPCurve::prepareDraw()
+{
+  clearPreparedDraw();
+  if (mData->isEmpty()) return;
+  
+  getCurveData(&mPreparedLineData);
+  mDrawPrepared = true;
+}
+
+/* inherits documentation from base class */
+void QCPCurve::clearPreparedDraw()
+{
+  mPreparedLineData.clear();
+  QCPAbstractPlottable::clearPreparedDraw();
+}
+
+/*! \internal
+  
+  Returns the data point nearest to \a pixelPos among the data points with keys inside \a
+  keyWindow, see \ref QCPAbstractPlottable::nearestDataPoint. The distance is measured to the data
+  point itself, not to the line segments connecting the data points.
+  
+  Since the keys of a curve aren't sorted, the pixel positions of all data points are held in a
+  spatial index (\ref QCPHitTestIndex). It is built on the first query after the data or the axes
+  have changed, and answers subsequent queries by examining only the data points close to \a
+  pixelPos.
+*/
+QCPDataPoint QCPCurve::findNearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return QCPDataPoint(); }
+  if (mData->isEmpty())
+    return QCPDataPoint();
+  
+  const bool keyIsVertical = keyAxis->orientation() == Qt::Vertical;
+  if (!mPointIndexValid || !(mPointIndexState == hitTestState(mData->revision())))
+  {
+    QVector<QPointF> points(mData->size());
+    for (int i=0; i<points.size(); ++i)
+    {
+      const double keyPixel = keyAxis->coordToPixel(mData->keyAt(i));
+      const double valuePixel = valueAxis->coordToPixel(mData->valueAt(i));
+      points[i] = keyIsVertical ? QPointF(valuePixel, keyPixel) : QPointF(keyPixel, valuePixel);
+    }
+    mPointIndex.setGeometry(points, QCPHitTestIndex::gtPoints, keyAxis->axisRect()->rect());
+    mPointIndexState = hitTestState(mData->revision());
+    mPointIndexValid = true;
+  }
+  
+  // transform the key window to pixels, bounds that can't be transformed (e.g. infinite bounds on
+  // logarithmic axes) leave the window open in their direction:
+  const bool pixelsIncrease = keyAxis->coordToPixel(keyAxis->range().upper) > keyAxis->coordToPixel(keyAxis->range().lower);
+  double lowerPixel = keyAxis->coordToPixel(keyWindow.lower);
+  double upperPixel = keyAxis->coordToPixel(keyWindow.upper);
+  if (qIsNaN(lowerPixel))
+    lowerPixel = pixelsIncrease ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+  if (qIsNaN(upperPixel))
+    upperPixel = pixelsIncrease ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity();
+  const QCPRange keyPixelRange(lowerPixel, upperPixel);
+  const QCPRange valuePixelRange(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+  
+  double distance;
+  const int nearest = keyIsVertical ? mPointIndex.nearestItem(pixelPos, valuePixelRange, keyPixelRange, &distance)
+                                    : mPointIndex.nearestItem(pixelPos, keyPixelRange, valuePixelRange, &distance);
+  if (nearest < 0)
+    return QCPDataPoint();
+  return QCPDataPoint(nearest, mData->keyAt(nearest), mData->valueAt(nearest), distance);
+}
+
 /* inherits documentation from base class */
 void QCPCurve::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 {
@@ -502,9 +1190,7 @@ void QCPCurve::drawScatterPlot(QCPPainter *painter, const QVector<QPointF> *poin
   // draw scatter point symbols:
   applyScattersAntialiasingHint(painter);
   mScatterStyle.applyTo(painter, mPen);
-  for (int i=0; i<pointData->size(); ++i)
-    if (!qIsNaN(pointData->at(i).x()) && !qIsNaN(pointData->at(i).y()))
-      mScatterStyle.drawShape(painter,  pointData->at(i));
+  mScatterStyle.drawShapes(painter, *pointData, mParentPlot->plottingHints().testFlag(QCP::phCacheScatters));
 }
 
 /*! \internal
@@ -535,13 +1221,17 @@ void QCPCurve::getCurveData(QVector<QPointF> *lineData) const
   double rectBottom = valueAxis->pixelToCoord(valueAxis->coordToPixel(valueAxis->range().lower)+strokeMargin*((valueAxis->orientation()==Qt::Horizontal)!=valueAxis->rangeReversed()?-1:1));
   double rectTop = valueAxis->pixelToCoord(valueAxis->coordToPixel(valueAxis->range().upper)-strokeMargin*((valueAxis->orientation()==Qt::Horizontal)!=valueAxis->rangeReversed()?-1:1));
   int currentRegion;
-  QCPCurveDataMap::const_iterator it = mData->constBegin();
-  QCPCurveDataMap::const_iterator prevIt = mData->constEnd()-1;
-  int prevRegion = getRegion(prevIt.value().key, prevIt.value().value, rectLeft, rectTop, rectRight, rectBottom);
+  int i = 0;
+  double key, value;
+  double prevKey = mData->keyAt(mData->size()-1);
+  double prevValue = mData->valueAt(mData->size()-1);
+  int prevRegion = getRegion(prevKey, prevValue, rectLeft, rectTop, rectRight, rectBottom);
   QVector<QPointF> trailingPoints; // points that must be applied after all other points (are generated only when handling first point to get virtual segment between last and first point right)
-  while (it != mData->constEnd())
+  while (i < mData->size())
   {
-    currentRegion = getRegion(it.value().key, it.value().value, rectLeft, rectTop, rectRight, rectBottom);
+    key = mData->keyAt(i);
+    value = mData->valueAt(i);
+    currentRegion = getRegion(key, value, rectLeft, rectTop, rectRight, rectBottom);
     if (currentRegion != prevRegion) // changed region, possibly need to add some optimized edge points or original points if entering R
     {
       if (currentRegion != 5) // segment doesn't end in R, so it's a candidate for removal
@@ -549,16 +1239,16 @@ void QCPCurve::getCurveData(QVector<QPointF> *lineData) const
         QPointF crossA, crossB;
         if (prevRegion == 5) // we're coming from R, so add this point optimized
         {
-          lineData->append(getOptimizedPoint(currentRegion, it.value().key, it.value().value, prevIt.value().key, prevIt.value().value, rectLeft, rectTop, rectRight, rectBottom));
+          lineData->append(getOptimizedPoint(currentRegion, key, value, prevKey, prevValue, rectLeft, rectTop, rectRight, rectBottom));
           // in the situations 5->1/7/9/3 the segment may leave R and directly cross through two outer regions. In these cases we need to add an additional corner point
-          *lineData << getOptimizedCornerPoints(prevRegion, currentRegion, prevIt.value().key, prevIt.value().value, it.value().key, it.value().value, rectLeft, rectTop, rectRight, rectBottom);
+          *lineData << getOptimizedCornerPoints(prevRegion, currentRegion, prevKey, prevValue, key, value, rectLeft, rectTop, rectRight, rectBottom);
         } else if (mayTraverse(prevRegion, currentRegion) &&
-                   getTraverse(prevIt.value().key, prevIt.value().value, it.value().key, it.value().value, rectLeft, rectTop, rectRight, rectBottom, crossA, crossB))
+                   getTraverse(prevKey, prevValue, key, value, rectLeft, rectTop, rectRight, rectBottom, crossA, crossB))
         {
           // add the two cross points optimized if segment crosses R and if segment isn't virtual zeroth segment between last and first curve point:
           QVector<QPointF> beforeTraverseCornerPoints, afterTraverseCornerPoints;
           getTraverseCornerPoints(prevRegion, currentRegion, rectLeft, rectTop, rectRight, rectBottom, beforeTraverseCornerPoints, afterTraverseCornerPoints);
-          if (it != mData->constBegin())
+          if (i != 0)
           {
             *lineData << beforeTraverseCornerPoints;
             lineData->append(crossA);
@@ -572,29 +1262,30 @@ void QCPCurve::getCurveData(QVector<QPointF> *lineData) const
           }
         } else // doesn't cross R, line is just moving around in outside regions, so only need to add optimized point(s) at the boundary corner(s)
         {
-          *lineData << getOptimizedCornerPoints(prevRegion, currentRegion, prevIt.value().key, prevIt.value().value, it.value().key, it.value().value, rectLeft, rectTop, rectRight, rectBottom);
+          *lineData << getOptimizedCornerPoints(prevRegion, currentRegion, prevKey, prevValue, key, value, rectLeft, rectTop, rectRight, rectBottom);
         }
       } else // segment does end in R, so we add previous point optimized and this point at original position
       {
-        if (it == mData->constBegin()) // it is first point in curve and prevIt is last one. So save optimized point for adding it to the lineData in the end
-          trailingPoints << getOptimizedPoint(prevRegion, prevIt.value().key, prevIt.value().value, it.value().key, it.value().value, rectLeft, rectTop, rectRight, rectBottom);
+        if (i == 0) // it is first point in curve and the previous point is the last one. So save optimized point for adding it to the lineData in the end
+          trailingPoints << getOptimizedPoint(prevRegion, prevKey, prevValue, key, value, rectLeft, rectTop, rectRight, rectBottom);
         else
-          lineData->append(getOptimizedPoint(prevRegion, prevIt.value().key, prevIt.value().value, it.value().key, it.value().value, rectLeft, rectTop, rectRight, rectBottom));
-        lineData->append(coordsToPixels(it.value().key, it.value().value));
+          lineData->append(getOptimizedPoint(prevRegion, prevKey, prevValue, key, value, rectLeft, rectTop, rectRight, rectBottom));
+        lineData->append(coordsToPixels(key, value));
       }
     } else // region didn't change
     {
       if (currentRegion == 5) // still in R, keep adding original points
       {
-        lineData->append(coordsToPixels(it.value().key, it.value().value));
+        lineData->append(coordsToPixels(key, value));
       } else // still outside R, no need to add anything
       {
         // see how this is not doing anything? That's the main optimization...
       }
     }
-    prevIt = it;
+    prevKey = key;
+    prevValue = value;
     prevRegion = currentRegion;
-    ++it;
+    ++i;
   }
   *lineData << trailingPoints;
 }
@@ -1244,71 +1935,73 @@ double QCPCurve::pointDistance(const QPointF &pixelPoint) const
 /* inherits documentation from base class */
 QCPRange QCPCurve::getKeyRange(bool &foundRange, SignDomain inSignDomain) const
 {
-  QCPRange range;
-  bool haveLower = false;
-  bool haveUpper = false;
-  
-  double current;
-  
-  QCPCurveDataMap::const_iterator it = mData->constBegin();
-  while (it != mData->constEnd())
+  syncRangeCache(mData->revision());
+  RangeCache &cache = rangeCache(false, inSignDomain);
+  if (!cache.valid)
   {
-    current = it.value().key;
-    if (!qIsNaN(current) && !qIsNaN(it.value().value))
+    cache = RangeCache();
+    for (int i=0; i<mData->size(); ++i)
     {
-      if (inSignDomain == sdBoth || (inSignDomain == sdNegative && current < 0) || (inSignDomain == sdPositive && current > 0))
-      {
-        if (current < range.lower || !haveLower)
-        {
-          range.lower = current;
-          haveLower = true;
-        }
-        if (current > range.upper || !haveUpper)
-        {
-          range.upper = current;
-          haveUpper = true;
-        }
-      }
+      const double current = mData->keyAt(i);
+      if (!qIsNaN(current) && !qIsNaN(mData->valueAt(i)))
+        extendRange(cache, inSignDomain, current);
     }
-    ++it;
+    cache.valid = true;
   }
-  
-  foundRange = haveLower && haveUpper;
-  return range;
+  foundRange = cache.haveLower && cache.haveUpper;
+  return cache.range;
 }
 
 /* inherits documentation from base class */
 QCPRange QCPCurve::getValueRange(bool &foundRange, SignDomain inSignDomain) const
 {
-  QCPRange range;
-  bool haveLower = false;
-  bool haveUpper = false;
-  
-  double current;
-  
-  QCPCurveDataMap::const_iterator it = mData->constBegin();
-  while (it != mData->constEnd())
+  syncRangeCache(mData->revision());
+  RangeCache &cache = rangeCache(true, inSignDomain);
+  if (!cache.valid)
   {
-    current = it.value().value;
-    if (!qIsNaN(current) && !qIsNaN(it.value().key))
+    cache = RangeCache();
+    for (int i=0; i<mData->size(); ++i)
     {
-      if (inSignDomain == sdBoth || (inSignDomain == sdNegative && current < 0) || (inSignDomain == sdPositive && current > 0))
-      {
-        if (current < range.lower || !haveLower)
-        {
-          range.lower = current;
-          haveLower = true;
-        }
-        if (current > range.upper || !haveUpper)
-        {
-          range.upper = current;
-          haveUpper = true;
-        }
-      }
+      const double current = mData->valueAt(i);
+      if (!qIsNaN(current) && !qIsNaN(mData->keyAt(i)))
+        extendRange(cache, inSignDomain, current);
     }
-    ++it;
+    cache.valid = true;
+  }
+  foundRange = cache.haveLower && cache.haveUpper;
+  return cache.range;
+}
+
+/*! \internal
+  
+  Returns the value range of the curve points with keys inside \a inKeyRange. Since the keys of a
+  curve are not sorted, all points are examined, so this is linear in the number of points.
+*/
+QCPRange QCPCurve::getValueRangeInKeyRange(bool &foundRange, SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+  RangeCache result;
+  for (int i=0; i<mData->size(); ++i)
+  {
+    const double key = mData->keyAt(i);
+    const double current = mData->valueAt(i);
+    if (!qIsNaN(current) && key >= inKeyRange.lower && key <= inKeyRange.upper)
+      extendRange(result, inSignDomain, current);
   }
+  foundRange = result.haveLower && result.haveUpper;
+  return result.range;
+}
+
+/*! \internal
   
-  foundRange = haveLower && haveUpper;
-  return range;
+  Extends the range cache (see \ref QCPAbstractPlottable::rangeCache) by the newly added data point
+  \a data. If the values are stored with single precision, the value is rounded accordingly.
+*/
+void QCPCurve::addToRangeCache(const QCPCurveData &data) const
+{
+  const double value = mData->singlePrecisionValues() ? double(float(data.value)) : data.value;
+  if (!qIsNaN(data.key) && !qIsNaN(value))
+  {
+    extendRangeCache(false, data.key);
+    extendRangeCache(true, value);
+  }
 }
@@ -43,17 +43,198 @@ public:
 };
 Q_DECLARE_TYPEINFO(QCPCurveData, Q_MOVABLE_TYPE);
 
+class QCP_LIB_DECL QCPCurveDataContainer
+{
+public:
+  class reference : public QCPCurveData
+  {
+  public:
+    reference(QCPCurveDataContainer *container, int index) : QCPCurveData(container->at(index)), mContainer(container), mIndex(index), mOriginal(*this) {}
+    ~reference();
+    reference &operator=(const QCPCurveData &data) { QCPCurveData::operator=(data); return *this; }
+    reference &operator=(const reference &other) { QCPCurveData::operator=(other); return *this; }
+    
+  private:
+    QCPCurveDataContainer *mContainer;
+    int mIndex;
+    QCPCurveData mOriginal;
+    static bool sameValue(double a, double b);
+  };
+  
+  class const_iterator
+  {
+  public:
+    const_iterator() : mContainer(0), mIndex(0) {}
+    const_iterator(const QCPCurveDataContainer *container, int index) : mContainer(container), mIndex(index) {}
+    
+    double key() const { return mContainer->tAt(mIndex); }
+    QCPCurveData value() const { return mContainer->at(mIndex); }
+    QCPCurveData operator*() const { return mContainer->at(mIndex); }
+    int index() const { return mIndex; }
+    
+    bool operator==(const const_iterator &other) const { return mIndex == other.mIndex && mContainer == other.mContainer; }
+    bool operator!=(const const_iterator &other) const { return mIndex != other.mIndex || mContainer != other.mContainer; }
+    bool operator<(const const_iterator &other) const { return mIndex < other.mIndex; }
+    const_iterator &operator++() { ++mIndex; return *this; }
+    const_iterator operator++(int) { const_iterator result(*this); ++mIndex; return result; }
+    const_iterator &operator--() { --mIndex; return *this; }
+    const_iterator operator--(int) { const_iterator result(*this); --mIndex; return result; }
+    const_iterator &operator+=(int n) { mIndex += n; return *this; }
+    const_iterator &operator-=(int n) { mIndex -= n; return *this; }
+    const_iterator operator+(int n) const { return const_iterator(mContainer, mIndex+n); }
+    const_iterator operator-(int n) const { return const_iterator(mContainer, mIndex-n); }
+    int operator-(const const_iterator &other) const { return mIndex-other.mIndex; }
+    
+  private:
+    const QCPCurveDataContainer *mContainer;
+    int mIndex;
+  };
+  
+  class iterator : public const_iterator
+  {
+  public:
+    iterator() : mMutableContainer(0) {}
+    iterator(QCPCurveDataContainer *container, int index) : const_iterator(container, index), mMutableContainer(container) {}
+    
+    reference value() const { return reference(mMutableContainer, index()); }
+    reference operator*() const { return reference(mMutableContainer, index()); }
+    
+    iterator &operator++() { const_iterator::operator++(); return *this; }
+    iterator operator++(int) { iterator result(*this); const_iterator::operator++(); return result; }
+    iterator &operator--() { const_iterator::operator--(); return *this; }
+    iterator operator--(int) { iterator result(*this); const_iterator::operator--(); return result; }
+    iterator &operator+=(int n) { const_iterator::operator+=(n); return *this; }
+    iterator &operator-=(int n) { const_iterator::operator-=(n); return *this; }
+    iterator operator+(int n) const { return iterator(mMutableContainer, index()+n); }
+    iterator operator-(int n) const { return iterator(mMutableContainer, index()-n); }
+    int operator-(const const_iterator &other) const { return index()-other.index(); }
+    
+  private:
+    QCPCurveDataContainer *mMutableContainer;
+  };
+  
+  QCPCurveDataContainer();
+  
+  // getters:
+  int size() const { return mT.size(); }
+  int count() const { return mT.size(); }
+  bool isEmpty() const { return mT.isEmpty(); }
+  bool singlePrecisionValues() const { return mSinglePrecisionValues; }
+  quint32 revision() const { return mRevision; }
+  QCPCurveData at(int index) const { return QCPCurveData(mT.at(index), mKeys.at(index), valueAt(index)); }
+  double tAt(int index) const { return mT.at(index); }
+  double keyAt(int index) const { return mKeys.at(index); }
+  double valueAt(int index) const { return mSinglePrecisionValues ? mFloatValues.at(index) : mValues.at(index); }
+  QCPCurveData first() const { return at(0); }
+  QCPCurveData last() const { return at(mT.size()-1); }
+  const_iterator constBegin() const { return const_iterator(this, 0); }
+  const_iterator constEnd() const { return const_iterator(this, mT.size()); }
+  const_iterator begin() const { return constBegin(); }
+  const_iterator end() const { return constEnd(); }
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, mT.size()); }
+  
+  // setters:
+  void setSinglePrecisionValues(bool enabled);
+  
+  // non-property methods:
+  int findBegin(double t) const;
+  int findEnd(double t) const;
+  const_iterator lowerBound(double t) const { return const_iterator(this, findBegin(t)); }
+  const_iterator upperBound(double t) const { return const_iterator(this, findEnd(t)); }
+  iterator lowerBound(double t) { return iterator(this, findBegin(t)); }
+  iterator upperBound(double t) { return iterator(this, findEnd(t)); }
+  const_iterator constFind(double t) const;
+  const_iterator find(double t) const { return constFind(t); }
+  iterator find(double t) { return iterator(this, constFind(t).index()); }
+  bool contains(double t) const { return constFind(t) != constEnd(); }
+  void set(const QVector<QCPCurveData> &data, bool alreadySorted=false);
+  void add(const QVector<QCPCurveData> &data, bool alreadySorted=false);
+  void add(const QCPCurveDataContainer &other);
+  void add(const QCPCurveData &data);
+  void insert(double t, const QCPCurveData &data);
+  void insertMulti(double t, const QCPCurveData &data);
+  void replace(int index, const QCPCurveData &data);
+  void setKeyAt(int index, double key);
+  void setValueAt(int index, double value);
+  void unite(const QCPCurveDataContainer &other) { add(other); }
+  void removeBefore(double t);
+  void removeAfter(double t);
+  void remove(double fromT, double toT);
+  int remove(double t);
+  const_iterator erase(const_iterator it);
+  const_iterator erase(const_iterator first, const_iterator last);
+  iterator erase(iterator it) { return iterator(this, erase(const_iterator(it)).index()); }
+  iterator erase(iterator first, iterator last) { return iterator(this, erase(const_iterator(first), const_iterator(last)).index()); }
+  void clear();
+  void reserve(int size);
+  void squeeze();
+  QVector<QCPCurveData> toVector() const;
+  
+protected:
+  // columns, only one of mValues and mFloatValues is used depending on mSinglePrecisionValues:
+  QVector<double> mT, mKeys, mValues;
+  QVector<float> mFloatValues;
+  bool mSinglePrecisionValues;
+  quint32 mRevision;
+  
+  void insertData(int index, const QCPCurveData &data);
+  void eraseData(int begin, int end);
+  static bool lessThanT(const QCPCurveData &a, const QCPCurveData &b);
+  static bool isSorted(const QVector<QCPCurveData> &data, int from=0);
+};
+
 /*! \typedef QCPCurveDataMap
-  Container for storing \ref QCPCurveData items in a sorted fashion. The key of the map
-  is the t member of the QCPCurveData instance.
+  Container for storing \ref QCPCurveData items in a sorted fashion. The sort key is the t member
+  of the QCPCurveData instance. This is a typedef of \ref QCPCurveDataContainer, which provides the
+  subset of the QMap interface that was used with earlier versions of QCustomPlot, when QCPCurve
+  still stored its data in a QMap.
   
-  This is the container in which QCPCurve holds its data.
-  \see QCPCurveData, QCPCurve::setData
+  This is the container in which QCPCurve holds its data. Data points can be modified via the
+  non-const iterators like with QMap (see \ref QCPCurveDataContainer::reference), or with \ref
+  QCPCurveDataContainer::replace, \ref QCPCurveDataContainer::setValueAt and \ref
+  QCPCurveDataMutableMapIterator.
+  \see QCPCurveData, QCPCurveDataContainer, QCPCurveDataMapIterator, QCPCurve::setData
 */
+typedef QCPCurveDataContainer QCPCurveDataMap;
+
+class QCP_LIB_DECL QCPCurveDataMapIterator
+{
+public:
+  QCPCurveDataMapIterator(const QCPCurveDataContainer &container) : mContainer(&container), mIndex(0), mLast(-1) {}
+  
+  void toFront() { mIndex = 0; mLast = -1; }
+  void toBack() { mIndex = mContainer->size(); mLast = -1; }
+  bool hasNext() const { return mIndex < mContainer->size(); }
+  bool hasPrevious() const { return mIndex > 0; }
+  QCPCurveDataContainer::const_iterator next() { mLast = mIndex++; return QCPCurveDataContainer::const_iterator(mContainer, mLast); }
+  QCPCurveDataContainer::const_iterator previous() { mLast = --mIndex; return QCPCurveDataContainer::const_iterator(mContainer, mLast); }
+  QCPCurveDataContainer::const_iterator peekNext() const { return QCPCurveDataContainer::const_iterator(mContainer, mIndex); }
+  QCPCurveDataContainer::const_iterator peekPrevious() const { return QCPCurveDataContainer::const_iterator(mContainer, mIndex-1); }
+  double key() const { return mContainer->tAt(mLast); }
+  QCPCurveData value() const { return mContainer->at(mLast); }
+  
+protected:
+  const QCPCurveDataContainer *mContainer;
+  int mIndex; // position between the data points mIndex-1 and mIndex
+  int mLast; // index of the data point returned by the last next/previous call, or -1
+};
 
-typedef QMap<double, QCPCurveData> QCPCurveDataMap;
-typedef QMapIterator<double, QCPCurveData> QCPCurveDataMapIterator;
-typedef QMutableMapIterator<double, QCPCurveData> QCPCurveDataMutableMapIterator;
+class QCP_LIB_DECL QCPCurveDataMutableMapIterator : public QCPCurveDataMapIterator
+{
+public:
+  QCPCurveDataMutableMapIterator(QCPCurveDataContainer &container) : QCPCurveDataMapIterator(container), mMutableContainer(&container) {}
+  
+  QCPCurveDataContainer::iterator next() { mLast = mIndex++; return QCPCurveDataContainer::iterator(mMutableContainer, mLast); }
+  QCPCurveDataContainer::iterator previous() { mLast = --mIndex; return QCPCurveDataContainer::iterator(mMutableContainer, mLast); }
+  QCPCurveData value() const { return QCPCurveDataMapIterator::value(); }
+  QCPCurveDataContainer::reference value() { return QCPCurveDataContainer::reference(mMutableContainer, mLast); }
+  void setValue(const QCPCurveData &data) { if (mLast >= 0) mMutableContainer->replace(mLast, data); }
+  void remove();
+  
+protected:
+  QCPCurveDataContainer *mMutableContainer;
+};
 
 
 class QCP_LIB_DECL QCPCurve : public QCPAbstractPlottable
@@ -79,6 +260,7 @@ public:
   QCPCurveDataMap *data() const { return mData; }
   QCPScatterStyle scatterStyle() const { return mScatterStyle; }
   LineStyle lineStyle() const { return mLineStyle; }
+  bool singlePrecisionValues() const { return mData->singlePrecisionValues(); }
   
   // setters:
   void setData(QCPCurveDataMap *data, bool copy=false);
@@ -86,6 +268,7 @@ public:
   void setData(const QVector<double> &key, const QVector<double> &value);
   void setScatterStyle(const QCPScatterStyle &style);
   void setLineStyle(LineStyle style);
+  void setSinglePrecisionValues(bool enabled);
   
   // non-property methods:
   void addData(const QCPCurveDataMap &dataMap);
@@ -107,12 +290,21 @@ protected:
   QCPCurveDataMap *mData;
   QCPScatterStyle mScatterStyle;
   LineStyle mLineStyle;
+  // non-property members:
+  QVector<QPointF> mPreparedLineData;
+  mutable QCPHitTestIndex mPointIndex;
+  mutable HitTestState mPointIndexState;
+  mutable bool mPointIndexValid;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter);
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const;
   virtual QCPRange getKeyRange(bool &foundRange, SignDomain inSignDomain=sdBoth) const;
   virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain=sdBoth) const;
+  virtual QCPRange getValueRangeInKeyRange(bool &foundRange, SignDomain inSignDomain, const QCPRange &inKeyRange) const;
+  virtual void prepareDraw();
+  virtual void clearPreparedDraw();
+  virtual QCPDataPoint findNearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const;
   
   // introduced virtual methods:
   virtual void drawScatterPlot(QCPPainter *painter, const QVector<QPointF> *pointData) const;
@@ -126,6 +318,7 @@ protected:
   bool getTraverse(double prevKey, double prevValue, double key, double value, double rectLeft, double rectTop, double rectRight, double rectBottom, QPointF &crossA, QPointF &crossB) const;
   void getTraverseCornerPoints(int prevRegion, int currentRegion, double rectLeft, double rectTop, double rectRight, double rectBottom, QVector<QPointF> &beforeTraverse, QVector<QPointF> &afterTraverse) const;
   double pointDistance(const QPointF &pixelPoint) const;
+  void addToRangeCache(const QCPCurveData &data) const;
   
   friend class QCustomPlot;
   friend class QCPLegend;
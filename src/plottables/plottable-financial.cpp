@@ -117,6 +117,9 @@ QCPFinancialData::QCPFinancialData(double key, double open, double high, double
   Returns a pointer to the internal data storage of type \ref QCPFinancialDataMap. You may use it to
   directly manipulate the data, which may be more convenient and faster than using the regular \ref
   setData or \ref addData methods, in certain situations.
+  
+  If you modify the data this way, call \ref dataChanged afterwards, so the cached data bounds
+  which are used by \ref rescaleAxes are determined anew.
 */
 
 /* end of documentation of inline functions */
@@ -179,6 +182,7 @@ void QCPFinancial::setData(QCPFinancialDataMap *data, bool copy)
     delete mData;
     mData = data;
   }
+  invalidateRangeCache();
 }
 
 /*! \overload
@@ -200,6 +204,7 @@ void QCPFinancial::setData(const QVector<double> &key, const QVector<double> &op
   {
     mData->insertMulti(key[i], QCPFinancialData(key[i], open[i], high[i], low[i], close[i]));
   }
+  invalidateRangeCache();
 }
 
 /*!
@@ -301,6 +306,12 @@ void QCPFinancial::setPenNegative(const QPen &pen)
 void QCPFinancial::addData(const QCPFinancialDataMap &dataMap)
 {
   mData->unite(dataMap);
+  QCPFinancialDataMap::const_iterator it = dataMap.constBegin();
+  while (it != dataMap.constEnd())
+  {
+    addToRangeCache(it.value());
+    ++it;
+  }
 }
 
 /*! \overload
@@ -315,6 +326,7 @@ void QCPFinancial::addData(const QCPFinancialDataMap &dataMap)
 void QCPFinancial::addData(const QCPFinancialData &data)
 {
   mData->insertMulti(data.key, data);
+  addToRangeCache(data);
 }
 
 /*! \overload
@@ -329,7 +341,9 @@ void QCPFinancial::addData(const QCPFinancialData &data)
 */
 void QCPFinancial::addData(double key, double open, double high, double low, double close)
 {
-  mData->insertMulti(key, QCPFinancialData(key, open, high, low, close));
+  QCPFinancialData newData(key, open, high, low, close);
+  mData->insertMulti(key, newData);
+  addToRangeCache(newData);
 }
 
 /*! \overload
@@ -350,7 +364,9 @@ void QCPFinancial::addData(const QVector<double> &key, const QVector<double> &op
   n = qMin(n, close.size());
   for (int i=0; i<n; ++i)
   {
-    mData->insertMulti(key[i], QCPFinancialData(key[i], open[i], high[i], low[i], close[i]));
+    QCPFinancialData newData(key[i], open[i], high[i], low[i], close[i]);
+    mData->insertMulti(key[i], newData);
+    addToRangeCache(newData);
   }
 }
 
@@ -364,6 +380,7 @@ void QCPFinancial::removeDataBefore(double key)
   QCPFinancialDataMap::iterator it = mData->begin();
   while (it != mData->end() && it.key() < key)
     it = mData->erase(it);
+  invalidateRangeCache();
 }
 
 /*!
@@ -377,6 +394,7 @@ void QCPFinancial::removeDataAfter(double key)
   QCPFinancialDataMap::iterator it = mData->upperBound(key);
   while (it != mData->end())
     it = mData->erase(it);
+  invalidateRangeCache();
 }
 
 /*!
@@ -393,6 +411,7 @@ void QCPFinancial::removeData(double fromKey, double toKey)
   QCPFinancialDataMap::iterator itEnd = mData->upperBound(toKey);
   while (it != itEnd)
     it = mData->erase(it);
+  invalidateRangeCache();
 }
 
 /*! \overload
@@ -406,6 +425,7 @@ void QCPFinancial::removeData(double fromKey, double toKey)
 void QCPFinancial::removeData(double key)
 {
   mData->remove(key);
+  invalidateRangeCache();
 }
 
 /*!
@@ -416,6 +436,18 @@ void QCPFinancial::removeData(double key)
 void QCPFinancial::clearData()
 {
   mData->clear();
+  invalidateRangeCache();
+}
+
+/*!
+  Notifies the plottable that its data was modified directly via the pointer returned by \ref
+  data. The cached data bounds are discarded, so the next call of e.g. \ref rescaleAxes determines
+  them anew. Modifications via the methods of this plottable (e.g. \ref addData) don't require
+  calling this method.
+*/
+void QCPFinancial::dataChanged()
+{
+  invalidateRangeCache();
 }
 
 /* inherits documentation from base class */
@@ -578,82 +610,157 @@ void QCPFinancial::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 /* inherits documentation from base class */
 QCPRange QCPFinancial::getKeyRange(bool &foundRange, QCPAbstractPlottable::SignDomain inSignDomain) const
 {
-  QCPRange range;
-  bool haveLower = false;
-  bool haveUpper = false;
-  
-  double current;
-  QCPFinancialDataMap::const_iterator it = mData->constBegin();
-  while (it != mData->constEnd())
+  RangeCache &cache = rangeCache(false, inSignDomain);
+  if (!cache.valid)
   {
-    current = it.value().key;
-    if (inSignDomain == sdBoth || (inSignDomain == sdNegative && current < 0) || (inSignDomain == sdPositive && current > 0))
+    cache = RangeCache();
+    QCPFinancialDataMap::const_iterator it = mData->constBegin();
+    while (it != mData->constEnd())
     {
-      if (current < range.lower || !haveLower)
-      {
-        range.lower = current;
-        haveLower = true;
-      }
-      if (current > range.upper || !haveUpper)
-      {
-        range.upper = current;
-        haveUpper = true;
-      }
+      extendRange(cache, inSignDomain, it.value().key);
+      ++it;
     }
-    ++it;
+    cache.valid = true;
   }
+  QCPRange range = cache.range;
   // determine exact range by including width of bars/flags:
-  if (haveLower && mKeyAxis)
+  if (cache.haveLower && mKeyAxis)
     range.lower = range.lower-mWidth*0.5;
-  if (haveUpper && mKeyAxis)
+  if (cache.haveUpper && mKeyAxis)
     range.upper = range.upper+mWidth*0.5;
-  foundRange = haveLower && haveUpper;
+  foundRange = cache.haveLower && cache.haveUpper;
   return range;
 }
 
 /* inherits documentation from base class */
 QCPRange QCPFinancial::getValueRange(bool &foundRange, QCPAbstractPlottable::SignDomain inSignDomain) const
 {
-  QCPRange range;
-  bool haveLower = false;
-  bool haveUpper = false;
+  RangeCache &cache = rangeCache(true, inSignDomain);
+  if (!cache.valid)
+  {
+    cache = RangeCache();
+    QCPFinancialDataMap::const_iterator it = mData->constBegin();
+    while (it != mData->constEnd())
+    {
+      extendRange(cache, inSignDomain, it.value().high);
+      extendRange(cache, inSignDomain, it.value().low);
+      ++it;
+    }
+    cache.valid = true;
+  }
+  foundRange = cache.haveLower && cache.haveUpper;
+  return cache.range;
+}
+
+/*! \internal
+  
+  Returns the range spanned by the low and high values of the data points with keys inside \a
+  inKeyRange. The data points inside the key range are found with binary searches, and only these
+  are examined.
+*/
+QCPRange QCPFinancial::getValueRangeInKeyRange(bool &foundRange, QCPAbstractPlottable::SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+  RangeCache result;
+  const QCPFinancialDataMap &constData = *mData;
+  QCPFinancialDataMap::const_iterator it = constData.lowerBound(inKeyRange.lower);
+  const QCPFinancialDataMap::const_iterator end = constData.upperBound(inKeyRange.upper);
+  while (it != end)
+  {
+    extendRange(result, inSignDomain, it.value().high);
+    extendRange(result, inSignDomain, it.value().low);
+    ++it;
+  }
+  foundRange = result.haveLower && result.haveUpper;
+  return result.range;
+}
+
+/*! \internal
   
-  QCPFinancialDataMap::const_iterator it = mData->constBegin();
-  while (it != mData->constEnd())
+  Returns the data point nearest to \a pixelPos among the data points with keys inside \a
+  keyWindow, see \ref QCPAbstractPlottable::nearestDataPoint. The distance is measured to the
+  rectangle spanned by the width (\ref setWidth) and the low and high values of the data point, so
+  it is zero if \a pixelPos lies within the OHLC bar or candlestick. The value of the returned
+  data point is the close value.
+  
+  The search starts at the data point with the key at \a pixelPos, which is found with a binary
+  search, and proceeds to both sides until the remaining data points are farther away in the key
+  dimension than the nearest data point found. Since the data is held in a QMap, the index of the
+  found data point is determined by counting the data points before it.
+*/
+QCPDataPoint QCPFinancial::findNearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return QCPDataPoint(); }
+  if (mData->isEmpty() || !(keyWindow.lower <= keyWindow.upper))
+    return QCPDataPoint();
+  
+  const bool keyIsVertical = keyAxis->orientation() == Qt::Vertical;
+  const double posKeyPixel = keyIsVertical ? pixelPos.y() : pixelPos.x();
+  const double posValuePixel = keyIsVertical ? pixelPos.x() : pixelPos.y();
+  const QCPFinancialDataMap &constData = *mData;
+  const QCPFinancialDataMap::const_iterator begin = constData.lowerBound(keyWindow.lower);
+  const QCPFinancialDataMap::const_iterator end = constData.upperBound(keyWindow.upper);
+  QCPFinancialDataMap::const_iterator lower = constData.lowerBound(qBound(keyWindow.lower, keyAxis->pixelToCoord(posKeyPixel), keyWindow.upper));
+  QCPFinancialDataMap::const_iterator upper = lower;
+  QCPFinancialDataMap::const_iterator nearest = mData->constEnd();
+  double minDistSqr = std::numeric_limits<double>::max();
+  while (lower != begin || upper != end)
   {
-    // high:
-    if (inSignDomain == sdBoth || (inSignDomain == sdNegative && it.value().high < 0) || (inSignDomain == sdPositive && it.value().high > 0))
+    // distances in the key dimension of the next data points on both sides, considering their width:
+    double lowerDist = std::numeric_limits<double>::max();
+    double upperDist = std::numeric_limits<double>::max();
+    if (lower != begin)
     {
-      if (it.value().high < range.lower || !haveLower)
-      {
-        range.lower = it.value().high;
-        haveLower = true;
-      }
-      if (it.value().high > range.upper || !haveUpper)
-      {
-        range.upper = it.value().high;
-        haveUpper = true;
-      }
+      const double key = (lower-1).key();
+      const double pixel1 = keyAxis->coordToPixel(key-mWidth*0.5);
+      const double pixel2 = keyAxis->coordToPixel(key+mWidth*0.5);
+      lowerDist = qMax(0.0, qMax(qMin(pixel1, pixel2)-posKeyPixel, posKeyPixel-qMax(pixel1, pixel2)));
     }
-    // low:
-    if (inSignDomain == sdBoth || (inSignDomain == sdNegative && it.value().low < 0) || (inSignDomain == sdPositive && it.value().low > 0))
+    if (upper != end)
     {
-      if (it.value().low < range.lower || !haveLower)
-      {
-        range.lower = it.value().low;
-        haveLower = true;
-      }
-      if (it.value().low > range.upper || !haveUpper)
-      {
-        range.upper = it.value().low;
-        haveUpper = true;
-      }
+      const double key = upper.key();
+      const double pixel1 = keyAxis->coordToPixel(key-mWidth*0.5);
+      const double pixel2 = keyAxis->coordToPixel(key+mWidth*0.5);
+      upperDist = qMax(0.0, qMax(qMin(pixel1, pixel2)-posKeyPixel, posKeyPixel-qMax(pixel1, pixel2)));
+    }
+    const double keyDist = qMin(lowerDist, upperDist);
+    if (keyDist*keyDist > minDistSqr)
+      break;
+    QCPFinancialDataMap::const_iterator it;
+    if (upperDist <= lowerDist)
+      it = upper++;
+    else
+      it = --lower;
+    const double highPixel = valueAxis->coordToPixel(it.value().high);
+    const double lowPixel = valueAxis->coordToPixel(it.value().low);
+    const double valueDist = qMax(0.0, qMax(qMin(highPixel, lowPixel)-posValuePixel, posValuePixel-qMax(highPixel, lowPixel)));
+    const double distSqr = keyDist*keyDist+valueDist*valueDist;
+    if (distSqr < minDistSqr) // also false for data points with NaN values
+    {
+      minDistSqr = distSqr;
+      nearest = it;
     }
-    ++it;
   }
   
-  foundRange = haveLower && haveUpper;
-  return range;
+  if (nearest == mData->constEnd())
+    return QCPDataPoint();
+  int index = 0;
+  for (QCPFinancialDataMap::const_iterator it = mData->constBegin(); it != nearest; ++it)
+    ++index;
+  return QCPDataPoint(index, nearest.key(), nearest.value().close, qSqrt(minDistSqr));
+}
+
+/*! \internal
+  
+  Extends the range cache (see \ref QCPAbstractPlottable::rangeCache) by the newly added data point
+  \a data. In the value dimension, the high and low values of the data point are taken into account.
+*/
+void QCPFinancial::addToRangeCache(const QCPFinancialData &data) const
+{
+  extendRangeCache(false, data.key);
+  extendRangeCache(true, data.high);
+  extendRangeCache(true, data.low);
 }
 
 /*! \internal
@@ -939,8 +1046,9 @@ void QCPFinancial::getVisibleDataBounds(QCPFinancialDataMap::const_iterator &low
   }
   
   // get visible data range as QMap iterators
-  QCPFinancialDataMap::const_iterator lbound = mData->lowerBound(mKeyAxis.data()->range().lower);
-  QCPFinancialDataMap::const_iterator ubound = mData->upperBound(mKeyAxis.data()->range().upper);
+  const QCPFinancialDataMap &constData = *mData;
+  QCPFinancialDataMap::const_iterator lbound = constData.lowerBound(mKeyAxis.data()->range().lower);
+  QCPFinancialDataMap::const_iterator ubound = constData.upperBound(mKeyAxis.data()->range().upper);
   bool lowoutlier = lbound != mData->constBegin(); // indicates whether there exist points below axis range
   bool highoutlier = ubound != mData->constEnd(); // indicates whether there exist points above axis range
   
@@ -37,7 +37,8 @@
 /*! \class QCPData
   \brief Holds the data of one single data point for QCPGraph.
   
-  The container for storing multiple data points is \ref QCPDataMap.
+  The container for storing multiple data points is \ref QCPDataContainer (also available under
+  its traditional name \ref QCPDataMap).
   
   The stored data is:
   \li \a key: coordinate on the key axis of this data point
@@ -47,7 +48,7 @@
   \li \a valueErrorMinus: negative error in the value dimension (for error bars)
   \li \a valueErrorPlus: positive error in the value dimension (for error bars)
   
-  \see QCPDataMap
+  \see QCPDataContainer
 */
 
 /*!
@@ -76,6 +77,1703 @@ QCPData::QCPData(double key, double value) :
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataContainer
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDataContainer
+  \brief Holds the data points of a QCPGraph, sorted by their keys.
+  
+  The data points (\ref QCPData) are stored contiguously in memory, ordered ascending by key. This
+  allows fast lookup of the visible data range via binary search (\ref findBegin, \ref findEnd),
+  cache friendly iteration during replots and bulk insertion without per-point allocations.
+  Multiple data points with the same key may exist, they keep the order in which they were added.
+  
+  The storage is column oriented: Keys and values are held in separate arrays, so scanning e.g.
+  only the keys touches no other memory. The four error columns are only allocated once a data
+  point with non-zero errors is added (e.g. via \ref QCPGraph::setDataValueError). For the common
+  case of data without error bars, a data point thus occupies 16 bytes instead of the 48 bytes of
+  a \ref QCPData. Use \ref keyAt, \ref valueAt and the error accessors like \ref keyErrorMinusAt to
+  access single columns, or \ref at to get the complete data point. Since the data points aren't
+  stored as QCPData instances, \ref at and the const iterators return them by value.
+  
+  QCPDataContainer provides the subset of the QMap interface that was commonly used when QCPGraph
+  stored its data in a QMap, e.g. \ref constBegin, \ref constEnd, \ref lowerBound, \ref upperBound,
+  \ref insert, \ref insertMulti and \ref unite. Its iterators provide \a key() and \a value() methods
+  like QMap iterators. For backward compatibility, \ref QCPDataMap is a typedef of this class.
+  
+  The non-const STL-style iterators (\ref iterator) return a \ref reference to the data point,
+  which writes modifications back to the container, so code like <tt>it.value().value = 5;</tt>
+  written for QMap keeps working. Since each write back is a separate modification, loops that
+  change many values are faster with \ref setValueAt. Other data points are modified with the
+  methods of this class (e.g. \ref replace) or of QCPGraph (\ref QCPGraph::setData, \ref
+  QCPGraph::addData, \ref QCPGraph::removeData, etc.). Code written for the Java-style QMap
+  iterators can use \ref QCPDataMapIterator and \ref QCPDataMutableMapIterator. Like with QVector,
+  iterators and indices are invalidated when the container is modified by other means than the
+  iterator itself.
+  
+  \section qcpdatacontainer-streaming Streaming with a fixed capacity
+  
+  Internally, the data points are held in a circular buffer. Removing data points from the front
+  (\ref removeBefore) therefore doesn't move the remaining data points, and appending data points
+  with keys greater than or equal to the current highest key doesn't move any data points either.
+  
+  For data acquisition scenarios where data points are continuously appended and old ones are
+  dropped, a fixed capacity can be set with \ref setFixedCapacity. The circular buffer is then
+  allocated once, and when it is full, appending a new data point evicts the data point with the
+  lowest key in constant time. No memory is allocated per data point in this mode.
+  
+  \section qcpdatacontainer-external External data views
+  
+  If the data is already held in user-owned arrays, the container can be made a view onto them
+  with \ref setExternal, without copying the data. See \ref setExternal for the lifetime and
+  invalidation contract of such views.
+  
+  \section qcpdatacontainer-pyramid Min/max pyramid
+  
+  For large data sets, the container can maintain a multi-resolution min/max pyramid of the values
+  (\ref setMinMaxPyramid). The smallest and largest value of any index range can then be determined
+  with \ref valueMinMax in logarithmic time, which QCPGraph uses to make adaptive sampling
+  independent of the number of visible data points.
+  
+  \see QCPGraph::data, QCPGraph::setStreamingCapacity, QCPGraph::setExternalData
+*/
+
+/* start of documentation of inline functions */
+
+/*! \fn int QCPDataContainer::size() const
+  
+  Returns the number of data points in the container.
+*/
+
+/*! \fn bool QCPDataContainer::isExternal() const
+  
+  Returns whether this container is a view onto user-owned arrays.
+  
+  \see setExternal
+*/
+
+/*! \fn int QCPDataContainer::fixedCapacity() const
+  
+  Returns the fixed capacity of this container, or 0 if the container grows as needed.
+  
+  \see setFixedCapacity
+*/
+
+/*! \fn bool QCPDataContainer::hasKeyErrors() const
+  
+  Returns whether the key error columns are allocated, i.e. whether a data point with non-zero key
+  errors was added. If false, \ref keyErrorMinusAt and \ref keyErrorPlusAt return 0 for all data
+  points.
+*/
+
+/*! \fn bool QCPDataContainer::hasValueErrors() const
+  
+  Returns whether the value error columns are allocated, i.e. whether a data point with non-zero
+  value errors was added. If false, \ref valueErrorMinusAt and \ref valueErrorPlusAt return 0 for
+  all data points.
+*/
+
+/*! \fn quint32 QCPDataContainer::revision() const
+  
+  Returns a number that changes whenever the data points of this container are modified. This
+  allows users of the container, like QCPGraph, to determine whether information they derived from
+  the data (e.g. the data bounds) is still up to date.
+*/
+
+/*! \fn double QCPDataContainer::keyAt(int index) const
+  
+  Returns the key of the data point at \a index. This is equivalent to <tt>at(index).key</tt>.
+*/
+
+/*! \fn double QCPDataContainer::valueAt(int index) const
+  
+  Returns the value of the data point at \a index. This is equivalent to <tt>at(index).value</tt>.
+  If \ref setSinglePrecisionValues is enabled, the stored single precision value is converted to
+  double.
+*/
+
+/*! \fn bool QCPDataContainer::singlePrecisionValues() const
+  
+  Returns whether the values are stored with single precision.
+  
+  \see setSinglePrecisionValues
+*/
+
+/*! \fn bool QCPDataContainer::minMaxPyramid() const
+  
+  Returns whether the container maintains a min/max pyramid of the values.
+  
+  \see setMinMaxPyramid
+*/
+
+/*! \fn double QCPDataContainer::keyErrorMinusAt(int index) const
+  
+  Returns the negative key error of the data point at \a index, or 0 if no key errors were set
+  (see \ref hasKeyErrors).
+*/
+
+/*! \fn double QCPDataContainer::keyErrorPlusAt(int index) const
+  
+  Returns the positive key error of the data point at \a index, or 0 if no key errors were set
+  (see \ref hasKeyErrors).
+*/
+
+/*! \fn double QCPDataContainer::valueErrorMinusAt(int index) const
+  
+  Returns the negative value error of the data point at \a index, or 0 if no value errors were set
+  (see \ref hasValueErrors).
+*/
+
+/*! \fn double QCPDataContainer::valueErrorPlusAt(int index) const
+  
+  Returns the positive value error of the data point at \a index, or 0 if no value errors were set
+  (see \ref hasValueErrors).
+*/
+
+/*! \fn QCPDataContainer::const_iterator QCPDataContainer::lowerBound(double key) const
+  
+  Returns an iterator to the first data point with a key greater than or equal to \a key, or \ref
+  constEnd if there is none. Like QMap::lowerBound.
+  
+  \see findBegin
+*/
+
+/*! \fn QCPDataContainer::const_iterator QCPDataContainer::upperBound(double key) const
+  
+  Returns an iterator to the first data point with a key greater than \a key, or \ref constEnd if
+  there is none. Like QMap::upperBound.
+  
+  \see findEnd
+*/
+
+/* end of documentation of inline functions */
+
+/*! \internal
+  
+  The number of consecutive physical slots whose value bounds are combined in one entry of the
+  lowest level of the min/max pyramid (see \ref setMinMaxPyramid). Ranges shorter than two blocks
+  are scanned directly.
+*/
+const int QCPDataContainer::pyramidBlockSize = 32;
+
+/*!
+  Constructs an empty data container.
+*/
+QCPDataContainer::QCPDataContainer() :
+  mBegin(0),
+  mSize(0),
+  mFixedCapacity(0),
+  mSinglePrecisionValues(false),
+  mRevision(0),
+  mExternalKeys(0),
+  mExternalValues(0),
+  mMinMaxPyramid(false),
+  mPyramidValid(false),
+  mPyramidDirtyBlock(-1)
+{
+}
+
+/*!
+  Sets a fixed capacity for this container. If \a capacity is greater than zero, the internal
+  circular buffer is allocated with exactly \a capacity data points and never grows. When the
+  buffer is full, adding a data point evicts the data point with the lowest key (which may be the
+  added data point itself, if its key is lower than all others). Appending data points whose keys
+  are greater than or equal to the current highest key, and evicting the oldest data points, are
+  constant time operations without memory allocation.
+  
+  If the container currently holds more than \a capacity data points, the ones with the lowest
+  keys are removed.
+  
+  Setting \a capacity to 0 makes the container grow as needed again, which is the default.
+  
+  \see QCPGraph::setStreamingCapacity
+*/
+void QCPDataContainer::setFixedCapacity(int capacity)
+{
+  if (capacity < 0)
+    capacity = 0;
+  mFixedCapacity = capacity;
+  if (mFixedCapacity > 0)
+    reallocate(mFixedCapacity);
+}
+
+/*!
+  Sets whether the values of the data points are stored with single precision (float) instead of
+  double precision. The keys are always stored with double precision, so e.g. time axes keep their
+  resolution. For data without error bars, this reduces the memory per data point from 16 to 12
+  bytes.
+  
+  Values that are already stored are converted. When switching to single precision, this loses
+  precision accordingly. \ref valueAt and \ref at convert the stored values back to double on
+  access, so the drawing code reads the single precision column directly, without creating a
+  converted copy of the data.
+  
+  \see QCPGraph::setSinglePrecisionValues
+*/
+void QCPDataContainer::setSinglePrecisionValues(bool enabled)
+{
+  if (mSinglePrecisionValues == enabled)
+    return;
+  mSinglePrecisionValues = enabled;
+  if (mSinglePrecisionValues)
+  {
+    mFloatValues.resize(mValues.size());
+    for (int i=0; i<mValues.size(); ++i)
+      mFloatValues[i] = mValues.at(i);
+    mValues.clear();
+  } else
+  {
+    mValues.resize(mFloatValues.size());
+    for (int i=0; i<mFloatValues.size(); ++i)
+      mValues[i] = mFloatValues.at(i);
+    mFloatValues.clear();
+  }
+  invalidatePyramid();
+  ++mRevision;
+}
+
+/*!
+  Sets whether the container maintains a min/max pyramid of the values. The pyramid holds the
+  smallest and largest value of consecutive blocks of data points, and of successively larger
+  groups of these blocks. \ref valueMinMax then determines the value bounds of any index range in
+  logarithmic instead of linear time. QCPGraph uses this to perform adaptive sampling of large data
+  sets in time proportional to the number of pixels, rather than the number of visible data points
+  (see \ref QCPGraph::setMinMaxPyramid).
+  
+  The pyramid is built on the first call to \ref valueMinMax after the data was replaced (e.g. by
+  \ref set, \ref setExternal or \ref externalDataChanged). Appending data points, also in a
+  circular buffer with fixed capacity, and removing data points from either end keep it up to
+  date at amortized constant cost. Inserting or removing data points in the middle of the data
+  invalidates it, so it is rebuilt on the next call to \ref valueMinMax.
+  
+  The pyramid needs roughly one eighth of the memory of the value column (for double precision
+  values) and is disabled by default.
+*/
+void QCPDataContainer::setMinMaxPyramid(bool enabled)
+{
+  mMinMaxPyramid = enabled;
+  invalidatePyramid();
+  if (!enabled)
+  {
+    mPyramidMin.clear();
+    mPyramidMax.clear();
+  }
+}
+
+/*!
+  Returns the data point at \a index. The data points are ordered ascending by key, so index 0 is
+  the data point with the lowest key. \a index must be a valid index, i.e. 0 <= \a index < \ref
+  size.
+  
+  The data point is assembled from the individual columns. If only the key or value is needed, \ref
+  keyAt or \ref valueAt are faster.
+*/
+QCPData QCPDataContainer::at(int index) const
+{
+  if (mExternalKeys)
+    return QCPData(mExternalKeys[index], mExternalValues[index]);
+  const int slot = physicalIndex(index);
+  QCPData result(mKeys.at(slot), mSinglePrecisionValues ? mFloatValues.at(slot) : mValues.at(slot));
+  if (!mKeyErrorsMinus.isEmpty())
+  {
+    result.keyErrorMinus = mKeyErrorsMinus.at(slot);
+    result.keyErrorPlus = mKeyErrorsPlus.at(slot);
+  }
+  if (!mValueErrorsMinus.isEmpty())
+  {
+    result.valueErrorMinus = mValueErrorsMinus.at(slot);
+    result.valueErrorPlus = mValueErrorsPlus.at(slot);
+  }
+  return result;
+}
+
+/*!
+  Returns the index of the first data point with a key greater than or equal to \a key. If all
+  data points have smaller keys, returns \ref size.
+  
+  This is a binary search and thus has logarithmic complexity.
+  
+  \see findEnd, lowerBound
+*/
+int QCPDataContainer::findBegin(double key) const
+{
+  return findBegin(key, 0, mSize);
+}
+
+/*! \overload
+  
+  Returns the index of the first data point with a key greater than or equal to \a key, searching
+  only the indices from \a from up to (but not including) \a to. If all data points in this range
+  have smaller keys, returns \a to.
+*/
+int QCPDataContainer::findBegin(double key, int from, int to) const
+{
+  int lower = from;
+  int count = to-from;
+  while (count > 0)
+  {
+    int step = count/2;
+    int middle = lower+step;
+    if (keyAt(middle) < key)
+    {
+      lower = middle+1;
+      count -= step+1;
+    } else
+      count = step;
+  }
+  return lower;
+}
+
+/*!
+  Returns the index of the first data point with a key greater than \a key. If no data point has a
+  greater key, returns \ref size.
+  
+  This is a binary search and thus has logarithmic complexity.
+  
+  \see findBegin, upperBound
+*/
+int QCPDataContainer::findEnd(double key) const
+{
+  int lower = 0;
+  int count = mSize;
+  while (count > 0)
+  {
+    int step = count/2;
+    int middle = lower+step;
+    if (!(key < keyAt(middle)))
+    {
+      lower = middle+1;
+      count -= step+1;
+    } else
+      count = step;
+  }
+  return lower;
+}
+
+/*!
+  Returns an iterator to the first data point with exactly the key \a key, or \ref constEnd if
+  there is no such data point.
+*/
+QCPDataContainer::const_iterator QCPDataContainer::constFind(double key) const
+{
+  int index = findBegin(key);
+  if (index < mSize && keyAt(index) == key)
+    return const_iterator(this, index);
+  else
+    return constEnd();
+}
+
+/*!
+  Replaces the current data with the data points in \a data.
+  
+  If \a alreadySorted is true, \a data must be sorted ascending by key. If it is false, the data
+  points are checked for order and sorted if necessary. Since the check is linear, passing
+  presorted data with \a alreadySorted set to false is still fast.
+  
+  The error columns are only allocated if \a data contains data points with non-zero errors.
+  
+  If a fixed capacity is set (\ref setFixedCapacity) and \a data holds more data points, only the
+  ones with the highest keys are kept.
+*/
+void QCPDataContainer::set(const QVector<QCPData> &data, bool alreadySorted)
+{
+  QVector<QCPData> sortedData(data);
+  if (!alreadySorted && !isSorted(sortedData))
+    std::stable_sort(sortedData.begin(), sortedData.end(), lessThanKey);
+  
+  const int newCapacity = mFixedCapacity > 0 ? mFixedCapacity : sortedData.size();
+  const int keep = qMin(sortedData.size(), newCapacity);
+  const int offset = sortedData.size()-keep;
+  resetColumns(newCapacity);
+  for (int i=0; i<keep; ++i)
+    writeData(i, sortedData.at(offset+i));
+  mBegin = 0;
+  mSize = keep;
+}
+
+/*! \overload
+  
+  Replaces the current data with data points given by the \a keys and \a values columns. If the
+  vectors have different sizes, the number of data points is the size of the smaller one.
+  
+  If \a alreadySorted is true, \a keys must be sorted ascending. If it is false, the keys are
+  checked for order and the data points are sorted if necessary.
+  
+  Because QVector is implicitly shared, this doesn't copy \a keys and \a values if they have the
+  same size, are already sorted, the container has no fixed capacity and doesn't store single
+  precision values. The error columns are released.
+*/
+void QCPDataContainer::set(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
+{
+  const int n = qMin(keys.size(), values.size());
+  if (!alreadySorted)
+  {
+    for (int i=1; i<n; ++i)
+    {
+      if (keys.at(i) < keys.at(i-1)) // unsorted, fall back to sorting complete data points
+      {
+        QVector<QCPData> data(n);
+        for (int k=0; k<n; ++k)
+        {
+          data[k].key = keys.at(k);
+          data[k].value = values.at(k);
+        }
+        set(data, false);
+        return;
+      }
+    }
+  }
+  
+  if (mFixedCapacity == 0 && !mSinglePrecisionValues && keys.size() == n && values.size() == n)
+  {
+    resetColumns(0);
+    mKeys = keys;
+    mValues = values;
+    mBegin = 0;
+    mSize = n;
+  } else
+    assignColumns(keys.constData(), values.constData(), n);
+}
+
+/*!
+  Makes this container a view onto the user-owned arrays \a keys and \a values, each holding \a
+  size entries. The data isn't copied, so attaching even very large data sets is a constant time
+  operation without memory allocation. The keys must be sorted ascending. Data points of an
+  external view have no errors.
+  
+  The caller must adhere to the following contract:
+  \li The arrays must stay valid until the view ends, i.e. until the data is replaced (e.g. with
+  \ref set or another call to \ref setExternal), until the container is destroyed, or until the
+  view is detached (see below).
+  \li The arrays may be modified or reallocated by the caller, but before the container is accessed
+  again (typically by the next replot), \ref externalDataChanged or \ref setExternal must be called
+  to report the change.
+  
+  All modifying methods (e.g. \ref add, \ref removeBefore, \ref insert, \ref setFixedCapacity)
+  detach the view first: the data points are copied into internally owned storage and the external
+  arrays are no longer referenced afterwards. Setting an external view resets the fixed capacity
+  (\ref setFixedCapacity) to 0.
+  
+  If \c QCUSTOMPLOT_CHECK_DATA is defined, the key order is checked and a debug message is printed
+  if the keys aren't sorted.
+  
+  \see isExternal, QCPGraph::setExternalData
+*/
+void QCPDataContainer::setExternal(const double *keys, const double *values, int size)
+{
+  if (!keys || !values || size < 0)
+  {
+    qDebug() << Q_FUNC_INFO << "invalid external data" << reinterpret_cast<quintptr>(keys) << reinterpret_cast<quintptr>(values) << size;
+    return;
+  }
+  resetColumns(0);
+  mFixedCapacity = 0;
+  mExternalKeys = keys;
+  mExternalValues = values;
+  mBegin = 0;
+  mSize = size;
+  externalDataChanged();
+}
+
+/*!
+  Notifies the container that the external arrays passed to \ref setExternal were modified. If \a
+  size is non-negative, the number of data points is set to \a size, e.g. when the producer
+  appended to the arrays. The arrays themselves must still be located at the same addresses,
+  otherwise call \ref setExternal again.
+  
+  If the container isn't an external view, this function does nothing.
+*/
+void QCPDataContainer::externalDataChanged(int size)
+{
+  if (!mExternalKeys)
+    return;
+  if (size >= 0)
+    mSize = size;
+  invalidatePyramid();
+  ++mRevision;
+#ifdef QCUSTOMPLOT_CHECK_DATA
+  for (int i=1; i<mSize; ++i)
+  {
+    if (mExternalKeys[i] < mExternalKeys[i-1])
+    {
+      qDebug() << Q_FUNC_INFO << "External keys not sorted ascending at index" << i;
+      break;
+    }
+  }
+#endif
+}
+
+/*! \overload
+  
+  Adds the data points in \a data to the container.
+  
+  If \a alreadySorted is true, \a data must be sorted ascending by key. If it is false, the data
+  points are checked for order and sorted if necessary.
+  
+  If the new data points all have keys greater than or equal to the keys of the existing data
+  points (as is typical for data that is appended in a running measurement), the data points are
+  simply appended. Otherwise, the new data points are merged into the existing ones, which has
+  linear complexity.
+*/
+void QCPDataContainer::add(const QVector<QCPData> &data, bool alreadySorted)
+{
+  if (data.isEmpty())
+    return;
+  if (mSize == 0)
+  {
+    set(data, alreadySorted);
+    return;
+  }
+  
+  const bool sorted = alreadySorted || isSorted(data);
+  if (sorted && !(data.first().key < lastKey())) // new data extends existing data, append it
+  {
+    int start = 0;
+    if (mFixedCapacity > 0)
+      start = qMax(0, data.size()-mFixedCapacity); // data points before start would be evicted right away
+    else if (mSize+data.size() > capacity())
+      reallocate(qMax(mSize+data.size(), capacity()*2));
+    for (int i=start; i<data.size(); ++i)
+      appendData(data.at(i));
+  } else // merge new data into existing data
+  {
+    QVector<QCPData> merged = toVector();
+    const int oldSize = merged.size();
+    merged.reserve(oldSize+data.size());
+    for (int i=0; i<data.size(); ++i)
+      merged.append(data.at(i));
+    if (!sorted)
+      std::stable_sort(merged.begin()+oldSize, merged.end(), lessThanKey);
+    std::inplace_merge(merged.begin(), merged.begin()+oldSize, merged.end(), lessThanKey);
+    set(merged, true);
+  }
+}
+
+/*! \overload
+  
+  Adds all data points of \a other to this container. Equivalent to QMap::unite.
+*/
+void QCPDataContainer::add(const QCPDataContainer &other)
+{
+  add(other.toVector(), true);
+}
+
+/*! \overload
+  
+  Adds the single data point \a data to the container.
+  
+  If the key of \a data is greater than or equal to the keys of all existing data points, this is
+  an amortized constant time operation. Otherwise the data point is inserted at the appropriate
+  position, which requires moving the data points on the shorter side of that position.
+*/
+void QCPDataContainer::add(const QCPData &data)
+{
+  if (mSize == 0 || !(data.key < lastKey()))
+    appendData(data);
+  else
+    insertData(findEnd(data.key), data);
+}
+
+/*!
+  Inserts \a data with the key \a key into the container. If a data point with exactly the key \a
+  key already exists, it is replaced. The key member of \a data is set to \a key. This function
+  corresponds to QMap::insert.
+  
+  \see insertMulti, add
+*/
+void QCPDataContainer::insert(double key, const QCPData &data)
+{
+  detachExternal();
+  QCPData newData(data);
+  newData.key = key;
+  if (mSize == 0 || key > lastKey())
+  {
+    appendData(newData);
+  } else
+  {
+    int index = findBegin(key);
+    if (index < mSize && keyAt(index) == key)
+      writeData(physicalIndex(index), newData);
+    else
+      insertData(index, newData);
+  }
+}
+
+/*!
+  Inserts \a data with the key \a key into the container, even if data points with the same key
+  already exist. The key member of \a data is set to \a key. This function corresponds to
+  QMap::insertMulti.
+  
+  \see insert, add
+*/
+void QCPDataContainer::insertMulti(double key, const QCPData &data)
+{
+  QCPData newData(data);
+  newData.key = key;
+  add(newData);
+}
+
+/*!
+  Replaces the data point at \a index with \a data. The key of the data point stays the same, the
+  key member of \a data is ignored, so the key order is preserved. This is the equivalent of
+  assigning to the value of a QMap iterator.
+  
+  \a index must be a valid index, i.e. 0 <= \a index < \ref size.
+  
+  \see insert, QCPDataMutableMapIterator::setValue
+*/
+void QCPDataContainer::replace(int index, const QCPData &data)
+{
+  if (index < 0 || index >= mSize)
+  {
+    qDebug() << Q_FUNC_INFO << "index out of bounds:" << index;
+    return;
+  }
+  detachExternal();
+  QCPData newData(data);
+  newData.key = keyAt(index);
+  writeData(physicalIndex(index), newData);
+}
+
+/*!
+  Sets the value of the data point at \a index to \a value. Unlike \ref replace, this only writes
+  the value column, so it is the fastest way to modify the values of existing data points.
+  
+  \a index must be a valid index, i.e. 0 <= \a index < \ref size.
+  
+  \see valueAt, replace
+*/
+void QCPDataContainer::setValueAt(int index, double value)
+{
+  if (index < 0 || index >= mSize)
+  {
+    qDebug() << Q_FUNC_INFO << "index out of bounds:" << index;
+    return;
+  }
+  detachExternal();
+  const int slot = physicalIndex(index);
+  if (mSinglePrecisionValues)
+    mFloatValues[slot] = value;
+  else
+    mValues[slot] = value;
+  if (mPyramidValid)
+    markPyramidSlot(slot);
+  ++mRevision;
+}
+
+/*!
+  Removes all data points with keys smaller than \a key.
+  
+  Since the data points are held in a circular buffer, the remaining data points usually aren't
+  moved, so apart from the binary search for \a key, this takes constant time. If the container is
+  an external view (\ref setExternal) however, the remaining data points are first copied into
+  internally owned columns, which is linear in their number. The memory of the removed data points
+  isn't released, call \ref squeeze to do that (which moves the remaining data points).
+*/
+void QCPDataContainer::removeBefore(double key)
+{
+  eraseData(0, findBegin(key));
+}
+
+/*!
+  Removes all data points with keys greater than \a key.
+*/
+void QCPDataContainer::removeAfter(double key)
+{
+  eraseData(findEnd(key), mSize);
+}
+
+/*!
+  Removes all data points with keys greater than \a fromKey and smaller than or equal to \a toKey.
+  If \a fromKey is greater than or equal to \a toKey, this function does nothing.
+*/
+void QCPDataContainer::remove(double fromKey, double toKey)
+{
+  if (fromKey >= toKey || mSize == 0)
+    return;
+  eraseData(findEnd(fromKey), findEnd(toKey));
+}
+
+/*! \overload
+  
+  Removes all data points with exactly the key \a key and returns the number of removed data
+  points. This function corresponds to QMap::remove.
+*/
+int QCPDataContainer::remove(double key)
+{
+  int begin = findBegin(key);
+  int end = begin;
+  while (end < mSize && keyAt(end) == key)
+    ++end;
+  eraseData(begin, end);
+  return end-begin;
+}
+
+/*!
+  Removes the data point at \a it and returns an iterator to the data point following it.
+*/
+QCPDataContainer::const_iterator QCPDataContainer::erase(const_iterator it)
+{
+  eraseData(it.index(), it.index()+1);
+  return const_iterator(this, it.index());
+}
+
+/*! \overload
+  
+  Removes the data points from \a first up to (but not including) \a last and returns an iterator
+  to the data point following the removed range.
+*/
+QCPDataContainer::const_iterator QCPDataContainer::erase(const_iterator first, const_iterator last)
+{
+  eraseData(first.index(), last.index());
+  return const_iterator(this, first.index());
+}
+
+/*!
+  Removes all data points. If a fixed capacity is set, the allocated key and value columns are
+  kept, otherwise they are freed. The error columns are always freed.
+*/
+void QCPDataContainer::clear()
+{
+  mExternalKeys = 0;
+  mExternalValues = 0;
+  if (mFixedCapacity == 0)
+  {
+    mKeys.clear();
+    mValues.clear();
+    mFloatValues.clear();
+  }
+  mKeyErrorsMinus.clear();
+  mKeyErrorsPlus.clear();
+  mValueErrorsMinus.clear();
+  mValueErrorsPlus.clear();
+  mBegin = 0;
+  mSize = 0;
+  invalidatePyramid();
+  ++mRevision;
+}
+
+/*!
+  Preallocates memory for \a size data points. This avoids reallocations when data points are
+  added one by one, e.g. in a running measurement with a known number of data points.
+  
+  If a fixed capacity is set (\ref setFixedCapacity), this function does nothing.
+*/
+void QCPDataContainer::reserve(int size)
+{
+  if (mFixedCapacity == 0 && size > capacity())
+    reallocate(size);
+}
+
+/*!
+  Releases memory that was allocated for data points which have since been removed, or which was
+  preallocated with \ref reserve.
+  
+  If a fixed capacity is set (\ref setFixedCapacity), this function does nothing.
+*/
+void QCPDataContainer::squeeze()
+{
+  if (mFixedCapacity == 0 && capacity() > mSize)
+    reallocate(mSize);
+}
+
+/*!
+  Returns a copy of all data points, sorted ascending by key.
+*/
+QVector<QCPData> QCPDataContainer::toVector() const
+{
+  QVector<QCPData> result(mSize);
+  for (int i=0; i<mSize; ++i)
+    result[i] = at(i);
+  return result;
+}
+
+/*!
+  Determines the smallest and largest value of the data points with indices from \a begin up to
+  (but not including) \a end and stores them in \a minValue and \a maxValue. NaN values are
+  ignored. Returns false if the range contains no values other than NaN, \a minValue and \a
+  maxValue are then set to positive and negative infinity, respectively.
+  
+  If the min/max pyramid is enabled (\ref setMinMaxPyramid), this has logarithmic complexity,
+  otherwise the values are scanned. Building or updating the pyramid happens lazily in this
+  function, so like the other const methods, it must not be called concurrently with modifications
+  of the container.
+*/
+bool QCPDataContainer::valueMinMax(int begin, int end, double &minValue, double &maxValue) const
+{
+  minValue = std::numeric_limits<double>::infinity();
+  maxValue = -std::numeric_limits<double>::infinity();
+  if (!mMinMaxPyramid || end-begin < 2*pyramidBlockSize)
+  {
+    for (int i=begin; i<end; ++i)
+    {
+      const double value = valueAt(i);
+      if (value < minValue)
+        minValue = value;
+      if (value > maxValue)
+        maxValue = value;
+    }
+  } else
+  {
+    updatePyramid();
+    // the index range maps to one or (if it wraps around the end of the circular buffer) two ranges of physical slots:
+    const int fromSlot = physicalIndex(begin);
+    const int toSlot = fromSlot+(end-begin);
+    const int slots = slotCount();
+    if (toSlot <= slots)
+      pyramidMinMax(fromSlot, toSlot, minValue, maxValue);
+    else
+    {
+      pyramidMinMax(fromSlot, slots, minValue, maxValue);
+      pyramidMinMax(0, toSlot-slots, minValue, maxValue);
+    }
+  }
+  return minValue <= maxValue;
+}
+
+/*! \internal
+  
+  Replaces the key and value columns with new, zero-initialized columns of size \a newCapacity and
+  releases the error columns. An external view is ended. The value column is allocated in the
+  precision given by \ref setSinglePrecisionValues. mBegin and mSize must be updated by the caller.
+*/
+void QCPDataContainer::resetColumns(int newCapacity)
+{
+  mExternalKeys = 0;
+  mExternalValues = 0;
+  mKeys = QVector<double>(newCapacity);
+  if (mSinglePrecisionValues)
+  {
+    mValues.clear();
+    mFloatValues = QVector<float>(newCapacity);
+  } else
+  {
+    mValues = QVector<double>(newCapacity);
+    mFloatValues.clear();
+  }
+  mKeyErrorsMinus.clear();
+  mKeyErrorsPlus.clear();
+  mValueErrorsMinus.clear();
+  mValueErrorsPlus.clear();
+  invalidatePyramid();
+  ++mRevision;
+}
+
+/*! \internal
+  
+  Replaces all data points with the \a count data points given by the arrays \a keys and \a
+  values, which must be sorted by key. If a fixed capacity is set and \a count exceeds it, only
+  the data points with the highest keys are copied.
+*/
+void QCPDataContainer::assignColumns(const double *keys, const double *values, int count)
+{
+  const int newCapacity = mFixedCapacity > 0 ? mFixedCapacity : count;
+  const int keep = qMin(count, newCapacity);
+  const int offset = count-keep;
+  resetColumns(newCapacity);
+  for (int i=0; i<keep; ++i)
+  {
+    mKeys[i] = keys[offset+i];
+    if (mSinglePrecisionValues)
+      mFloatValues[i] = values[offset+i];
+    else
+      mValues[i] = values[offset+i];
+  }
+  mBegin = 0;
+  mSize = keep;
+}
+
+/*! \internal
+  
+  If this container is an external view (see \ref setExternal), copies the data points into
+  internally owned columns, so they can be modified. Afterwards, the external arrays are no longer
+  referenced.
+*/
+void QCPDataContainer::detachExternal()
+{
+  if (!mExternalKeys)
+    return;
+  const double *keys = mExternalKeys;
+  const double *values = mExternalValues;
+  assignColumns(keys, values, mSize);
+}
+
+/*! \internal
+  
+  Writes \a data to the physical index \a slot of the columns. If \a data has non-zero errors and
+  the respective error columns aren't allocated yet, they are allocated and filled with zeros.
+*/
+void QCPDataContainer::writeData(int slot, const QCPData &data)
+{
+  mKeys[slot] = data.key;
+  if (mSinglePrecisionValues)
+    mFloatValues[slot] = data.value;
+  else
+    mValues[slot] = data.value;
+  if (mPyramidValid)
+    markPyramidSlot(slot);
+  ++mRevision;
+  if (mKeyErrorsMinus.isEmpty() && (data.keyErrorMinus != 0 || data.keyErrorPlus != 0))
+  {
+    mKeyErrorsMinus.fill(0, capacity());
+    mKeyErrorsPlus.fill(0, capacity());
+  }
+  if (!mKeyErrorsMinus.isEmpty())
+  {
+    mKeyErrorsMinus[slot] = data.keyErrorMinus;
+    mKeyErrorsPlus[slot] = data.keyErrorPlus;
+  }
+  if (mValueErrorsMinus.isEmpty() && (data.valueErrorMinus != 0 || data.valueErrorPlus != 0))
+  {
+    mValueErrorsMinus.fill(0, capacity());
+    mValueErrorsPlus.fill(0, capacity());
+  }
+  if (!mValueErrorsMinus.isEmpty())
+  {
+    mValueErrorsMinus[slot] = data.valueErrorMinus;
+    mValueErrorsPlus[slot] = data.valueErrorPlus;
+  }
+}
+
+/*! \internal
+  
+  Copies the data point at the physical index \a fromSlot to the physical index \a toSlot, in all
+  allocated columns.
+*/
+void QCPDataContainer::moveData(int toSlot, int fromSlot)
+{
+  mKeys[toSlot] = mKeys.at(fromSlot);
+  if (mSinglePrecisionValues)
+    mFloatValues[toSlot] = mFloatValues.at(fromSlot);
+  else
+    mValues[toSlot] = mValues.at(fromSlot);
+  if (!mKeyErrorsMinus.isEmpty())
+  {
+    mKeyErrorsMinus[toSlot] = mKeyErrorsMinus.at(fromSlot);
+    mKeyErrorsPlus[toSlot] = mKeyErrorsPlus.at(fromSlot);
+  }
+  if (!mValueErrorsMinus.isEmpty())
+  {
+    mValueErrorsMinus[toSlot] = mValueErrorsMinus.at(fromSlot);
+    mValueErrorsPlus[toSlot] = mValueErrorsPlus.at(fromSlot);
+  }
+}
+
+/*! \internal
+  
+  Appends \a data behind the last data point, without checking the key order. If the buffer is
+  full, it either grows, or, if a fixed capacity is set, the oldest data point is overwritten.
+*/
+void QCPDataContainer::appendData(const QCPData &data)
+{
+  detachExternal();
+  if (mSize == capacity()) // buffer is full
+  {
+    if (mFixedCapacity > 0)
+    {
+      // overwrite the data point with the lowest key:
+      writeData(mBegin, data);
+      mBegin = physicalIndex(1);
+      return;
+    }
+    reallocate(qMax(16, capacity()*2));
+  }
+  writeData(physicalIndex(mSize), data);
+  ++mSize;
+}
+
+/*! \internal
+  
+  Inserts \a data at \a index, moving the data points on the shorter side of \a index by one
+  position. If the buffer is full and a fixed capacity is set, the data point with the lowest key
+  is evicted (which is \a data itself, if \a index is 0).
+*/
+void QCPDataContainer::insertData(int index, const QCPData &data)
+{
+  detachExternal();
+  invalidatePyramid(); // data points are moved to different slots
+  if (mSize == capacity()) // buffer is full
+  {
+    if (mFixedCapacity > 0)
+    {
+      if (index == 0) // inserted data point would be the one with the lowest key, so it's evicted right away
+        return;
+      mBegin = physicalIndex(1);
+      --mSize;
+      --index;
+    } else
+      reallocate(qMax(16, capacity()*2));
+  }
+  
+  if (index < mSize/2)
+  {
+    // move data points in front of index one position towards the front:
+    mBegin = (mBegin > 0 ? mBegin : capacity())-1;
+    for (int i=0; i<index; ++i)
+      moveData(physicalIndex(i), physicalIndex(i+1));
+  } else
+  {
+    // move data points starting at index one position towards the back:
+    for (int i=mSize; i>index; --i)
+      moveData(physicalIndex(i), physicalIndex(i-1));
+  }
+  writeData(physicalIndex(index), data);
+  ++mSize;
+}
+
+/*! \internal
+  
+  Removes the data points with indices from \a begin up to (but not including) \a end, moving the
+  data points on the shorter side of the removed range to close the gap.
+*/
+void QCPDataContainer::eraseData(int begin, int end)
+{
+  const int count = end-begin;
+  if (count <= 0)
+    return;
+  detachExternal();
+  ++mRevision;
+  if (begin < mSize-end)
+  {
+    // move data points in front of removed range towards the back:
+    if (begin > 0)
+      invalidatePyramid();
+    for (int i=begin-1; i>=0; --i)
+      moveData(physicalIndex(i+count), physicalIndex(i));
+    mBegin = physicalIndex(count);
+  } else
+  {
+    // move data points behind removed range towards the front:
+    if (end < mSize)
+      invalidatePyramid();
+    for (int i=end; i<mSize; ++i)
+      moveData(physicalIndex(i-count), physicalIndex(i));
+  }
+  mSize -= count;
+}
+
+/*! \internal
+  
+  Replaces \a column (of size \a oldCapacity) with a new column of size \a newCapacity, holding the
+  \a count entries of the old column starting at the logical index \a offset. The old column is
+  interpreted as circular buffer starting at mBegin.
+*/
+template <typename T>
+void QCPDataContainer::reallocateColumn(QVector<T> &column, int oldCapacity, int newCapacity, int offset, int count) const
+{
+  QVector<T> newColumn(newCapacity);
+  for (int i=0; i<count; ++i)
+  {
+    int slot = mBegin+offset+i;
+    if (slot >= oldCapacity)
+      slot -= oldCapacity;
+    newColumn[i] = column.at(slot);
+  }
+  column = newColumn;
+}
+
+/*! \internal
+  
+  Reallocates the columns of the circular buffer with a size of \a newCapacity data points and
+  places the data points at their beginning, in order. If there are more data points than \a
+  newCapacity, the ones with the lowest keys are dropped. Error columns are only reallocated if
+  they are currently allocated.
+*/
+void QCPDataContainer::reallocate(int newCapacity)
+{
+  detachExternal();
+  const int oldCapacity = capacity();
+  const int keep = qMin(mSize, newCapacity);
+  const int offset = mSize-keep;
+  reallocateColumn(mKeys, oldCapacity, newCapacity, offset, keep);
+  if (mSinglePrecisionValues)
+    reallocateColumn(mFloatValues, oldCapacity, newCapacity, offset, keep);
+  else
+    reallocateColumn(mValues, oldCapacity, newCapacity, offset, keep);
+  if (!mKeyErrorsMinus.isEmpty())
+  {
+    reallocateColumn(mKeyErrorsMinus, oldCapacity, newCapacity, offset, keep);
+    reallocateColumn(mKeyErrorsPlus, oldCapacity, newCapacity, offset, keep);
+  }
+  if (!mValueErrorsMinus.isEmpty())
+  {
+    reallocateColumn(mValueErrorsMinus, oldCapacity, newCapacity, offset, keep);
+    reallocateColumn(mValueErrorsPlus, oldCapacity, newCapacity, offset, keep);
+  }
+  mBegin = 0;
+  mSize = keep;
+  invalidatePyramid();
+  ++mRevision;
+}
+
+/*! \internal
+  
+  Notifies the min/max pyramid that the value in the physical index \a slot was written. The block
+  containing \a slot is only marked as dirty, and recomputed by \ref updatePyramid once a different
+  block is written or the pyramid is queried. Since data points are typically appended in
+  sequence, each block is thus recomputed once per \ref pyramidBlockSize written data points.
+*/
+void QCPDataContainer::markPyramidSlot(int slot)
+{
+  const int block = slot/pyramidBlockSize;
+  if (block != mPyramidDirtyBlock)
+  {
+    updatePyramid();
+    mPyramidDirtyBlock = block;
+  }
+}
+
+/*! \internal
+  
+  Brings the min/max pyramid up to date: If it is invalid, it is rebuilt from all physical slots,
+  otherwise a block marked as dirty by \ref markPyramidSlot is recomputed.
+  
+  The pyramid maintains the following invariant: For each block whose slots all hold data points,
+  the level 0 entry holds the bounds of their values, and each entry of a higher level combines its
+  two entries of the level below. Blocks with unused slots may hold arbitrary bounds, so removing
+  data points from either end of the circular buffer doesn't require any updates. \ref
+  pyramidMinMax only uses entries whose blocks are completely covered by the queried range, so it
+  never reads such arbitrary bounds.
+*/
+void QCPDataContainer::updatePyramid() const
+{
+  if (mPyramidValid)
+  {
+    if (mPyramidDirtyBlock >= 0)
+    {
+      updatePyramidBlock(mPyramidDirtyBlock);
+      mPyramidDirtyBlock = -1;
+    }
+    return;
+  }
+  
+  const int slots = slotCount();
+  QVector<double> minLevel((slots+pyramidBlockSize-1)/pyramidBlockSize, std::numeric_limits<double>::infinity());
+  QVector<double> maxLevel(minLevel.size(), -std::numeric_limits<double>::infinity());
+  for (int slot=0; slot<slots; ++slot)
+  {
+    const double value = slotValue(slot);
+    const int block = slot/pyramidBlockSize;
+    if (value < minLevel.at(block))
+      minLevel[block] = value;
+    if (value > maxLevel.at(block))
+      maxLevel[block] = value;
+  }
+  mPyramidMin.clear();
+  mPyramidMax.clear();
+  mPyramidMin.append(minLevel);
+  mPyramidMax.append(maxLevel);
+  while (minLevel.size() > 1)
+  {
+    const QVector<double> lowerMin = minLevel;
+    const QVector<double> lowerMax = maxLevel;
+    minLevel.resize((lowerMin.size()+1)/2);
+    maxLevel.resize(minLevel.size());
+    for (int i=0; i<minLevel.size(); ++i)
+    {
+      const int child = i*2;
+      minLevel[i] = lowerMin.at(child);
+      maxLevel[i] = lowerMax.at(child);
+      if (child+1 < lowerMin.size())
+      {
+        minLevel[i] = qMin(minLevel.at(i), lowerMin.at(child+1));
+        maxLevel[i] = qMax(maxLevel.at(i), lowerMax.at(child+1));
+      }
+    }
+    mPyramidMin.append(minLevel);
+    mPyramidMax.append(maxLevel);
+  }
+  mPyramidValid = true;
+  mPyramidDirtyBlock = -1;
+}
+
+/*! \internal
+  
+  Recomputes the level 0 entry of the min/max pyramid for \a block from the values in its slots,
+  and updates the entries of the higher levels that contain it.
+*/
+void QCPDataContainer::updatePyramidBlock(int block) const
+{
+  double minValue = std::numeric_limits<double>::infinity();
+  double maxValue = -std::numeric_limits<double>::infinity();
+  const int endSlot = qMin(slotCount(), (block+1)*pyramidBlockSize);
+  for (int slot=block*pyramidBlockSize; slot<endSlot; ++slot)
+  {
+    const double value = slotValue(slot);
+    if (value < minValue)
+      minValue = value;
+    if (value > maxValue)
+      maxValue = value;
+  }
+  mPyramidMin[0][block] = minValue;
+  mPyramidMax[0][block] = maxValue;
+  for (int level=1; level<mPyramidMin.size(); ++level)
+  {
+    block /= 2;
+    const int child = block*2;
+    minValue = mPyramidMin.at(level-1).at(child);
+    maxValue = mPyramidMax.at(level-1).at(child);
+    if (child+1 < mPyramidMin.at(level-1).size())
+    {
+      minValue = qMin(minValue, mPyramidMin.at(level-1).at(child+1));
+      maxValue = qMax(maxValue, mPyramidMax.at(level-1).at(child+1));
+    }
+    mPyramidMin[level][block] = minValue;
+    mPyramidMax[level][block] = maxValue;
+  }
+}
+
+/*! \internal
+  
+  Extends \a minValue and \a maxValue by the values in the physical slots from \a fromSlot up to
+  (but not including) \a toSlot, which must all hold data points. Slots at the ends of the range
+  that don't fill a complete block are scanned, the complete blocks in between are covered by
+  combining the fewest possible entries of the min/max pyramid.
+*/
+void QCPDataContainer::pyramidMinMax(int fromSlot, int toSlot, double &minValue, double &maxValue) const
+{
+  int lowerBlock = (fromSlot+pyramidBlockSize-1)/pyramidBlockSize;
+  int upperBlock = toSlot/pyramidBlockSize;
+  if (lowerBlock >= upperBlock) // range doesn't contain a complete block
+    lowerBlock = upperBlock = (toSlot+pyramidBlockSize-1)/pyramidBlockSize;
+  for (int slot=fromSlot; slot<toSlot; ++slot)
+  {
+    if (slot == lowerBlock*pyramidBlockSize) // skip the complete blocks
+      slot = upperBlock*pyramidBlockSize;
+    if (slot >= toSlot)
+      break;
+    const double value = slotValue(slot);
+    if (value < minValue)
+      minValue = value;
+    if (value > maxValue)
+      maxValue = value;
+  }
+  // combine entries of the pyramid, climbing a level whenever both range ends are aligned to an entry of the next level:
+  for (int level=0; lowerBlock < upperBlock; ++level)
+  {
+    if (lowerBlock % 2 == 1)
+    {
+      minValue = qMin(minValue, mPyramidMin.at(level).at(lowerBlock));
+      maxValue = qMax(maxValue, mPyramidMax.at(level).at(lowerBlock));
+      ++lowerBlock;
+    }
+    if (upperBlock % 2 == 1)
+    {
+      --upperBlock;
+      minValue = qMin(minValue, mPyramidMin.at(level).at(upperBlock));
+      maxValue = qMax(maxValue, mPyramidMax.at(level).at(upperBlock));
+    }
+    lowerBlock /= 2;
+    upperBlock /= 2;
+  }
+}
+
+/*! \internal
+  
+  Comparison function used for sorting data points by key.
+*/
+bool QCPDataContainer::lessThanKey(const QCPData &a, const QCPData &b)
+{
+  return a.key < b.key;
+}
+
+/*! \internal
+  
+  Returns whether the data points in \a data, starting at index \a from, are sorted ascending by
+  key.
+*/
+bool QCPDataContainer::isSorted(const QVector<QCPData> &data, int from)
+{
+  for (int i=from+1; i<data.size(); ++i)
+  {
+    if (data.at(i).key < data.at(i-1).key)
+      return false;
+  }
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataContainer::reference
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDataContainer::reference
+  \brief Writable copy of a data point in a QCPDataContainer
+  
+  The non-const iterators of \ref QCPDataContainer return instances of this class instead of a
+  QCPData reference, because the container doesn't store QCPData instances. It is a QCPData
+  holding a copy of the data point, and when it is destroyed, it writes its modifications back to
+  the container via \ref QCPDataContainer::replace. So QMap style code keeps working:
+  
+  \code
+  QCPDataMap::iterator it = graph->data()->lowerBound(5);
+  it.value().value = 2; // the temporary reference writes the value back at the end of the statement
+  (*it).valueErrorPlus = 0.5;
+  \endcode
+  
+  Like with \ref QCPDataContainer::replace, the key can't be modified this way, changes of the
+  \a key member are ignored. Binding the result to a non-const <tt>QCPData&</tt> doesn't compile
+  anymore, use a \ref QCPDataContainer::reference variable instead, which writes back when it goes
+  out of scope.
+*/
+
+/*!
+  Writes the data point back to the container, if it was modified since this reference was
+  created.
+*/
+QCPDataContainer::reference::~reference()
+{
+  const QCPData &data = *this;
+  if (!sameValue(data.value, mOriginal.value) ||
+      !sameValue(data.keyErrorMinus, mOriginal.keyErrorMinus) || !sameValue(data.keyErrorPlus, mOriginal.keyErrorPlus) ||
+      !sameValue(data.valueErrorMinus, mOriginal.valueErrorMinus) || !sameValue(data.valueErrorPlus, mOriginal.valueErrorPlus))
+    mContainer->replace(mIndex, data);
+}
+
+/*! \internal
+  
+  Returns whether \a a and \a b are equal, treating two NaN values as equal, so unmodified gaps
+  (see \ref QCPGraph) don't cause a write back.
+*/
+bool QCPDataContainer::reference::sameValue(double a, double b)
+{
+  return a == b || (qIsNaN(a) && qIsNaN(b));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataMapIterator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDataMapIterator
+  \brief Java-style read-only iterator over the data points of a QCPDataContainer
+  
+  This class provides the interface of QMapIterator<double, QCPData>, which was the type of
+  QCPDataMapIterator in earlier versions of QCustomPlot, when QCPGraph still stored its data in a
+  QMap. Existing code iterating over \ref QCPGraph::data like this keeps working:
+  
+  \code
+  QCPDataMapIterator it(*graph->data());
+  while (it.hasNext())
+  {
+    it.next();
+    qDebug() << it.key() << it.value().value;
+  }
+  \endcode
+  
+  The iterator sits between data points. \ref next and \ref previous jump over a data point and
+  return an STL-style iterator to it, \ref key and \ref value return the data point that was jumped
+  over last. Since the container doesn't store QCPData instances, \ref value returns a copy.
+  
+  \see QCPDataMutableMapIterator, QCPDataContainer
+*/
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataMutableMapIterator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDataMutableMapIterator
+  \brief Java-style iterator that can modify the data points of a QCPDataContainer
+  
+  This class provides the interface of QMutableMapIterator<double, QCPData>, which was the type of
+  QCPDataMutableMapIterator in earlier versions of QCustomPlot. In addition to the methods of \ref
+  QCPDataMapIterator, it can replace (\ref setValue) and remove (\ref remove) the data point that
+  was jumped over last:
+  
+  \code
+  QCPDataMutableMapIterator it(*graph->data());
+  while (it.hasNext())
+  {
+    QCPData data = it.next().value();
+    if (qIsNaN(data.value))
+      it.remove();
+    else
+      it.setValue(QCPData(data.key, data.value*2));
+  }
+  \endcode
+  
+  Like with QMutableMapIterator, data points can also be modified via \ref value, which returns a
+  \ref QCPDataContainer::reference that writes its modifications back to the container.
+  
+  \see QCPDataContainer::replace
+*/
+
+/* start of documentation of inline functions */
+
+/*! \fn void QCPDataMutableMapIterator::setValue(const QCPData &data)
+  
+  Replaces the data point that was jumped over by the last call to \ref next or \ref previous with
+  \a data. The key stays the same, see \ref QCPDataContainer::replace.
+*/
+
+/*! \fn QCPDataContainer::reference QCPDataMutableMapIterator::value()
+  
+  Returns the data point that was jumped over by the last call to \ref next or \ref previous. The
+  returned \ref QCPDataContainer::reference writes its modifications back to the container.
+*/
+
+/* end of documentation of inline functions */
+
+/*!
+  Removes the data point that was jumped over by the last call to \ref next or \ref previous from
+  the container.
+*/
+void QCPDataMutableMapIterator::remove()
+{
+  if (mLast < 0)
+    return;
+  mMutableContainer->erase(QCPDataContainer::const_iterator(mMutableContainer, mLast));
+  if (mLast < mIndex)
+    --mIndex;
+  mLast = -1;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataFile
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDataFile
+  \brief A memory-mapped binary file holding graph data
+  
+  QCPDataFile maps a binary data file into memory, so a QCPGraph can display it as an external view
+  (\ref QCPGraph::setExternalData) without reading the file into memory. This allows plotting
+  recordings that are larger than the available memory: The operating system only pages in the
+  parts of the file that are actually accessed. Since the keys are sorted, finding the visible data
+  range is a binary search that touches only a few pages, and drawing (including adaptive sampling)
+  only reads the visible data points. Opening a file only reads and checks its header, so it takes
+  constant time regardless of the file size.
+  
+  Usage:
+  \code
+  QCPDataFile *file = new QCPDataFile("recording.qcpdata");
+  if (file->isOpen())
+    graph->setExternalData(*file);
+  \endcode
+  The QCPDataFile instance must outlive the graph's view onto its data, see \ref
+  QCPDataContainer::setExternal for the details of that contract.
+  
+  Note that functions which iterate over all data points, such as \ref
+  QCPAbstractPlottable::rescaleAxes, read the complete file.
+  
+  \section qcpdatafile-layout File layout
+  
+  The file starts with a header of \ref headerSize (24) bytes, followed by the key array and then
+  the value array:
+  
+  <table>
+  <tr><th>Offset</th><th>Type</th><th>Content</th></tr>
+  <tr><td>0</td><td>8 characters</td><td>Magic "QCPGRAPH"</td></tr>
+  <tr><td>8</td><td>quint32</td><td>Format version, currently 1</td></tr>
+  <tr><td>12</td><td>quint32</td><td>Byte order mark 0x01020304</td></tr>
+  <tr><td>16</td><td>qint64</td><td>Number of data points \a n</td></tr>
+  <tr><td>24</td><td>\a n doubles</td><td>Keys, sorted ascending</td></tr>
+  <tr><td>24+8\a n</td><td>\a n doubles</td><td>Values</td></tr>
+  </table>
+  
+  All numbers are stored in the native byte order of the machine that wrote the file. Files written
+  on a machine with different byte order are rejected, since the byte order mark doesn't match.
+  
+  QCPDataFile handles files with any number of data points that can be mapped into the address
+  space (so on 32 bit systems, files must be smaller than about 2 GB). Since QCPGraph indexes its
+  data points with int, \ref QCPGraph::setExternalData only accepts files with at most INT_MAX
+  (2147483647) data points.
+  
+  Files can be written with \ref write, or with \ref writeHeader followed by the raw arrays, which
+  allows writing files that don't fit into memory. The \c csv-to-qcpdata tool in the \c tools
+  directory converts CSV files to this format.
+*/
+
+/* start of documentation of inline functions */
+
+/*! \fn bool QCPDataFile::isOpen() const
+  
+  Returns whether a data file is open and mapped.
+*/
+
+/*! \fn qint64 QCPDataFile::size() const
+  
+  Returns the number of data points in the open data file, or 0 if no file is open.
+*/
+
+/*! \fn const double *QCPDataFile::keys() const
+  
+  Returns a pointer to the mapped key array of the open data file, or 0 if no file is open. The
+  pointer is valid until the file is closed.
+*/
+
+/*! \fn const double *QCPDataFile::values() const
+  
+  Returns a pointer to the mapped value array of the open data file, or 0 if no file is open. The
+  pointer is valid until the file is closed.
+*/
+
+/* end of documentation of inline functions */
+
+/*!
+  Size of the data file header in bytes. The key array starts at this offset, see the \ref
+  qcpdatafile-layout "file layout".
+*/
+const int QCPDataFile::headerSize = 24;
+
+/*!
+  Creates a QCPDataFile instance without an open file.
+  
+  \see open
+*/
+QCPDataFile::QCPDataFile() :
+  mMap(0),
+  mSize(0),
+  mKeys(0),
+  mValues(0)
+{
+}
+
+/*!
+  Creates a QCPDataFile instance and opens the file \a fileName. Use \ref isOpen to check whether
+  opening the file succeeded.
+*/
+QCPDataFile::QCPDataFile(const QString &fileName) :
+  mMap(0),
+  mSize(0),
+  mKeys(0),
+  mValues(0)
+{
+  open(fileName);
+}
+
+QCPDataFile::~QCPDataFile()
+{
+  close();
+}
+
+/*!
+  Opens and maps the data file \a fileName. If another file was open, it is closed first. Returns
+  true on success. If the file can't be opened or mapped, or if its header is invalid (see the
+  \ref qcpdatafile-layout "file layout"), a debug message is printed and false is returned.
+  
+  This function only reads the header, so it takes constant time regardless of the file size. The
+  order of the keys isn't checked.
+*/
+bool QCPDataFile::open(const QString &fileName)
+{
+  close();
+  mFile.setFileName(fileName);
+  if (!mFile.open(QIODevice::ReadOnly))
+  {
+    qDebug() << Q_FUNC_INFO << "Couldn't open file" << fileName << mFile.errorString();
+    return false;
+  }
+  
+  const qint64 fileSize = mFile.size();
+  if (fileSize < headerSize)
+  {
+    qDebug() << Q_FUNC_INFO << "File too small for header:" << fileName;
+    mFile.close();
+    return false;
+  }
+  uchar *map = mFile.map(0, fileSize);
+  if (!map)
+  {
+    qDebug() << Q_FUNC_INFO << "Couldn't map file" << fileName << mFile.errorString();
+    mFile.close();
+    return false;
+  }
+  
+  quint32 version, byteOrderMark;
+  qint64 count;
+  memcpy(&version, map+8, sizeof(version));
+  memcpy(&byteOrderMark, map+12, sizeof(byteOrderMark));
+  memcpy(&count, map+16, sizeof(count));
+  const char *error = 0;
+  if (memcmp(map, "QCPGRAPH", 8) != 0)
+    error = "invalid magic";
+  else if (version != 1)
+    error = "unsupported version";
+  else if (byteOrderMark != 0x01020304)
+    error = "byte order mismatch";
+  else if (count < 0 || count > (fileSize-headerSize)/qint64(2*sizeof(double)) || fileSize != headerSize+count*qint64(2*sizeof(double))) // first check prevents overflow in second
+    error = "file size doesn't match number of data points";
+  if (error)
+  {
+    qDebug() << Q_FUNC_INFO << "Invalid data file" << fileName << error;
+    mFile.unmap(map);
+    mFile.close();
+    return false;
+  }
+  
+  mMap = map;
+  mSize = count;
+  mKeys = reinterpret_cast<const double*>(mMap+headerSize);
+  mValues = mKeys+mSize;
+  return true;
+}
+
+/*!
+  Unmaps and closes the data file. Graphs that still show the data of this file via \ref
+  QCPGraph::setExternalData must be given other data before calling this function.
+*/
+void QCPDataFile::close()
+{
+  if (mMap)
+    mFile.unmap(mMap);
+  if (mFile.isOpen())
+    mFile.close();
+  mMap = 0;
+  mSize = 0;
+  mKeys = 0;
+  mValues = 0;
+}
+
+/*!
+  Writes the header of a data file with \a count data points to \a device. Afterwards, the caller
+  must write \a count keys (sorted ascending) and then \a count values as raw doubles in native
+  byte order, see the \ref qcpdatafile-layout "file layout".
+  
+  Returns true on success.
+  
+  \see write
+*/
+bool QCPDataFile::writeHeader(QIODevice *device, qint64 count)
+{
+  const quint32 version = 1;
+  const quint32 byteOrderMark = 0x01020304;
+  return device->write("QCPGRAPH", 8) == 8 &&
+         device->write(reinterpret_cast<const char*>(&version), sizeof(version)) == sizeof(version) &&
+         device->write(reinterpret_cast<const char*>(&byteOrderMark), sizeof(byteOrderMark)) == sizeof(byteOrderMark) &&
+         device->write(reinterpret_cast<const char*>(&count), sizeof(count)) == sizeof(count);
+}
+
+/*!
+  Writes a data file \a fileName with the data points given by \a keys and \a values. If the
+  vectors have different sizes, the number of data points is the size of the smaller one. The keys
+  must be sorted ascending.
+  
+  Returns true on success, otherwise prints a debug message and returns false.
+  
+  \see writeHeader
+*/
+bool QCPDataFile::write(const QString &fileName, const QVector<double> &keys, const QVector<double> &values)
+{
+  const int n = qMin(keys.size(), values.size());
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    qDebug() << Q_FUNC_INFO << "Couldn't open file" << fileName << file.errorString();
+    return false;
+  }
+  const qint64 bytes = n*qint64(sizeof(double));
+  if (!writeHeader(&file, n) ||
+      file.write(reinterpret_cast<const char*>(keys.constData()), bytes) != bytes ||
+      file.write(reinterpret_cast<const char*>(values.constData()), bytes) != bytes)
+  {
+    qDebug() << Q_FUNC_INFO << "Couldn't write file" << fileName << file.errorString();
+    return false;
+  }
+  return true;
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPGraph
@@ -123,9 +1821,11 @@ QCPData::QCPData(double key, double value) :
 
 /*! \fn QCPDataMap *QCPGraph::data() const
   
-  Returns a pointer to the internal data storage of type \ref QCPDataMap. You may use it to
-  directly manipulate the data, which may be more convenient and faster than using the regular \ref
-  setData or \ref addData methods, in certain situations.
+  Returns a pointer to the internal data storage of type \ref QCPDataMap (a \ref QCPDataContainer
+  holding the data points sorted by key). You may use it to directly access or manipulate the data,
+  which may be more convenient and faster than using the regular \ref setData or \ref addData
+  methods, in certain situations.
+
 */
 
 /* end of documentation of inline functions */
@@ -142,7 +1842,8 @@ QCPData::QCPData(double key, double value) :
   To directly create a graph inside a plot, you can also use the simpler QCustomPlot::addGraph function.
 */
 QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
-  QCPAbstractPlottable(keyAxis, valueAxis)
+  QCPAbstractPlottable(keyAxis, valueAxis),
+  mHitTestValid(false)
 {
   mData = new QCPDataMap;
   
@@ -158,6 +1859,10 @@ QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   setErrorBarSkipSymbol(true);
   setChannelFillGraph(0);
   setAdaptiveSampling(true);
+  setSamplingAlgorithm(saMinMax);
+  setScatterMode(smShapes);
+  setDensityGradient(QCPColorGradient(QCPColorGradient::gpCold));
+  setDensityScaleType(QCPAxis::stLinear);
 }
 
 QCPGraph::~QCPGraph()
@@ -172,6 +1877,11 @@ QCPGraph::~QCPGraph()
   takes ownership of the passed data and replaces the internal data pointer with it. This is
   significantly faster than copying for large datasets.
   
+  In both cases, the storage settings of the graph (\ref setStreamingCapacity, \ref
+  setSinglePrecisionValues and \ref setMinMaxPyramid) are kept. If \a data is adopted, it is
+  configured accordingly, i.e. its values may be converted to single precision, and if it holds
+  more data points than the streaming capacity, the ones with the lowest keys are removed.
+  
   Alternatively, you can also access and modify the graph's data via the \ref data method, which
   returns a pointer to the internal \ref QCPDataMap.
 */
@@ -184,12 +1894,18 @@ void QCPGraph::setData(QCPDataMap *data, bool copy)
   }
   if (copy)
   {
-    *mData = *data;
+    mData->set(data->toVector(), true); // keeps the storage settings of this graph
   } else
   {
+    // carry the storage settings of this graph over to the adopted container:
+    data->setSinglePrecisionValues(mData->singlePrecisionValues());
+    data->setMinMaxPyramid(mData->minMaxPyramid());
+    data->setFixedCapacity(mData->fixedCapacity());
     delete mData;
     mData = data;
+    mHitTestValid = false; // the revision of the new container isn't comparable
   }
+  invalidateRangeCache();
 }
 
 /*! \overload
@@ -200,16 +1916,55 @@ void QCPGraph::setData(QCPDataMap *data, bool copy)
 */
 void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 {
-  mData->clear();
-  int n = key.size();
-  n = qMin(n, value.size());
-  QCPData newData;
-  for (int i=0; i<n; ++i)
+  mData->set(key, value);
+}
+
+/*!
+  Makes the graph display the \a size data points given by the user-owned arrays \a keys and \a
+  values, without copying them. This is useful if the data is produced by a library that owns the
+  buffers, since copying the data would double the peak memory consumption. The keys must be
+  sorted ascending.
+  
+  The arrays must stay valid as long as the graph references them, i.e. until the graph data is
+  replaced (e.g. with another call to \ref setData or \ref setExternalData), or the graph is
+  deleted. If the content or the number of valid entries of the arrays changes, call \ref
+  externalDataChanged before the next replot. If the arrays are reallocated, call \ref
+  setExternalData again with the new addresses.
+  
+  Functions that modify the data, like \ref addData or \ref removeDataBefore, first copy the data
+  into the graph's own storage. The external arrays are no longer referenced afterwards. The same
+  applies to \ref setStreamingCapacity.
+  
+  \see QCPDataContainer::setExternal
+*/
+void QCPGraph::setExternalData(const double *keys, const double *values, int size)
+{
+  mData->setExternal(keys, values, size);
+}
+
+/*! \overload
+  
+  Makes the graph display the data of the memory-mapped data file \a file, without reading it into
+  memory. \a file must be open and must stay open as long as the graph displays its data.
+  
+  Since the graph indexes its data points with int, files with more than INT_MAX data points are
+  rejected with a debug message.
+  
+  \see QCPDataFile
+*/
+void QCPGraph::setExternalData(const QCPDataFile &file)
+{
+  if (!file.isOpen())
+  {
+    qDebug() << Q_FUNC_INFO << "data file not open:" << file.fileName();
+    return;
+  }
+  if (file.size() > std::numeric_limits<int>::max())
   {
-    newData.key = key[i];
-    newData.value = value[i];
-    mData->insertMulti(newData.key, newData);
+    qDebug() << Q_FUNC_INFO << "data file has too many data points:" << file.fileName() << file.size();
+    return;
   }
+  mData->setExternal(file.keys(), file.values(), int(file.size()));
 }
 
 /*!
@@ -223,19 +1978,18 @@ void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 */
 void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueError)
 {
-  mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, valueError.size());
-  QCPData newData;
+  QVector<QCPData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.key = key[i];
-    newData.value = value[i];
-    newData.valueErrorMinus = valueError[i];
-    newData.valueErrorPlus = valueError[i];
-    mData->insertMulti(key[i], newData);
+    newData[i].key = key[i];
+    newData[i].value = value[i];
+    newData[i].valueErrorMinus = valueError[i];
+    newData[i].valueErrorPlus = valueError[i];
   }
+  mData->set(newData);
 }
 
 /*!
@@ -249,20 +2003,19 @@ void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<doubl
 */
 void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueErrorMinus, const QVector<double> &valueErrorPlus)
 {
-  mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, valueErrorMinus.size());
   n = qMin(n, valueErrorPlus.size());
-  QCPData newData;
+  QVector<QCPData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.key = key[i];
-    newData.value = value[i];
-    newData.valueErrorMinus = valueErrorMinus[i];
-    newData.valueErrorPlus = valueErrorPlus[i];
-    mData->insertMulti(key[i], newData);
+    newData[i].key = key[i];
+    newData[i].value = value[i];
+    newData[i].valueErrorMinus = valueErrorMinus[i];
+    newData[i].valueErrorPlus = valueErrorPlus[i];
   }
+  mData->set(newData);
 }
 
 /*!
@@ -276,19 +2029,18 @@ void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<doubl
 */
 void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError)
 {
-  mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, keyError.size());
-  QCPData newData;
+  QVector<QCPData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.key = key[i];
-    newData.value = value[i];
-    newData.keyErrorMinus = keyError[i];
-    newData.keyErrorPlus = keyError[i];
-    mData->insertMulti(key[i], newData);
+    newData[i].key = key[i];
+    newData[i].value = value[i];
+    newData[i].keyErrorMinus = keyError[i];
+    newData[i].keyErrorPlus = keyError[i];
   }
+  mData->set(newData);
 }
 
 /*!
@@ -302,20 +2054,19 @@ void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double>
 */
 void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus)
 {
-  mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, keyErrorMinus.size());
   n = qMin(n, keyErrorPlus.size());
-  QCPData newData;
+  QVector<QCPData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.key = key[i];
-    newData.value = value[i];
-    newData.keyErrorMinus = keyErrorMinus[i];
-    newData.keyErrorPlus = keyErrorPlus[i];
-    mData->insertMulti(key[i], newData);
+    newData[i].key = key[i];
+    newData[i].value = value[i];
+    newData[i].keyErrorMinus = keyErrorMinus[i];
+    newData[i].keyErrorPlus = keyErrorPlus[i];
   }
+  mData->set(newData);
 }
 
 /*!
@@ -329,22 +2080,21 @@ void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double>
 */
 void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError, const QVector<double> &valueError)
 {
-  mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, valueError.size());
   n = qMin(n, keyError.size());
-  QCPData newData;
+  QVector<QCPData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.key = key[i];
-    newData.value = value[i];
-    newData.keyErrorMinus = keyError[i];
-    newData.keyErrorPlus = keyError[i];
-    newData.valueErrorMinus = valueError[i];
-    newData.valueErrorPlus = valueError[i];
-    mData->insertMulti(key[i], newData);
+    newData[i].key = key[i];
+    newData[i].value = value[i];
+    newData[i].keyErrorMinus = keyError[i];
+    newData[i].keyErrorPlus = keyError[i];
+    newData[i].valueErrorMinus = valueError[i];
+    newData[i].valueErrorPlus = valueError[i];
   }
+  mData->set(newData);
 }
 
 /*!
@@ -358,24 +2108,23 @@ void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double
 */
 void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus, const QVector<double> &valueErrorMinus, const QVector<double> &valueErrorPlus)
 {
-  mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, valueErrorMinus.size());
   n = qMin(n, valueErrorPlus.size());
   n = qMin(n, keyErrorMinus.size());
   n = qMin(n, keyErrorPlus.size());
-  QCPData newData;
+  QVector<QCPData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.key = key[i];
-    newData.value = value[i];
-    newData.keyErrorMinus = keyErrorMinus[i];
-    newData.keyErrorPlus = keyErrorPlus[i];
-    newData.valueErrorMinus = valueErrorMinus[i];
-    newData.valueErrorPlus = valueErrorPlus[i];
-    mData->insertMulti(key[i], newData);
+    newData[i].key = key[i];
+    newData[i].value = value[i];
+    newData[i].keyErrorMinus = keyErrorMinus[i];
+    newData[i].keyErrorPlus = keyErrorPlus[i];
+    newData[i].valueErrorMinus = valueErrorMinus[i];
+    newData[i].valueErrorPlus = valueErrorPlus[i];
   }
+  mData->set(newData);
 }
 
 
@@ -388,6 +2137,7 @@ void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double
 void QCPGraph::setLineStyle(LineStyle ls)
 {
   mLineStyle = ls;
+  mHitTestValid = false;
 }
 
 /*!
@@ -399,6 +2149,7 @@ void QCPGraph::setLineStyle(LineStyle ls)
 void QCPGraph::setScatterStyle(const QCPScatterStyle &style)
 {
   mScatterStyle = style;
+  mHitTestValid = false;
 }
 
 /*!
@@ -505,11 +2256,156 @@ void QCPGraph::setChannelFillGraph(QCPGraph *targetGraph)
   For some situations with scatter plots it might thus be desirable to manually turn adaptive
   sampling off. For example, when saving the plot to disk. This can be achieved by setting \a
   enabled to false before issuing a command like \ref QCustomPlot::savePng, and setting \a enabled
-  back to true afterwards.
+  back to true afterwards. Alternatively, a different sampling algorithm may suit the scatter plot
+  better, see \ref setSamplingAlgorithm.
 */
 void QCPGraph::setAdaptiveSampling(bool enabled)
 {
   mAdaptiveSampling = enabled;
+  mHitTestValid = false;
+}
+
+/*!
+  Sets the algorithm that reduces the data points, if adaptive sampling is enabled (\ref
+  setAdaptiveSampling) and there are at least two visible data points per pixel on average.
+  
+  \li \ref saMinMax is the default. For the line, it keeps the value span of each pixel column with
+  a few synthetic points. With the min/max pyramid (\ref setMinMaxPyramid), its cost is
+  proportional to the number of pixels. For scatters, it keeps the outer data points of each pixel
+  column and thins out the inner ones, which causes the banding described at \ref
+  setAdaptiveSampling.
+  \li \ref saM4 keeps the first, the minimum, the maximum and the last data point of each pixel
+  column, i.e. at most four real data points per pixel. The line looks practically the same as
+  without sampling, and since only real data points are kept, the same points are used as
+  scatters. Its cost is proportional to the number of visible data points.
+  \li \ref saLttb (Largest-Triangle-Three-Buckets) keeps about two data points per pixel, chosen
+  such that the visual shape of the data is preserved. It is well suited for scatter plots and for
+  lines that don't need to show every outlier. Its cost is proportional to the number of visible
+  data points.
+  
+  Which algorithm reproduces a certain graph best can be measured with \ref samplingPixelError.
+  
+  \see setAdaptiveSampling
+*/
+void QCPGraph::setSamplingAlgorithm(SamplingAlgorithm algorithm)
+{
+  mSamplingAlgorithm = algorithm;
+  mHitTestValid = false;
+}
+
+/*!
+  Sets the graph to streaming mode with a fixed capacity of \a capacity data points. This is
+  intended for strip chart displays, where new data points are continuously appended while old
+  ones scroll out of the visible range and should be discarded.
+  
+  In streaming mode, the data points are held in a circular buffer that is allocated once. When the
+  buffer is full, each added data point evicts the data point with the lowest key. Appending data
+  points with ascending keys (e.g. via \ref addData) and evicting old ones are then constant time
+  operations without any memory allocation, and \ref removeDataBefore doesn't move the remaining
+  data points. The drawing code works directly on the circular buffer, so no data is copied during
+  replots either.
+  
+  If the graph currently holds more than \a capacity data points, the ones with the lowest keys are
+  removed. Setting \a capacity to 0 disables streaming mode, so the data storage grows as needed
+  again. This is the default.
+  
+  \see QCPDataContainer::setFixedCapacity
+*/
+void QCPGraph::setStreamingCapacity(int capacity)
+{
+  mData->setFixedCapacity(capacity);
+}
+
+/*!
+  Sets whether the values of the data points are stored with single precision (float) instead of
+  double precision. The keys are always stored with double precision, so time axes with large key
+  offsets stay accurate.
+  
+  For data with limited precision in the value dimension (e.g. from sensors), this reduces the
+  memory consumption of the graph data considerably. The drawing code, including adaptive sampling
+  in \ref getPreparedData, reads the single precision values directly, no converted copy of the
+  data is created.
+  
+  \see QCPDataContainer::setSinglePrecisionValues
+*/
+void QCPGraph::setSinglePrecisionValues(bool enabled)
+{
+  mData->setSinglePrecisionValues(enabled);
+}
+
+/*!
+  Sets whether the graph data maintains a min/max pyramid of the values, i.e. the smallest and
+  largest value of blocks of data points at multiple resolutions.
+  
+  With adaptive sampling (\ref setAdaptiveSampling), the line of a graph with many data points per
+  pixel is reduced to a few points per pixel that preserve the value span and thus all outliers.
+  With the pyramid enabled, the value span of each pixel is looked up in logarithmic time instead
+  of scanning all data points in it, so replotting a zoomed out view of a large data set takes time
+  proportional to the number of pixels, not the number of visible data points. The sampled line is
+  exactly the same as without the pyramid.
+  
+  The pyramid is built lazily on the next replot after the data was set, and kept up to date when
+  data points are appended (\ref addData) or removed at the ends (e.g. \ref removeDataBefore). It
+  costs roughly one eighth of the memory of the values. The scatter points are sampled without the
+  pyramid, because they are chosen individually from each pixel interval.
+  
+  The pyramid also allows \ref rescaleValueAxisInKeyRange to determine the value range of the
+  visible data points in logarithmic time, and speeds up \ref nearestDataPoint for dense data,
+  which is linear in the number of data points without the pyramid in the worst case.
+  
+  \see QCPDataContainer::setMinMaxPyramid
+*/
+void QCPGraph::setMinMaxPyramid(bool enabled)
+{
+  mData->setMinMaxPyramid(enabled);
+}
+
+/*!
+  Sets how the data points of the graph are represented, in addition to the line (\ref
+  setLineStyle).
+  
+  With \ref smShapes, the scatter style (\ref setScatterStyle) is drawn at the data points, if it
+  isn't \ref QCPScatterStyle::ssNone.
+  
+  With \ref smDensity, the scatter style is ignored. Instead, all visible data points are counted
+  per pixel of the axis rect, and the counts are shown as an image, colorized with the density
+  gradient (\ref setDensityGradient). Pixels without data points stay transparent. The gradient
+  spans from zero (or one, if \ref setDensityScaleType is logarithmic) to the largest count of a
+  pixel. Use this mode for graphs with hundreds of thousands of visible scatter points: Drawing
+  them individually would only cover the plot uniformly, while the density shows where the points
+  accumulate. Since every visible point is counted (adaptive sampling doesn't apply), the time
+  this takes is proportional to the number of visible data points, but it is very small per point.
+  With many points, the counting is distributed among the threads of the global QThreadPool.
+  
+  \see setDensityGradient, setDensityScaleType
+*/
+void QCPGraph::setScatterMode(ScatterMode mode)
+{
+  mScatterMode = mode;
+}
+
+/*!
+  Sets the color gradient that is used to colorize the point counts per pixel, if the scatter mode
+  is \ref smDensity.
+  
+  \see setScatterMode, setDensityScaleType
+*/
+void QCPGraph::setDensityGradient(const QCPColorGradient &gradient)
+{
+  mDensityGradient = gradient;
+}
+
+/*!
+  Sets whether the point counts per pixel are mapped linearly (\ref QCPAxis::stLinear) or
+  logarithmically (\ref QCPAxis::stLogarithmic) to the density gradient, if the scatter mode is
+  \ref smDensity. A logarithmic mapping reveals the structure of sparse regions next to very dense
+  ones.
+  
+  \see setScatterMode, setDensityGradient
+*/
+void QCPGraph::setDensityScaleType(QCPAxis::ScaleType type)
+{
+  mDensityScaleType = type;
 }
 
 /*!
@@ -522,7 +2418,19 @@ void QCPGraph::setAdaptiveSampling(bool enabled)
 */
 void QCPGraph::addData(const QCPDataMap &dataMap)
 {
-  mData->unite(dataMap);
+  syncRangeCache(mData->revision());
+  const int evicted = removeEvictedFromRangeCache(dataMap.size());
+  const int oldSize = mData->size();
+  mData->add(dataMap);
+  if (evicted > oldSize || (evicted > 0 && !dataMap.isEmpty() && dataMap.firstKey() <= mData->firstKey())) // added data points may have been evicted
+  {
+    invalidateRangeCache();
+  } else
+  {
+    for (int i=0; i<dataMap.size(); ++i)
+      addToRangeCache(dataMap.at(i));
+  }
+  mRangeCacheRevision = mData->revision();
 }
 
 /*! \overload
@@ -535,7 +2443,14 @@ void QCPGraph::addData(const QCPDataMap &dataMap)
 */
 void QCPGraph::addData(const QCPData &data)
 {
-  mData->insertMulti(data.key, data);
+  syncRangeCache(mData->revision());
+  const int evicted = removeEvictedFromRangeCache(1);
+  mData->add(data);
+  if (evicted > 0 && data.key <= mData->firstKey()) // added data point may have been evicted
+    invalidateRangeCache();
+  else
+    addToRangeCache(data);
+  mRangeCacheRevision = mData->revision();
 }
 
 /*! \overload
@@ -548,10 +2463,7 @@ void QCPGraph::addData(const QCPData &data)
 */
 void QCPGraph::addData(double key, double value)
 {
-  QCPData newData;
-  newData.key = key;
-  newData.value = value;
-  mData->insertMulti(newData.key, newData);
+  addData(QCPData(key, value));
 }
 
 /*! \overload
@@ -565,13 +2477,28 @@ void QCPGraph::addData(double key, double value)
 void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &values)
 {
   int n = qMin(keys.size(), values.size());
-  QCPData newData;
+  QVector<QCPData> newData(n);
   for (int i=0; i<n; ++i)
   {
-    newData.key = keys[i];
-    newData.value = values[i];
-    mData->insertMulti(newData.key, newData);
+    newData[i].key = keys[i];
+    newData[i].value = values[i];
+  }
+  syncRangeCache(mData->revision());
+  const int evicted = removeEvictedFromRangeCache(n);
+  const int oldSize = mData->size();
+  mData->add(newData);
+  bool newDataEvicted = evicted > oldSize;
+  for (int i=0; i<n && evicted > 0 && !newDataEvicted; ++i)
+    newDataEvicted = newData.at(i).key <= mData->firstKey();
+  if (newDataEvicted)
+  {
+    invalidateRangeCache();
+  } else
+  {
+    for (int i=0; i<n; ++i)
+      addToRangeCache(newData.at(i));
   }
+  mRangeCacheRevision = mData->revision();
 }
 
 /*!
@@ -580,9 +2507,7 @@ void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &value
 */
 void QCPGraph::removeDataBefore(double key)
 {
-  QCPDataMap::iterator it = mData->begin();
-  while (it != mData->end() && it.key() < key)
-    it = mData->erase(it);
+  mData->removeBefore(key);
 }
 
 /*!
@@ -591,10 +2516,7 @@ void QCPGraph::removeDataBefore(double key)
 */
 void QCPGraph::removeDataAfter(double key)
 {
-  if (mData->isEmpty()) return;
-  QCPDataMap::iterator it = mData->upperBound(key);
-  while (it != mData->end())
-    it = mData->erase(it);
+  mData->removeAfter(key);
 }
 
 /*!
@@ -606,11 +2528,7 @@ void QCPGraph::removeDataAfter(double key)
 */
 void QCPGraph::removeData(double fromKey, double toKey)
 {
-  if (fromKey >= toKey || mData->isEmpty()) return;
-  QCPDataMap::iterator it = mData->upperBound(fromKey);
-  QCPDataMap::iterator itEnd = mData->upperBound(toKey);
-  while (it != itEnd)
-    it = mData->erase(it);
+  mData->remove(fromKey, toKey);
 }
 
 /*! \overload
@@ -626,6 +2544,80 @@ void QCPGraph::removeData(double key)
   mData->remove(key);
 }
 
+/*!
+  Notifies the graph that the content of the external arrays passed to \ref setExternalData has
+  changed. If \a size is non-negative, the number of data points is set to \a size, e.g. when the
+  producer appended to the arrays.
+  
+  If the graph doesn't display external data, this function does nothing.
+*/
+void QCPGraph::externalDataChanged(int size)
+{
+  mData->externalDataChanged(size);
+}
+
+/*!
+  Measures how much adaptive sampling with \a algorithm changes the appearance of this graph at the
+  current axis ranges.
+  
+  The line and scatter points of the graph are drawn twice into images of the size of its axis
+  rect, once without adaptive sampling and once with adaptive sampling and \a algorithm (see \ref
+  setSamplingAlgorithm). The fill, error bars and density plots aren't drawn. The returned pixel
+  error is the number of pixels that differ between the two images, divided by the number of
+  pixels painted in either of them. So 0 means that sampling is invisible, and 1 means that the
+  images have nothing in common. The graph itself is not modified.
+  
+  This can be used to choose the most suitable sampling algorithm for a graph. Note that if there
+  are less than two visible data points per pixel on average, no sampling takes place and the
+  pixel error is zero.
+*/
+double QCPGraph::samplingPixelError(SamplingAlgorithm algorithm) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return 0; }
+  const QRect rect = keyAxis->axisRect()->rect();
+  if (rect.isEmpty() || keyAxis->range().size() <= 0 || mData->isEmpty())
+    return 0;
+  
+  QImage images[2];
+  for (int i=0; i<2; ++i)
+  {
+    QVector<QPointF> lineData;
+    QVector<QCPData> scatterData;
+    const bool drawScatters = !mScatterStyle.isNone() && mScatterMode == smShapes;
+    getPlotData(&lineData, drawScatters ? &scatterData : 0, i == 1, algorithm);
+    images[i] = QImage(rect.size(), QImage::Format_ARGB32_Premultiplied);
+    images[i].fill(0);
+    QCPPainter painter(&images[i]);
+    painter.translate(-rect.topLeft());
+    painter.setClipRect(clipRect());
+    if (mLineStyle == lsImpulse)
+      drawImpulsePlot(&painter, &lineData);
+    else if (mLineStyle != lsNone)
+      drawLinePlot(&painter, &lineData);
+    if (drawScatters)
+      drawScatterPlot(&painter, &scatterData);
+  }
+  
+  int paintedCount = 0;
+  int differentCount = 0;
+  for (int y=0; y<rect.height(); ++y)
+  {
+    const QRgb *unsampled = reinterpret_cast<const QRgb*>(images[0].constScanLine(y));
+    const QRgb *sampled = reinterpret_cast<const QRgb*>(images[1].constScanLine(y));
+    for (int x=0; x<rect.width(); ++x)
+    {
+      if (unsampled[x] != 0 || sampled[x] != 0)
+      {
+        ++paintedCount;
+        if (unsampled[x] != sampled[x])
+          ++differentCount;
+      }
+    }
+  }
+  return paintedCount > 0 ? differentCount/(double)paintedCount : 0;
+}
+
 /*!
   Removes all data points.
   \see removeData, removeDataAfter, removeDataBefore
@@ -739,26 +2731,33 @@ void QCPGraph::draw(QCPPainter *painter)
 {
   if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
   if (mKeyAxis.data()->range().size() <= 0 || mData->isEmpty()) return;
-  if (mLineStyle == lsNone && mScatterStyle.isNone()) return;
+  if (mLineStyle == lsNone && mScatterStyle.isNone() && mScatterMode != smDensity) return;
   
   // allocate line and (if necessary) point vectors:
   QVector<QPointF> *lineData = new QVector<QPointF>;
   QVector<QCPData> *scatterData = 0;
-  if (!mScatterStyle.isNone())
+  if (!mScatterStyle.isNone() && mScatterMode == smShapes)
     scatterData = new QVector<QCPData>;
   
-  // fill vectors with data appropriate to plot style:
-  getPlotData(lineData, scatterData);
+  // fill vectors with data appropriate to plot style, or take them from prepareDraw:
+  if (mDrawPrepared)
+  {
+    *lineData = mPreparedLineData;
+    if (scatterData)
+      *scatterData = mPreparedScatterData;
+    clearPreparedDraw();
+  } else
+    getPlotData(lineData, scatterData);
   
   // check data validity if flag set:
 #ifdef QCUSTOMPLOT_CHECK_DATA
-  QCPDataMap::const_iterator it;
-  for (it = mData->constBegin(); it != mData->constEnd(); ++it)
+  for (int i=0; i<mData->size(); ++i)
   {
-    if (QCP::isInvalidData(it.value().key, it.value().value) ||
-        QCP::isInvalidData(it.value().keyErrorPlus, it.value().keyErrorMinus) ||
-        QCP::isInvalidData(it.value().valueErrorPlus, it.value().valueErrorPlus))
-      qDebug() << Q_FUNC_INFO << "Data point at" << it.key() << "invalid." << "Plottable name:" << name();
+    const QCPData data = mData->at(i);
+    if (QCP::isInvalidData(data.key, data.value) ||
+        QCP::isInvalidData(data.keyErrorPlus, data.keyErrorMinus) ||
+        QCP::isInvalidData(data.valueErrorPlus, data.valueErrorPlus))
+      qDebug() << Q_FUNC_INFO << "Data point at" << data.key << "invalid." << "Plottable name:" << name();
   }
 #endif
 
@@ -774,6 +2773,12 @@ void QCPGraph::draw(QCPPainter *painter)
   // draw scatters:
   if (scatterData)
     drawScatterPlot(painter, scatterData);
+  else if (mScatterMode == smDensity)
+    drawDensityPlot(painter);
+  
+  // keep line geometry for hit tests (scatter geometry is only calculated when needed, see pointDistance):
+  if (mLineStyle != lsNone)
+    setHitTestGeometry(lineData, 0);
   
   // free allocated line and point vectors:
   delete lineData;
@@ -781,6 +2786,92 @@ void QCPGraph::draw(QCPPainter *painter)
     delete scatterData;
 }
 
+/* inherits documentation from base class */
+void QCPGraph::prepareDraw()
+{
+  clearPreparedDraw();
+  if (!mKeyAxis || !mValueAxis) return;
+  if (mKeyAxis.data()->range().size() <= 0 || mData->isEmpty()) return;
+  if (mLineStyle == lsNone && mScatterStyle.isNone() && mScatterMode != smDensity) return;
+  
+  getPlotData(&mPreparedLineData, mScatterStyle.isNone() || mScatterMode != smShapes ? 0 : &mPreparedScatterData);
+  mDrawPrepared = true;
+}
+
+/* inherits documentation from base class */
+void QCPGraph::clearPreparedDraw()
+{
+  mPreparedLineData.clear();
+  mPreparedScatterData.clear();
+  QCPAbstractPlottable::clearPreparedDraw();
+}
+
+/*! \internal
+  
+  Returns the data point nearest to \a pixelPos among the data points with keys inside \a
+  keyWindow, see \ref QCPAbstractPlottable::nearestDataPoint.
+  
+  The search starts at the data point with the key at \a pixelPos, which is found with a binary
+  search, and examines the data points on both sides in order of their key distance. It stops once
+  the remaining data points are farther away in the key dimension than the nearest data point
+  found. Without the min/max pyramid (\ref setMinMaxPyramid), each examined data point costs
+  constant time. This is fast if the data points are spread out in the key dimension, but if many
+  data points share the pixel columns around \a pixelPos (e.g. a large data set viewed zoomed
+  out), the worst case is linear in the number of data points inside \a keyWindow. With the
+  pyramid, the examined chunks grow exponentially and chunks whose bounding box is farther away
+  than the nearest data point are skipped as a whole (see \ref findNearestInRange), so typically
+  only a logarithmic number of data points is examined.
+*/
+QCPDataPoint QCPGraph::findNearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return QCPDataPoint(); }
+  
+  const int begin = mData->findBegin(keyWindow.lower);
+  const int end = mData->findEnd(keyWindow.upper);
+  if (begin >= end)
+    return QCPDataPoint();
+  
+  // start at the data point with the key at pixelPos, and examine chunks of data points on both
+  // sides, always continuing on the side whose next key is closer. Once the next keys on both sides
+  // are farther away (in the key dimension alone) than the nearest data point found so far, no
+  // closer data point can follow:
+  const double posKeyPixel = keyAxis->orientation() == Qt::Horizontal ? pixelPos.x() : pixelPos.y();
+  const int start = mData->findBegin(keyAxis->pixelToCoord(posKeyPixel), begin, end);
+  int lower = start; // data points before lower remain to be examined
+  int upper = start; // data points from upper on remain to be examined
+  int chunkSize = 32;
+  int nearest = -1;
+  double minDistSqr = std::numeric_limits<double>::max();
+  while (lower > begin || upper < end)
+  {
+    const double lowerDist = lower > begin ? qAbs(keyAxis->coordToPixel(mData->keyAt(lower-1))-posKeyPixel) : std::numeric_limits<double>::max();
+    const double upperDist = upper < end ? qAbs(keyAxis->coordToPixel(mData->keyAt(upper))-posKeyPixel) : std::numeric_limits<double>::max();
+    const double keyDist = qMin(lowerDist, upperDist);
+    if (keyDist*keyDist > minDistSqr)
+      break;
+    if (upperDist <= lowerDist)
+    {
+      const int chunkEnd = qMin(end, upper+chunkSize);
+      findNearestInRange(upper, chunkEnd, pixelPos, nearest, minDistSqr);
+      upper = chunkEnd;
+    } else
+    {
+      const int chunkBegin = qMax(begin, lower-chunkSize);
+      findNearestInRange(chunkBegin, lower, pixelPos, nearest, minDistSqr);
+      lower = chunkBegin;
+    }
+    // with the min/max pyramid, large chunks are cheap to skip if they are far away in the value dimension:
+    if (mData->minMaxPyramid() && chunkSize < 1<<20)
+      chunkSize *= 2;
+  }
+  
+  if (nearest < 0) // only NaN values in the key window
+    return QCPDataPoint();
+  return QCPDataPoint(nearest, mData->keyAt(nearest), mData->valueAt(nearest), qSqrt(minDistSqr));
+}
+
 /* inherits documentation from base class */
 void QCPGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 {
@@ -835,15 +2926,28 @@ void QCPGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
   getStepCenterPlotData, getImpulsePlotData
 */
 void QCPGraph::getPlotData(QVector<QPointF> *lineData, QVector<QCPData> *scatterData) const
+{
+  getPlotData(lineData, scatterData, mAdaptiveSampling, mSamplingAlgorithm);
+}
+
+/*! \internal
+  
+  \overload
+  
+  Uses \a adaptiveSampling and \a samplingAlgorithm instead of the sampling settings of the graph
+  (\ref setAdaptiveSampling, \ref setSamplingAlgorithm). This allows \ref samplingPixelError to
+  compare different settings without changing the graph.
+*/
+void QCPGraph::getPlotData(QVector<QPointF> *lineData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const
 {
   switch(mLineStyle)
   {
-    case lsNone: getScatterPlotData(scatterData); break;
-    case lsLine: getLinePlotData(lineData, scatterData); break;
-    case lsStepLeft: getStepLeftPlotData(lineData, scatterData); break;
-    case lsStepRight: getStepRightPlotData(lineData, scatterData); break;
-    case lsStepCenter: getStepCenterPlotData(lineData, scatterData); break;
-    case lsImpulse: getImpulsePlotData(lineData, scatterData); break;
+    case lsNone: getScatterPlotData(scatterData, adaptiveSampling, samplingAlgorithm); break;
+    case lsLine: getLinePlotData(lineData, scatterData, adaptiveSampling, samplingAlgorithm); break;
+    case lsStepLeft: getStepLeftPlotData(lineData, scatterData, adaptiveSampling, samplingAlgorithm); break;
+    case lsStepRight: getStepRightPlotData(lineData, scatterData, adaptiveSampling, samplingAlgorithm); break;
+    case lsStepCenter: getStepCenterPlotData(lineData, scatterData, adaptiveSampling, samplingAlgorithm); break;
+    case lsImpulse: getImpulsePlotData(lineData, scatterData, adaptiveSampling, samplingAlgorithm); break;
   }
 }
 
@@ -858,9 +2962,241 @@ void QCPGraph::getPlotData(QVector<QPointF> *lineData, QVector<QCPData> *scatter
   
   \see drawScatterPlot
 */
-void QCPGraph::getScatterPlotData(QVector<QCPData> *scatterData) const
+void QCPGraph::getScatterPlotData(QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const
+{
+  getPreparedData(0, scatterData, adaptiveSampling, samplingAlgorithm);
+}
+
+/*! \internal
+  
+  Reduces the data points with indices from \a lower to \a upper (inclusive) with the M4
+  algorithm, and places the result in \a sampledData (see \ref saM4).
+  
+  The data points are grouped by the pixel column of their key. Of each column, the first, the
+  minimum, the maximum and the last data point are kept in their original order, so the line
+  connecting them covers the same pixels as the line connecting all points. Data points with NaN
+  values are kept as well and close the current column, so gaps in the line are preserved.
+  
+  \see getLttbSampledData
+*/
+void QCPGraph::getM4SampledData(QVector<QCPData> *sampledData, int lower, int upper) const
+{
+  const QRect axisRect = mKeyAxis.data()->axisRect()->rect();
+  const int columnCount = mKeyAxis.data()->orientation() == Qt::Horizontal ? axisRect.width() : axisRect.height();
+  sampledData->reserve(qMin(upper-lower+1, 4*columnCount+8)+2); // +2 for possible fill end points
+  int first = -1, last = -1, minIndex = -1, maxIndex = -1;
+  double minValue = 0, maxValue = 0;
+  int column = 0;
+  QVector<double> keyPixels, valuePixels;
+  const int batchSize = 1024;
+  for (int batchBegin=lower; batchBegin<=upper; batchBegin+=batchSize)
+  {
+    const int batchEnd = qMin(batchBegin+batchSize, upper+1);
+    dataToPixels(batchBegin, batchEnd, &keyPixels, &valuePixels);
+    for (int i=0; i<batchEnd-batchBegin; ++i)
+    {
+      const int index = batchBegin+i;
+      const double value = mData->valueAt(index);
+      const int pixelColumn = qFloor(qBound(-1.0e9, keyPixels.at(i), 1.0e9)); // bounded, because outer data points may lie far outside
+      if (qIsNaN(value))
+      {
+        if (first >= 0)
+          appendM4Column(sampledData, first, minIndex, maxIndex, last);
+        first = -1;
+        sampledData->append(mData->at(index));
+      } else if (first < 0 || pixelColumn != column)
+      {
+        if (first >= 0)
+          appendM4Column(sampledData, first, minIndex, maxIndex, last);
+        first = last = minIndex = maxIndex = index;
+        minValue = maxValue = value;
+        column = pixelColumn;
+      } else
+      {
+        last = index;
+        if (value < minValue)
+        {
+          minValue = value;
+          minIndex = index;
+        } else if (value > maxValue)
+        {
+          maxValue = value;
+          maxIndex = index;
+        }
+      }
+    }
+  }
+  if (first >= 0)
+    appendM4Column(sampledData, first, minIndex, maxIndex, last);
+}
+
+/*! \internal
+  
+  Appends the data points with the indices \a first, \a minIndex, \a maxIndex and \a last of one
+  pixel column to \a sampledData, in the order of their indices and without duplicates.
+  
+  \see getM4SampledData
+*/
+void QCPGraph::appendM4Column(QVector<QCPData> *sampledData, int first, int minIndex, int maxIndex, int last) const
+{
+  // first and last are the outer indices, only minimum and maximum may need to be swapped:
+  int middle1 = minIndex, middle2 = maxIndex;
+  if (middle1 > middle2)
+    qSwap(middle1, middle2);
+  sampledData->append(mData->at(first));
+  if (middle1 != first)
+    sampledData->append(mData->at(middle1));
+  if (middle2 != middle1 && middle2 != first)
+    sampledData->append(mData->at(middle2));
+  if (last != middle2 && last != first)
+    sampledData->append(mData->at(last));
+}
+
+/*! \internal
+  
+  Reduces the data points with indices from \a lower to \a upper (inclusive) to about \a
+  bucketCount points with the Largest-Triangle-Three-Buckets algorithm, and places the result in
+  \a sampledData (see \ref saLttb).
+  
+  The first and the last data point are always kept. The data points in between are split into
+  \a bucketCount-2 buckets with the same number of points. Going from the first to the last bucket,
+  the point of each bucket is kept that forms the largest triangle with the previously kept point
+  and the average of the next bucket. The triangle areas are calculated in pixel coordinates, so
+  the result corresponds to the visual shape also for logarithmic axes. Each bucket is transformed
+  to pixel coordinates only once. Data points with NaN values are skipped, but the first one in a
+  bucket is kept, so gaps in the line are preserved.
+  
+  \see getM4SampledData
+*/
+void QCPGraph::getLttbSampledData(QVector<QCPData> *sampledData, int lower, int upper, int bucketCount) const
+{
+  const int dataCount = upper-lower+1;
+  const int innerBucketCount = bucketCount-2;
+  if (innerBucketCount < 1 || dataCount <= bucketCount)
+  {
+    sampledData->reserve(dataCount+2); // +2 for possible fill end points
+    for (int i=lower; i<=upper; ++i)
+      sampledData->append(mData->at(i));
+    return;
+  }
+  
+  sampledData->reserve(2*bucketCount+2); // buckets with a gap may contribute two points
+  sampledData->append(mData->at(lower));
+  QVector<double> keyPixels, valuePixels, nextKeyPixels, nextValuePixels;
+  dataToPixels(lower, lower+1, &keyPixels, &valuePixels);
+  double previousKey = keyPixels.first();
+  double previousValue = valuePixels.first();
+  int bucketBegin = lower+1;
+  int bucketEnd = lower+1+int(qint64(dataCount-2)/innerBucketCount);
+  dataToPixels(bucketBegin, bucketEnd, &keyPixels, &valuePixels);
+  for (int bucket=0; bucket<innerBucketCount; ++bucket)
+  {
+    // average of next bucket, the last bucket is followed by the last data point:
+    const int nextBucketEnd = bucket+1 < innerBucketCount ? lower+1+int(qint64(dataCount-2)*(bucket+2)/innerBucketCount) : upper+1;
+    dataToPixels(bucketEnd, nextBucketEnd, &nextKeyPixels, &nextValuePixels);
+    double averageKey = 0, averageValue = 0;
+    int averageCount = 0;
+    for (int i=0; i<nextKeyPixels.size(); ++i)
+    {
+      if (!qIsNaN(nextValuePixels.at(i)))
+      {
+        averageKey += nextKeyPixels.at(i);
+        averageValue += nextValuePixels.at(i);
+        ++averageCount;
+      }
+    }
+    if (averageCount > 0)
+    {
+      averageKey /= averageCount;
+      averageValue /= averageCount;
+    } else // next bucket only consists of gaps, so the previous point is the best reference
+    {
+      averageKey = previousKey;
+      averageValue = previousValue;
+    }
+    
+    // find point with largest triangle area in current bucket:
+    int bestIndex = -1;
+    double bestArea = 0;
+    int gapIndex = -1;
+    for (int i=0; i<keyPixels.size(); ++i)
+    {
+      if (qIsNaN(valuePixels.at(i)))
+      {
+        if (gapIndex < 0)
+          gapIndex = bucketBegin+i;
+        continue;
+      }
+      double area = qAbs((previousKey-averageKey)*(valuePixels.at(i)-previousValue)-(previousKey-keyPixels.at(i))*(averageValue-previousValue));
+      if (qIsNaN(area)) // previous point is a gap
+        area = 0;
+      if (bestIndex < 0 || area > bestArea)
+      {
+        bestIndex = i;
+        bestArea = area;
+      }
+    }
+    if (gapIndex >= 0 && (bestIndex < 0 || gapIndex < bucketBegin+bestIndex))
+      sampledData->append(mData->at(gapIndex));
+    if (bestIndex >= 0)
+    {
+      sampledData->append(mData->at(bucketBegin+bestIndex));
+      previousKey = keyPixels.at(bestIndex);
+      previousValue = valuePixels.at(bestIndex);
+    }
+    if (gapIndex >= 0 && bestIndex >= 0 && gapIndex > bucketBegin+bestIndex)
+      sampledData->append(mData->at(gapIndex));
+    
+    keyPixels.swap(nextKeyPixels);
+    valuePixels.swap(nextValuePixels);
+    bucketBegin = bucketEnd;
+    bucketEnd = nextBucketEnd;
+  }
+  sampledData->append(mData->at(upper));
+}
+
+/*! \internal
+  
+  Transforms the keys and values of the data points in \a data to pixel coordinates and stores them
+  in \a keyPixels and \a valuePixels, respectively. The coordinates are transformed in batches (see
+  \ref QCPAxis::coordToPixel(const double *values, double *pixels, int count) const), which is
+  considerably faster than transforming each point individually.
+*/
+void QCPGraph::dataToPixels(const QVector<QCPData> &data, QVector<double> *keyPixels, QVector<double> *valuePixels) const
+{
+  const int n = data.size();
+  keyPixels->resize(n);
+  valuePixels->resize(n);
+  double *keys = keyPixels->data();
+  double *values = valuePixels->data();
+  for (int i=0; i<n; ++i)
+  {
+    keys[i] = data.at(i).key;
+    values[i] = data.at(i).value;
+  }
+  mKeyAxis.data()->coordToPixel(keys, keys, n);
+  mValueAxis.data()->coordToPixel(values, values, n);
+}
+
+/*! \internal \overload
+  
+  Transforms the keys and values of the data points with indices from \a begin to \a end
+  (exclusive) in the data container of this graph to pixel coordinates.
+*/
+void QCPGraph::dataToPixels(int begin, int end, QVector<double> *keyPixels, QVector<double> *valuePixels) const
 {
-  getPreparedData(0, scatterData);
+  const int n = end-begin;
+  keyPixels->resize(n);
+  valuePixels->resize(n);
+  double *keys = keyPixels->data();
+  double *values = valuePixels->data();
+  for (int i=0; i<n; ++i)
+  {
+    keys[i] = mData->keyAt(begin+i);
+    values[i] = mData->valueAt(begin+i);
+  }
+  mKeyAxis.data()->coordToPixel(keys, keys, n);
+  mValueAxis.data()->coordToPixel(values, values, n);
 }
 
 /*! \internal
@@ -874,7 +3210,7 @@ void QCPGraph::getScatterPlotData(QVector<QCPData> *scatterData) const
   
   \see drawLinePlot
 */
-void QCPGraph::getLinePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const
+void QCPGraph::getLinePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const
 {
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
@@ -882,25 +3218,24 @@ void QCPGraph::getLinePlotData(QVector<QPointF> *linePixelData, QVector<QCPData>
   if (!linePixelData) { qDebug() << Q_FUNC_INFO << "null pointer passed as linePixelData"; return; }
   
   QVector<QCPData> lineData;
-  getPreparedData(&lineData, scatterData);
+  getPreparedData(&lineData, scatterData, adaptiveSampling, samplingAlgorithm);
   linePixelData->reserve(lineData.size()+2); // added 2 to reserve memory for lower/upper fill base points that might be needed for fill
   linePixelData->resize(lineData.size());
   
   // transform lineData points to pixels:
+  QVector<double> keyPixels, valuePixels;
+  dataToPixels(lineData, &keyPixels, &valuePixels);
+  const double *keys = keyPixels.constData();
+  const double *values = valuePixels.constData();
+  QPointF *points = linePixelData->data();
   if (keyAxis->orientation() == Qt::Vertical)
   {
     for (int i=0; i<lineData.size(); ++i)
-    {
-      (*linePixelData)[i].setX(valueAxis->coordToPixel(lineData.at(i).value));
-      (*linePixelData)[i].setY(keyAxis->coordToPixel(lineData.at(i).key));
-    }
+      points[i] = QPointF(values[i], keys[i]);
   } else // key axis is horizontal
   {
     for (int i=0; i<lineData.size(); ++i)
-    {
-      (*linePixelData)[i].setX(keyAxis->coordToPixel(lineData.at(i).key));
-      (*linePixelData)[i].setY(valueAxis->coordToPixel(lineData.at(i).value));
-    }
+      points[i] = QPointF(keys[i], values[i]);
   }
 }
 
@@ -915,7 +3250,7 @@ void QCPGraph::getLinePlotData(QVector<QPointF> *linePixelData, QVector<QCPData>
   
   \see drawLinePlot
 */
-void QCPGraph::getStepLeftPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const
+void QCPGraph::getStepLeftPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const
 {
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
@@ -923,36 +3258,33 @@ void QCPGraph::getStepLeftPlotData(QVector<QPointF> *linePixelData, QVector<QCPD
   if (!linePixelData) { qDebug() << Q_FUNC_INFO << "null pointer passed as lineData"; return; }
   
   QVector<QCPData> lineData;
-  getPreparedData(&lineData, scatterData);
+  getPreparedData(&lineData, scatterData, adaptiveSampling, samplingAlgorithm);
   linePixelData->reserve(lineData.size()*2+2); // added 2 to reserve memory for lower/upper fill base points that might be needed for fill
   linePixelData->resize(lineData.size()*2);
   
   // calculate steps from lineData and transform to pixel coordinates:
+  QVector<double> keyPixels, valuePixels;
+  dataToPixels(lineData, &keyPixels, &valuePixels);
+  const double *keys = keyPixels.constData();
+  const double *values = valuePixels.constData();
+  QPointF *points = linePixelData->data();
   if (keyAxis->orientation() == Qt::Vertical)
   {
-    double lastValue = valueAxis->coordToPixel(lineData.first().value);
-    double key;
+    double lastValue = valuePixels.first();
     for (int i=0; i<lineData.size(); ++i)
     {
-      key = keyAxis->coordToPixel(lineData.at(i).key);
-      (*linePixelData)[i*2+0].setX(lastValue);
-      (*linePixelData)[i*2+0].setY(key);
-      lastValue = valueAxis->coordToPixel(lineData.at(i).value);
-      (*linePixelData)[i*2+1].setX(lastValue);
-      (*linePixelData)[i*2+1].setY(key);
+      points[i*2+0] = QPointF(lastValue, keys[i]);
+      lastValue = values[i];
+      points[i*2+1] = QPointF(lastValue, keys[i]);
     }
   } else // key axis is horizontal
   {
-    double lastValue = valueAxis->coordToPixel(lineData.first().value);
-    double key;
+    double lastValue = valuePixels.first();
     for (int i=0; i<lineData.size(); ++i)
     {
-      key = keyAxis->coordToPixel(lineData.at(i).key);
-      (*linePixelData)[i*2+0].setX(key);
-      (*linePixelData)[i*2+0].setY(lastValue);
-      lastValue = valueAxis->coordToPixel(lineData.at(i).value);
-      (*linePixelData)[i*2+1].setX(key);
-      (*linePixelData)[i*2+1].setY(lastValue);
+      points[i*2+0] = QPointF(keys[i], lastValue);
+      lastValue = values[i];
+      points[i*2+1] = QPointF(keys[i], lastValue);
     }
   }
 }
@@ -968,7 +3300,7 @@ void QCPGraph::getStepLeftPlotData(QVector<QPointF> *linePixelData, QVector<QCPD
   
   \see drawLinePlot
 */
-void QCPGraph::getStepRightPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const
+void QCPGraph::getStepRightPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const
 {
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
@@ -976,36 +3308,33 @@ void QCPGraph::getStepRightPlotData(QVector<QPointF> *linePixelData, QVector<QCP
   if (!linePixelData) { qDebug() << Q_FUNC_INFO << "null pointer passed as lineData"; return; }
   
   QVector<QCPData> lineData;
-  getPreparedData(&lineData, scatterData);
+  getPreparedData(&lineData, scatterData, adaptiveSampling, samplingAlgorithm);
   linePixelData->reserve(lineData.size()*2+2); // added 2 to reserve memory for lower/upper fill base points that might be needed for fill
   linePixelData->resize(lineData.size()*2);
   
   // calculate steps from lineData and transform to pixel coordinates:
+  QVector<double> keyPixels, valuePixels;
+  dataToPixels(lineData, &keyPixels, &valuePixels);
+  const double *keys = keyPixels.constData();
+  const double *values = valuePixels.constData();
+  QPointF *points = linePixelData->data();
   if (keyAxis->orientation() == Qt::Vertical)
   {
-    double lastKey = keyAxis->coordToPixel(lineData.first().key);
-    double value;
+    double lastKey = keyPixels.first();
     for (int i=0; i<lineData.size(); ++i)
     {
-      value = valueAxis->coordToPixel(lineData.at(i).value);
-      (*linePixelData)[i*2+0].setX(value);
-      (*linePixelData)[i*2+0].setY(lastKey);
-      lastKey = keyAxis->coordToPixel(lineData.at(i).key);
-      (*linePixelData)[i*2+1].setX(value);
-      (*linePixelData)[i*2+1].setY(lastKey);
+      points[i*2+0] = QPointF(values[i], lastKey);
+      lastKey = keys[i];
+      points[i*2+1] = QPointF(values[i], lastKey);
     }
   } else // key axis is horizontal
   {
-    double lastKey = keyAxis->coordToPixel(lineData.first().key);
-    double value;
+    double lastKey = keyPixels.first();
     for (int i=0; i<lineData.size(); ++i)
     {
-      value = valueAxis->coordToPixel(lineData.at(i).value);
-      (*linePixelData)[i*2+0].setX(lastKey);
-      (*linePixelData)[i*2+0].setY(value);
-      lastKey = keyAxis->coordToPixel(lineData.at(i).key);
-      (*linePixelData)[i*2+1].setX(lastKey);
-      (*linePixelData)[i*2+1].setY(value);
+      points[i*2+0] = QPointF(lastKey, values[i]);
+      lastKey = keys[i];
+      points[i*2+1] = QPointF(lastKey, values[i]);
     }
   }
 }
@@ -1021,7 +3350,7 @@ void QCPGraph::getStepRightPlotData(QVector<QPointF> *linePixelData, QVector<QCP
   
   \see drawLinePlot
 */
-void QCPGraph::getStepCenterPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const
+void QCPGraph::getStepCenterPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const
 {
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
@@ -1029,50 +3358,46 @@ void QCPGraph::getStepCenterPlotData(QVector<QPointF> *linePixelData, QVector<QC
   if (!linePixelData) { qDebug() << Q_FUNC_INFO << "null pointer passed as lineData"; return; }
   
   QVector<QCPData> lineData;
-  getPreparedData(&lineData, scatterData);
+  getPreparedData(&lineData, scatterData, adaptiveSampling, samplingAlgorithm);
   linePixelData->reserve(lineData.size()*2+2); // added 2 to reserve memory for lower/upper fill base points that might be needed for fill
   linePixelData->resize(lineData.size()*2);
   // calculate steps from lineData and transform to pixel coordinates:
+  QVector<double> keyPixels, valuePixels;
+  dataToPixels(lineData, &keyPixels, &valuePixels);
+  const double *keys = keyPixels.constData();
+  const double *values = valuePixels.constData();
+  QPointF *points = linePixelData->data();
   if (keyAxis->orientation() == Qt::Vertical)
   {
-    double lastKey = keyAxis->coordToPixel(lineData.first().key);
-    double lastValue = valueAxis->coordToPixel(lineData.first().value);
+    double lastKey = keyPixels.first();
+    double lastValue = valuePixels.first();
     double key;
-    (*linePixelData)[0].setX(lastValue);
-    (*linePixelData)[0].setY(lastKey);
+    points[0] = QPointF(lastValue, lastKey);
     for (int i=1; i<lineData.size(); ++i)
     {
-      key = (keyAxis->coordToPixel(lineData.at(i).key)+lastKey)*0.5;
-      (*linePixelData)[i*2-1].setX(lastValue);
-      (*linePixelData)[i*2-1].setY(key);
-      lastValue = valueAxis->coordToPixel(lineData.at(i).value);
-      lastKey = keyAxis->coordToPixel(lineData.at(i).key);
-      (*linePixelData)[i*2+0].setX(lastValue);
-      (*linePixelData)[i*2+0].setY(key);
+      key = (keys[i]+lastKey)*0.5;
+      points[i*2-1] = QPointF(lastValue, key);
+      lastValue = values[i];
+      lastKey = keys[i];
+      points[i*2+0] = QPointF(lastValue, key);
     }
-    (*linePixelData)[lineData.size()*2-1].setX(lastValue);
-    (*linePixelData)[lineData.size()*2-1].setY(lastKey);
+    points[lineData.size()*2-1] = QPointF(lastValue, lastKey);
   } else // key axis is horizontal
   {
-    double lastKey = keyAxis->coordToPixel(lineData.first().key);
-    double lastValue = valueAxis->coordToPixel(lineData.first().value);
+    double lastKey = keyPixels.first();
+    double lastValue = valuePixels.first();
     double key;
-    (*linePixelData)[0].setX(lastKey);
-    (*linePixelData)[0].setY(lastValue);
+    points[0] = QPointF(lastKey, lastValue);
     for (int i=1; i<lineData.size(); ++i)
     {
-      key = (keyAxis->coordToPixel(lineData.at(i).key)+lastKey)*0.5;
-      (*linePixelData)[i*2-1].setX(key);
-      (*linePixelData)[i*2-1].setY(lastValue);
-      lastValue = valueAxis->coordToPixel(lineData.at(i).value);
-      lastKey = keyAxis->coordToPixel(lineData.at(i).key);
-      (*linePixelData)[i*2+0].setX(key);
-      (*linePixelData)[i*2+0].setY(lastValue);
+      key = (keys[i]+lastKey)*0.5;
+      points[i*2-1] = QPointF(key, lastValue);
+      lastValue = values[i];
+      lastKey = keys[i];
+      points[i*2+0] = QPointF(key, lastValue);
     }
-    (*linePixelData)[lineData.size()*2-1].setX(lastKey);
-    (*linePixelData)[lineData.size()*2-1].setY(lastValue);
+    points[lineData.size()*2-1] = QPointF(lastKey, lastValue);
   }
-
 }
 
 /*!
@@ -1086,7 +3411,7 @@ void QCPGraph::getStepCenterPlotData(QVector<QPointF> *linePixelData, QVector<QC
   
   \see drawImpulsePlot
 */
-void QCPGraph::getImpulsePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const
+void QCPGraph::getImpulsePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const
 {
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
@@ -1094,33 +3419,30 @@ void QCPGraph::getImpulsePlotData(QVector<QPointF> *linePixelData, QVector<QCPDa
   if (!linePixelData) { qDebug() << Q_FUNC_INFO << "null pointer passed as linePixelData"; return; }
   
   QVector<QCPData> lineData;
-  getPreparedData(&lineData, scatterData);
+  getPreparedData(&lineData, scatterData, adaptiveSampling, samplingAlgorithm);
   linePixelData->resize(lineData.size()*2); // no need to reserve 2 extra points because impulse plot has no fill
   
   // transform lineData points to pixels:
+  QVector<double> keyPixels, valuePixels;
+  dataToPixels(lineData, &keyPixels, &valuePixels);
+  const double *keys = keyPixels.constData();
+  const double *values = valuePixels.constData();
+  QPointF *points = linePixelData->data();
   if (keyAxis->orientation() == Qt::Vertical)
   {
     double zeroPointX = valueAxis->coordToPixel(0);
-    double key;
     for (int i=0; i<lineData.size(); ++i)
     {
-      key = keyAxis->coordToPixel(lineData.at(i).key);
-      (*linePixelData)[i*2+0].setX(zeroPointX);
-      (*linePixelData)[i*2+0].setY(key);
-      (*linePixelData)[i*2+1].setX(valueAxis->coordToPixel(lineData.at(i).value));
-      (*linePixelData)[i*2+1].setY(key);
+      points[i*2+0] = QPointF(zeroPointX, keys[i]);
+      points[i*2+1] = QPointF(values[i], keys[i]);
     }
   } else // key axis is horizontal
   {
     double zeroPointY = valueAxis->coordToPixel(0);
-    double key;
     for (int i=0; i<lineData.size(); ++i)
     {
-      key = keyAxis->coordToPixel(lineData.at(i).key);
-      (*linePixelData)[i*2+0].setX(key);
-      (*linePixelData)[i*2+0].setY(zeroPointY);
-      (*linePixelData)[i*2+1].setX(key);
-      (*linePixelData)[i*2+1].setY(valueAxis->coordToPixel(lineData.at(i).value));
+      points[i*2+0] = QPointF(keys[i], zeroPointY);
+      points[i*2+1] = QPointF(keys[i], values[i]);
     }
   }
 }
@@ -1176,6 +3498,11 @@ void QCPGraph::drawScatterPlot(QCPPainter *painter, QVector<QCPData> *scatterDat
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
   
+  QVector<double> keyPixels, valuePixels;
+  dataToPixels(*scatterData, &keyPixels, &valuePixels);
+  const double *keys = keyPixels.constData();
+  const double *values = valuePixels.constData();
+  
   // draw error bars:
   if (mErrorType != etNone)
   {
@@ -1184,28 +3511,31 @@ void QCPGraph::drawScatterPlot(QCPPainter *painter, QVector<QCPData> *scatterDat
     if (keyAxis->orientation() == Qt::Vertical)
     {
       for (int i=0; i<scatterData->size(); ++i)
-        drawError(painter, valueAxis->coordToPixel(scatterData->at(i).value), keyAxis->coordToPixel(scatterData->at(i).key), scatterData->at(i));
+        drawError(painter, values[i], keys[i], scatterData->at(i));
     } else
     {
       for (int i=0; i<scatterData->size(); ++i)
-        drawError(painter, keyAxis->coordToPixel(scatterData->at(i).key), valueAxis->coordToPixel(scatterData->at(i).value), scatterData->at(i));
+        drawError(painter, keys[i], values[i], scatterData->at(i));
     }
   }
   
   // draw scatter point symbols:
   applyScattersAntialiasingHint(painter);
   mScatterStyle.applyTo(painter, mPen);
+  QVector<QPointF> positions;
+  positions.reserve(scatterData->size());
   if (keyAxis->orientation() == Qt::Vertical)
   {
     for (int i=0; i<scatterData->size(); ++i)
       if (!qIsNaN(scatterData->at(i).value))
-        mScatterStyle.drawShape(painter, valueAxis->coordToPixel(scatterData->at(i).value), keyAxis->coordToPixel(scatterData->at(i).key));
+        positions.append(QPointF(values[i], keys[i]));
   } else
   {
     for (int i=0; i<scatterData->size(); ++i)
       if (!qIsNaN(scatterData->at(i).value))
-        mScatterStyle.drawShape(painter, keyAxis->coordToPixel(scatterData->at(i).key), valueAxis->coordToPixel(scatterData->at(i).value));
+        positions.append(QPointF(keys[i], values[i]));
   }
+  mScatterStyle.drawShapes(painter, positions, mParentPlot->plottingHints().testFlag(QCP::phCacheScatters));
 }
 
 /*!  \internal
@@ -1241,8 +3571,11 @@ void QCPGraph::drawLinePlot(QCPPainter *painter, QVector<QPointF> *lineData) con
     }
     */
     
-    // if drawing solid line and not in PDF, use much faster line drawing instead of polyline:
-    if (mParentPlot->plottingHints().testFlag(QCP::phFastPolylines) &&
+    // if drawing aliased 1px lines into a raster image, rasterize them directly; else if drawing solid line and not in PDF, use much faster line drawing instead of polyline:
+    if (painter->canRasterizePolylineDirectly(lineData->size()))
+    {
+      painter->drawPolylineWithGaps(lineData->constData(), lineData->size());
+    } else if (mParentPlot->plottingHints().testFlag(QCP::phFastPolylines) &&
         painter->pen().style() == Qt::SolidLine &&
         !painter->modes().testFlag(QCPPainter::pmVectorized) &&
         !painter->modes().testFlag(QCPPainter::pmNoCaching))
@@ -1257,31 +3590,16 @@ void QCPGraph::drawLinePlot(QCPPainter *painter, QVector<QPointF> *lineData) con
       {
         if (!qIsNaN(lineData->at(i).y()) && !qIsNaN(lineData->at(i).x())) // NaNs create a gap in the line
         {
-          if (!lastIsNan)
-            painter->drawLine(lineData->at(i-1), lineData->at(i));
-          else
-            lastIsNan = false;
-        } else
-          lastIsNan = true;
-        ++i;
-      }
-    } else
-    {
-      int segmentStart = 0;
-      int i = 0;
-      const int lineDataSize = lineData->size();
-      while (i < lineDataSize)
-      {
-        if (qIsNaN(lineData->at(i).y()) || qIsNaN(lineData->at(i).x())) // NaNs create a gap in the line
-        {
-          painter->drawPolyline(lineData->constData()+segmentStart, i-segmentStart); // i, because we don't want to include the current NaN point
-          segmentStart = i+1;
-        }
+          if (!lastIsNan)
+            painter->drawLine(lineData->at(i-1), lineData->at(i));
+          else
+            lastIsNan = false;
+        } else
+          lastIsNan = true;
         ++i;
       }
-      // draw last segment:
-      painter->drawPolyline(lineData->constData()+segmentStart, lineDataSize-segmentStart);
-    }
+    } else
+      painter->drawPolylineWithGaps(lineData->constData(), lineData->size());
   }
 }
 
@@ -1306,11 +3624,73 @@ void QCPGraph::drawImpulsePlot(QCPPainter *painter, QVector<QPointF> *lineData)
   }
 }
 
+/*! \internal
+  
+  Draws the visible data points as a density image, if the scatter mode is \ref smDensity. The data
+  points are counted per pixel of the axis rect by \ref QCPDensityBinner, and the counts are
+  colorized with the density gradient. Pixels without data points are left transparent.
+  
+  \see setScatterMode
+*/
+void QCPGraph::drawDensityPlot(QCPPainter *painter)
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
+  
+  const QRect rect = keyAxis->axisRect()->rect();
+  if (rect.isEmpty())
+    return;
+  int lower, upper;
+  getVisibleDataBounds(lower, upper);
+  if (lower > upper)
+    return;
+  
+  const QVector<quint32> counts = QCPDensityBinner::binData(mData, keyAxis, valueAxis, lower, upper+1, rect);
+  quint32 maxCount = 0;
+  for (int i=0; i<counts.size(); ++i)
+  {
+    if (counts.at(i) > maxCount)
+      maxCount = counts.at(i);
+  }
+  if (maxCount == 0)
+    return;
+  
+  // a logarithmic range can't start at zero. Starting it at 0.5 keeps a single point distinguishable from empty pixels, like the linear range from zero does:
+  const bool logarithmic = mDensityScaleType == QCPAxis::stLogarithmic;
+  const QCPRange countRange(logarithmic ? 0.5 : 0, maxCount);
+  QImage image(rect.size(), QImage::Format_ARGB32_Premultiplied);
+  QVector<double> lineCounts(rect.width());
+  for (int y=0; y<rect.height(); ++y)
+  {
+    const quint32 *countLine = counts.constData()+y*rect.width();
+    for (int x=0; x<rect.width(); ++x)
+      lineCounts[x] = countLine[x];
+    QRgb *pixels = reinterpret_cast<QRgb*>(image.scanLine(y));
+    mDensityGradient.colorize(lineCounts.constData(), countRange, pixels, rect.width(), 1, logarithmic);
+    for (int x=0; x<rect.width(); ++x)
+    {
+      if (countLine[x] == 0)
+        pixels[x] = 0;
+    }
+  }
+  painter->setAntialiasing(false); // the image pixels map exactly to the counted pixels
+  painter->drawImage(rect.topLeft(), image);
+}
+
 /*! \internal
   
   Returns the \a lineData and \a scatterData that need to be plotted for this graph taking into
-  consideration the current axis ranges and, if \ref setAdaptiveSampling is enabled, local point
-  densities.
+  consideration the current axis ranges and, if \a adaptiveSampling is true, local point densities.
+  The sampling algorithm is given by \a samplingAlgorithm. Usually these parameters are the
+  settings of the graph (\ref setAdaptiveSampling, \ref setSamplingAlgorithm).
+  
+  For the line data, adaptive sampling with \ref saMinMax determines the data points of each pixel
+  interval with an exponential search and their value span with \ref QCPDataContainer::valueMinMax.
+  If the min/max pyramid is enabled (\ref setMinMaxPyramid), the cost is thus proportional to the
+  number of pixels rather than the number of visible data points. The other sampling algorithms
+  (see \ref setSamplingAlgorithm) are implemented in \ref getM4SampledData and \ref
+  getLttbSampledData.
   
   0 may be passed as \a lineData or \a scatterData to indicate that the respective dataset isn't
   needed. For example, if the scatter style (\ref setScatterStyle) is \ref QCPScatterStyle::ssNone, \a
@@ -1318,116 +3698,125 @@ void QCPGraph::drawImpulsePlot(QCPPainter *painter, QVector<QPointF> *lineData)
   
   This method is used by the various "get(...)PlotData" methods to get the basic working set of data.
 */
-void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *scatterData) const
+void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const
 {
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
   // get visible data range:
-  QCPDataMap::const_iterator lower, upper; // note that upper is the actual upper point, and not 1 step after the upper point
+  int lower, upper; // note that upper is the index of the actual upper point, and not 1 step after the upper point
   getVisibleDataBounds(lower, upper);
-  if (lower == mData->constEnd() || upper == mData->constEnd())
+  if (lower > upper)
     return;
   
-  // count points in visible range, taking into account that we only need to count to the limit maxCount if using adaptive sampling:
+  // determine whether the number of points in visible range is large enough for adaptive sampling:
   int maxCount = std::numeric_limits<int>::max();
-  if (mAdaptiveSampling)
+  if (adaptiveSampling)
   {
-    int keyPixelSpan = qAbs(keyAxis->coordToPixel(lower.key())-keyAxis->coordToPixel(upper.key()));
+    int keyPixelSpan = qAbs(keyAxis->coordToPixel(mData->keyAt(lower))-keyAxis->coordToPixel(mData->keyAt(upper)));
     maxCount = 2*keyPixelSpan+2;
   }
-  int dataCount = countDataInBounds(lower, upper, maxCount);
+  int dataCount = upper-lower+1;
   
-  if (mAdaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
+  if (adaptiveSampling && dataCount >= maxCount && samplingAlgorithm != saMinMax) // M4 and LTTB select real data points, which serve as line and scatter points alike
+  {
+    QVector<QCPData> *dataVector = lineData ? lineData : scatterData;
+    if (dataVector)
+    {
+      if (samplingAlgorithm == saM4)
+        getM4SampledData(dataVector, lower, upper);
+      else
+        getLttbSampledData(dataVector, lower, upper, maxCount);
+    }
+    if (lineData && scatterData)
+      *scatterData = *lineData;
+  } else if (adaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
   {
     if (lineData)
     {
-      QCPDataMap::const_iterator it = lower;
-      QCPDataMap::const_iterator upperEnd = upper+1;
-      double minValue = it.value().value;
-      double maxValue = it.value().value;
-      QCPDataMap::const_iterator currentIntervalFirstPoint = it;
       int reversedFactor = keyAxis->rangeReversed() != (keyAxis->orientation()==Qt::Vertical) ? -1 : 1; // is used to calculate keyEpsilon pixel into the correct direction
       int reversedRound = keyAxis->rangeReversed() != (keyAxis->orientation()==Qt::Vertical) ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
-      double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(lower.key())+reversedRound));
+      double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(mData->keyAt(lower))+reversedRound));
       double lastIntervalEndKey = currentIntervalStartKey;
       double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
       bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
-      int intervalDataCount = 1;
-      ++it; // advance iterator to second data point because adaptive sampling works in 1 point retrospect
-      while (it != upperEnd)
+      int currentIntervalFirstPoint = lower;
+      while (true)
       {
-        if (it.key() < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this cluster if necessary
+        // find first data point of next pixel interval by exponential search, so the cost depends only logarithmically on the points per pixel:
+        const double nextIntervalStartKey = currentIntervalStartKey+keyEpsilon;
+        int searchLower = currentIntervalFirstPoint+1;
+        int searchUpper = searchLower;
+        int step = 1;
+        while (searchUpper <= upper && mData->keyAt(searchUpper) < nextIntervalStartKey)
         {
-          if (it.value().value < minValue)
-            minValue = it.value().value;
-          else if (it.value().value > maxValue)
-            maxValue = it.value().value;
-          ++intervalDataCount;
-        } else // new pixel interval started
+          searchLower = searchUpper+1;
+          searchUpper += step;
+          step *= 2;
+        }
+        const int nextIntervalFirstPoint = mData->findBegin(nextIntervalStartKey, searchLower, qMin(searchUpper, upper+1));
+        const double firstValue = mData->valueAt(currentIntervalFirstPoint);
+        if (nextIntervalFirstPoint-currentIntervalFirstPoint >= 2) // pixel has multiple data points, consolidate them to a cluster
         {
-          if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
+          // value span of cluster, with min/max pyramid (QCPDataContainer::setMinMaxPyramid) this has logarithmic complexity:
+          double minValue = firstValue;
+          double maxValue = firstValue;
+          if (!qIsNaN(firstValue))
           {
-            if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
-              lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint.value().value));
-            lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
-            lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
-            if (it.key() > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
-              lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.8, (it-1).value().value));
-          } else
-            lineData->append(QCPData(currentIntervalFirstPoint.key(), currentIntervalFirstPoint.value().value));
-          lastIntervalEndKey = (it-1).value().key;
-          minValue = it.value().value;
-          maxValue = it.value().value;
-          currentIntervalFirstPoint = it;
-          currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(it.key())+reversedRound));
-          if (keyEpsilonVariable)
-            keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
-          intervalDataCount = 1;
-        }
-        ++it;
+            double restMin, restMax;
+            mData->valueMinMax(currentIntervalFirstPoint+1, nextIntervalFirstPoint, restMin, restMax);
+            minValue = qMin(minValue, restMin);
+            maxValue = qMax(maxValue, restMax);
+          }
+          if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
+            lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.2, firstValue));
+          lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
+          lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
+          if (nextIntervalFirstPoint <= upper && mData->keyAt(nextIntervalFirstPoint) > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
+            lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.8, mData->valueAt(nextIntervalFirstPoint-1)));
+        } else
+          lineData->append(QCPData(mData->keyAt(currentIntervalFirstPoint), firstValue));
+        if (nextIntervalFirstPoint > upper) // this was the last interval
+          break;
+        lastIntervalEndKey = mData->keyAt(nextIntervalFirstPoint-1);
+        currentIntervalFirstPoint = nextIntervalFirstPoint;
+        currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(mData->keyAt(currentIntervalFirstPoint))+reversedRound));
+        if (keyEpsilonVariable)
+          keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
       }
-      // handle last interval:
-      if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them to a cluster
-      {
-        if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point wasn't a cluster, so first point of this cluster must be at a real data point
-          lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.2, currentIntervalFirstPoint.value().value));
-        lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
-        lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
-      } else
-        lineData->append(QCPData(currentIntervalFirstPoint.key(), currentIntervalFirstPoint.value().value));
     }
     
     if (scatterData)
     {
       double valueMaxRange = valueAxis->range().upper;
       double valueMinRange = valueAxis->range().lower;
-      QCPDataMap::const_iterator it = lower;
-      QCPDataMap::const_iterator upperEnd = upper+1;
-      double minValue = it.value().value;
-      double maxValue = it.value().value;
-      QCPDataMap::const_iterator minValueIt = it;
-      QCPDataMap::const_iterator maxValueIt = it;
-      QCPDataMap::const_iterator currentIntervalStart = it;
+      int i = lower;
+      double minValue = mData->valueAt(i);
+      double maxValue = mData->valueAt(i);
+      int minValueIndex = i;
+      int maxValueIndex = i;
+      int currentIntervalStart = i;
       int reversedFactor = keyAxis->rangeReversed() ? -1 : 1; // is used to calculate keyEpsilon pixel into the correct direction
       int reversedRound = keyAxis->rangeReversed() ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
-      double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(lower.key())+reversedRound));
+      double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(mData->keyAt(lower))+reversedRound));
       double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
       bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
       int intervalDataCount = 1;
-      ++it; // advance iterator to second data point because adaptive sampling works in 1 point retrospect
-      while (it != upperEnd)
+      ++i; // advance index to second data point because adaptive sampling works in 1 point retrospect
+      while (i <= upper)
       {
-        if (it.key() < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this pixel if necessary
+        const double key = mData->keyAt(i);
+        const double value = mData->valueAt(i);
+        if (key < currentIntervalStartKey+keyEpsilon) // data point is still within same pixel, so skip it and expand value span of this pixel if necessary
         {
-          if (it.value().value < minValue && it.value().value > valueMinRange && it.value().value < valueMaxRange)
+          if (value < minValue && value > valueMinRange && value < valueMaxRange)
           {
-            minValue = it.value().value;
-            minValueIt = it;
-          } else if (it.value().value > maxValue && it.value().value > valueMinRange && it.value().value < valueMaxRange)
+            minValue = value;
+            minValueIndex = i;
+          } else if (value > maxValue && value > valueMinRange && value < valueMaxRange)
           {
-            maxValue = it.value().value;
-            maxValueIt = it;
+            maxValue = value;
+            maxValueIndex = i;
           }
           ++intervalDataCount;
         } else // new pixel started
@@ -1437,26 +3826,25 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
             // determine value pixel span and add as many points in interval to maintain certain vertical data density (this is specific to scatter plot):
             double valuePixelSpan = qAbs(valueAxis->coordToPixel(minValue)-valueAxis->coordToPixel(maxValue));
             int dataModulo = qMax(1, qRound(intervalDataCount/(valuePixelSpan/4.0))); // approximately every 4 value pixels one data point on average
-            QCPDataMap::const_iterator intervalIt = currentIntervalStart;
             int c = 0;
-            while (intervalIt != it)
+            for (int intervalIndex=currentIntervalStart; intervalIndex<i; ++intervalIndex)
             {
-              if ((c % dataModulo == 0 || intervalIt == minValueIt || intervalIt == maxValueIt) && intervalIt.value().value > valueMinRange && intervalIt.value().value < valueMaxRange)
-                scatterData->append(intervalIt.value());
+              const double intervalValue = mData->valueAt(intervalIndex);
+              if ((c % dataModulo == 0 || intervalIndex == minValueIndex || intervalIndex == maxValueIndex) && intervalValue > valueMinRange && intervalValue < valueMaxRange)
+                scatterData->append(mData->at(intervalIndex));
               ++c;
-              ++intervalIt;
             }
-          } else if (currentIntervalStart.value().value > valueMinRange && currentIntervalStart.value().value < valueMaxRange)
-            scatterData->append(currentIntervalStart.value());
-          minValue = it.value().value;
-          maxValue = it.value().value;
-          currentIntervalStart = it;
-          currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(it.key())+reversedRound));
+          } else if (mData->valueAt(currentIntervalStart) > valueMinRange && mData->valueAt(currentIntervalStart) < valueMaxRange)
+            scatterData->append(mData->at(currentIntervalStart));
+          minValue = value;
+          maxValue = value;
+          currentIntervalStart = i;
+          currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(key)+reversedRound));
           if (keyEpsilonVariable)
             keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
           intervalDataCount = 1;
         }
-        ++it;
+        ++i;
       }
       // handle last interval:
       if (intervalDataCount >= 2) // last pixel had multiple data points, consolidate them
@@ -1464,19 +3852,18 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
         // determine value pixel span and add as many points in interval to maintain certain vertical data density (this is specific to scatter plot):
         double valuePixelSpan = qAbs(valueAxis->coordToPixel(minValue)-valueAxis->coordToPixel(maxValue));
         int dataModulo = qMax(1, qRound(intervalDataCount/(valuePixelSpan/4.0))); // approximately every 4 value pixels one data point on average
-        QCPDataMap::const_iterator intervalIt = currentIntervalStart;
         int c = 0;
-        while (intervalIt != it)
+        for (int intervalIndex=currentIntervalStart; intervalIndex<i; ++intervalIndex)
         {
-          if ((c % dataModulo == 0 || intervalIt == minValueIt || intervalIt == maxValueIt) && intervalIt.value().value > valueMinRange && intervalIt.value().value < valueMaxRange)
-            scatterData->append(intervalIt.value());
+          const double intervalValue = mData->valueAt(intervalIndex);
+          if ((c % dataModulo == 0 || intervalIndex == minValueIndex || intervalIndex == maxValueIndex) && intervalValue > valueMinRange && intervalValue < valueMaxRange)
+            scatterData->append(mData->at(intervalIndex));
           ++c;
-          ++intervalIt;
         }
-      } else if (currentIntervalStart.value().value > valueMinRange && currentIntervalStart.value().value < valueMaxRange)
-        scatterData->append(currentIntervalStart.value());
+      } else if (mData->valueAt(currentIntervalStart) > valueMinRange && mData->valueAt(currentIntervalStart) < valueMaxRange)
+        scatterData->append(mData->at(currentIntervalStart));
     }
-  } else // don't use adaptive sampling algorithm, transfer points one-to-one from the map into the output parameters
+  } else // don't use adaptive sampling algorithm, transfer points one-to-one from the data container into the output parameters
   {
     QVector<QCPData> *dataVector = 0;
     if (lineData)
@@ -1485,14 +3872,10 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
       dataVector = scatterData;
     if (dataVector)
     {
-      QCPDataMap::const_iterator it = lower;
-      QCPDataMap::const_iterator upperEnd = upper+1;
       dataVector->reserve(dataCount+2); // +2 for possible fill end points
-      while (it != upperEnd)
-      {
-        dataVector->append(it.value());
-        ++it;
-      }
+      dataVector->resize(dataCount);
+      for (int i=0; i<dataCount; ++i)
+        (*dataVector)[i] = mData->at(lower+i);
     }
     if (lineData && scatterData)
       *scatterData = *dataVector;
@@ -1608,59 +3991,36 @@ void QCPGraph::drawError(QCPPainter *painter, double x, double y, const QCPData
   called by \ref getPreparedData to determine which data (key) range is visible at the current key
   axis range setting, so only that needs to be processed.
   
-  \a lower returns an iterator to the lowest data point that needs to be taken into account when
+  \a lower returns the index of the lowest data point that needs to be taken into account when
   plotting. Note that in order to get a clean plot all the way to the edge of the axis rect, \a
   lower may still be just outside the visible range.
   
-  \a upper returns an iterator to the highest data point. Same as before, \a upper may also lie
-  just outside of the visible range.
+  \a upper returns the index of the highest data point. Same as before, \a upper may also lie just
+  outside of the visible range.
+  
+  Since the data container is sorted by key, both bounds are found via binary search.
   
-  if the graph contains no data, both \a lower and \a upper point to constEnd.
+  if the graph contains no data, \a lower is set to 0 and \a upper to -1, so \a lower is greater
+  than \a upper.
 */
-void QCPGraph::getVisibleDataBounds(QCPDataMap::const_iterator &lower, QCPDataMap::const_iterator &upper) const
+void QCPGraph::getVisibleDataBounds(int &lower, int &upper) const
 {
+  lower = 0;
+  upper = -1;
   if (!mKeyAxis) { qDebug() << Q_FUNC_INFO << "invalid key axis"; return; }
   if (mData->isEmpty())
-  {
-    lower = mData->constEnd();
-    upper = mData->constEnd();
     return;
-  }
   
-  // get visible data range as QMap iterators
-  QCPDataMap::const_iterator lbound = mData->lowerBound(mKeyAxis.data()->range().lower);
-  QCPDataMap::const_iterator ubound = mData->upperBound(mKeyAxis.data()->range().upper);
-  bool lowoutlier = lbound != mData->constBegin(); // indicates whether there exist points below axis range
-  bool highoutlier = ubound != mData->constEnd(); // indicates whether there exist points above axis range
+  // get visible data range as container indices:
+  int lbound = mData->findBegin(mKeyAxis.data()->range().lower);
+  int ubound = mData->findEnd(mKeyAxis.data()->range().upper);
+  bool lowoutlier = lbound > 0; // indicates whether there exist points below axis range
+  bool highoutlier = ubound < mData->size(); // indicates whether there exist points above axis range
   
   lower = (lowoutlier ? lbound-1 : lbound); // data point range that will be actually drawn
   upper = (highoutlier ? ubound : ubound-1); // data point range that will be actually drawn
 }
 
-/*!  \internal
-  
-  Counts the number of data points between \a lower and \a upper (including them), up to a maximum
-  of \a maxCount.
-  
-  This function is used by \ref getPreparedData to determine whether adaptive sampling shall be
-  used (if enabled via \ref setAdaptiveSampling) or not. This is also why counting of data points
-  only needs to be done until \a maxCount is reached, which should be set to the number of data
-  points at which adaptive sampling sets in.
-*/
-int QCPGraph::countDataInBounds(const QCPDataMap::const_iterator &lower, const QCPDataMap::const_iterator &upper, int maxCount) const
-{
-  if (upper == mData->constEnd() && lower == mData->constEnd())
-    return 0;
-  QCPDataMap::const_iterator it = lower;
-  int count = 1;
-  while (it != upper && count < maxCount)
-  {
-    ++it;
-    ++count;
-  }
-  return count;
-}
-
 /*! \internal
   
   The line data vector generated by e.g. getLinePlotData contains only the line that connects the
@@ -2059,57 +4419,122 @@ double QCPGraph::pointDistance(const QPointF &pixelPoint) const
   if (mLineStyle == lsNone && mScatterStyle.isNone())
     return -1.0;
   
-  // calculate minimum distances to graph representation:
-  if (mLineStyle == lsNone)
+  if (!mHitTestValid || !(mHitTestState == hitTestState(mData->revision())))
   {
-    // no line displayed, only calculate distance to scatter points:
-    QVector<QCPData> scatterData;
-    getScatterPlotData(&scatterData);
-    if (scatterData.size() > 0)
+    if (mLineStyle == lsNone)
     {
-      double minDistSqr = std::numeric_limits<double>::max();
-      for (int i=0; i<scatterData.size(); ++i)
-      {
-        double currentDistSqr = QVector2D(coordsToPixels(scatterData.at(i).key, scatterData.at(i).value)-pixelPoint).lengthSquared();
-        if (currentDistSqr < minDistSqr)
-          minDistSqr = currentDistSqr;
-      }
-      return qSqrt(minDistSqr);
-    } else // no data available in view to calculate distance to
-      return -1.0;
+      // no line displayed, only calculate distance to scatter points:
+      QVector<QCPData> scatterData;
+      getScatterPlotData(&scatterData, mAdaptiveSampling, mSamplingAlgorithm);
+      setHitTestGeometry(0, &scatterData);
+    } else
+    {
+      // line displayed, calculate distance to line segments:
+      QVector<QPointF> lineData;
+      getPlotData(&lineData, 0); // unlike with getScatterPlotData we get pixel coordinates here
+      setHitTestGeometry(&lineData, 0);
+    }
+  }
+  return mHitTestIndex.distance(pixelPoint);
+}
+
+/*! \internal
+  
+  Stores the pixel geometry of the graph in the hit test index, for the current state of the axes
+  and the data (see \ref hitTestState). If the line style is not \ref lsNone, \a lineData holds
+  the line in pixel coordinates, as generated by \ref getPlotData. Otherwise \a scatterData holds
+  the visible scatter points, which are transformed to pixel coordinates here.
+  
+  This is called when the graph is drawn, so hit tests (\ref pointDistance) after a replot don't
+  need to calculate the geometry again.
+*/
+void QCPGraph::setHitTestGeometry(const QVector<QPointF> *lineData, const QVector<QCPData> *scatterData) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis) { qDebug() << Q_FUNC_INFO << "invalid key axis"; return; }
+  
+  const QRect axisRect = keyAxis->axisRect()->rect();
+  if (lineData)
+  {
+    mHitTestIndex.setGeometry(*lineData, mLineStyle == lsImpulse ? QCPHitTestIndex::gtLinePairs : QCPHitTestIndex::gtPolyline, axisRect);
+  } else if (scatterData)
+  {
+    QVector<double> keyPixels, valuePixels;
+    dataToPixels(*scatterData, &keyPixels, &valuePixels);
+    const bool keyIsVertical = keyAxis->orientation() == Qt::Vertical;
+    QVector<QPointF> points(scatterData->size());
+    for (int i=0; i<points.size(); ++i)
+      points[i] = keyIsVertical ? QPointF(valuePixels.at(i), keyPixels.at(i)) : QPointF(keyPixels.at(i), valuePixels.at(i));
+    mHitTestIndex.setGeometry(points, QCPHitTestIndex::gtPoints, axisRect);
+  } else
+    mHitTestIndex.clear();
+  mHitTestState = hitTestState(mData->revision());
+  mHitTestValid = true;
+}
+
+/*! \internal
+  
+  Examines the data points with indices from \a begin up to (but not including) \a end for a data
+  point closer to \a pixelPos than \a minDistSqr, the squared distance of the data point with
+  index \a nearest found so far. If one is found, \a nearest and \a minDistSqr are updated. Data
+  points with NaN values are ignored.
+  
+  If the min/max pyramid is enabled (\ref setMinMaxPyramid), large ranges are skipped when their
+  bounding box is farther away than \a minDistSqr, and otherwise split in halves, of which the
+  half closer to \a pixelPos in the key dimension is examined first. Without the pyramid,
+  determining the bounding box would be as expensive as examining the data points, so they are
+  examined directly.
+  
+  This is used by \ref findNearestDataPoint.
+*/
+void QCPGraph::findNearestInRange(int begin, int end, const QPointF &pixelPos, int &nearest, double &minDistSqr) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  const bool keyIsVertical = keyAxis->orientation() == Qt::Vertical;
+  const double posKeyPixel = keyIsVertical ? pixelPos.y() : pixelPos.x();
+  const double posValuePixel = keyIsVertical ? pixelPos.x() : pixelPos.y();
+  
+  if (mData->minMaxPyramid() && end-begin > 64)
+  {
+    double minValue, maxValue;
+    if (!mData->valueMinMax(begin, end, minValue, maxValue))
+      return; // only NaN values
+    // squared distance of pixelPos to the pixel bounding box of the range (NaN for invalid log values, which never skips the range):
+    const double keyPixel1 = keyAxis->coordToPixel(mData->keyAt(begin));
+    const double keyPixel2 = keyAxis->coordToPixel(mData->keyAt(end-1));
+    const double valuePixel1 = valueAxis->coordToPixel(minValue);
+    const double valuePixel2 = valueAxis->coordToPixel(maxValue);
+    const double keyDist = qMax(0.0, qMax(qMin(keyPixel1, keyPixel2)-posKeyPixel, posKeyPixel-qMax(keyPixel1, keyPixel2)));
+    const double valueDist = qMax(0.0, qMax(qMin(valuePixel1, valuePixel2)-posValuePixel, posValuePixel-qMax(valuePixel1, valuePixel2)));
+    if (keyDist*keyDist+valueDist*valueDist > minDistSqr)
+      return;
+    const int middle = begin+(end-begin)/2;
+    if (qAbs(keyAxis->coordToPixel(mData->keyAt(middle))-posKeyPixel) < qAbs(keyPixel1-posKeyPixel))
+    {
+      findNearestInRange(middle, end, pixelPos, nearest, minDistSqr);
+      findNearestInRange(begin, middle, pixelPos, nearest, minDistSqr);
+    } else
+    {
+      findNearestInRange(begin, middle, pixelPos, nearest, minDistSqr);
+      findNearestInRange(middle, end, pixelPos, nearest, minDistSqr);
+    }
   } else
   {
-    // line displayed, calculate distance to line segments:
-    QVector<QPointF> lineData;
-    getPlotData(&lineData, 0); // unlike with getScatterPlotData we get pixel coordinates here
-    if (lineData.size() > 1) // at least one line segment, compare distance to line segments
+    for (int i=begin; i<end; ++i)
     {
-      double minDistSqr = std::numeric_limits<double>::max();
-      if (mLineStyle == lsImpulse)
-      {
-        // impulse plot differs from other line styles in that the lineData points are only pairwise connected:
-        for (int i=0; i<lineData.size()-1; i+=2) // iterate pairs
-        {
-          double currentDistSqr = distSqrToLine(lineData.at(i), lineData.at(i+1), pixelPoint);
-          if (currentDistSqr < minDistSqr)
-            minDistSqr = currentDistSqr;
-        }
-      } else
+      const double value = mData->valueAt(i);
+      if (qIsNaN(value))
+        continue;
+      const double keyDist = keyAxis->coordToPixel(mData->keyAt(i))-posKeyPixel;
+      const double valueDist = valueAxis->coordToPixel(value)-posValuePixel;
+      const double distSqr = keyDist*keyDist+valueDist*valueDist;
+      if (distSqr < minDistSqr)
       {
-        // all other line plots (line and step) connect points directly:
-        for (int i=0; i<lineData.size()-1; ++i)
-        {
-          double currentDistSqr = distSqrToLine(lineData.at(i), lineData.at(i+1), pixelPoint);
-          if (currentDistSqr < minDistSqr)
-            minDistSqr = currentDistSqr;
-        }
+        minDistSqr = distSqr;
+        nearest = i;
       }
-      return qSqrt(minDistSqr);
-    } else if (lineData.size() > 0) // only single data point, calculate distance to that point
-    {
-      return QVector2D(lineData.at(0)-pixelPoint).length();
-    } else // no data available in view to calculate distance to
-      return -1.0;
+    }
   }
 }
 
@@ -2156,228 +4581,304 @@ QCPRange QCPGraph::getValueRange(bool &foundRange, SignDomain inSignDomain) cons
   
   Allows to specify whether the error bars should be included in the range calculation.
   
+  Without key error bars, the range is determined from the sorted keys in logarithmic time.
+  Otherwise, the range cache (see \ref QCPAbstractPlottable::rangeCache) is used.
+  
   \see getKeyRange(bool &foundRange, SignDomain inSignDomain)
 */
 QCPRange QCPGraph::getKeyRange(bool &foundRange, SignDomain inSignDomain, bool includeErrors) const
 {
-  QCPRange range;
-  bool haveLower = false;
-  bool haveUpper = false;
-  
-  double current, currentErrorMinus, currentErrorPlus;
-  
-  if (inSignDomain == sdBoth) // range may be anywhere
-  {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
-    {
-      if (!qIsNaN(it.value().value))
-      {
-        current = it.value().key;
-        currentErrorMinus = (includeErrors ? it.value().keyErrorMinus : 0);
-        currentErrorPlus = (includeErrors ? it.value().keyErrorPlus : 0);
-        if (current-currentErrorMinus < range.lower || !haveLower)
-        {
-          range.lower = current-currentErrorMinus;
-          haveLower = true;
-        }
-        if (current+currentErrorPlus > range.upper || !haveUpper)
-        {
-          range.upper = current+currentErrorPlus;
-          haveUpper = true;
-        }
-      }
-      ++it;
-    }
-  } else if (inSignDomain == sdNegative) // range may only be in the negative sign domain
+  if (!includeErrors || !mData->hasKeyErrors())
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
-    {
-      if (!qIsNaN(it.value().value))
-      {
-        current = it.value().key;
-        currentErrorMinus = (includeErrors ? it.value().keyErrorMinus : 0);
-        currentErrorPlus = (includeErrors ? it.value().keyErrorPlus : 0);
-        if ((current-currentErrorMinus < range.lower || !haveLower) && current-currentErrorMinus < 0)
-        {
-          range.lower = current-currentErrorMinus;
-          haveLower = true;
-        }
-        if ((current+currentErrorPlus > range.upper || !haveUpper) && current+currentErrorPlus < 0)
-        {
-          range.upper = current+currentErrorPlus;
-          haveUpper = true;
-        }
-        if (includeErrors) // in case point is in valid sign domain but errobars stretch beyond it, we still want to geht that point.
-        {
-          if ((current < range.lower || !haveLower) && current < 0)
-          {
-            range.lower = current;
-            haveLower = true;
-          }
-          if ((current > range.upper || !haveUpper) && current < 0)
-          {
-            range.upper = current;
-            haveUpper = true;
-          }
-        }
-      }
-      ++it;
-    }
-  } else if (inSignDomain == sdPositive) // range may only be in the positive sign domain
+    // the keys are sorted, so the bounds are the first and last keys in the sign domain whose values aren't NaN:
+    int begin = inSignDomain == sdPositive ? mData->findEnd(0) : 0;
+    int end = inSignDomain == sdNegative ? mData->findBegin(0) : mData->size();
+    while (begin < end && qIsNaN(mData->valueAt(begin)))
+      ++begin;
+    while (end > begin && qIsNaN(mData->valueAt(end-1)))
+      --end;
+    foundRange = begin < end;
+    return foundRange ? QCPRange(mData->keyAt(begin), mData->keyAt(end-1)) : QCPRange();
+  }
+  syncRangeCache(mData->revision());
+  RangeCache &cache = rangeCache(false, inSignDomain, includeErrors);
+  if (!cache.valid)
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    cache = RangeCache();
+    for (int i=0; i<mData->size(); ++i)
     {
-      if (!qIsNaN(it.value().value))
+      if (!qIsNaN(mData->valueAt(i)))
       {
-        current = it.value().key;
-        currentErrorMinus = (includeErrors ? it.value().keyErrorMinus : 0);
-        currentErrorPlus = (includeErrors ? it.value().keyErrorPlus : 0);
-        if ((current-currentErrorMinus < range.lower || !haveLower) && current-currentErrorMinus > 0)
-        {
-          range.lower = current-currentErrorMinus;
-          haveLower = true;
-        }
-        if ((current+currentErrorPlus > range.upper || !haveUpper) && current+currentErrorPlus > 0)
-        {
-          range.upper = current+currentErrorPlus;
-          haveUpper = true;
-        }
-        if (includeErrors) // in case point is in valid sign domain but errobars stretch beyond it, we still want to get that point.
-        {
-          if ((current < range.lower || !haveLower) && current > 0)
-          {
-            range.lower = current;
-            haveLower = true;
-          }
-          if ((current > range.upper || !haveUpper) && current > 0)
-          {
-            range.upper = current;
-            haveUpper = true;
-          }
-        }
+        if (includeErrors)
+          extendRange(cache, inSignDomain, mData->keyAt(i), mData->keyErrorMinusAt(i), mData->keyErrorPlusAt(i));
+        else
+          extendRange(cache, inSignDomain, mData->keyAt(i));
       }
-      ++it;
     }
+    cache.valid = true;
   }
-  
-  foundRange = haveLower && haveUpper;
-  return range;
+  foundRange = cache.haveLower && cache.haveUpper;
+  return cache.range;
 }
 
 /*! \overload
   
   Allows to specify whether the error bars should be included in the range calculation.
   
+  If the min/max pyramid is enabled (\ref setMinMaxPyramid) and neither a sign domain nor value
+  error bars are involved, the range is determined from the pyramid in logarithmic time.
+  Otherwise, the range cache (see \ref QCPAbstractPlottable::rangeCache) is used.
+  
   \see getValueRange(bool &foundRange, SignDomain inSignDomain)
 */
 QCPRange QCPGraph::getValueRange(bool &foundRange, SignDomain inSignDomain, bool includeErrors) const
 {
-  QCPRange range;
-  bool haveLower = false;
-  bool haveUpper = false;
-  
-  double current, currentErrorMinus, currentErrorPlus;
-  
-  if (inSignDomain == sdBoth) // range may be anywhere
+  if (inSignDomain == sdBoth && (!includeErrors || !mData->hasValueErrors()) && mData->minMaxPyramid())
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    // the min/max pyramid provides the bounds in logarithmic time, even after old data points were evicted:
+    QCPRange range;
+    foundRange = mData->valueMinMax(0, mData->size(), range.lower, range.upper);
+    return foundRange ? range : QCPRange();
+  }
+  syncRangeCache(mData->revision());
+  RangeCache &cache = rangeCache(true, inSignDomain, includeErrors);
+  if (!cache.valid)
+  {
+    cache = RangeCache();
+    for (int i=0; i<mData->size(); ++i)
     {
-      current = it.value().value;
+      const double current = mData->valueAt(i);
       if (!qIsNaN(current))
       {
-        currentErrorMinus = (includeErrors ? it.value().valueErrorMinus : 0);
-        currentErrorPlus = (includeErrors ? it.value().valueErrorPlus : 0);
-        if (current-currentErrorMinus < range.lower || !haveLower)
-        {
-          range.lower = current-currentErrorMinus;
-          haveLower = true;
-        }
-        if (current+currentErrorPlus > range.upper || !haveUpper)
-        {
-          range.upper = current+currentErrorPlus;
-          haveUpper = true;
-        }
+        if (includeErrors)
+          extendRange(cache, inSignDomain, current, mData->valueErrorMinusAt(i), mData->valueErrorPlusAt(i));
+        else
+          extendRange(cache, inSignDomain, current);
       }
-      ++it;
     }
-  } else if (inSignDomain == sdNegative) // range may only be in the negative sign domain
+    cache.valid = true;
+  }
+  foundRange = cache.haveLower && cache.haveUpper;
+  return cache.range;
+}
+
+/*! \internal
+  
+  Returns the value range of the data points with keys inside \a inKeyRange, including their value
+  error bars. The index range of these data points is found with binary searches, and only data
+  points inside it are examined.
+  
+  Without value errors, the bounds are determined with \ref QCPDataContainer::valueMinMax, which
+  has logarithmic complexity if the min/max pyramid is enabled (\ref setMinMaxPyramid), and is
+  linear in the number of data points inside \a inKeyRange otherwise. The pyramid also tells
+  whether the values lie entirely inside or outside \a inSignDomain. Only if they lie on both sides
+  of zero, or if the data has value errors, the data points inside \a inKeyRange are scanned
+  individually, which is linear in their number.
+*/
+QCPRange QCPGraph::getValueRangeInKeyRange(bool &foundRange, SignDomain inSignDomain, const QCPRange &inKeyRange) const
+{
+  const int begin = mData->findBegin(inKeyRange.lower);
+  const int end = mData->findEnd(inKeyRange.upper);
+  if (!mData->hasValueErrors())
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    double minValue, maxValue;
+    if (!mData->valueMinMax(begin, end, minValue, maxValue) ||
+        (inSignDomain == sdPositive && maxValue <= 0) || (inSignDomain == sdNegative && minValue >= 0))
     {
-      current = it.value().value;
-      if (!qIsNaN(current))
-      {
-        currentErrorMinus = (includeErrors ? it.value().valueErrorMinus : 0);
-        currentErrorPlus = (includeErrors ? it.value().valueErrorPlus : 0);
-        if ((current-currentErrorMinus < range.lower || !haveLower) && current-currentErrorMinus < 0)
-        {
-          range.lower = current-currentErrorMinus;
-          haveLower = true;
-        }
-        if ((current+currentErrorPlus > range.upper || !haveUpper) && current+currentErrorPlus < 0)
-        {
-          range.upper = current+currentErrorPlus;
-          haveUpper = true;
-        }
-        if (includeErrors) // in case point is in valid sign domain but errobars stretch beyond it, we still want to get that point.
-        {
-          if ((current < range.lower || !haveLower) && current < 0)
-          {
-            range.lower = current;
-            haveLower = true;
-          }
-          if ((current > range.upper || !haveUpper) && current < 0)
-          {
-            range.upper = current;
-            haveUpper = true;
-          }
-        }
-      }
-      ++it;
+      foundRange = false;
+      return QCPRange();
+    }
+    if (inSignDomain == sdBoth || (inSignDomain == sdPositive && minValue > 0) || (inSignDomain == sdNegative && maxValue < 0))
+    {
+      foundRange = true;
+      return QCPRange(minValue, maxValue);
     }
-  } else if (inSignDomain == sdPositive) // range may only be in the positive sign domain
+  }
+  // error bars or values on both sides of zero require looking at each data point inside the key range:
+  RangeCache result;
+  for (int i=begin; i<end; ++i)
+  {
+    const double current = mData->valueAt(i);
+    if (!qIsNaN(current))
+      extendRange(result, inSignDomain, current, mData->valueErrorMinusAt(i), mData->valueErrorPlusAt(i));
+  }
+  foundRange = result.haveLower && result.haveUpper;
+  return result.range;
+}
+
+/*! \internal
+  
+  Extends the range cache (see \ref QCPAbstractPlottable::rangeCache) by the newly added data point
+  \a data. If the values are stored with single precision, the value is rounded accordingly, so the
+  cached bounds are the same as when determined from the stored data.
+*/
+void QCPGraph::addToRangeCache(const QCPData &data) const
+{
+  const double value = mData->singlePrecisionValues() ? double(float(data.value)) : data.value;
+  if (!qIsNaN(value))
+  {
+    extendRangeCache(false, data.key, data.keyErrorMinus, data.keyErrorPlus);
+    extendRangeCache(true, value, data.valueErrorMinus, data.valueErrorPlus);
+  }
+}
+
+/*! \internal
+  
+  Invalidates the entries of the range cache (see \ref QCPAbstractPlottable::rangeCache) whose
+  bounds may be defined by the stored data point \a data, which is about to be removed.
+  
+  \see QCPAbstractPlottable::shrinkRangeCache
+*/
+void QCPGraph::removeFromRangeCache(const QCPData &data) const
+{
+  if (!qIsNaN(data.value))
+  {
+    shrinkRangeCache(false, data.key, data.keyErrorMinus, data.keyErrorPlus);
+    shrinkRangeCache(true, data.value, data.valueErrorMinus, data.valueErrorPlus);
+  }
+}
+
+/*! \internal
+  
+  Called before \a addCount data points are added to the data container. If the container has a
+  fixed capacity (see \ref setStreamingCapacity) that will be exceeded, the data points with the
+  lowest keys are evicted. This function removes them from the range cache via \ref
+  removeFromRangeCache, so the cached bounds only need to be determined anew if an evicted data
+  point defined one of them. Returns the number of data points that will be evicted.
+  
+  Since the evicted data points are taken from the currently stored ones, the caller must
+  invalidate the range cache if the return value exceeds the current size, or if added data points
+  have keys not greater than the lowest key after the addition, because then added data points may
+  have been evicted instead.
+*/
+int QCPGraph::removeEvictedFromRangeCache(int addCount) const
+{
+  const int capacity = mData->fixedCapacity();
+  if (capacity <= 0)
+    return 0;
+  const int evicted = qMax(0, mData->size()+addCount-capacity);
+  const int count = qMin(evicted, mData->size());
+  for (int i=0; i<count; ++i)
+    removeFromRangeCache(mData->at(i));
+  return evicted;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDensityBinner
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDensityBinner
+  
+  \internal
+  \brief (Private)
+  
+  This is a private class and not part of the public QCustomPlot interface.
+  
+  It counts the data points of a graph per pixel, for the density scatter mode of QCPGraph (see
+  \ref QCPGraph::setScatterMode). Each instance counts one chunk of the data points into its own
+  count buffer, so multiple chunks can be counted in parallel on the global QThreadPool without
+  synchronization. The buffers are added up afterwards, see \ref binData.
+*/
+
+/*!
+  Creates a task that counts the data points of \a data with indices from \a begin to \a end
+  (exclusive), transformed to pixels with \a keyAxis and \a valueAxis. The counts are collected per
+  pixel of \a rect, points outside \a rect are ignored. When done, the task releases \a finished
+  once.
+*/
+QCPDensityBinner::QCPDensityBinner(const QCPDataContainer *data, const QCPAxis *keyAxis, const QCPAxis *valueAxis, int begin, int end, const QRect &rect, QSemaphore *finished) :
+  mData(data),
+  mKeyAxis(keyAxis),
+  mValueAxis(valueAxis),
+  mBegin(begin),
+  mEnd(end),
+  mRect(rect),
+  mFinished(finished)
+{
+  setAutoDelete(false); // the counts are read after the task has run
+}
+
+/* inherits documentation from base class */
+void QCPDensityBinner::run()
+{
+  const int width = mRect.width();
+  const int height = mRect.height();
+  mCounts.fill(0, width*height);
+  quint32 *counts = mCounts.data();
+  const bool keyIsHorizontal = mKeyAxis->orientation() == Qt::Horizontal;
+  
+  // transform the points in batches, so the pixel buffers stay small and in cache:
+  const int batchSize = 1024;
+  double keys[batchSize], values[batchSize];
+  double keyPixels[batchSize], valuePixels[batchSize];
+  for (int batchBegin=mBegin; batchBegin<mEnd; batchBegin+=batchSize)
   {
-    QCPDataMap::const_iterator it = mData->constBegin();
-    while (it != mData->constEnd())
+    const int n = qMin(batchSize, mEnd-batchBegin);
+    for (int i=0; i<n; ++i)
     {
-      current = it.value().value;
-      if (!qIsNaN(current))
-      {
-        currentErrorMinus = (includeErrors ? it.value().valueErrorMinus : 0);
-        currentErrorPlus = (includeErrors ? it.value().valueErrorPlus : 0);
-        if ((current-currentErrorMinus < range.lower || !haveLower) && current-currentErrorMinus > 0)
-        {
-          range.lower = current-currentErrorMinus;
-          haveLower = true;
-        }
-        if ((current+currentErrorPlus > range.upper || !haveUpper) && current+currentErrorPlus > 0)
-        {
-          range.upper = current+currentErrorPlus;
-          haveUpper = true;
-        }
-        if (includeErrors) // in case point is in valid sign domain but errobars stretch beyond it, we still want to geht that point.
-        {
-          if ((current < range.lower || !haveLower) && current > 0)
-          {
-            range.lower = current;
-            haveLower = true;
-          }
-          if ((current > range.upper || !haveUpper) && current > 0)
-          {
-            range.upper = current;
-            haveUpper = true;
-          }
-        }
-      }
-      ++it;
+      keys[i] = mData->keyAt(batchBegin+i);
+      values[i] = mData->valueAt(batchBegin+i);
+    }
+    mKeyAxis->coordToPixel(keys, keyPixels, n);
+    mValueAxis->coordToPixel(values, valuePixels, n);
+    const double *xPixels = keyIsHorizontal ? keyPixels : valuePixels;
+    const double *yPixels = keyIsHorizontal ? valuePixels : keyPixels;
+    for (int i=0; i<n; ++i)
+    {
+      // the comparisons are false for NaN, so points with NaN values are skipped:
+      const double x = xPixels[i]-mRect.left();
+      const double y = yPixels[i]-mRect.top();
+      if (x >= 0 && x < width && y >= 0 && y < height)
+        ++counts[int(y)*width+int(x)];
     }
   }
+  mFinished->release();
+}
+
+/*!
+  Returns the number of data points of \a data with indices from \a begin to \a end (exclusive)
+  per pixel of \a rect. The counts are ordered row by row, starting at the top left pixel of \a
+  rect.
+  
+  Large index ranges are split into chunks that are counted in parallel. The calling thread takes
+  part in the work, and as many idle threads of the global thread pool as are available are used
+  in addition.
+*/
+QVector<quint32> QCPDensityBinner::binData(const QCPDataContainer *data, const QCPAxis *keyAxis, const QCPAxis *valueAxis, int begin, int end, const QRect &rect)
+{
+  // chunks must be large, so counting them outweighs the allocation and summation of their count buffers:
+  const int minChunkSize = qMax(100000, rect.width()*rect.height());
+  const int chunkCount = qBound(1, (end-begin)/minChunkSize, QThreadPool::globalInstance()->maxThreadCount());
+  
+  QSemaphore finished;
+  QList<QCPDensityBinner*> tasks;
+  for (int i=0; i<chunkCount; ++i)
+  {
+    const int chunkBegin = begin+int((end-begin)*qint64(i)/chunkCount);
+    const int chunkEnd = begin+int((end-begin)*qint64(i+1)/chunkCount);
+    tasks.append(new QCPDensityBinner(data, keyAxis, valueAxis, chunkBegin, chunkEnd, rect, &finished));
+  }
+  // start all tasks but the first one in the thread pool, tasks for which no thread is idle are run by the calling thread:
+  QList<QCPDensityBinner*> remainingTasks;
+  remainingTasks.append(tasks.first());
+  for (int i=1; i<tasks.size(); ++i)
+  {
+    if (!QThreadPool::globalInstance()->tryStart(tasks.at(i)))
+      remainingTasks.append(tasks.at(i));
+  }
+  for (int i=0; i<remainingTasks.size(); ++i)
+    remainingTasks.at(i)->run();
+  finished.acquire(chunkCount);
   
-  foundRange = haveLower && haveUpper;
-  return range;
+  QVector<quint32> counts = tasks.first()->counts();
+  quint32 *sum = counts.data();
+  for (int i=1; i<tasks.size(); ++i)
+  {
+    const quint32 *chunkCounts = tasks.at(i)->counts().constData();
+    for (int k=0; k<counts.size(); ++k)
+      sum[k] += chunkCounts[k];
+  }
+  qDeleteAll(tasks);
+  return counts;
 }
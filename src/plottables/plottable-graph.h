@@ -30,6 +30,7 @@
 #include "../range.h"
 #include "../plottable.h"
 #include "../painter.h"
+#include "../colorgradient.h"
 
 class QCPPainter;
 class QCPAxis;
@@ -45,16 +46,277 @@ public:
 };
 Q_DECLARE_TYPEINFO(QCPData, Q_MOVABLE_TYPE);
 
+class QCP_LIB_DECL QCPDataContainer
+{
+public:
+  class reference : public QCPData
+  {
+  public:
+    reference(QCPDataContainer *container, int index) : QCPData(container->at(index)), mContainer(container), mIndex(index), mOriginal(*this) {}
+    ~reference();
+    reference &operator=(const QCPData &data) { QCPData::operator=(data); return *this; }
+    reference &operator=(const reference &other) { QCPData::operator=(other); return *this; }
+    
+  private:
+    QCPDataContainer *mContainer;
+    int mIndex;
+    QCPData mOriginal;
+    static bool sameValue(double a, double b);
+  };
+  
+  class const_iterator
+  {
+  public:
+    const_iterator() : mContainer(0), mIndex(0) {}
+    const_iterator(const QCPDataContainer *container, int index) : mContainer(container), mIndex(index) {}
+    
+    double key() const { return mContainer->keyAt(mIndex); }
+    QCPData value() const { return mContainer->at(mIndex); }
+    QCPData operator*() const { return mContainer->at(mIndex); }
+    int index() const { return mIndex; }
+    
+    bool operator==(const const_iterator &other) const { return mIndex == other.mIndex && mContainer == other.mContainer; }
+    bool operator!=(const const_iterator &other) const { return mIndex != other.mIndex || mContainer != other.mContainer; }
+    bool operator<(const const_iterator &other) const { return mIndex < other.mIndex; }
+    const_iterator &operator++() { ++mIndex; return *this; }
+    const_iterator operator++(int) { const_iterator result(*this); ++mIndex; return result; }
+    const_iterator &operator--() { --mIndex; return *this; }
+    const_iterator operator--(int) { const_iterator result(*this); --mIndex; return result; }
+    const_iterator &operator+=(int n) { mIndex += n; return *this; }
+    const_iterator &operator-=(int n) { mIndex -= n; return *this; }
+    const_iterator operator+(int n) const { return const_iterator(mContainer, mIndex+n); }
+    const_iterator operator-(int n) const { return const_iterator(mContainer, mIndex-n); }
+    int operator-(const const_iterator &other) const { return mIndex-other.mIndex; }
+    
+  private:
+    const QCPDataContainer *mContainer;
+    int mIndex;
+  };
+  
+  class iterator : public const_iterator
+  {
+  public:
+    iterator() : mMutableContainer(0) {}
+    iterator(QCPDataContainer *container, int index) : const_iterator(container, index), mMutableContainer(container) {}
+    
+    reference value() const { return reference(mMutableContainer, index()); }
+    reference operator*() const { return reference(mMutableContainer, index()); }
+    
+    iterator &operator++() { const_iterator::operator++(); return *this; }
+    iterator operator++(int) { iterator result(*this); const_iterator::operator++(); return result; }
+    iterator &operator--() { const_iterator::operator--(); return *this; }
+    iterator operator--(int) { iterator result(*this); const_iterator::operator--(); return result; }
+    iterator &operator+=(int n) { const_iterator::operator+=(n); return *this; }
+    iterator &operator-=(int n) { const_iterator::operator-=(n); return *this; }
+    iterator operator+(int n) const { return iterator(mMutableContainer, index()+n); }
+    iterator operator-(int n) const { return iterator(mMutableContainer, index()-n); }
+    int operator-(const const_iterator &other) const { return index()-other.index(); }
+    
+  private:
+    QCPDataContainer *mMutableContainer;
+  };
+  
+  QCPDataContainer();
+  
+  // getters:
+  int size() const { return mSize; }
+  int count() const { return mSize; }
+  bool isEmpty() const { return mSize == 0; }
+  int fixedCapacity() const { return mFixedCapacity; }
+  bool singlePrecisionValues() const { return mSinglePrecisionValues; }
+  bool minMaxPyramid() const { return mMinMaxPyramid; }
+  bool isExternal() const { return mExternalKeys != 0; }
+  bool hasKeyErrors() const { return !mKeyErrorsMinus.isEmpty(); }
+  bool hasValueErrors() const { return !mValueErrorsMinus.isEmpty(); }
+  quint32 revision() const { return mRevision; }
+  QCPData at(int index) const;
+  double keyAt(int index) const { return mExternalKeys ? mExternalKeys[index] : mKeys.at(physicalIndex(index)); }
+  double valueAt(int index) const { return mExternalValues ? mExternalValues[index] : (mSinglePrecisionValues ? mFloatValues.at(physicalIndex(index)) : mValues.at(physicalIndex(index))); }
+  double keyErrorMinusAt(int index) const { return mKeyErrorsMinus.isEmpty() ? 0 : mKeyErrorsMinus.at(physicalIndex(index)); }
+  double keyErrorPlusAt(int index) const { return mKeyErrorsPlus.isEmpty() ? 0 : mKeyErrorsPlus.at(physicalIndex(index)); }
+  double valueErrorMinusAt(int index) const { return mValueErrorsMinus.isEmpty() ? 0 : mValueErrorsMinus.at(physicalIndex(index)); }
+  double valueErrorPlusAt(int index) const { return mValueErrorsPlus.isEmpty() ? 0 : mValueErrorsPlus.at(physicalIndex(index)); }
+  QCPData first() const { return at(0); }
+  QCPData last() const { return at(mSize-1); }
+  double firstKey() const { return keyAt(0); }
+  double lastKey() const { return keyAt(mSize-1); }
+  const_iterator constBegin() const { return const_iterator(this, 0); }
+  const_iterator constEnd() const { return const_iterator(this, mSize); }
+  const_iterator begin() const { return constBegin(); }
+  const_iterator end() const { return constEnd(); }
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, mSize); }
+  
+  // setters:
+  void setFixedCapacity(int capacity);
+  void setSinglePrecisionValues(bool enabled);
+  void setMinMaxPyramid(bool enabled);
+  
+  // non-property methods:
+  int findBegin(double key) const;
+  int findBegin(double key, int from, int to) const;
+  int findEnd(double key) const;
+  const_iterator lowerBound(double key) const { return const_iterator(this, findBegin(key)); }
+  const_iterator upperBound(double key) const { return const_iterator(this, findEnd(key)); }
+  iterator lowerBound(double key) { return iterator(this, findBegin(key)); }
+  iterator upperBound(double key) { return iterator(this, findEnd(key)); }
+  const_iterator constFind(double key) const;
+  const_iterator find(double key) const { return constFind(key); }
+  iterator find(double key) { return iterator(this, constFind(key).index()); }
+  bool contains(double key) const { return constFind(key) != constEnd(); }
+  void set(const QVector<QCPData> &data, bool alreadySorted=false);
+  void set(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
+  void setExternal(const double *keys, const double *values, int size);
+  void externalDataChanged(int size=-1);
+  void add(const QVector<QCPData> &data, bool alreadySorted=false);
+  void add(const QCPDataContainer &other);
+  void add(const QCPData &data);
+  void insert(double key, const QCPData &data);
+  void insertMulti(double key, const QCPData &data);
+  void replace(int index, const QCPData &data);
+  void setValueAt(int index, double value);
+  void unite(const QCPDataContainer &other) { add(other); }
+  void removeBefore(double key);
+  void removeAfter(double key);
+  void remove(double fromKey, double toKey);
+  int remove(double key);
+  const_iterator erase(const_iterator it);
+  const_iterator erase(const_iterator first, const_iterator last);
+  iterator erase(iterator it) { return iterator(this, erase(const_iterator(it)).index()); }
+  iterator erase(iterator first, iterator last) { return iterator(this, erase(const_iterator(first), const_iterator(last)).index()); }
+  void clear();
+  void reserve(int size);
+  void squeeze();
+  QVector<QCPData> toVector() const;
+  bool valueMinMax(int begin, int end, double &minValue, double &maxValue) const;
+  
+protected:
+  // circular buffer columns, holding mSize data points starting at the physical index mBegin. Only
+  // one of mValues and mFloatValues is used, depending on mSinglePrecisionValues. The error columns
+  // are either empty or have the same size as the key and value columns:
+  QVector<double> mKeys, mValues;
+  QVector<float> mFloatValues;
+  QVector<double> mKeyErrorsMinus, mKeyErrorsPlus;
+  QVector<double> mValueErrorsMinus, mValueErrorsPlus;
+  int mBegin, mSize;
+  int mFixedCapacity;
+  bool mSinglePrecisionValues;
+  quint32 mRevision;
+  // user-owned arrays if the container is an external view, see setExternal:
+  const double *mExternalKeys;
+  const double *mExternalValues;
+  // min/max pyramid of the values, see setMinMaxPyramid. Level 0 holds the value bounds of blocks of
+  // pyramidBlockSize physical slots, each further level combines two entries of the level below:
+  bool mMinMaxPyramid;
+  mutable QVector<QVector<double> > mPyramidMin, mPyramidMax;
+  mutable bool mPyramidValid;
+  mutable int mPyramidDirtyBlock;
+  static const int pyramidBlockSize;
+  
+  int capacity() const { return mKeys.size(); }
+  int physicalIndex(int index) const { int p = mBegin+index; return p < mKeys.size() ? p : p-mKeys.size(); }
+  int slotCount() const { return mExternalKeys ? mSize : mKeys.size(); }
+  double slotValue(int slot) const { return mExternalValues ? mExternalValues[slot] : (mSinglePrecisionValues ? mFloatValues.at(slot) : mValues.at(slot)); }
+  void resetColumns(int newCapacity);
+  void assignColumns(const double *keys, const double *values, int count);
+  void detachExternal();
+  void writeData(int slot, const QCPData &data);
+  void moveData(int toSlot, int fromSlot);
+  void appendData(const QCPData &data);
+  void insertData(int index, const QCPData &data);
+  void eraseData(int begin, int end);
+  void reallocate(int newCapacity);
+  template <typename T> void reallocateColumn(QVector<T> &column, int oldCapacity, int newCapacity, int offset, int count) const;
+  void invalidatePyramid() { mPyramidValid = false; mPyramidDirtyBlock = -1; }
+  void markPyramidSlot(int slot);
+  void updatePyramid() const;
+  void updatePyramidBlock(int block) const;
+  void pyramidMinMax(int fromSlot, int toSlot, double &minValue, double &maxValue) const;
+  static bool lessThanKey(const QCPData &a, const QCPData &b);
+  static bool isSorted(const QVector<QCPData> &data, int from=0);
+};
+
 /*! \typedef QCPDataMap
-  Container for storing \ref QCPData items in a sorted fashion. The key of the map
-  is the key member of the QCPData instance.
+  Container for storing \ref QCPData items in a sorted fashion. This is a typedef of \ref
+  QCPDataContainer, which provides the subset of the QMap interface that was used with earlier
+  versions of QCustomPlot, when QCPGraph still stored its data in a QMap.
   
-  This is the container in which QCPGraph holds its data.
-  \see QCPData, QCPGraph::setData
+  This is the container in which QCPGraph holds its data. Data points can be modified via the
+  non-const iterators like with QMap (see \ref QCPDataContainer::reference), or with \ref
+  QCPDataContainer::replace, \ref QCPDataContainer::setValueAt and \ref QCPDataMutableMapIterator.
+  \see QCPData, QCPDataContainer, QCPDataMapIterator, QCPGraph::setData
 */
-typedef QMap<double, QCPData> QCPDataMap;
-typedef QMapIterator<double, QCPData> QCPDataMapIterator;
-typedef QMutableMapIterator<double, QCPData> QCPDataMutableMapIterator;
+typedef QCPDataContainer QCPDataMap;
+
+class QCP_LIB_DECL QCPDataMapIterator
+{
+public:
+  QCPDataMapIterator(const QCPDataContainer &container) : mContainer(&container), mIndex(0), mLast(-1) {}
+  
+  void toFront() { mIndex = 0; mLast = -1; }
+  void toBack() { mIndex = mContainer->size(); mLast = -1; }
+  bool hasNext() const { return mIndex < mContainer->size(); }
+  bool hasPrevious() const { return mIndex > 0; }
+  QCPDataContainer::const_iterator next() { mLast = mIndex++; return QCPDataContainer::const_iterator(mContainer, mLast); }
+  QCPDataContainer::const_iterator previous() { mLast = --mIndex; return QCPDataContainer::const_iterator(mContainer, mLast); }
+  QCPDataContainer::const_iterator peekNext() const { return QCPDataContainer::const_iterator(mContainer, mIndex); }
+  QCPDataContainer::const_iterator peekPrevious() const { return QCPDataContainer::const_iterator(mContainer, mIndex-1); }
+  double key() const { return mContainer->keyAt(mLast); }
+  QCPData value() const { return mContainer->at(mLast); }
+  
+protected:
+  const QCPDataContainer *mContainer;
+  int mIndex; // position between the data points mIndex-1 and mIndex
+  int mLast; // index of the data point returned by the last next/previous call, or -1
+};
+
+class QCP_LIB_DECL QCPDataMutableMapIterator : public QCPDataMapIterator
+{
+public:
+  QCPDataMutableMapIterator(QCPDataContainer &container) : QCPDataMapIterator(container), mMutableContainer(&container) {}
+  
+  QCPDataContainer::iterator next() { mLast = mIndex++; return QCPDataContainer::iterator(mMutableContainer, mLast); }
+  QCPDataContainer::iterator previous() { mLast = --mIndex; return QCPDataContainer::iterator(mMutableContainer, mLast); }
+  QCPData value() const { return QCPDataMapIterator::value(); }
+  QCPDataContainer::reference value() { return QCPDataContainer::reference(mMutableContainer, mLast); }
+  void setValue(const QCPData &data) { if (mLast >= 0) mMutableContainer->replace(mLast, data); }
+  void remove();
+  
+protected:
+  QCPDataContainer *mMutableContainer;
+};
+
+class QCP_LIB_DECL QCPDataFile
+{
+public:
+  QCPDataFile();
+  explicit QCPDataFile(const QString &fileName);
+  ~QCPDataFile();
+  
+  // getters:
+  QString fileName() const { return mFile.fileName(); }
+  bool isOpen() const { return mMap != 0; }
+  qint64 size() const { return mSize; }
+  const double *keys() const { return mKeys; }
+  const double *values() const { return mValues; }
+  
+  // non-property methods:
+  bool open(const QString &fileName);
+  void close();
+  static bool writeHeader(QIODevice *device, qint64 count);
+  static bool write(const QString &fileName, const QVector<double> &keys, const QVector<double> &values);
+  
+  static const int headerSize;
+  
+protected:
+  QFile mFile;
+  uchar *mMap;
+  qint64 mSize;
+  const double *mKeys, *mValues;
+  
+private:
+  Q_DISABLE_COPY(QCPDataFile)
+};
 
 
 class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable
@@ -69,6 +331,10 @@ class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable
   Q_PROPERTY(bool errorBarSkipSymbol READ errorBarSkipSymbol WRITE setErrorBarSkipSymbol)
   Q_PROPERTY(QCPGraph* channelFillGraph READ channelFillGraph WRITE setChannelFillGraph)
   Q_PROPERTY(bool adaptiveSampling READ adaptiveSampling WRITE setAdaptiveSampling)
+  Q_PROPERTY(SamplingAlgorithm samplingAlgorithm READ samplingAlgorithm WRITE setSamplingAlgorithm)
+  Q_PROPERTY(ScatterMode scatterMode READ scatterMode WRITE setScatterMode)
+  Q_PROPERTY(QCPColorGradient densityGradient READ densityGradient WRITE setDensityGradient)
+  Q_PROPERTY(QCPAxis::ScaleType densityScaleType READ densityScaleType WRITE setDensityScaleType)
   /// \endcond
 public:
   /*!
@@ -94,6 +360,23 @@ public:
                    ,etBoth  ///< Error bars for both key and value dimensions of the data point are shown
                  };
   Q_ENUMS(ErrorType)
+  /*!
+    Defines how the data points of the graph are represented, besides the line.
+    \see setScatterMode
+  */
+  enum ScatterMode { smShapes    ///< each data point is drawn with the scatter style (see \ref setScatterStyle)
+                     ,smDensity  ///< the data points are counted per pixel, and the counts are shown with the density gradient (see \ref setDensityGradient)
+                   };
+  Q_ENUMS(ScatterMode)
+  /*!
+    Defines how the data points are reduced by adaptive sampling (\ref setAdaptiveSampling).
+    \see setSamplingAlgorithm
+  */
+  enum SamplingAlgorithm { saMinMax ///< the line keeps the value span of each pixel column, scatters keep the outer points and a subset of the inner points of each pixel column
+                           ,saM4    ///< the first, minimum, maximum and last data point of each pixel column are kept, for the line as well as for scatters
+                           ,saLttb  ///< Largest-Triangle-Three-Buckets: the data points are split into buckets of equal size, and the point spanning the largest triangle with its neighbours is kept per bucket. Preserves the visual shape with few points
+                         };
+  Q_ENUMS(SamplingAlgorithm)
   
   explicit QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis);
   virtual ~QCPGraph();
@@ -108,10 +391,19 @@ public:
   bool errorBarSkipSymbol() const { return mErrorBarSkipSymbol; }
   QCPGraph *channelFillGraph() const { return mChannelFillGraph.data(); }
   bool adaptiveSampling() const { return mAdaptiveSampling; }
+  SamplingAlgorithm samplingAlgorithm() const { return mSamplingAlgorithm; }
+  int streamingCapacity() const { return mData->fixedCapacity(); }
+  bool singlePrecisionValues() const { return mData->singlePrecisionValues(); }
+  bool minMaxPyramid() const { return mData->minMaxPyramid(); }
+  ScatterMode scatterMode() const { return mScatterMode; }
+  QCPColorGradient densityGradient() const { return mDensityGradient; }
+  QCPAxis::ScaleType densityScaleType() const { return mDensityScaleType; }
   
   // setters:
   void setData(QCPDataMap *data, bool copy=false);
   void setData(const QVector<double> &key, const QVector<double> &value);
+  void setExternalData(const double *keys, const double *values, int size);
+  void setExternalData(const QCPDataFile &file);
   void setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError);
   void setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus);
   void setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueError);
@@ -126,6 +418,13 @@ public:
   void setErrorBarSkipSymbol(bool enabled);
   void setChannelFillGraph(QCPGraph *targetGraph);
   void setAdaptiveSampling(bool enabled);
+  void setSamplingAlgorithm(SamplingAlgorithm algorithm);
+  void setStreamingCapacity(int capacity);
+  void setSinglePrecisionValues(bool enabled);
+  void setMinMaxPyramid(bool enabled);
+  void setScatterMode(ScatterMode mode);
+  void setDensityGradient(const QCPColorGradient &gradient);
+  void setDensityScaleType(QCPAxis::ScaleType type);
   
   // non-property methods:
   void addData(const QCPDataMap &dataMap);
@@ -136,6 +435,8 @@ public:
   void removeDataAfter(double key);
   void removeData(double fromKey, double toKey);
   void removeData(double key);
+  void externalDataChanged(int size=-1);
+  double samplingPixelError(SamplingAlgorithm algorithm) const;
   
   // reimplemented virtual methods:
   virtual void clearData();
@@ -158,6 +459,16 @@ protected:
   bool mErrorBarSkipSymbol;
   QPointer<QCPGraph> mChannelFillGraph;
   bool mAdaptiveSampling;
+  SamplingAlgorithm mSamplingAlgorithm;
+  ScatterMode mScatterMode;
+  QCPColorGradient mDensityGradient;
+  QCPAxis::ScaleType mDensityScaleType;
+  // non-property members:
+  QVector<QPointF> mPreparedLineData;
+  QVector<QCPData> mPreparedScatterData;
+  mutable QCPHitTestIndex mHitTestIndex;
+  mutable HitTestState mHitTestState;
+  mutable bool mHitTestValid;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter);
@@ -166,25 +477,35 @@ protected:
   virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain=sdBoth) const;
   virtual QCPRange getKeyRange(bool &foundRange, SignDomain inSignDomain, bool includeErrors) const; // overloads base class interface
   virtual QCPRange getValueRange(bool &foundRange, SignDomain inSignDomain, bool includeErrors) const; // overloads base class interface
+  virtual QCPRange getValueRangeInKeyRange(bool &foundRange, SignDomain inSignDomain, const QCPRange &inKeyRange) const;
+  virtual void prepareDraw();
+  virtual void clearPreparedDraw();
+  virtual QCPDataPoint findNearestDataPoint(const QPointF &pixelPos, const QCPRange &keyWindow) const;
   
   // introduced virtual methods:
   virtual void drawFill(QCPPainter *painter, QVector<QPointF> *lineData) const;
   virtual void drawScatterPlot(QCPPainter *painter, QVector<QCPData> *scatterData) const;
   virtual void drawLinePlot(QCPPainter *painter, QVector<QPointF> *lineData) const;
   virtual void drawImpulsePlot(QCPPainter *painter, QVector<QPointF> *lineData) const;
+  virtual void drawDensityPlot(QCPPainter *painter);
   
   // non-virtual methods:
-  void getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *scatterData) const;
+  void getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const;
   void getPlotData(QVector<QPointF> *lineData, QVector<QCPData> *scatterData) const;
-  void getScatterPlotData(QVector<QCPData> *scatterData) const;
-  void getLinePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const;
-  void getStepLeftPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const;
-  void getStepRightPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const;
-  void getStepCenterPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const;
-  void getImpulsePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const;
+  void getPlotData(QVector<QPointF> *lineData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const;
+  void getScatterPlotData(QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const;
+  void getM4SampledData(QVector<QCPData> *sampledData, int lower, int upper) const;
+  void appendM4Column(QVector<QCPData> *sampledData, int first, int minIndex, int maxIndex, int last) const;
+  void getLttbSampledData(QVector<QCPData> *sampledData, int lower, int upper, int bucketCount) const;
+  void getLinePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const;
+  void getStepLeftPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const;
+  void getStepRightPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const;
+  void getStepCenterPlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const;
+  void getImpulsePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData, bool adaptiveSampling, SamplingAlgorithm samplingAlgorithm) const;
+  void dataToPixels(const QVector<QCPData> &data, QVector<double> *keyPixels, QVector<double> *valuePixels) const;
+  void dataToPixels(int begin, int end, QVector<double> *keyPixels, QVector<double> *valuePixels) const;
   void drawError(QCPPainter *painter, double x, double y, const QCPData &data) const;
-  void getVisibleDataBounds(QCPDataMap::const_iterator &lower, QCPDataMap::const_iterator &upper) const;
-  int countDataInBounds(const QCPDataMap::const_iterator &lower, const QCPDataMap::const_iterator &upper, int maxCount) const;
+  void getVisibleDataBounds(int &lower, int &upper) const;
   void addFillBasePoints(QVector<QPointF> *lineData) const;
   void removeFillBasePoints(QVector<QPointF> *lineData) const;
   QPointF lowerFillBasePoint(double lowerKey) const;
@@ -195,9 +516,38 @@ protected:
   int findIndexBelowY(const QVector<QPointF> *data, double y) const;
   int findIndexAboveY(const QVector<QPointF> *data, double y) const;
   double pointDistance(const QPointF &pixelPoint) const;
+  void setHitTestGeometry(const QVector<QPointF> *lineData, const QVector<QCPData> *scatterData) const;
+  void findNearestInRange(int begin, int end, const QPointF &pixelPos, int &nearest, double &minDistSqr) const;
+  void addToRangeCache(const QCPData &data) const;
+  void removeFromRangeCache(const QCPData &data) const;
+  int removeEvictedFromRangeCache(int addCount) const;
   
   friend class QCustomPlot;
   friend class QCPLegend;
 };
 
+
+class QCP_LIB_DECL QCPDensityBinner : public QRunnable
+{
+public:
+  QCPDensityBinner(const QCPDataContainer *data, const QCPAxis *keyAxis, const QCPAxis *valueAxis, int begin, int end, const QRect &rect, QSemaphore *finished);
+  
+  // getters:
+  const QVector<quint32> &counts() const { return mCounts; }
+  
+  // reimplemented virtual methods:
+  virtual void run();
+  
+  // static methods:
+  static QVector<quint32> binData(const QCPDataContainer *data, const QCPAxis *keyAxis, const QCPAxis *valueAxis, int begin, int end, const QRect &rect);
+  
+protected:
+  const QCPDataContainer *mData;
+  const QCPAxis *mKeyAxis, *mValueAxis;
+  int mBegin, mEnd;
+  QRect mRect;
+  QSemaphore *mFinished;
+  QVector<quint32> mCounts;
+};
+
 #endif // QCP_PLOTTABLE_GRAPH_H
@@ -104,3 +104,365 @@ void TestColorMap::cleanup()
 {
   delete mPlot;
 }
+
+void TestColorMap::parallelColorization()
+{
+  const int keySize = 600;
+  const int valueSize = 400;
+  QVector<double> data(keySize*valueSize);
+  for (int i=0; i<data.size(); ++i)
+    data[i] = qAbs(qSin(i*0.001)*(i%7))+(i%1000 == 0 ? qQNaN() : 0);
+  QCPColorGradient gradient(QCPColorGradient::gpJet);
+  
+  // the parallel colorization must produce the same image as colorizing one scanline after another,
+  // for all cell types, both orientations and scale types:
+  for (int type=QCPColorMapData::ctDouble; type<=QCPColorMapData::ctUInt16; ++type)
+  {
+    QCPColorMapData mapData(keySize, valueSize, QCPRange(0, 1), QCPRange(0, 1), (QCPColorMapData::CellType)type);
+    mapData.setBlock(0, 0, keySize, valueSize, data.constData());
+    QVector<double> storedData(keySize*valueSize); // the cells as stored in the cell type, converted back to double
+    for (int v=0; v<valueSize; ++v)
+      for (int k=0; k<keySize; ++k)
+        storedData[v*keySize+k] = mapData.cell(k, v);
+    for (int vertical=0; vertical<2; ++vertical)
+    {
+      for (int logarithmic=0; logarithmic<2; ++logarithmic)
+      {
+        const QCPRange range = logarithmic ? QCPRange(0.01, 6) : QCPRange(-1, 5);
+        const int lineCount = vertical ? keySize : valueSize;
+        const int rowCount = vertical ? valueSize : keySize;
+        const int dataLineStep = vertical ? 1 : keySize;
+        const int dataIndexFactor = vertical ? keySize : 1;
+        QImage expected(rowCount, lineCount, QImage::Format_RGB32);
+        for (int line=0; line<lineCount; ++line)
+          gradient.colorize(storedData.constData()+line*dataLineStep, range, reinterpret_cast<QRgb*>(expected.scanLine(lineCount-1-line)), rowCount, dataIndexFactor, logarithmic);
+        QImage result(rowCount, lineCount, QImage::Format_RGB32);
+        QCPColorMapColorizer::colorize(gradient, range, logarithmic, &mapData, dataLineStep, dataIndexFactor, &result, lineCount, rowCount);
+        QCOMPARE(result, expected);
+      }
+    }
+  }
+  
+  // the rendered color map must not depend on the number of threads:
+  mColorMap->data()->setSize(keySize, valueSize);
+  mColorMap->data()->setRange(QCPRange(0, 10), QCPRange(0, 10));
+  for (int k=0; k<keySize; ++k)
+    for (int v=0; v<valueSize; ++v)
+      mColorMap->data()->setCell(k, v, data.at(v*keySize+k));
+  mColorMap->setGradient(gradient);
+  mColorMap->rescaleDataRange(true);
+  mPlot->rescaleAxes();
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount(1);
+  const QImage serialImage = mPlot->toPixmap(400, 300).toImage();
+  QThreadPool::globalInstance()->setMaxThreadCount(qMax(4, maxThreadCount));
+  mColorMap->setInterpolate(mColorMap->interpolate()); // invalidates the map image, so it is colorized again
+  const QImage parallelImage = mPlot->toPixmap(400, 300).toImage();
+  QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+  QCOMPARE(parallelImage, serialImage);
+}
+
+void TestColorMap::dirtyCellUpdates()
+{
+  // for both orientations, recolorizing only modified cells must give the same result as recolorizing all cells:
+  mPlot->clearPlottables();
+  for (int vertical=0; vertical<2; ++vertical)
+  {
+    QCPColorMap *colorMap = vertical ? new QCPColorMap(mPlot->yAxis, mPlot->xAxis) : new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+    mPlot->addPlottable(colorMap);
+    colorMap->data()->setSize(300, 250); // large enough to not be oversampled
+    colorMap->data()->setRange(QCPRange(0, 10), QCPRange(0, 10));
+    for (int k=0; k<300; ++k)
+      for (int v=0; v<250; ++v)
+        colorMap->data()->setCell(k, v, qSin(k/20.0)*qCos(v/30.0));
+    colorMap->setDataRange(QCPRange(-1, 1));
+    mPlot->rescaleAxes();
+    mPlot->replot();
+    
+    qsrand(1);
+    for (int frame=0; frame<3; ++frame)
+    {
+      // scattered cells, a row span, a column span and (in the last frame) too many cells to track:
+      for (int i=0; i<200; ++i)
+        colorMap->data()->setCell(qrand()%300, qrand()%250, qrand()/(double)RAND_MAX*2-1);
+      for (int k=50; k<150; ++k)
+        colorMap->data()->setCell(k, 100+frame, -1);
+      for (int v=20; v<80; ++v)
+        colorMap->data()->setCell(200+frame, v, 1);
+      colorMap->data()->setData(5, 5, 0.5);
+      if (frame == 2)
+      {
+        for (int i=0; i<30000; ++i)
+          colorMap->data()->setCell(qrand()%300, qrand()%250, 0);
+      }
+      const QImage incremental = mPlot->toPixmap(400, 300).toImage();
+      colorMap->setInterpolate(colorMap->interpolate()); // invalidates the map image, so all cells are colorized
+      const QImage full = mPlot->toPixmap(400, 300).toImage();
+      QCOMPARE(incremental, full);
+    }
+    mPlot->clearPlottables();
+  }
+}
+
+void TestColorMap::appendRow()
+{
+  // appended rows move the existing rows down by one value index:
+  QCPColorMapData data(3, 4, QCPRange(0, 2), QCPRange(0, 3));
+  for (int k=0; k<3; ++k)
+    for (int v=0; v<4; ++v)
+      data.setCell(k, v, v*10+k);
+  const double newRow[3] = {40, 41, 42};
+  data.appendRow(newRow);
+  for (int k=0; k<3; ++k)
+    for (int v=0; v<4; ++v)
+      QCOMPARE(data.cell(k, v), (v+1)*10.0+k);
+  QCOMPARE(data.dataBounds(), QCPRange(0, 42));
+  data.setCell(1, 0, -5);
+  QCOMPARE(data.cell(1, 0), -5.0);
+  QCOMPARE(data.data(1, 0), -5.0);
+  QCPColorMapData copy(data);
+  QCOMPARE(copy.cell(1, 0), -5.0);
+  QCOMPARE(copy.cell(2, 3), 42.0);
+  
+  // a color map with appended rows must look like one with the same cells set directly, for all orientations and range directions:
+  mPlot->clearPlottables();
+  const int keySize = 300;
+  const int valueSize = 250;
+  QVector<double> row(keySize);
+  for (int config=0; config<4; ++config)
+  {
+    const bool vertical = config & 1;
+    const bool reversed = config & 2;
+    mPlot->xAxis->setRangeReversed(reversed);
+    mPlot->yAxis->setRangeReversed(reversed);
+    QCPColorMap *appendedMap = vertical ? new QCPColorMap(mPlot->yAxis, mPlot->xAxis) : new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+    QCPColorMap *directMap = vertical ? new QCPColorMap(mPlot->yAxis, mPlot->xAxis) : new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+    mPlot->addPlottable(appendedMap);
+    mPlot->addPlottable(directMap);
+    appendedMap->data()->setSize(keySize, valueSize);
+    appendedMap->data()->setRange(QCPRange(0, 10), QCPRange(0, 10));
+    appendedMap->setInterpolate(false);
+    appendedMap->setDataRange(QCPRange(-1, 1));
+    directMap->setInterpolate(false);
+    directMap->setDataRange(QCPRange(-1, 1));
+    mPlot->rescaleAxes();
+    directMap->setVisible(false);
+    mPlot->replot();
+    for (int i=0; i<valueSize+100; ++i) // wraps around the ring buffer
+    {
+      for (int k=0; k<keySize; ++k)
+        row[k] = qSin(k/20.0+i/10.0);
+      appendedMap->data()->appendRow(row.constData());
+      if (i%37 == 0)
+        mPlot->replot();
+    }
+    directMap->data()->setSize(keySize, valueSize);
+    directMap->data()->setRange(QCPRange(0, 10), QCPRange(0, 10));
+    for (int k=0; k<keySize; ++k)
+      for (int v=0; v<valueSize; ++v)
+        directMap->data()->setCell(k, v, appendedMap->data()->cell(k, v));
+    QCOMPARE(directMap->data()->cell(10, valueSize-1), qSin(10/20.0+(valueSize+99)/10.0));
+    
+    const QImage appendedImage = mPlot->toPixmap(400, 300).toImage();
+    appendedMap->setVisible(false);
+    directMap->setVisible(true);
+    const QImage directImage = mPlot->toPixmap(400, 300).toImage();
+    // the two parts of the ring buffer are scaled separately, so pixels at the seam may differ:
+    int differingPixels = 0;
+    for (int y=0; y<directImage.height(); ++y)
+      for (int x=0; x<directImage.width(); ++x)
+        if (appendedImage.pixel(x, y) != directImage.pixel(x, y))
+          ++differingPixels;
+    QVERIFY(differingPixels <= 2*qMax(directImage.width(), directImage.height()));
+    mPlot->clearPlottables();
+  }
+  mPlot->xAxis->setRangeReversed(false);
+  mPlot->yAxis->setRangeReversed(false);
+}
+
+void TestColorMap::levelOfDetail()
+{
+  mPlot->clearPlottables();
+  QCPColorMap *colorMap = new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(colorMap);
+  const int keySize = 2000;
+  const int valueSize = 1500;
+  colorMap->data()->setSize(keySize, valueSize);
+  colorMap->data()->setRange(QCPRange(0, keySize-1), QCPRange(0, valueSize-1));
+  colorMap->data()->setCell(1234, 567, 1); // single peak on a zero background
+  colorMap->setGradient(QCPColorGradient::gpGrayscale);
+  colorMap->setDataRange(QCPRange(0, 1));
+  colorMap->setInterpolate(false);
+  mPlot->rescaleAxes();
+  
+  // reduced with the maximum, the peak stays visible at full intensity, reduced with the mean, it fades:
+  colorMap->setLodReduction(QCPColorMap::lrMaximum);
+  QCOMPARE(colorMap->lodReduction(), QCPColorMap::lrMaximum);
+  QImage image = mPlot->toPixmap(400, 300).toImage();
+  bool foundPeak = false;
+  for (int y=0; y<image.height() && !foundPeak; ++y)
+    for (int x=0; x<image.width() && !foundPeak; ++x)
+      foundPeak = image.pixel(x, y) == qRgb(255, 255, 255);
+  QVERIFY(foundPeak);
+  colorMap->setLodReduction(QCPColorMap::lrMean);
+  image = mPlot->toPixmap(400, 300).toImage();
+  int maxGray = 0;
+  for (int y=0; y<image.height(); ++y)
+    for (int x=0; x<image.width(); ++x)
+      maxGray = qMax(maxGray, qGray(image.pixel(x, y)));
+  QVERIFY(maxGray > 0);
+  QVERIFY(maxGray < 255);
+  
+  // modified cells only update the affected tiles, the result must equal a complete rebuild:
+  for (int k=0; k<keySize; k+=3)
+    colorMap->data()->setCell(k, 1000+k%200, 0.8);
+  colorMap->data()->setCell(0, 0, 0.5);
+  const QImage incremental = mPlot->toPixmap(400, 300).toImage();
+  colorMap->setLodReduction(QCPColorMap::lrNone);
+  colorMap->setLodReduction(QCPColorMap::lrMean);
+  QCOMPARE(mPlot->toPixmap(400, 300).toImage(), incremental);
+  
+  // zoomed in, the full resolution cells are drawn in tiles and must look like the undivided map image:
+  mPlot->xAxis->setRange(200, 400);
+  mPlot->yAxis->setRange(950, 1100);
+  const QImage tiles = mPlot->toPixmap(400, 300).toImage();
+  colorMap->setLodReduction(QCPColorMap::lrNone);
+  const QImage mapImage = mPlot->toPixmap(400, 300).toImage();
+  // tiles are scaled separately, so pixels at tile borders may differ:
+  int differingPixels = 0;
+  for (int y=0; y<mapImage.height(); ++y)
+    for (int x=0; x<mapImage.width(); ++x)
+      if (tiles.pixel(x, y) != mapImage.pixel(x, y))
+        ++differingPixels;
+  QVERIFY(differingPixels <= 2*qMax(mapImage.width(), mapImage.height()));
+}
+
+void TestColorMap::bulkSetters()
+{
+  QCPColorMapData data(4, 3, QCPRange(0, 3), QCPRange(0, 2));
+  const double row[4] = {1, 2, 3, 4};
+  data.setRow(1, row);
+  for (int k=0; k<4; ++k)
+    QCOMPARE(data.cell(k, 1), row[k]);
+  QCOMPARE(data.cell(0, 0), 0.0);
+  QCOMPARE(data.dataBounds(), QCPRange(0, 4));
+  
+  const float column[3] = {-1, -2, -3};
+  data.setColumn(2, column);
+  for (int v=0; v<3; ++v)
+    QCOMPARE(data.cell(2, v), (double)column[v]);
+  QCOMPARE(data.dataBounds(), QCPRange(-3, 4));
+  
+  const quint16 block[4] = {10, 11, 12, 13}; // two rows of two cells
+  data.setBlock(1, 1, 2, 2, block);
+  QCOMPARE(data.cell(1, 1), 10.0);
+  QCOMPARE(data.cell(2, 1), 11.0);
+  QCOMPARE(data.cell(1, 2), 12.0);
+  QCOMPARE(data.cell(2, 2), 13.0);
+  QCOMPARE(data.cell(0, 1), 1.0);
+  QCOMPARE(data.cell(3, 1), 4.0);
+  
+  // blocks exceeding the map are rejected:
+  data.setBlock(3, 0, 2, 1, row);
+  QCOMPARE(data.cell(3, 0), 0.0);
+  
+  // rows set with the bulk setters respect the ring buffer of appendRow:
+  data.appendRow(row);
+  data.setRow(0, block);
+  QCOMPARE(data.cell(1, 0), 11.0);
+  QCOMPARE(data.cell(3, 2), 4.0);
+  
+  // a color map filled with bulk setters looks like one filled cell by cell:
+  mPlot->clearPlottables();
+  QCPColorMap *bulkMap = new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+  QCPColorMap *cellMap = new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(bulkMap);
+  mPlot->addPlottable(cellMap);
+  const int keySize = 300;
+  const int valueSize = 250;
+  QVector<double> values(keySize*valueSize);
+  for (int v=0; v<valueSize; ++v)
+    for (int k=0; k<keySize; ++k)
+      values[v*keySize+k] = qSin(k/20.0)*qCos(v/30.0);
+  bulkMap->data()->setSize(keySize, valueSize);
+  cellMap->data()->setSize(keySize, valueSize);
+  bulkMap->data()->setBlock(0, 0, keySize, valueSize, values.constData());
+  for (int v=0; v<valueSize; ++v)
+    for (int k=0; k<keySize; ++k)
+      cellMap->data()->setCell(k, v, values.at(v*keySize+k));
+  QCOMPARE(bulkMap->data()->dataBounds(), cellMap->data()->dataBounds());
+  bulkMap->rescaleDataRange();
+  cellMap->rescaleDataRange();
+  mPlot->rescaleAxes();
+  cellMap->setVisible(false);
+  const QImage bulkImage = mPlot->toPixmap(400, 300).toImage();
+  cellMap->setVisible(true);
+  bulkMap->setVisible(false);
+  QCOMPARE(mPlot->toPixmap(400, 300).toImage(), bulkImage);
+}
+
+void TestColorMap::cellTypes()
+{
+  // values are converted to the cell type:
+  QCPColorMapData data(3, 2, QCPRange(0, 2), QCPRange(0, 1), QCPColorMapData::ctUInt16);
+  QCOMPARE(data.cellType(), QCPColorMapData::ctUInt16);
+  data.setCell(0, 0, 2.6);
+  data.setCell(1, 0, -5);
+  data.setCell(2, 0, 70000);
+  QCOMPARE(data.cell(0, 0), 3.0);
+  QCOMPARE(data.cell(1, 0), 0.0);
+  QCOMPARE(data.cell(2, 0), 65535.0);
+  QCOMPARE(data.dataBounds(), QCPRange(0, 65535));
+  const quint16 row[3] = {7, 65535, 1000};
+  data.setRow(1, row);
+  QCOMPARE(data.cell(1, 1), 65535.0);
+  data.fill(12.4);
+  QCOMPARE(data.cell(2, 1), 12.0);
+  QCOMPARE(data.dataBounds(), QCPRange(12, 12));
+  
+  // changing the cell type converts the present cells:
+  data.setCell(1, 1, 300);
+  data.setCellType(QCPColorMapData::ctFloat);
+  QCOMPARE(data.cellType(), QCPColorMapData::ctFloat);
+  QCOMPARE(data.cell(1, 1), 300.0);
+  QCOMPARE(data.cell(0, 0), 12.0);
+  data.setCell(0, 1, 0.5);
+  QCOMPARE(data.cell(0, 1), 0.5);
+  QCPColorMapData copy(data);
+  QCOMPARE(copy.cellType(), QCPColorMapData::ctFloat);
+  QCOMPARE(copy.cell(0, 1), 0.5);
+  data.setCellType(QCPColorMapData::ctDouble);
+  QCOMPARE(data.cell(1, 1), 300.0);
+  
+  // maps with integer data must look the same for all cell types, for full, incremental and level of detail updates:
+  mPlot->clearPlottables();
+  const int keySize = 300;
+  const int valueSize = 250;
+  QVector<quint16> values(keySize*valueSize);
+  for (int v=0; v<valueSize; ++v)
+    for (int k=0; k<keySize; ++k)
+      values[v*keySize+k] = (k*v)%1000;
+  QList<QImage> images[2];
+  for (int lod=0; lod<2; ++lod)
+  {
+    for (int type=QCPColorMapData::ctDouble; type<=QCPColorMapData::ctUInt16; ++type)
+    {
+      QCPColorMap *colorMap = new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+      mPlot->addPlottable(colorMap);
+      colorMap->setLodReduction(lod ? QCPColorMap::lrMean : QCPColorMap::lrNone);
+      colorMap->data()->setCellType((QCPColorMapData::CellType)type);
+      colorMap->data()->setSize(keySize, valueSize);
+      colorMap->data()->setBlock(0, 0, keySize, valueSize, values.constData());
+      colorMap->setDataRange(QCPRange(0, 1000));
+      mPlot->rescaleAxes();
+      mPlot->replot();
+      for (int k=0; k<keySize; k+=7)
+        colorMap->data()->setCell(k, 100, 500);
+      images[lod].append(mPlot->toPixmap(400, 300).toImage());
+      mPlot->clearPlottables();
+    }
+    QCOMPARE(images[lod].at(1), images[lod].at(0));
+    QCOMPARE(images[lod].at(2), images[lod].at(0));
+  }
+}
+
@@ -9,6 +9,12 @@ private slots:
   void cleanup();
   
   void QCPColorScale_rescaleDataRange();
+  void parallelColorization();
+  void dirtyCellUpdates();
+  void appendRow();
+  void levelOfDetail();
+  void bulkSetters();
+  void cellTypes();
   
 private:
   QCustomPlot *mPlot;
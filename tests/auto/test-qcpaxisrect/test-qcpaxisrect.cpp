@@ -195,15 +195,47 @@ void TestQCPAxisRect::axisRectRemovalConsequencesToItems()
   mPlot->replot();
 }
 
-
-
-
-
-
-
-
-
-
-
-
-
+void TestQCPAxisRect::batchCoordToPixel()
+{
+  mPlot->setGeometry(50, 50, 500, 400);
+  mPlot->replot();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  const QVector<double> values = QVector<double>() << -1e6 << -1000 << -3 << -0.5 << 0 << 1e-5 << 0.1 << 0.25 << 1 << 7 << 42 << 1000 << 5e4 << nan << inf << -inf;
+  const QVector<QCPRange> linearRanges = QVector<QCPRange>() << QCPRange(-3, 7) << QCPRange(0.1, 1000);
+  const QVector<QCPRange> logRanges = QVector<QCPRange>() << QCPRange(0.1, 1000) << QCPRange(-1000, -0.1);
+  
+  QList<QCPAxis*> axes = QList<QCPAxis*>() << mPlot->xAxis << mPlot->yAxis;
+  foreach (QCPAxis *axis, axes)
+  {
+    for (int scale=0; scale<2; ++scale)
+    {
+      axis->setScaleType(scale == 0 ? QCPAxis::stLinear : QCPAxis::stLogarithmic);
+      foreach (const QCPRange &range, scale == 0 ? linearRanges : logRanges)
+      {
+        axis->setRange(range);
+        for (int reversed=0; reversed<2; ++reversed)
+        {
+          axis->setRangeReversed(reversed == 1);
+          QVector<double> pixels(values.size());
+          axis->coordToPixel(values.constData(), pixels.data(), values.size());
+          for (int i=0; i<values.size(); ++i)
+          {
+            const double expected = axis->coordToPixel(values.at(i));
+            if (qIsNaN(expected))
+              QVERIFY(qIsNaN(pixels.at(i)));
+            else if (qIsInf(expected))
+              QVERIFY(pixels.at(i) == expected);
+            else
+              QVERIFY(qAbs(pixels.at(i)-expected) < 1e-9*qMax(1.0, qAbs(expected)));
+          }
+          // transformation in place:
+          QVector<double> inPlace = values;
+          axis->coordToPixel(inPlace.constData(), inPlace.data(), inPlace.size());
+          for (int i=0; i<values.size(); ++i)
+            QVERIFY(inPlace.at(i) == pixels.at(i) || (qIsNaN(inPlace.at(i)) && qIsNaN(pixels.at(i))));
+        }
+      }
+    }
+  }
+}
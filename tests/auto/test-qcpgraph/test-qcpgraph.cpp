@@ -1,5 +1,6 @@
 #include "test-qcpgraph.h"
 #include <QMainWindow>
+#include <QTemporaryFile>
 
 void TestQCPGraph::init()
 {
@@ -152,6 +153,473 @@ void TestQCPGraph::dataManipulation()
   QCOMPARE((mGraph->data()->begin()+6).value().value, 6.0);
 }
 
+void TestQCPGraph::mapIterators()
+{
+  QVector<double> x, y;
+  x << 0 << 1 << 2 << 3;
+  y << 0 << 10 << 20 << 30;
+  mGraph->setData(x, y);
+  
+  // read-only iteration forward and backward:
+  QCPDataMapIterator it(*mGraph->data());
+  QVector<double> keys;
+  while (it.hasNext())
+  {
+    it.next();
+    QCOMPARE(it.value().key, it.key());
+    keys << it.key();
+  }
+  QCOMPARE(keys, x);
+  QVERIFY(it.hasPrevious());
+  QCOMPARE(it.previous().key(), 3.0);
+  QCOMPARE(it.peekPrevious().key(), 2.0);
+  it.toFront();
+  QVERIFY(!it.hasPrevious());
+  QCOMPARE(it.peekNext().value().value, 0.0);
+  
+  // modification in place, the key is kept:
+  QCPDataMutableMapIterator mit(*mGraph->data());
+  while (mit.hasNext())
+  {
+    QCPData data = mit.next().value();
+    if (data.key == 1)
+      mit.remove();
+    else
+      mit.setValue(QCPData(data.key+100, data.value+1));
+  }
+  QCOMPARE(mGraph->data()->size(), 3);
+  QCOMPARE(mGraph->data()->keyAt(0), 0.0);
+  QCOMPARE(mGraph->data()->keyAt(1), 2.0);
+  QCOMPARE(mGraph->data()->keyAt(2), 3.0);
+  QCOMPARE(mGraph->data()->valueAt(0), 1.0);
+  QCOMPARE(mGraph->data()->valueAt(1), 21.0);
+  QCOMPARE(mGraph->data()->valueAt(2), 31.0);
+  
+  // removal while iterating backward:
+  mit.toBack();
+  mit.previous();
+  mit.remove();
+  QCOMPARE(mGraph->data()->size(), 2);
+  QVERIFY(mit.hasPrevious());
+  QCOMPARE(mit.previous().key(), 2.0);
+  
+  // replacing values updates the value range:
+  mGraph->data()->replace(0, QCPData(0, -5));
+  mPlot->rescaleAxes();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-5, 21));
+  
+  // QMap style modification via the non-const iterators, the key is kept:
+  QCPDataMap::iterator mutableIt = mGraph->data()->lowerBound(1);
+  QCOMPARE(mutableIt.key(), 2.0);
+  mutableIt.value().value = 50;
+  (*mutableIt).valueErrorPlus = 2;
+  mutableIt.value().key = 100;
+  QCOMPARE(mGraph->data()->keyAt(1), 2.0);
+  QCOMPARE(mGraph->data()->valueAt(1), 50.0);
+  QCOMPARE(mGraph->data()->valueErrorPlusAt(1), 2.0);
+  for (mutableIt = mGraph->data()->begin(); mutableIt != mGraph->data()->end(); ++mutableIt)
+    mutableIt.value().value *= 2;
+  QCOMPARE(mGraph->data()->valueAt(0), -10.0);
+  QCOMPARE(mGraph->data()->valueAt(1), 100.0);
+  
+  // copies of a reference don't write back stale data:
+  {
+    QCPDataContainer::reference first = *mGraph->data()->begin();
+    QCPDataContainer::reference second = first;
+    first.value = 7;
+  }
+  QCOMPARE(mGraph->data()->valueAt(0), 7.0);
+  
+  // single values, the value range follows the modifications:
+  mGraph->data()->setValueAt(1, -20);
+  mPlot->rescaleAxes();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-20, 7));
+  mutableIt = mGraph->data()->erase(mGraph->data()->begin());
+  QCOMPARE(mutableIt.key(), 2.0);
+  QCOMPARE(mGraph->data()->size(), 1);
+}
+
+void TestQCPGraph::streamingCapacity()
+{
+  QCOMPARE(mGraph->streamingCapacity(), 0);
+  mGraph->setStreamingCapacity(4);
+  QCOMPARE(mGraph->streamingCapacity(), 4);
+  
+  // appending beyond capacity evicts the data points with lowest keys:
+  for (int i=0; i<10; ++i)
+    mGraph->addData(i, i*10);
+  QCOMPARE(mGraph->data()->size(), 4);
+  for (int i=0; i<4; ++i)
+  {
+    QCOMPARE(mGraph->data()->keyAt(i), 6.0+i);
+    QCOMPARE(mGraph->data()->valueAt(i), 60.0+i*10);
+  }
+  
+  // inserting in the middle evicts lowest key, inserting below all keys is dropped:
+  mGraph->addData(7.5, 75);
+  QCOMPARE(mGraph->data()->size(), 4);
+  QCOMPARE(mGraph->data()->firstKey(), 7.0);
+  QCOMPARE(mGraph->data()->keyAt(1), 7.5);
+  mGraph->addData(1, 10);
+  QCOMPARE(mGraph->data()->size(), 4);
+  QCOMPARE(mGraph->data()->firstKey(), 7.0);
+  
+  // removal works on wrapped buffer:
+  mGraph->removeDataBefore(8);
+  QCOMPARE(mGraph->data()->size(), 2);
+  QCOMPARE(mGraph->data()->firstKey(), 8.0);
+  QCOMPARE(mGraph->data()->lastKey(), 9.0);
+  mGraph->addData(QVector<double>() << 10 << 11 << 12, QVector<double>() << 100 << 110 << 120);
+  QCOMPARE(mGraph->data()->size(), 4);
+  QCOMPARE(mGraph->data()->firstKey(), 9.0);
+  QCOMPARE(mGraph->data()->lastKey(), 12.0);
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  
+  // setting data keeps the highest keys:
+  mGraph->setData(QVector<double>() << 5 << 3 << 1 << 4 << 2 << 6, QVector<double>() << 5 << 3 << 1 << 4 << 2 << 6);
+  QCOMPARE(mGraph->data()->size(), 4);
+  QCOMPARE(mGraph->data()->firstKey(), 3.0);
+  QCOMPARE(mGraph->data()->lastKey(), 6.0);
+  
+  // an adopted container gets the storage settings of the graph:
+  mGraph->setSinglePrecisionValues(true);
+  QCPDataMap *adopted = new QCPDataMap;
+  for (int i=0; i<6; ++i)
+    adopted->add(QCPData(i, i+0.1));
+  mGraph->setData(adopted, false);
+  QCOMPARE(mGraph->data(), adopted);
+  QCOMPARE(mGraph->streamingCapacity(), 4);
+  QVERIFY(mGraph->data()->singlePrecisionValues());
+  QCOMPARE(mGraph->data()->size(), 4);
+  QCOMPARE(mGraph->data()->firstKey(), 2.0);
+  QCOMPARE(mGraph->data()->valueAt(0), double(float(2.1)));
+  mGraph->setSinglePrecisionValues(false);
+  
+  // disabling streaming mode lets data grow again:
+  mGraph->setStreamingCapacity(0);
+  mGraph->addData(7, 7);
+  QCOMPARE(mGraph->data()->size(), 5);
+}
+
+void TestQCPGraph::errorColumns()
+{
+  QVector<double> x, y, e;
+  x << 3 << 1 << 2;
+  y << 30 << 10 << 20;
+  e << 0.3 << 0.1 << 0.2;
+  
+  // plain data doesn't allocate error columns:
+  mGraph->setData(x, y);
+  QVERIFY(!mGraph->data()->hasKeyErrors());
+  QVERIFY(!mGraph->data()->hasValueErrors());
+  QCOMPARE(mGraph->data()->valueErrorPlusAt(0), 0.0);
+  
+  // errors are sorted along with the keys:
+  mGraph->setDataValueError(x, y, e);
+  QVERIFY(!mGraph->data()->hasKeyErrors());
+  QVERIFY(mGraph->data()->hasValueErrors());
+  QCOMPARE(mGraph->data()->keyAt(0), 1.0);
+  QCOMPARE(mGraph->data()->valueErrorMinusAt(0), 0.1);
+  QCOMPARE(mGraph->data()->valueErrorPlusAt(2), 0.3);
+  QCOMPARE(mGraph->data()->at(1).valueErrorPlus, 0.2);
+  QCOMPARE(mGraph->data()->at(1).keyErrorPlus, 0.0);
+  
+  // adding a point with key errors allocates key error columns, existing points have zero key errors:
+  QCPData point(4, 40);
+  point.keyErrorMinus = 0.5;
+  point.keyErrorPlus = 0.6;
+  mGraph->addData(point);
+  QVERIFY(mGraph->data()->hasKeyErrors());
+  QCOMPARE(mGraph->data()->keyErrorMinusAt(0), 0.0);
+  QCOMPARE(mGraph->data()->keyErrorPlusAt(3), 0.6);
+  QCOMPARE(mGraph->data()->valueErrorPlusAt(3), 0.0);
+  mGraph->rescaleKeyAxis();
+  QCOMPARE(mPlot->xAxis->range().lower, 1.0);
+  QCOMPARE(mPlot->xAxis->range().upper, 4.6);
+  
+  // replacing data without errors releases error columns:
+  mGraph->setData(x, y);
+  QVERIFY(!mGraph->data()->hasKeyErrors());
+  QVERIFY(!mGraph->data()->hasValueErrors());
+}
+
+void TestQCPGraph::singlePrecisionValues()
+{
+  QVector<double> x, y;
+  x << 1e9+1 << 1e9+2 << 1e9+3;
+  y << 0.1 << 0.2 << 0.3;
+  mGraph->setData(x, y);
+  QVERIFY(!mGraph->singlePrecisionValues());
+  QCOMPARE(mGraph->data()->valueAt(0), 0.1);
+  
+  // existing values are converted, keys keep double precision:
+  mGraph->setSinglePrecisionValues(true);
+  QVERIFY(mGraph->singlePrecisionValues());
+  QCOMPARE(mGraph->data()->size(), 3);
+  QCOMPARE(mGraph->data()->keyAt(1), 1e9+2);
+  QCOMPARE(mGraph->data()->valueAt(0), (double)0.1f);
+  QCOMPARE(mGraph->data()->at(2).value, (double)0.3f);
+  
+  // new data is stored with single precision as well:
+  mGraph->setData(x, y);
+  mGraph->addData(1e9+4, 0.4);
+  QCOMPARE(mGraph->data()->size(), 4);
+  QCOMPARE(mGraph->data()->keyAt(3), 1e9+4);
+  QCOMPARE(mGraph->data()->valueAt(3), (double)0.4f);
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  
+  mGraph->setSinglePrecisionValues(false);
+  QCOMPARE(mGraph->data()->valueAt(3), (double)0.4f);
+}
+
+void TestQCPGraph::externalData()
+{
+  double keys[] = {1, 2, 3, 4, 5};
+  double values[] = {10, 20, 30, 40, 50};
+  
+  mGraph->setExternalData(keys, values, 3);
+  QVERIFY(mGraph->data()->isExternal());
+  QCOMPARE(mGraph->data()->size(), 3);
+  QCOMPARE(mGraph->data()->valueAt(1), 20.0);
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  
+  // external modifications are visible after notification:
+  values[1] = 25;
+  mGraph->externalDataChanged(5);
+  QCOMPARE(mGraph->data()->size(), 5);
+  QCOMPARE(mGraph->data()->valueAt(1), 25.0);
+  QCOMPARE(mGraph->data()->lastKey(), 5.0);
+  
+  // modifying the graph data detaches it from the external arrays:
+  mGraph->addData(6, 60);
+  QVERIFY(!mGraph->data()->isExternal());
+  QCOMPARE(mGraph->data()->size(), 6);
+  values[1] = 0;
+  QCOMPARE(mGraph->data()->valueAt(1), 25.0);
+  
+  mGraph->setExternalData(keys, values, 5);
+  mGraph->setData(QVector<double>() << 1, QVector<double>() << 2);
+  QVERIFY(!mGraph->data()->isExternal());
+  QCOMPARE(mGraph->data()->size(), 1);
+}
+
+void TestQCPGraph::dataFile()
+{
+  QTemporaryFile tempFile;
+  QVERIFY(tempFile.open());
+  QVector<double> keys, values;
+  for (int i=0; i<1000; ++i)
+  {
+    keys << i*0.5;
+    values << qSin(i*0.1);
+  }
+  QVERIFY(QCPDataFile::write(tempFile.fileName(), keys, values));
+  
+  QCPDataFile file(tempFile.fileName());
+  QVERIFY(file.isOpen());
+  QCOMPARE(file.size(), qint64(1000));
+  QCOMPARE(file.keys()[999], 499.5);
+  QCOMPARE(file.values()[10], qSin(1.0));
+  
+  mGraph->setExternalData(file);
+  QVERIFY(mGraph->data()->isExternal());
+  QCOMPARE(mGraph->data()->size(), 1000);
+  QCOMPARE(mGraph->data()->findBegin(100), 200);
+  mPlot->rescaleAxes();
+  mPlot->xAxis->setRange(100, 110);
+  mPlot->replot();
+  mGraph->clearData();
+  file.close();
+  QVERIFY(!file.isOpen());
+  
+  // files with invalid header are rejected:
+  QFile invalidFile(tempFile.fileName());
+  QVERIFY(invalidFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  invalidFile.write(QByteArray(100, 'x'));
+  invalidFile.close();
+  QVERIFY(!file.open(tempFile.fileName()));
+  QVERIFY(!file.isOpen());
+}
+
+void TestQCPGraph::minMaxPyramid()
+{
+  QCPDataMap *data = mGraph->data();
+  int n = 10000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i;
+    y[i] = qSin(i/100.0);
+  }
+  y[4321] = 5; // outlier that must not be lost
+  mGraph->setData(x, y);
+  mGraph->setMinMaxPyramid(true);
+  QVERIFY(mGraph->minMaxPyramid());
+  
+  double minValue, maxValue;
+  QVERIFY(data->valueMinMax(0, n, minValue, maxValue));
+  QCOMPARE(maxValue, 5.0);
+  QVERIFY(data->valueMinMax(4000, 4321, minValue, maxValue));
+  QVERIFY(maxValue < 1.1);
+  QVERIFY(data->valueMinMax(4321, 4322, minValue, maxValue));
+  QCOMPARE(minValue, 5.0);
+  QVERIFY(!data->valueMinMax(10, 10, minValue, maxValue));
+  
+  // pyramid must give the same result as scanning, also after appending and removing in a circular buffer:
+  mGraph->setStreamingCapacity(3000);
+  for (int i=n; i<n+5000; ++i)
+  {
+    mGraph->addData(i, i == 12345 ? -7 : qCos(i/50.0));
+    if (i % 700 == 0)
+      mGraph->removeDataBefore(i-2500);
+    if (i % 300 == 0)
+    {
+      for (int begin=0; begin<data->size(); begin+=97)
+      {
+        int end = qMin(data->size(), begin+1500);
+        double scanMin = std::numeric_limits<double>::infinity();
+        double scanMax = -std::numeric_limits<double>::infinity();
+        for (int k=begin; k<end; ++k)
+        {
+          scanMin = qMin(scanMin, data->valueAt(k));
+          scanMax = qMax(scanMax, data->valueAt(k));
+        }
+        data->valueMinMax(begin, end, minValue, maxValue);
+        QCOMPARE(minValue, scanMin);
+        QCOMPARE(maxValue, scanMax);
+      }
+    }
+  }
+  QVERIFY(data->valueMinMax(0, data->size(), minValue, maxValue));
+  QCOMPARE(minValue, -7.0);
+  
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  mGraph->setMinMaxPyramid(false);
+  QVERIFY(!mGraph->minMaxPyramid());
+}
+
+void TestQCPGraph::rangeCache()
+{
+  QVector<double> x(100), y(100);
+  for (int i=0; i<100; ++i)
+  {
+    x[i] = i;
+    y[i] = i;
+  }
+  mGraph->setData(x, y);
+  mPlot->rescaleAxes();
+  QCOMPARE(mPlot->xAxis->range(), QCPRange(0, 99));
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(0, 99));
+  
+  // adding data extends the cached ranges:
+  mGraph->addData(150, -20);
+  mPlot->rescaleAxes();
+  QCOMPARE(mPlot->xAxis->range(), QCPRange(0, 150));
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-20, 99));
+  
+  // removing data invalidates them:
+  mGraph->removeDataBefore(50);
+  mGraph->removeDataAfter(120);
+  mPlot->rescaleAxes();
+  QCOMPARE(mPlot->xAxis->range(), QCPRange(50, 99));
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(50, 99));
+  
+  // direct modifications of the data container are detected:
+  mGraph->data()->add(QCPData(200, 500));
+  mPlot->rescaleAxes();
+  QCOMPARE(mPlot->xAxis->range(), QCPRange(50, 200));
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(50, 500));
+  mGraph->data()->remove(200);
+  mPlot->rescaleAxes();
+  QCOMPARE(mPlot->xAxis->range(), QCPRange(50, 99));
+  
+  // points evicted from a circular buffer don't remain in the ranges:
+  mGraph->setStreamingCapacity(10);
+  for (int i=0; i<20; ++i)
+    mGraph->addData(1000+i, -i);
+  mPlot->rescaleAxes();
+  QCOMPARE(mPlot->xAxis->range(), QCPRange(1010, 1019));
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-19, -10));
+  
+  // error bars are taken into account when rescaling:
+  QCPData errorPoint(1020, -5);
+  errorPoint.valueErrorPlus = 100;
+  mGraph->addData(errorPoint);
+  mPlot->rescaleAxes();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-19, 95));
+  
+  // evictions only shrink the cached ranges if the evicted data points defined them:
+  mGraph->clearData();
+  for (int i=0; i<100; ++i)
+  {
+    mGraph->addData(2000+i, (i*37)%23);
+    if (i%7 == 6)
+    {
+      QCPRange expected((i*37)%23, (i*37)%23);
+      for (int k=qMax(0, i-9); k<=i; ++k)
+        expected.expand((k*37)%23);
+      mPlot->rescaleAxes();
+      QCOMPARE(mPlot->xAxis->range(), QCPRange(2000+qMax(0, i-9), 2000+i));
+      QCOMPARE(mPlot->yAxis->range(), expected);
+    }
+  }
+}
+
+void TestQCPGraph::rescaleValueAxisInKeyRange()
+{
+  int n = 10000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i;
+    y[i] = i < n/2 ? i : -i;
+  }
+  mGraph->setData(x, y);
+  mGraph->setMinMaxPyramid(true);
+  
+  mPlot->xAxis->setRange(100, 1000);
+  mGraph->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(100, 1000));
+  
+  mPlot->xAxis->setRange(4000.5, 6000.5);
+  mGraph->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-6000, 4999));
+  
+  mGraph->rescaleValueAxisInKeyRange(true);
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-6000, 4999));
+  mPlot->xAxis->setRange(0, 10);
+  mGraph->rescaleValueAxisInKeyRange(true);
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-6000, 4999));
+  
+  // logarithmic value axis only takes the matching sign domain into account:
+  mPlot->yAxis->setScaleType(QCPAxis::stLogarithmic);
+  mPlot->yAxis->setRange(1, 10);
+  mPlot->xAxis->setRange(4000.5, 6000.5);
+  mGraph->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(4001, 4999));
+  mPlot->yAxis->setScaleType(QCPAxis::stLinear);
+  
+  // without the pyramid and with error bars the result is the same:
+  mGraph->setMinMaxPyramid(false);
+  mPlot->xAxis->setRange(100, 1000);
+  mGraph->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(100, 1000));
+  QCPData errorPoint(500.5, 0);
+  errorPoint.valueErrorPlus = 2000;
+  mGraph->addData(errorPoint);
+  mGraph->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(0, 2000));
+  
+  // no data in key range leaves the value axis unchanged:
+  mPlot->xAxis->setRange(-100, -10);
+  mGraph->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(0, 2000));
+}
+
 void TestQCPGraph::channelFill()
 {
   QCPGraph *otherGraph = mPlot->addGraph();
@@ -174,3 +642,379 @@ void TestQCPGraph::channelFill()
   mPlot->replot();
 }
 
+void TestQCPGraph::directLineRasterization()
+{
+  // polylines with long and sub-pixel segments, direction reversals, clipped parts and NaN gaps:
+  QVector<QPointF> points;
+  qsrand(1);
+  double x = 100, y = 75;
+  for (int i=0; i<2000; ++i)
+  {
+    const double step = i%3 == 0 ? 40.0 : (i%3 == 1 ? 3.0 : 0.3);
+    x += (qrand()/(double)RAND_MAX-0.5)*step;
+    y += (qrand()/(double)RAND_MAX-0.5)*step;
+    if (i%50 == 0)
+      x = -30; // leaves the image
+    if (i%100 == 7)
+      points.append(QPointF(x, qQNaN()));
+    else if (i%40 < 4)
+      points.append(QPointF(qRound(x)+0.5*(i%2), y)); // vertical segments like in adaptive sampling
+    else
+      points.append(QPointF(x, y));
+  }
+  
+  QList<QPen> pens;
+  pens << QPen(Qt::black, 0) << QPen(QColor(10, 20, 200), 1) << QPen(QBrush(Qt::red), 1, Qt::SolidLine, Qt::FlatCap);
+  QList<QRect> clipRects;
+  // the clip rect determines where long segments start to be walked, so small clip rects that many
+  // segments cross are the critical case:
+  clipRects << QRect() << QRect(20, 10, 150, 100) << QRect(83, 61, 31, 17);
+  foreach (const QPen &pen, pens)
+  {
+    foreach (const QRect &clipRect, clipRects)
+    {
+      QImage expected(200, 150, QImage::Format_ARGB32_Premultiplied);
+      expected.fill(0);
+      QImage actual = expected.copy();
+      
+      QPainter painter(&expected);
+      painter.setPen(pen);
+      painter.translate(3, -2);
+      if (!clipRect.isNull())
+        painter.setClipRect(clipRect);
+      int segmentStart = 0;
+      for (int i=0; i<=points.size(); ++i)
+      {
+        if (i == points.size() || qIsNaN(points.at(i).y()))
+        {
+          painter.drawPolyline(points.constData()+segmentStart, i-segmentStart);
+          segmentStart = i+1;
+        }
+      }
+      painter.end();
+      
+      QCPPainter qcpPainter(&actual);
+      qcpPainter.setPen(pen);
+      qcpPainter.translate(3, -2);
+      if (!clipRect.isNull())
+        qcpPainter.setClipRect(clipRect);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+      QVERIFY(qcpPainter.canRasterizePolylineDirectly(points.size()));
+#endif
+      qcpPainter.drawPolylineWithGaps(points.constData(), points.size());
+      qcpPainter.end();
+      
+      QCOMPARE(actual, expected);
+    }
+  }
+  
+  // other painter states fall back to QPainter:
+  QImage image(10, 10, QImage::Format_ARGB32_Premultiplied);
+  QCPPainter painter(&image);
+  painter.setPen(QPen(Qt::black, 2));
+  QVERIFY(!painter.canRasterizePolylineDirectly(10));
+  painter.setPen(QPen(Qt::black, 1, Qt::DashLine));
+  QVERIFY(!painter.canRasterizePolylineDirectly(10));
+  painter.setPen(QPen(QColor(0, 0, 0, 100), 1));
+  QVERIFY(!painter.canRasterizePolylineDirectly(10));
+  painter.setPen(QPen(Qt::black, 1));
+  painter.setAntialiasing(true);
+  QVERIFY(!painter.canRasterizePolylineDirectly(10));
+  painter.end();
+  QPixmap pixmap(10, 10);
+  painter.begin(&pixmap);
+  painter.setPen(QPen(Qt::black, 1));
+  QVERIFY(!painter.canRasterizePolylineDirectly(10));
+}
+
+void TestQCPGraph::scatterSprites()
+{
+  // sprites quantize positions, so they are opt-in:
+  QVERIFY(!mPlot->plottingHints().testFlag(QCP::phCacheScatters));
+  
+  // scatter positions on the quarter pixel grid of the sprites must look exactly like directly painted shapes:
+  QVector<QPointF> positions;
+  for (int i=0; i<16; ++i)
+    positions.append(QPointF(10+i*20+(i%4)*0.25, 15+(i/4)*0.25));
+  positions.append(QPointF(qQNaN(), 20));
+  positions.append(QPointF(-2.75, 40)); // partially outside of image
+  
+  QList<QCPScatterStyle> styles;
+  styles << QCPScatterStyle(QCPScatterStyle::ssCircle, 7)
+         << QCPScatterStyle(QCPScatterStyle::ssDisc, 5)
+         << QCPScatterStyle(QCPScatterStyle::ssCross, 6)
+         << QCPScatterStyle(QCPScatterStyle::ssStar, QPen(Qt::blue, 2), QBrush(Qt::NoBrush), 9)
+         << QCPScatterStyle(QCPScatterStyle::ssSquare, QPen(QColor(255, 0, 0, 120)), QBrush(QColor(0, 200, 0, 80)), 8);
+  foreach (const QCPScatterStyle &style, styles)
+  {
+    for (int antialiasing=0; antialiasing<2; ++antialiasing)
+    {
+      QImage expected(340, 60, QImage::Format_ARGB32_Premultiplied);
+      expected.fill(0);
+      QImage actual = expected.copy();
+      
+      QCPPainter directPainter(&expected);
+      directPainter.setAntialiasing(antialiasing);
+      style.applyTo(&directPainter, QPen(Qt::black));
+      style.drawShapes(&directPainter, positions, false);
+      style.drawShape(&directPainter, QPointF(60.5, 45.75));
+      directPainter.end();
+      
+      QCPPainter spritePainter(&actual);
+      spritePainter.setAntialiasing(antialiasing);
+      style.applyTo(&spritePainter, QPen(Qt::black));
+      style.drawShapes(&spritePainter, positions, true);
+      style.drawShapes(&spritePainter, QVector<QPointF>() << QPointF(60.5, 45.75), true); // reuses sprites of previous call
+      spritePainter.end();
+      
+      QCOMPARE(actual, expected);
+    }
+  }
+}
+
+void TestQCPGraph::densityScatters()
+{
+  mPlot->resize(400, 300);
+  mPlot->xAxis->setRange(0, 10);
+  mPlot->yAxis->setRange(0, 10);
+  mPlot->xAxis->grid()->setVisible(false);
+  mPlot->yAxis->grid()->setVisible(false);
+  mPlot->replot();
+  
+  // counts of chunks that are counted in parallel must add up to the counts of all points:
+  const int n = 1000000;
+  QVector<double> keys(n), values(n);
+  for (int i=0; i<n; ++i)
+  {
+    keys[i] = -1+i*12.0/n; // partially outside of the key range
+    values[i] = i%777 == 0 ? qQNaN() : (i%1013)/100.0;
+  }
+  mGraph->setData(keys, values);
+  const QRect rect = mPlot->axisRect()->rect();
+  QVector<quint32> expectedCounts(rect.width()*rect.height(), 0);
+  for (int i=0; i<n; ++i)
+  {
+    const double x = mPlot->xAxis->coordToPixel(keys.at(i))-rect.left();
+    const double y = mPlot->yAxis->coordToPixel(values.at(i))-rect.top();
+    if (x >= 0 && x < rect.width() && y >= 0 && y < rect.height())
+      ++expectedCounts[int(y)*rect.width()+int(x)];
+  }
+  QCOMPARE(QCPDensityBinner::binData(mGraph->data(), mPlot->xAxis, mPlot->yAxis, 0, n, rect), expectedCounts);
+  
+  // densest pixel gets the upper gradient color, single points the lower color, empty pixels stay transparent:
+  keys.clear();
+  values.clear();
+  for (int i=0; i<1000; ++i)
+  {
+    keys << 5;
+    values << 5;
+  }
+  keys << 2;
+  values << 2;
+  mGraph->setData(keys, values);
+  mGraph->setLineStyle(QCPGraph::lsNone);
+  mGraph->setScatterMode(QCPGraph::smDensity);
+  QCOMPARE(mGraph->scatterMode(), QCPGraph::smDensity);
+  QCPColorGradient gradient;
+  gradient.clearColorStops();
+  gradient.setColorStopAt(0, QColor(0, 0, 255));
+  gradient.setColorStopAt(1, QColor(255, 0, 0));
+  mGraph->setDensityGradient(gradient);
+  QList<QCPAxis::ScaleType> scaleTypes;
+  scaleTypes << QCPAxis::stLinear << QCPAxis::stLogarithmic;
+  foreach (QCPAxis::ScaleType scaleType, scaleTypes)
+  {
+    mGraph->setDensityScaleType(scaleType);
+    QCOMPARE(mGraph->densityScaleType(), scaleType);
+    const QImage image = mPlot->toPixmap(400, 300).toImage();
+    const QColor densest = image.pixel(qFloor(mPlot->xAxis->coordToPixel(5)), qFloor(mPlot->yAxis->coordToPixel(5)));
+    const QColor single = image.pixel(qFloor(mPlot->xAxis->coordToPixel(2)), qFloor(mPlot->yAxis->coordToPixel(2)));
+    const QColor empty = image.pixel(qFloor(mPlot->xAxis->coordToPixel(7.5)), qFloor(mPlot->yAxis->coordToPixel(7.5)));
+    QCOMPARE(densest, QColor(255, 0, 0));
+    QVERIFY(single.blue() > single.red());
+    QCOMPARE(empty, QColor(Qt::white));
+  }
+}
+
+void TestQCPGraph::samplingAlgorithms()
+{
+  mPlot->resize(400, 300);
+  mPlot->xAxis->setRange(0, 10);
+  mPlot->yAxis->setRange(-2, 2);
+  mPlot->xAxis->grid()->setVisible(false);
+  mPlot->yAxis->grid()->setVisible(false);
+  mPlot->replot();
+  QList<QCPGraph::SamplingAlgorithm> algorithms;
+  algorithms << QCPGraph::saMinMax << QCPGraph::saM4 << QCPGraph::saLttb;
+  
+  // less than two points per pixel aren't sampled, so there is no pixel error:
+  QVector<double> keys, values;
+  for (int i=0; i<100; ++i)
+  {
+    keys << i/10.0;
+    values << qSin(i/3.0);
+  }
+  mGraph->setData(keys, values);
+  foreach (QCPGraph::SamplingAlgorithm algorithm, algorithms)
+    QCOMPARE(mGraph->samplingPixelError(algorithm), 0.0);
+  
+  // noisy data with many points per pixel and a gap in the middle:
+  const int n = 100000;
+  keys.resize(n);
+  values.resize(n);
+  qsrand(1);
+  for (int i=0; i<n; ++i)
+  {
+    keys[i] = i*10.0/n;
+    values[i] = keys[i] > 4.8 && keys[i] < 5.2 ? qQNaN() : qSin(keys[i])+(qrand()/(double)RAND_MAX-0.5)*0.5;
+  }
+  mGraph->setData(keys, values);
+  mGraph->setSamplingAlgorithm(QCPGraph::saLttb);
+  foreach (QCPGraph::SamplingAlgorithm algorithm, algorithms)
+  {
+    const double error = mGraph->samplingPixelError(algorithm);
+    QVERIFY(error >= 0 && error <= 1);
+    if (algorithm == QCPGraph::saM4)
+      QVERIFY(error < 0.1); // M4 keeps the extremes and connections of each pixel column
+  }
+  QCOMPARE(mGraph->samplingAlgorithm(), QCPGraph::saLttb); // measuring doesn't change the settings
+  QCOMPARE(mGraph->adaptiveSampling(), true);
+  
+  // the gap must be preserved by the algorithms that keep real data points:
+  QList<QCPGraph::SamplingAlgorithm> realPointAlgorithms;
+  realPointAlgorithms << QCPGraph::saM4 << QCPGraph::saLttb;
+  foreach (QCPGraph::SamplingAlgorithm algorithm, realPointAlgorithms)
+  {
+    mGraph->setSamplingAlgorithm(algorithm);
+    const QImage image = mPlot->toPixmap(400, 300).toImage();
+    const int x = qFloor(mPlot->xAxis->coordToPixel(5));
+    const QRect rect = mPlot->axisRect()->rect();
+    for (int y=rect.top()+10; y<rect.bottom()-10; ++y) // leave out axis ticks
+      QCOMPARE(QColor(image.pixel(x, y)), QColor(Qt::white));
+  }
+}
+
+void TestQCPGraph::hitTestIndex()
+{
+  mPlot->resize(400, 300);
+  mPlot->xAxis->setRange(0, 10);
+  mPlot->yAxis->setRange(-2, 2);
+  mPlot->replot();
+  
+  QVector<double> keys, values;
+  for (int i=0; i<100; ++i)
+  {
+    keys << i/10.0;
+    values << (i == 50 ? qQNaN() : qSin(i/3.0));
+  }
+  mGraph->setData(keys, values);
+  
+  // compares the distances from selectTest to the distances to the graph's segments or points:
+  QList<QPointF> positions;
+  const QRect rect = mPlot->axisRect()->rect();
+  qsrand(1);
+  for (int i=0; i<200; ++i)
+    positions << QPointF(rect.left()+qrand()%rect.width(), rect.top()+qrand()%rect.height());
+  QList<QCPGraph::LineStyle> lineStyles;
+  lineStyles << QCPGraph::lsLine << QCPGraph::lsImpulse << QCPGraph::lsNone;
+  mGraph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, 5));
+  for (int pass=0; pass<3; ++pass)
+  {
+    if (pass == 1) // changing the data must update the geometry
+    {
+      for (int i=0; i<values.size(); ++i)
+        values[i] = qCos(i/5.0);
+      mGraph->setData(keys, values);
+    } else if (pass == 2) // changing the range must update the geometry
+      mPlot->yAxis->setRange(-1.5, 0.5);
+    foreach (QCPGraph::LineStyle lineStyle, lineStyles)
+    {
+      mGraph->setLineStyle(lineStyle);
+      if (pass != 1) // the geometry is also calculated without replot
+        mPlot->replot();
+      QVector<QPointF> pixels;
+      for (int i=0; i<keys.size(); ++i)
+        pixels << QPointF(mPlot->xAxis->coordToPixel(keys.at(i)), mPlot->yAxis->coordToPixel(values.at(i)));
+      foreach (const QPointF &pos, positions)
+      {
+        double minDistSqr = std::numeric_limits<double>::max();
+        for (int i=0; i<pixels.size(); ++i)
+        {
+          QPointF a = pixels.at(i);
+          QPointF b = a;
+          if (lineStyle == QCPGraph::lsLine && i+1 < pixels.size())
+            b = pixels.at(i+1);
+          else if (lineStyle == QCPGraph::lsImpulse)
+            b.setY(mPlot->yAxis->coordToPixel(0));
+          if (qIsNaN(a.y()) || qIsNaN(b.y()))
+            continue;
+          const QPointF v = b-a;
+          const double vLengthSqr = v.x()*v.x()+v.y()*v.y();
+          const double mu = vLengthSqr > 0 ? qBound(0.0, ((pos.x()-a.x())*v.x()+(pos.y()-a.y())*v.y())/vLengthSqr, 1.0) : 0;
+          const QPointF d = a+mu*v-pos;
+          minDistSqr = qMin(minDistSqr, d.x()*d.x()+d.y()*d.y());
+        }
+        QVERIFY(qAbs(mGraph->selectTest(pos, false)-qSqrt(minDistSqr)) < 1e-3);
+      }
+    }
+  }
+}
+
+void TestQCPGraph::nearestDataPoint()
+{
+  mPlot->resize(400, 300);
+  mPlot->xAxis->setRange(0, 10);
+  mPlot->yAxis->setRange(-2, 2);
+  mPlot->replot();
+  QCOMPARE(mGraph->nearestDataPoint(QPointF(100, 100)).isValid(), false);
+  
+  const int n = 20000;
+  QVector<double> keys(n), values(n);
+  qsrand(1);
+  for (int i=0; i<n; ++i)
+  {
+    keys[i] = i*12.0/n-1; // also outside of the visible key range
+    values[i] = i%1000 == 0 ? qQNaN() : qSin(keys[i])+(qrand()/(double)RAND_MAX-0.5);
+  }
+  mGraph->setData(keys, values);
+  
+  // compares the found data points to the data points found by examining all data points:
+  QList<QCPRange> keyWindows;
+  keyWindows << QCPRange(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()) << QCPRange(3, 4) << QCPRange(20, 30);
+  for (int pyramid=0; pyramid<2; ++pyramid)
+  {
+    mGraph->setMinMaxPyramid(pyramid == 1);
+    for (int i=0; i<100; ++i)
+    {
+      const QPointF pos(qrand()%500-50, qrand()%400-50);
+      foreach (const QCPRange &keyWindow, keyWindows)
+      {
+        int expectedIndex = -1;
+        double minDistSqr = std::numeric_limits<double>::max();
+        for (int k=0; k<n; ++k)
+        {
+          if (qIsNaN(values.at(k)) || keys.at(k) < keyWindow.lower || keys.at(k) > keyWindow.upper)
+            continue;
+          const double dx = mPlot->xAxis->coordToPixel(keys.at(k))-pos.x();
+          const double dy = mPlot->yAxis->coordToPixel(values.at(k))-pos.y();
+          if (dx*dx+dy*dy < minDistSqr)
+          {
+            minDistSqr = dx*dx+dy*dy;
+            expectedIndex = k;
+          }
+        }
+        const QCPDataPoint point = keyWindow.lower > -1e300 ? mGraph->nearestDataPoint(pos, keyWindow) : mGraph->nearestDataPoint(pos);
+        if (expectedIndex < 0)
+        {
+          QCOMPARE(point.isValid(), false);
+        } else
+        {
+          QVERIFY(point.isValid());
+          QVERIFY(qAbs(point.distance-qSqrt(minDistSqr)) < 1e-6);
+          QCOMPARE(point.key, keys.at(point.index));
+          QCOMPARE(point.value, values.at(point.index));
+        }
+      }
+    }
+  }
+}
@@ -10,7 +10,22 @@ private slots:
   
   void specializedGraphInterface();
   void dataManipulation();
+  void mapIterators();
+  void streamingCapacity();
+  void errorColumns();
+  void singlePrecisionValues();
+  void externalData();
+  void dataFile();
+  void minMaxPyramid();
+  void rangeCache();
+  void rescaleValueAxisInKeyRange();
   void channelFill();
+  void directLineRasterization();
+  void scatterSprites();
+  void densityScatters();
+  void samplingAlgorithms();
+  void hitTestIndex();
+  void nearestDataPoint();
   
 private:
   QCustomPlot *mPlot;
@@ -78,16 +78,366 @@ void TestQCustomPlot::rescaleAxes_MultipleFlatGraphs()
   QCOMPARE(mPlot->yAxis->range().upper, 2.0);
 }
 
+void TestQCustomPlot::rescaleAxes_DirectDataAccess()
+{
+  // modifications via the data pointer of QMap based plottables are announced with dataChanged:
+  QCPFinancial *financial = new QCPFinancial(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(financial);
+  financial->addData(1, 0, 2, -1, 1);
+  financial->addData(2, 1, 3, 0, 2);
+  financial->rescaleValueAxis();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-1, 3));
+  
+  financial->data()->insert(3, QCPFinancialData(3, 0, 10, -5, 0));
+  financial->dataChanged();
+  financial->rescaleValueAxis();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-5, 10));
+  financial->data()->remove(3);
+  financial->dataChanged();
+  financial->rescaleValueAxis();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-1, 3));
+  
+  // modifications via the plottable interface keep working in between:
+  financial->addData(4, 0, 5, 0, 0);
+  financial->rescaleValueAxis();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(-1, 5));
+  
+  QCPBars *bars = new QCPBars(mPlot->xAxis, mPlot->yAxis2);
+  mPlot->addPlottable(bars);
+  bars->addData(1, 4);
+  bars->rescaleValueAxis();
+  QCOMPARE(mPlot->yAxis2->range(), QCPRange(0, 4));
+  bars->data()->begin().value().value = 8;
+  bars->dataChanged();
+  bars->rescaleValueAxis();
+  QCOMPARE(mPlot->yAxis2->range(), QCPRange(0, 8));
+  
+  // QCPCurve detects modifications via the mutable iterators of its data container by itself:
+  QCPCurve *curve = new QCPCurve(mPlot->xAxis2, mPlot->yAxis2);
+  mPlot->addPlottable(curve);
+  curve->addData(0, 1, 2);
+  curve->addData(1, 3, 4);
+  curve->rescaleAxes();
+  QCOMPARE(mPlot->xAxis2->range(), QCPRange(1, 3));
+  curve->data()->begin().value().key = -1;
+  (*(curve->data()->begin()+1)).value = 8;
+  curve->data()->begin().value().t = 5; // ignored, t defines the order of the data points
+  curve->rescaleAxes();
+  QCOMPARE(mPlot->xAxis2->range(), QCPRange(-1, 3));
+  QCOMPARE(mPlot->yAxis2->range(), QCPRange(2, 8));
+  QCOMPARE(curve->data()->tAt(0), 0.0);
+  curve->data()->setValueAt(0, -4);
+  curve->rescaleValueAxis();
+  QCOMPARE(mPlot->yAxis2->range(), QCPRange(-4, 8));
+}
 
+void TestQCustomPlot::rescaleValueAxisInKeyRange()
+{
+  mPlot->xAxis->setRange(1.5, 3.5);
+  
+  QCPFinancial *financial = new QCPFinancial(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(financial);
+  financial->addData(1, 0, 20, -10, 1);
+  financial->addData(2, 1, 3, 0, 2);
+  financial->addData(3, 2, 4, 1, 3);
+  financial->addData(4, 3, 30, -20, 4);
+  financial->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(0, 4));
+  
+  QCPBars *bars = new QCPBars(mPlot->xAxis, mPlot->yAxis2);
+  mPlot->addPlottable(bars);
+  bars->addData(1, 10);
+  bars->addData(2, 3);
+  bars->addData(3, -2);
+  bars->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis2->range(), QCPRange(-2, 3));
+  
+  QCPCurve *curve = new QCPCurve(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(curve);
+  curve->addData(0, 3, 5);
+  curve->addData(1, 2, 1);
+  curve->addData(2, 10, 100);
+  curve->addData(3, 3, 2);
+  curve->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(1, 5));
+  
+  // plottables without data points inside the key range leave the value axis untouched:
+  mPlot->xAxis->setRange(50, 60);
+  curve->rescaleValueAxisInKeyRange();
+  QCOMPARE(mPlot->yAxis->range(), QCPRange(1, 5));
+}
 
+void TestQCustomPlot::layerReplot()
+{
+  mPlot->setGeometry(50, 50, 500, 500);
+  mPlot->addGraph();
+  mPlot->graph(0)->setData(QVector<double>()<<1<<2<<3, QVector<double>()<<1<<4<<9);
+  mPlot->rescaleAxes();
+  QVERIFY(mPlot->addLayer(QLatin1String("cursor")));
+  QCPLayer *cursorLayer = mPlot->layer(QLatin1String("cursor"));
+  QCOMPARE(cursorLayer->mode(), QCPLayer::lmLogical);
+  QCPItemStraightLine *cursor = new QCPItemStraightLine(mPlot);
+  mPlot->addItem(cursor);
+  QVERIFY(cursor->setLayer(cursorLayer));
+  cursor->point1->setCoords(2, 0);
+  cursor->point2->setCoords(2, 1);
+  
+  QSignalSpy spy(mPlot, SIGNAL(beforeReplot()));
+  // a logical layer can't be replotted individually, so the whole plot is replotted:
+  cursorLayer->replot();
+  QCOMPARE(spy.count(), 1);
+  // paint buffer of a newly buffered layer is only set up by the next full replot:
+  cursorLayer->setMode(QCPLayer::lmBuffered);
+  QCOMPARE(cursorLayer->mode(), QCPLayer::lmBuffered);
+  cursorLayer->replot();
+  QCOMPARE(spy.count(), 2);
+  // afterwards, the buffered layer is replotted on its own:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) // QWidget::grab
+  const QImage before = mPlot->grab().toImage();
+#endif
+  const int oldCursorX = qRound(mPlot->xAxis->coordToPixel(2));
+  const int newCursorX = qRound(mPlot->xAxis->coordToPixel(2.5));
+  cursor->point1->setCoords(2.5, 0);
+  cursor->point2->setCoords(2.5, 1);
+  cursorLayer->replot();
+  QCOMPARE(spy.count(), 2);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+  // only the pixels of the cursor changed, the other layers kept their pixels:
+  const QImage after = mPlot->grab().toImage();
+  QCOMPARE(after.size(), before.size());
+  bool cursorChanged = false;
+  for (int y=0; y<after.height(); ++y)
+  {
+    for (int x=0; x<after.width(); ++x)
+    {
+      if (qAbs(x-oldCursorX) <= 2 || qAbs(x-newCursorX) <= 2)
+        cursorChanged |= after.pixel(x, y) != before.pixel(x, y);
+      else
+        QCOMPARE(after.pixel(x, y), before.pixel(x, y));
+    }
+  }
+  QVERIFY(cursorChanged);
+#else
+  Q_UNUSED(oldCursorX)
+  Q_UNUSED(newCursorX)
+#endif
+  mPlot->replot();
+  QCOMPARE(spy.count(), 3);
+  
+  // changing the layer order invalidates the paint buffer assignment until the next full replot:
+  QVERIFY(mPlot->moveLayer(cursorLayer, mPlot->layer(QLatin1String("main")), QCustomPlot::limBelow));
+  cursorLayer->replot();
+  QCOMPARE(spy.count(), 4);
+  cursorLayer->replot();
+  QCOMPARE(spy.count(), 4);
+  
+  cursorLayer->setMode(QCPLayer::lmLogical);
+  cursorLayer->replot();
+  QCOMPARE(spy.count(), 5);
+}
 
+void TestQCustomPlot::queuedReplot()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) // QSignalSpy::wait
+  QSignalSpy spy(mPlot, SIGNAL(beforeReplot()));
+  mPlot->resetReplotCounts();
+  
+  // queued replot requests are merged into one replot in the next event loop iteration:
+  for (int i=0; i<10; ++i)
+    mPlot->replot(QCustomPlot::rpQueuedReplot);
+  QCOMPARE(spy.count(), 0);
+  QVERIFY(spy.wait(1000));
+  QCOMPARE(spy.count(), 1);
+  QCOMPARE(mPlot->queuedReplotCount(), 10);
+  QCOMPARE(mPlot->mergedReplotCount(), 9);
+  
+  // a direct replot satisfies a pending queued replot:
+  mPlot->replot(QCustomPlot::rpQueuedReplot);
+  mPlot->replot();
+  QCOMPARE(spy.count(), 2);
+  QVERIFY(!spy.wait(50));
+  QCOMPARE(spy.count(), 2);
+  
+  // the replot rate is limited:
+  mPlot->setMaxReplotRate(2);
+  QCOMPARE(mPlot->maxReplotRate(), 2.0);
+  QTime timer;
+  timer.start();
+  mPlot->replot();
+  QCOMPARE(spy.count(), 3);
+  mPlot->replot(QCustomPlot::rpQueuedReplot);
+  QVERIFY(spy.wait(2000));
+  QCOMPARE(spy.count(), 4);
+  QVERIFY(timer.elapsed() >= 450);
+  
+  mPlot->resetReplotCounts();
+  QCOMPARE(mPlot->queuedReplotCount(), 0);
+  QCOMPARE(mPlot->mergedReplotCount(), 0);
+#endif
+}
 
+void TestQCustomPlot::asyncReplot()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0) // QSignalSpy::wait, QWidget::grab
+  mPlot->setGeometry(50, 50, 500, 500);
+  QPixmap background(500, 500);
+  background.fill(Qt::red);
+  mPlot->setBackground(background, false);
+  QCPGraph *graph = mPlot->addGraph();
+  QVector<double> x(10000), y(10000);
+  for (int i=0; i<x.size(); ++i)
+  {
+    x[i] = i;
+    y[i] = qSin(i/100.0);
+  }
+  graph->setData(x, y);
+  mPlot->rescaleAxes();
+  
+  QSignalSpy spy(mPlot, SIGNAL(asyncReplotFinished()));
+  mPlot->setAsyncReplot(true);
+  QVERIFY(mPlot->asyncReplot());
+  
+  // replot returns before the frame is shown, outdated frames are dropped:
+  for (int i=0; i<5; ++i)
+    mPlot->replot();
+  QCOMPARE(spy.count(), 0);
+  QVERIFY(spy.wait(5000));
+  while (spy.count() < 5 && spy.wait(500)) {}
+  QVERIFY(spy.count() <= 5);
+  // the background pixmap was recorded as an image and rasterized by the worker thread:
+  QCOMPARE(mPlot->grab().toImage().pixel(0, 0), QColor(Qt::red).rgb());
+  
+  // a synchronous replot discards pending frames:
+  int frameCount = spy.count();
+  mPlot->replot();
+  mPlot->replot(QCustomPlot::rpImmediate);
+  QVERIFY(!spy.wait(200));
+  QCOMPARE(spy.count(), frameCount);
+  
+  // until the frame of the new size is finished, the previous frame is shown stretched:
+  mPlot->resize(600, 400);
+  QImage resized = mPlot->grab().toImage();
+  QCOMPARE(resized.size(), QSize(600, 400));
+  QCOMPARE(resized.pixel(0, 0), QColor(Qt::red).rgb());
+  QCOMPARE(resized.pixel(599, 399), QColor(Qt::red).rgb());
+  QVERIFY(spy.wait(5000));
+  resized = mPlot->grab().toImage();
+  QCOMPARE(resized.pixel(0, 0), QColor(Qt::red).rgb());
+  QCOMPARE(resized.pixel(599, 399), QColor(Qt::white).rgb()); // outside of the unscaled background pixmap
+  
+  mPlot->setAsyncReplot(false);
+  QVERIFY(!mPlot->asyncReplot());
+#endif
+}
 
+void TestQCustomPlot::parallelPreparation()
+{
+  QVector<double> x(10000), y(10000);
+  for (int g=0; g<8; ++g)
+  {
+    for (int i=0; i<x.size(); ++i)
+    {
+      x[i] = i;
+      y[i] = qSin(i/100.0+g)*g;
+    }
+    QCPGraph *graph = mPlot->addGraph();
+    graph->setData(x, y);
+    graph->setScatterStyle(g%2 == 0 ? QCPScatterStyle::ssNone : QCPScatterStyle::ssCircle);
+  }
+  QCPCurve *curve = new QCPCurve(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(curve);
+  curve->setData(y, x);
+  mPlot->rescaleAxes();
+  
+  // parallel preparation must not change the rendered result:
+  mPlot->setPlottingHint(QCP::phParallelPreparation, false);
+  mPlot->replot();
+  QPixmap sequential(mPlot->size());
+  mPlot->render(&sequential);
+  mPlot->setPlottingHint(QCP::phParallelPreparation, true);
+  mPlot->replot();
+  QPixmap parallel(mPlot->size());
+  mPlot->render(&parallel);
+  QCOMPARE(parallel.toImage(), sequential.toImage());
+}
 
-
-
-
-
-
-
-
+void TestQCustomPlot::nearestDataPoint()
+{
+  mPlot->resize(400, 300);
+  mPlot->xAxis->setRange(0, 10);
+  mPlot->yAxis->setRange(-2, 2);
+  QCPCurve *curve = new QCPCurve(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(curve);
+  QCPBars *bars = new QCPBars(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(bars);
+  QCPFinancial *financial = new QCPFinancial(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(financial);
+  financial->setWidth(0.5);
+  
+  QVector<double> t, keys, values;
+  QCPFinancialDataMap financialData;
+  qsrand(1);
+  for (int i=0; i<1000; ++i)
+  {
+    t << i;
+    keys << 5+qSin(i/50.0)*(3+i/500.0);
+    values << qCos(i/50.0)*(1+i/1000.0);
+  }
+  curve->setData(t, keys, values);
+  for (int i=0; i<20; ++i)
+  {
+    bars->addData(i*0.5, qSin(i/3.0));
+    financialData.insert(i*0.5, QCPFinancialData(i*0.5, 0, 1+qrand()%100/100.0, -1-qrand()%100/100.0, 0.5));
+  }
+  financial->setData(&financialData, true);
+  mPlot->replot();
+  
+  // compares the found data points to the data points found by examining all data points:
+  const QCPRange keyWindow(3, 6);
+  for (int i=0; i<200; ++i)
+  {
+    const QPointF pos(qrand()%500-50, qrand()%400-50);
+    double minCurveDistSqr = std::numeric_limits<double>::max();
+    double minCurveWindowDistSqr = std::numeric_limits<double>::max();
+    for (int k=0; k<keys.size(); ++k)
+    {
+      const QPointF d = QPointF(mPlot->xAxis->coordToPixel(keys.at(k)), mPlot->yAxis->coordToPixel(values.at(k)))-pos;
+      minCurveDistSqr = qMin(minCurveDistSqr, d.x()*d.x()+d.y()*d.y());
+      if (keyWindow.contains(keys.at(k)))
+        minCurveWindowDistSqr = qMin(minCurveWindowDistSqr, d.x()*d.x()+d.y()*d.y());
+    }
+    QVERIFY(qAbs(curve->nearestDataPoint(pos).distance-qSqrt(minCurveDistSqr)) < 1e-6);
+    QVERIFY(qAbs(curve->nearestDataPoint(pos, keyWindow).distance-qSqrt(minCurveWindowDistSqr)) < 1e-6);
+    
+    double minBarsDistSqr = std::numeric_limits<double>::max();
+    double minFinancialDistSqr = std::numeric_limits<double>::max();
+    for (int k=0; k<20; ++k)
+    {
+      const double key = k*0.5;
+      const QRectF barRect = QRectF(QPointF(mPlot->xAxis->coordToPixel(key-bars->width()*0.5), mPlot->yAxis->coordToPixel(0)),
+                                    QPointF(mPlot->xAxis->coordToPixel(key+bars->width()*0.5), mPlot->yAxis->coordToPixel(bars->data()->value(key).value))).normalized();
+      const QRectF financialRect = QRectF(QPointF(mPlot->xAxis->coordToPixel(key-financial->width()*0.5), mPlot->yAxis->coordToPixel(financialData.value(key).high)),
+                                          QPointF(mPlot->xAxis->coordToPixel(key+financial->width()*0.5), mPlot->yAxis->coordToPixel(financialData.value(key).low))).normalized();
+      double dx = qMax(0.0, qMax(barRect.left()-pos.x(), pos.x()-barRect.right()));
+      double dy = qMax(0.0, qMax(barRect.top()-pos.y(), pos.y()-barRect.bottom()));
+      minBarsDistSqr = qMin(minBarsDistSqr, dx*dx+dy*dy);
+      dx = qMax(0.0, qMax(financialRect.left()-pos.x(), pos.x()-financialRect.right()));
+      dy = qMax(0.0, qMax(financialRect.top()-pos.y(), pos.y()-financialRect.bottom()));
+      minFinancialDistSqr = qMin(minFinancialDistSqr, dx*dx+dy*dy);
+    }
+    const QCPDataPoint barsPoint = bars->nearestDataPoint(pos);
+    QVERIFY(qAbs(barsPoint.distance-qSqrt(minBarsDistSqr)) < 1e-6);
+    QCOMPARE(barsPoint.key, barsPoint.index*0.5);
+    const QCPDataPoint financialPoint = financial->nearestDataPoint(pos);
+    QVERIFY(qAbs(financialPoint.distance-qSqrt(minFinancialDistSqr)) < 1e-6);
+    QCOMPARE(financialPoint.key, financialPoint.index*0.5);
+    QCOMPARE(financialPoint.value, 0.5);
+  }
+  
+  // changing the axis range must update the point index of the curve:
+  mPlot->xAxis->setRange(4, 6);
+  const QPointF pos(mPlot->xAxis->coordToPixel(keys.at(10)), mPlot->yAxis->coordToPixel(values.at(10)));
+  const QCPDataPoint point = curve->nearestDataPoint(pos);
+  QVERIFY(point.distance < 1e-6);
+  QCOMPARE(point.key, keys.at(point.index));
+}
@@ -11,6 +11,13 @@ private slots:
   void rescaleAxes_GraphVisibility();
   void rescaleAxes_FlatGraph();
   void rescaleAxes_MultipleFlatGraphs();
+  void rescaleAxes_DirectDataAccess();
+  void rescaleValueAxisInKeyRange();
+  void layerReplot();
+  void queuedReplot();
+  void asyncReplot();
+  void parallelPreparation();
+  void nearestDataPoint();
   
 private:
   QCustomPlot *mPlot;
@@ -17,9 +17,37 @@ private slots:
   void QCPGraph_RemoveDataAfter();
   void QCPGraph_RemoveDataBefore();
   void QCPGraph_AddData();
+  void QCPGraph_SetData();
+  void QCPGraph_AdaptiveSamplingLarge();
+  void QCPGraph_AdaptiveSamplingPyramid();
+  void QCPGraph_VisibleRangeLookup();
+  void QCPGraph_StreamingAddRemove();
+  void QCPGraph_RescaleAxesAfterAdd();
+  void QCPGraph_RescaleValueAxisInKeyRange();
+  void QCPGraph_ManyScatters();
+  void QCPGraph_ManyScattersUncached();
+  void QCPGraph_DensityScatters();
+  void QCPGraph_SamplingAlgorithms_data();
+  void QCPGraph_SamplingAlgorithms();
+  void QCPGraph_SelectTest();
+  void QCPAbstractPlottable_NearestDataPoint_data();
+  void QCPAbstractPlottable_NearestDataPoint();
+  void QCPColorMap_Colorize_data();
+  void QCPColorMap_Colorize();
+  void QCPColorMap_UpdateCells();
+  void QCPColorMap_AppendRow();
+  void QCPColorMap_LevelOfDetail_data();
+  void QCPColorMap_LevelOfDetail();
+  void QCPColorMapData_Load_data();
+  void QCPColorMapData_Load();
 
   void QCPAxis_TickLabels();
   void QCPAxis_TickLabelsCached();
+  void QCPAxis_CoordToPixel();
+  void QCPAxis_CoordToPixelBatch();
+  
+  void QCustomPlot_ReplotManyGraphs();
+  void QCustomPlot_ReplotManyGraphsParallel();
   
 private:
   QCustomPlot *mPlot;
@@ -256,6 +284,150 @@ void Benchmark::QCPGraph_AddData()
   }
 }
 
+void Benchmark::QCPGraph_SetData()
+{
+  QCPGraph *graph = mPlot->addGraph();
+  int n = 1000000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i/(double)n;
+    y[i] = qSin(x[i]*10*M_PI);
+  }
+  
+  QBENCHMARK_ONCE
+  {
+    graph->setData(x, y);
+  }
+}
+
+void Benchmark::QCPGraph_AdaptiveSamplingLarge()
+{
+  QCPGraph *graph = mPlot->addGraph();
+  int n = 5000000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i/(double)n;
+    y[i] = qSin(x[i]*10*M_PI)+qSin(x[i]*1e4*M_PI)*0.1;
+  }
+  graph->setData(x, y);
+  mPlot->rescaleAxes(); // all points visible, adaptive sampling reduces them to a few per pixel
+  
+  QBENCHMARK
+  {
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCPGraph_AdaptiveSamplingPyramid()
+{
+  QCPGraph *graph = mPlot->addGraph();
+  int n = 5000000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i/(double)n;
+    y[i] = qSin(x[i]*10*M_PI)+qSin(x[i]*1e4*M_PI)*0.1;
+  }
+  graph->setData(x, y);
+  graph->setMinMaxPyramid(true);
+  mPlot->rescaleAxes();
+  mPlot->replot(); // builds the pyramid
+  
+  QBENCHMARK
+  {
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCPGraph_VisibleRangeLookup()
+{
+  QCPGraph *graph = mPlot->addGraph();
+  int n = 5000000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i/(double)n;
+    y[i] = qSin(x[i]*10*M_PI);
+  }
+  graph->setData(x, y);
+  mPlot->rescaleAxes();
+  mPlot->xAxis->setRange(0.5, 0.5001); // only a few hundred points visible
+  
+  QBENCHMARK
+  {
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCPGraph_StreamingAddRemove()
+{
+  QCPGraph *graph = mPlot->addGraph();
+  int n = 100000; // samples in strip chart window
+  graph->setStreamingCapacity(n);
+  for (int i=0; i<n; ++i)
+    graph->addData(i, qSin(i/(double)n*10*M_PI));
+  
+  int t = n;
+  QBENCHMARK
+  {
+    for (int i=0; i<1000; ++i) // one acquisition tick per iteration
+    {
+      graph->addData(t, qSin(t/(double)n*10*M_PI));
+      graph->removeDataBefore(t-n+1);
+      ++t;
+    }
+  }
+}
+
+void Benchmark::QCPGraph_RescaleAxesAfterAdd()
+{
+  QCPGraph *graph = mPlot->addGraph();
+  int n = 1000000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i;
+    y[i] = qSin(i/1000.0);
+  }
+  graph->setData(x, y);
+  mPlot->rescaleAxes(); // fills the range cache
+  
+  int k = n;
+  QBENCHMARK
+  {
+    graph->addData(k, qSin(k/1000.0));
+    mPlot->rescaleAxes();
+    ++k;
+  }
+}
+
+void Benchmark::QCPGraph_RescaleValueAxisInKeyRange()
+{
+  QCPGraph *graph = mPlot->addGraph();
+  int n = 5000000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i;
+    y[i] = qSin(i/1000.0)*i;
+  }
+  graph->setData(x, y);
+  graph->setMinMaxPyramid(true);
+  
+  double offset = 0;
+  QBENCHMARK
+  {
+    // simulates dragging a wide key range across the data:
+    mPlot->xAxis->setRange(offset, offset+n/2);
+    graph->rescaleValueAxisInKeyRange();
+    offset += 1000.5;
+    if (offset > n/2)
+      offset = 0;
+  }
+}
+
 void Benchmark::QCPAxis_TickLabels()
 {
   mPlot->setPlottingHint(QCP::phCacheLabels, false);
@@ -287,3 +459,432 @@ void Benchmark::QCPAxis_TickLabelsCached()
     mPlot->replot();
   }
 }
+
+void Benchmark::QCPAxis_CoordToPixel()
+{
+  int n = 1000000;
+  QVector<double> coords(n), pixels(n);
+  for (int i=0; i<n; ++i)
+    coords[i] = i/(double)n*20-10;
+  mPlot->xAxis->setRange(-10, 10);
+  mPlot->replot(); // lays out the axis rect
+  
+  QBENCHMARK
+  {
+    for (int i=0; i<n; ++i)
+      pixels[i] = mPlot->xAxis->coordToPixel(coords.at(i));
+  }
+}
+
+void Benchmark::QCPAxis_CoordToPixelBatch()
+{
+  int n = 1000000;
+  QVector<double> coords(n), pixels(n);
+  for (int i=0; i<n; ++i)
+    coords[i] = i/(double)n*20-10;
+  mPlot->xAxis->setRange(-10, 10);
+  mPlot->replot(); // lays out the axis rect
+  
+  QBENCHMARK
+  {
+    mPlot->xAxis->coordToPixel(coords.constData(), pixels.data(), n);
+  }
+}
+
+void Benchmark::QCustomPlot_ReplotManyGraphs()
+{
+  mPlot->setPlottingHint(QCP::phParallelPreparation, false);
+  int n = 200000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+    x[i] = i;
+  for (int g=0; g<32; ++g)
+  {
+    for (int i=0; i<n; ++i)
+      y[i] = qSin(i/1000.0+g)*g;
+    mPlot->addGraph()->setData(x, y);
+  }
+  mPlot->rescaleAxes();
+  
+  QBENCHMARK
+  {
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCustomPlot_ReplotManyGraphsParallel()
+{
+  mPlot->setPlottingHint(QCP::phParallelPreparation, true);
+  int n = 200000;
+  QVector<double> x(n), y(n);
+  for (int i=0; i<n; ++i)
+    x[i] = i;
+  for (int g=0; g<32; ++g)
+  {
+    for (int i=0; i<n; ++i)
+      y[i] = qSin(i/1000.0+g)*g;
+    mPlot->addGraph()->setData(x, y);
+  }
+  mPlot->rescaleAxes();
+  
+  QBENCHMARK
+  {
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCPGraph_ManyScatters()
+{
+  mPlot->setPlottingHint(QCP::phCacheScatters, true);
+  QCPGraph *graph = mPlot->addGraph();
+  graph->setLineStyle(QCPGraph::lsNone);
+  graph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, 5));
+  graph->setAntialiasedScatters(true);
+  int n = 1000000;
+  QVector<double> x(n), y(n);
+  qsrand(1);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i;
+    y[i] = qrand()/(double)RAND_MAX;
+  }
+  graph->setData(x, y);
+  mPlot->rescaleAxes();
+  
+  QBENCHMARK
+  {
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCPGraph_ManyScattersUncached()
+{
+  mPlot->setPlottingHint(QCP::phCacheScatters, false);
+  QCPGraph *graph = mPlot->addGraph();
+  graph->setLineStyle(QCPGraph::lsNone);
+  graph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, 5));
+  graph->setAntialiasedScatters(true);
+  int n = 1000000;
+  QVector<double> x(n), y(n);
+  qsrand(1);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i;
+    y[i] = qrand()/(double)RAND_MAX;
+  }
+  graph->setData(x, y);
+  mPlot->rescaleAxes();
+  
+  QBENCHMARK
+  {
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCPGraph_DensityScatters()
+{
+  QCPGraph *graph = mPlot->addGraph();
+  graph->setLineStyle(QCPGraph::lsNone);
+  graph->setScatterMode(QCPGraph::smDensity);
+  graph->setDensityScaleType(QCPAxis::stLogarithmic);
+  int n = 5000000;
+  QVector<double> x(n), y(n);
+  qsrand(1);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i;
+    y[i] = qSin(i/100000.0)+(qrand()/(double)RAND_MAX-0.5)*(qrand()/(double)RAND_MAX);
+  }
+  graph->setData(x, y);
+  mPlot->rescaleAxes();
+  
+  QBENCHMARK
+  {
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCPGraph_SamplingAlgorithms_data()
+{
+  QTest::addColumn<int>("algorithm");
+  QTest::addColumn<bool>("scatters");
+  QTest::newRow("line MinMax") << (int)QCPGraph::saMinMax << false;
+  QTest::newRow("line M4") << (int)QCPGraph::saM4 << false;
+  QTest::newRow("line LTTB") << (int)QCPGraph::saLttb << false;
+  QTest::newRow("scatter MinMax") << (int)QCPGraph::saMinMax << true;
+  QTest::newRow("scatter M4") << (int)QCPGraph::saM4 << true;
+  QTest::newRow("scatter LTTB") << (int)QCPGraph::saLttb << true;
+}
+
+void Benchmark::QCPGraph_SamplingAlgorithms()
+{
+  QFETCH(int, algorithm);
+  QFETCH(bool, scatters);
+  QCPGraph *graph = mPlot->addGraph();
+  graph->setSamplingAlgorithm((QCPGraph::SamplingAlgorithm)algorithm);
+  if (scatters)
+  {
+    graph->setLineStyle(QCPGraph::lsNone);
+    graph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssDisc, 3));
+  }
+  int n = 1000000;
+  QVector<double> x(n), y(n);
+  qsrand(1);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i;
+    y[i] = qSin(i/50000.0)+(qrand()/(double)RAND_MAX-0.5)*qCos(i/20000.0);
+  }
+  graph->setData(x, y);
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  qDebug() << QTest::currentDataTag() << "pixel error:" << graph->samplingPixelError((QCPGraph::SamplingAlgorithm)algorithm);
+  
+  QBENCHMARK
+  {
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCPGraph_SelectTest()
+{
+  QCPGraph *graph = mPlot->addGraph();
+  int n = 100000;
+  QVector<double> x(n), y(n);
+  qsrand(1);
+  for (int i=0; i<n; ++i)
+  {
+    x[i] = i;
+    y[i] = qSin(i/5000.0)+(qrand()/(double)RAND_MAX-0.5)*0.5;
+  }
+  graph->setData(x, y);
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  QList<QPointF> positions;
+  const QRect rect = mPlot->axisRect()->rect();
+  for (int i=0; i<100; ++i)
+    positions << QPointF(rect.left()+qrand()%rect.width(), rect.top()+qrand()%rect.height());
+  
+  QBENCHMARK
+  {
+    foreach (const QPointF &pos, positions)
+      graph->selectTest(pos, false);
+  }
+}
+
+void Benchmark::QCPAbstractPlottable_NearestDataPoint_data()
+{
+  QTest::addColumn<QString>("plottable");
+  QTest::addColumn<int>("count");
+  QTest::newRow("graph 10M") << QString("graph") << 10000000;
+  QTest::newRow("graph 10M with min/max pyramid") << QString("pyramid") << 10000000;
+  QTest::newRow("curve 2M") << QString("curve") << 2000000;
+}
+
+void Benchmark::QCPAbstractPlottable_NearestDataPoint()
+{
+  QFETCH(QString, plottable);
+  QFETCH(int, count);
+  QVector<double> x(count), y(count);
+  qsrand(1);
+  for (int i=0; i<count; ++i)
+  {
+    x[i] = i;
+    y[i] = qSin(i/(count/20.0))+(qrand()/(double)RAND_MAX-0.5)*0.5;
+  }
+  QCPAbstractPlottable *target;
+  if (plottable == "curve")
+  {
+    QCPCurve *curve = new QCPCurve(mPlot->xAxis, mPlot->yAxis);
+    mPlot->addPlottable(curve);
+    curve->setData(x, y);
+    target = curve;
+  } else
+  {
+    QCPGraph *graph = mPlot->addGraph();
+    graph->setData(x, y);
+    graph->setMinMaxPyramid(plottable == "pyramid");
+    target = graph;
+  }
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  // simulate a mouse moving across the axis rect, one query per mouse move event:
+  QList<QPointF> positions;
+  const QRect rect = mPlot->axisRect()->rect();
+  for (int i=0; i<100; ++i)
+    positions << QPointF(rect.left()+i*rect.width()/100.0, rect.top()+qrand()%rect.height());
+  target->nearestDataPoint(positions.first()); // builds lazily initialized indices
+  
+  QBENCHMARK
+  {
+    foreach (const QPointF &pos, positions)
+      target->nearestDataPoint(pos);
+  }
+}
+
+void Benchmark::QCPColorMap_Colorize_data()
+{
+  QTest::addColumn<int>("threads");
+  QTest::newRow("1 thread") << 1;
+  QTest::newRow("2 threads") << 2;
+  QTest::newRow("4 threads") << 4;
+  QTest::newRow("all cores") << QThread::idealThreadCount();
+}
+
+void Benchmark::QCPColorMap_Colorize()
+{
+  QFETCH(int, threads);
+  QCPColorMap *colorMap = new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(colorMap);
+  const int size = 4096;
+  colorMap->data()->setSize(size, size);
+  colorMap->data()->setRange(QCPRange(0, 1), QCPRange(0, 1));
+  for (int k=0; k<size; ++k)
+    for (int v=0; v<size; ++v)
+      colorMap->data()->setCell(k, v, qSin(k/100.0)*qCos(v/150.0));
+  colorMap->setGradient(QCPColorGradient::gpSpectrum);
+  colorMap->rescaleDataRange(true);
+  mPlot->rescaleAxes();
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount(threads);
+  
+  QBENCHMARK
+  {
+    colorMap->setInterpolate(colorMap->interpolate()); // each replot colorizes the whole map again
+    mPlot->replot();
+  }
+  QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+}
+
+void Benchmark::QCPColorMap_UpdateCells()
+{
+  QCPColorMap *colorMap = new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(colorMap);
+  const int size = 4096;
+  colorMap->data()->setSize(size, size);
+  colorMap->data()->setRange(QCPRange(0, 1), QCPRange(0, 1));
+  for (int k=0; k<size; ++k)
+    for (int v=0; v<size; ++v)
+      colorMap->data()->setCell(k, v, qSin(k/100.0)*qCos(v/150.0));
+  colorMap->setGradient(QCPColorGradient::gpSpectrum);
+  colorMap->setDataRange(QCPRange(-1, 1));
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  
+  qsrand(1);
+  QBENCHMARK
+  {
+    // a few hundred scattered cells and one row change per frame, only those are colorized again:
+    for (int i=0; i<500; ++i)
+      colorMap->data()->setCell(qrand()%size, qrand()%size, qrand()/(double)RAND_MAX*2-1);
+    const int row = qrand()%size;
+    for (int k=0; k<size; ++k)
+      colorMap->data()->setCell(k, row, 0);
+    mPlot->replot();
+  }
+}
+
+void Benchmark::QCPColorMap_AppendRow()
+{
+  QCPColorMap *colorMap = new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(colorMap);
+  const int keySize = 4096;
+  const int valueSize = 2048;
+  colorMap->data()->setSize(keySize, valueSize);
+  colorMap->data()->setRange(QCPRange(0, 1), QCPRange(0, 1));
+  colorMap->setGradient(QCPColorGradient::gpSpectrum);
+  colorMap->setDataRange(QCPRange(-1, 1));
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  
+  QVector<double> row(keySize);
+  int frame = 0;
+  QBENCHMARK
+  {
+    // one new spectrum per frame, like a waterfall display:
+    for (int k=0; k<keySize; ++k)
+      row[k] = qSin(k/100.0+frame/10.0);
+    colorMap->data()->appendRow(row.constData());
+    mPlot->replot();
+    ++frame;
+  }
+}
+
+void Benchmark::QCPColorMap_LevelOfDetail_data()
+{
+  QTest::addColumn<int>("reduction");
+  QTest::newRow("lrNone") << (int)QCPColorMap::lrNone;
+  QTest::newRow("lrMean") << (int)QCPColorMap::lrMean;
+}
+
+void Benchmark::QCPColorMap_LevelOfDetail()
+{
+  QFETCH(int, reduction);
+  QCPColorMap *colorMap = new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(colorMap);
+  const int size = 8192;
+  colorMap->data()->setSize(size, size);
+  colorMap->data()->setRange(QCPRange(0, 1), QCPRange(0, 1));
+  for (int k=0; k<size; ++k)
+    for (int v=0; v<size; ++v)
+      colorMap->data()->setCell(k, v, qSin(k/100.0)*qCos(v/150.0));
+  colorMap->setGradient(QCPColorGradient::gpSpectrum);
+  colorMap->setDataRange(QCPRange(-1, 1));
+  colorMap->setLodReduction((QCPColorMap::LodReduction)reduction);
+  mPlot->rescaleAxes();
+  mPlot->replot();
+  
+  int frame = 0;
+  QBENCHMARK
+  {
+    // zooming in and out with a few modified cells per frame:
+    const double zoom = 1.0/(1+frame%8);
+    mPlot->xAxis->setRange(0.5, zoom, Qt::AlignCenter);
+    mPlot->yAxis->setRange(0.5, zoom, Qt::AlignCenter);
+    for (int i=0; i<100; ++i)
+      colorMap->data()->setCell((frame*97+i*31)%size, (frame*13+i*53)%size, 0);
+    mPlot->replot();
+    ++frame;
+  }
+}
+
+void Benchmark::QCPColorMapData_Load_data()
+{
+  QTest::addColumn<bool>("bulk");
+  QTest::addColumn<int>("cellType");
+  QTest::newRow("setCell, ctDouble") << false << (int)QCPColorMapData::ctDouble;
+  QTest::newRow("setBlock, ctDouble") << true << (int)QCPColorMapData::ctDouble;
+  QTest::newRow("setBlock, ctUInt16") << true << (int)QCPColorMapData::ctUInt16;
+}
+
+void Benchmark::QCPColorMapData_Load()
+{
+  QFETCH(bool, bulk);
+  QFETCH(int, cellType);
+  // a frame of 16 bit camera data, loaded and colorized:
+  const int size = 4096;
+  QVector<quint16> frame(size*size);
+  for (int i=0; i<frame.size(); ++i)
+    frame[i] = (i*7919)%65536;
+  QCPColorMap *colorMap = new QCPColorMap(mPlot->xAxis, mPlot->yAxis);
+  mPlot->addPlottable(colorMap);
+  colorMap->data()->setCellType((QCPColorMapData::CellType)cellType);
+  colorMap->data()->setSize(size, size);
+  colorMap->data()->setRange(QCPRange(0, 1), QCPRange(0, 1));
+  colorMap->setDataRange(QCPRange(0, 65535));
+  mPlot->rescaleAxes();
+  
+  QBENCHMARK
+  {
+    if (bulk)
+    {
+      colorMap->data()->setBlock(0, 0, size, size, frame.constData());
+    } else
+    {
+      for (int v=0; v<size; ++v)
+        for (int k=0; k<size; ++k)
+          colorMap->data()->setCell(k, v, frame.at(v*size+k));
+    }
+    mPlot->replot();
+  }
+}
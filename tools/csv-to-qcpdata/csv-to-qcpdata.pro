@@ -0,0 +1,16 @@
+#
+# Command line tool to convert CSV files to memory-mappable QCPDataFile files
+#
+
+QT += core gui
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
+
+TARGET = csv-to-qcpdata
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += main.cpp \
+         ../../qcustomplot.cpp
+
+HEADERS += ../../qcustomplot.h
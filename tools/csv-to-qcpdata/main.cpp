@@ -0,0 +1,165 @@
+/*
+  Converts a CSV file to the binary data file format of QCPDataFile, which QCPGraph can display
+  via memory mapping without loading it into memory (see QCPGraph::setExternalData).
+  
+  The CSV file is processed line by line, so files of any size can be converted. The keys must be
+  sorted ascending and must not be NaN. Lines that can't be parsed (e.g. column headers or
+  comments) are skipped. The number of data points is only limited by the file system, but
+  QCPGraph::setExternalData only displays files with at most INT_MAX data points.
+  
+  Usage: csv-to-qcpdata [-k keyColumn] [-v valueColumn] [-d delimiter] input.csv output.qcpdata
+*/
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QStringList>
+#include <QVector>
+#include <cstdio>
+#include <limits>
+#include "../../qcustomplot.h"
+
+static const int chunkSize = 65536; // number of doubles buffered before writing
+
+void printUsage()
+{
+  fprintf(stderr, "Usage: csv-to-qcpdata [-k keyColumn] [-v valueColumn] [-d delimiter] input.csv output.qcpdata\n"
+                  "  -k  zero-based index of the key column (default 0)\n"
+                  "  -v  zero-based index of the value column (default 1)\n"
+                  "  -d  column delimiter, a single character or \"tab\" (default ',')\n");
+}
+
+bool writeChunk(QIODevice *device, QVector<double> &chunk)
+{
+  const qint64 bytes = chunk.size()*qint64(sizeof(double));
+  bool ok = device->write(reinterpret_cast<const char*>(chunk.constData()), bytes) == bytes;
+  chunk.resize(0);
+  return ok;
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  QStringList args = app.arguments();
+  args.removeFirst();
+  
+  int keyColumn = 0;
+  int valueColumn = 1;
+  char delimiter = ',';
+  QStringList files;
+  while (!args.isEmpty())
+  {
+    QString arg = args.takeFirst();
+    if ((arg == QLatin1String("-k") || arg == QLatin1String("-v") || arg == QLatin1String("-d")) && !args.isEmpty())
+    {
+      QString param = args.takeFirst();
+      bool ok = true;
+      if (arg == QLatin1String("-k"))
+        keyColumn = param.toInt(&ok);
+      else if (arg == QLatin1String("-v"))
+        valueColumn = param.toInt(&ok);
+      else if (param == QLatin1String("tab"))
+        delimiter = '\t';
+      else if (param.size() == 1)
+        delimiter = param.at(0).toLatin1();
+      else
+        ok = false;
+      if (!ok || keyColumn < 0 || valueColumn < 0)
+      {
+        printUsage();
+        return 1;
+      }
+    } else
+      files << arg;
+  }
+  if (files.size() != 2)
+  {
+    printUsage();
+    return 1;
+  }
+  
+  QFile input(files.at(0));
+  if (!input.open(QIODevice::ReadOnly))
+  {
+    fprintf(stderr, "Couldn't open input file: %s\n", qPrintable(input.errorString()));
+    return 1;
+  }
+  QFile output(files.at(1));
+  if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    fprintf(stderr, "Couldn't open output file: %s\n", qPrintable(output.errorString()));
+    return 1;
+  }
+  QTemporaryFile valueFile; // values are collected separately and appended behind the keys in the end
+  if (!valueFile.open())
+  {
+    fprintf(stderr, "Couldn't open temporary file: %s\n", qPrintable(valueFile.errorString()));
+    return 1;
+  }
+  
+  // write preliminary header, keys go directly to the output file:
+  bool ok = QCPDataFile::writeHeader(&output, 0);
+  QVector<double> keyChunk, valueChunk;
+  keyChunk.reserve(chunkSize);
+  valueChunk.reserve(chunkSize);
+  qint64 count = 0;
+  qint64 skipped = 0;
+  qint64 lineNumber = 0;
+  double lastKey = -std::numeric_limits<double>::max();
+  const int requiredColumns = qMax(keyColumn, valueColumn)+1;
+  while (ok && !input.atEnd())
+  {
+    QByteArray line = input.readLine().trimmed();
+    ++lineNumber;
+    QList<QByteArray> columns = line.split(delimiter);
+    bool keyOk = false, valueOk = false;
+    double key = 0, value = 0;
+    if (columns.size() >= requiredColumns)
+    {
+      key = columns.at(keyColumn).trimmed().toDouble(&keyOk);
+      value = columns.at(valueColumn).trimmed().toDouble(&valueOk);
+    }
+    if (!keyOk || !valueOk)
+    {
+      ++skipped;
+      continue;
+    }
+    if (qIsNaN(key))
+    {
+      fprintf(stderr, "Key is NaN in line %lld\n", lineNumber);
+      output.remove();
+      return 1;
+    }
+    if (key < lastKey)
+    {
+      fprintf(stderr, "Keys not sorted ascending in line %lld\n", lineNumber);
+      output.remove();
+      return 1;
+    }
+    lastKey = key;
+    keyChunk.append(key);
+    valueChunk.append(value);
+    ++count;
+    if (keyChunk.size() == chunkSize)
+      ok = writeChunk(&output, keyChunk) && writeChunk(&valueFile, valueChunk);
+  }
+  ok = ok && writeChunk(&output, keyChunk) && writeChunk(&valueFile, valueChunk);
+  
+  // append values behind keys and write final header:
+  ok = ok && valueFile.seek(0);
+  while (ok && !valueFile.atEnd())
+  {
+    QByteArray block = valueFile.read(chunkSize*sizeof(double));
+    ok = output.write(block) == block.size();
+  }
+  ok = ok && output.seek(0) && QCPDataFile::writeHeader(&output, count);
+  if (!ok)
+  {
+    fprintf(stderr, "Couldn't write output file: %s\n", qPrintable(output.errorString()));
+    output.remove();
+    return 1;
+  }
+  
+  printf("Converted %lld data points, skipped %lld lines\n", count, skipped);
+  return 0;
+}